@@ -1,13 +1,130 @@
-// Placeholder benchmark file
-use criterion::{black_box, criterion_group, criterion_main, Criterion};
+//! Criterion benchmarks of the C ring buffer through FFI
+//!
+//! Writes and reads are timed separately: writes run in chunks that fit
+//! the buffer, which is drained untimed between chunks, and reads consume
+//! a backlog filled untimed beforehand.
 
-fn bench_placeholder(c: &mut Criterion) {
-    c.bench_function("placeholder", |b| {
-        b.iter(|| {
-            black_box(1 + 1)
-        })
-    });
+use std::time::{Duration, Instant};
+
+use chronicle_benchmarks::ring_buffer_ffi::{NativeRingBuffer, ReadBatch};
+use criterion::{black_box, criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+
+const BUFFER_SIZE: usize = 64 * 1024 * 1024;
+const MESSAGE_SIZES: &[usize] = &[64, 1024, 16 * 1024];
+const BATCH_SIZE: usize = 32;
+
+/// Header and alignment overhead per message, rounded up
+const MESSAGE_OVERHEAD: usize = 32;
+
+/// Iterations that fit in half the buffer
+fn chunk_len(bytes_per_iter: usize) -> u64 {
+    (BUFFER_SIZE / 2 / bytes_per_iter).max(1) as u64
+}
+
+/// Time `iters` calls of `op`, draining the buffer untimed whenever it is half full
+fn time_writes(rb: &NativeRingBuffer, iters: u64, bytes_per_iter: usize, mut op: impl FnMut()) -> Duration {
+    let chunk = chunk_len(bytes_per_iter);
+    let mut elapsed = Duration::ZERO;
+    let mut done = 0;
+    while done < iters {
+        let n = chunk.min(iters - done);
+        let start = Instant::now();
+        for _ in 0..n {
+            op();
+        }
+        elapsed += start.elapsed();
+        rb.drain();
+        done += n;
+    }
+    elapsed
+}
+
+fn bench_write(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ring_buffer_write");
+    let rb = NativeRingBuffer::new(BUFFER_SIZE).unwrap();
+
+    for &size in MESSAGE_SIZES {
+        let data = vec![0xA5u8; size];
+        group.throughput(Throughput::Bytes(size as u64));
+        group.bench_with_input(BenchmarkId::from_parameter(size), &data, |b, data| {
+            b.iter_custom(|iters| {
+                time_writes(&rb, iters, size + MESSAGE_OVERHEAD, || rb.write(black_box(data)).unwrap())
+            })
+        });
+    }
+
+    group.finish();
+}
+
+fn bench_reserve_commit(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ring_buffer_reserve_commit");
+    let rb = NativeRingBuffer::new(BUFFER_SIZE).unwrap();
+
+    for &size in MESSAGE_SIZES {
+        let data = vec![0xA5u8; size];
+        group.throughput(Throughput::Bytes(size as u64));
+        group.bench_with_input(BenchmarkId::from_parameter(size), &data, |b, data| {
+            b.iter_custom(|iters| {
+                time_writes(&rb, iters, size + MESSAGE_OVERHEAD, || rb.reserve_commit(black_box(data)).unwrap())
+            })
+        });
+    }
+
+    group.finish();
+}
+
+fn bench_read(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ring_buffer_read");
+    let rb = NativeRingBuffer::new(BUFFER_SIZE).unwrap();
+
+    for &size in MESSAGE_SIZES {
+        let data = vec![0xA5u8; size];
+        group.throughput(Throughput::Bytes(size as u64));
+        group.bench_with_input(BenchmarkId::from_parameter(size), &data, |b, data| {
+            b.iter_custom(|iters| {
+                let chunk = chunk_len(size + MESSAGE_OVERHEAD);
+                let mut elapsed = Duration::ZERO;
+                let mut done = 0;
+                while done < iters {
+                    let n = chunk.min(iters - done);
+                    for _ in 0..n {
+                        rb.write(data).unwrap();
+                    }
+                    let start = Instant::now();
+                    for _ in 0..n {
+                        black_box(rb.read());
+                    }
+                    elapsed += start.elapsed();
+                    done += n;
+                }
+                elapsed
+            })
+        });
+    }
+
+    group.finish();
+}
+
+fn bench_batch(c: &mut Criterion) {
+    let mut group = c.benchmark_group("ring_buffer_batch");
+    let rb = NativeRingBuffer::new(BUFFER_SIZE).unwrap();
+    let mut batch = ReadBatch::with_capacity(BATCH_SIZE);
+
+    // One write_batch() and one read_batch() of BATCH_SIZE messages per iteration
+    for &size in MESSAGE_SIZES {
+        let data = vec![0xA5u8; size];
+        let payloads: Vec<&[u8]> = (0..BATCH_SIZE).map(|_| data.as_slice()).collect();
+        group.throughput(Throughput::Bytes((size * BATCH_SIZE) as u64));
+        group.bench_with_input(BenchmarkId::from_parameter(size), &payloads, |b, payloads| {
+            b.iter(|| {
+                rb.write_batch(black_box(payloads)).unwrap();
+                black_box(rb.read_batch(&mut batch));
+            })
+        });
+    }
+
+    group.finish();
 }
 
-criterion_group!(benches, bench_placeholder);
-criterion_main!(benches);
\ No newline at end of file
+criterion_group!(benches, bench_write, bench_reserve_commit, bench_read, bench_batch);
+criterion_main!(benches);
@@ -2,7 +2,13 @@
 //!
 //! Tests the core ring buffer implementation for throughput, latency, and memory usage
 //! across different scenarios including single/multi-producer and single/multi-consumer patterns.
+//! Every scenario drives the C library through FFI; per-operation timings go to a
+//! `PerformanceProfiler` session and process memory is sampled by a `MemoryAnalyzer`.
 
+use crate::monitoring::memory_analyzer::MemoryAnalyzer;
+use crate::monitoring::performance_profiler::PerformanceProfiler;
+use crate::monitoring::MonitoringConfig;
+use crate::ring_buffer_ffi::{NativeRingBuffer, WriteRefused};
 use crate::{
     BenchmarkComponent, BenchmarkConfig, BenchmarkResult, ErrorMetrics, LatencyMetrics,
     PerformanceMetrics, ResourceMetrics, ThroughputMetrics,
@@ -25,90 +31,205 @@ const BENCHMARK_TESTS: &[&str] = &[
     "lock_contention",
 ];
 
-/// Simulated ring buffer operations (FFI calls to C implementation)
-struct RingBufferSimulator {
-    capacity: usize,
-    write_count: AtomicU64,
-    read_count: AtomicU64,
-    errors: AtomicU64,
+/// Capacity of the buffer each benchmark runs against
+const RING_BUFFER_CAPACITY: usize = 1024 * 1024;
+
+/// Yields a writer spends waiting for room before counting the write as failed
+const FULL_RETRIES: u32 = 1000;
+
+/// Call count and nanosecond timings of one operation, kept in atomics
+/// so that timing does not serialize the threads being measured
+struct OpTimer {
+    count: AtomicU64,
+    total_ns: AtomicU64,
+    min_ns: AtomicU64,
+    max_ns: AtomicU64,
 }
 
-impl RingBufferSimulator {
-    fn new(capacity: usize) -> Self {
+impl OpTimer {
+    fn new() -> Self {
         Self {
-            capacity,
-            write_count: AtomicU64::new(0),
-            read_count: AtomicU64::new(0),
-            errors: AtomicU64::new(0),
+            count: AtomicU64::new(0),
+            total_ns: AtomicU64::new(0),
+            min_ns: AtomicU64::new(u64::MAX),
+            max_ns: AtomicU64::new(0),
         }
     }
 
+    fn record(&self, elapsed: Duration) {
+        let ns = elapsed.as_nanos() as u64;
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.total_ns.fetch_add(ns, Ordering::Relaxed);
+        self.min_ns.fetch_min(ns, Ordering::Relaxed);
+        self.max_ns.fetch_max(ns, Ordering::Relaxed);
+    }
+
+    async fn report(&self, profiler: &PerformanceProfiler, name: &str) {
+        let ms = |ns: u64| ns as f64 / 1_000_000.0;
+        profiler
+            .record_aggregate(
+                name,
+                self.count.load(Ordering::Relaxed),
+                ms(self.total_ns.load(Ordering::Relaxed)),
+                ms(self.min_ns.load(Ordering::Relaxed)),
+                ms(self.max_ns.load(Ordering::Relaxed)),
+            )
+            .await;
+    }
+}
+
+/// The C ring buffer, driven through FFI, with per-operation timing
+struct RingBufferHarness {
+    buffer: NativeRingBuffer,
+    writes: OpTimer,
+    reads: OpTimer,
+    errors: AtomicU64,
+    producers: AtomicU64,
+}
+
+impl RingBufferHarness {
+    fn new(capacity: usize) -> Result<Self> {
+        Ok(Self {
+            buffer: NativeRingBuffer::new(capacity)?,
+            writes: OpTimer::new(),
+            reads: OpTimer::new(),
+            errors: AtomicU64::new(0),
+            producers: AtomicU64::new(0),
+        })
+    }
+
+    /// Register producers; readers stop waiting once they have all finished
+    fn add_producers(&self, count: usize) {
+        self.producers.fetch_add(count as u64, Ordering::Relaxed);
+    }
+
+    fn producer_done(&self) {
+        self.producers.fetch_sub(1, Ordering::Release);
+    }
+
+    /// Write one event, yielding to consumers while the buffer is full
     async fn write_event(&self, data: &[u8]) -> Result<()> {
-        // Simulate write latency
-        time::sleep(Duration::from_nanos(100)).await;
-        self.write_count.fetch_add(1, Ordering::Relaxed);
-        
-        // Simulate occasional errors
-        if rand::random::<f64>() < 0.001 {
-            self.errors.fetch_add(1, Ordering::Relaxed);
-            return Err(anyhow::anyhow!("Ring buffer full"));
+        self.write_with(data, || false).await
+    }
+
+    /// Write one event with no consumer running, discarding the backlog
+    /// whenever the buffer fills so the writer never stalls or fails
+    async fn write_event_recycling(&self, data: &[u8]) -> Result<()> {
+        self.write_with(data, || {
+            self.buffer.drain();
+            true
+        })
+        .await
+    }
+
+    async fn write_with(&self, data: &[u8], mut on_full: impl FnMut() -> bool) -> Result<()> {
+        for _ in 0..FULL_RETRIES {
+            let start = Instant::now();
+            match self.buffer.write(data) {
+                Ok(()) => {
+                    self.writes.record(start.elapsed());
+                    return Ok(());
+                }
+                Err(WriteRefused::Full) => {
+                    if !on_full() {
+                        tokio::task::yield_now().await;
+                    }
+                }
+                Err(e) => {
+                    self.errors.fetch_add(1, Ordering::Relaxed);
+                    return Err(e.into());
+                }
+            }
         }
-        
-        Ok(())
+
+        self.errors.fetch_add(1, Ordering::Relaxed);
+        Err(anyhow::anyhow!("Ring buffer full"))
     }
 
-    async fn read_event(&self) -> Result<Vec<u8>> {
-        // Simulate read latency
-        time::sleep(Duration::from_nanos(80)).await;
-        self.read_count.fetch_add(1, Ordering::Relaxed);
-        
-        // Simulate occasional errors
-        if rand::random::<f64>() < 0.001 {
-            self.errors.fetch_add(1, Ordering::Relaxed);
-            return Err(anyhow::anyhow!("Ring buffer empty"));
+    /// Read one event, returning its size, waiting while producers are still running
+    async fn read_event(&self) -> Result<usize> {
+        loop {
+            let start = Instant::now();
+            if let Some(size) = self.buffer.read() {
+                self.reads.record(start.elapsed());
+                return Ok(size);
+            }
+            if self.producers.load(Ordering::Acquire) == 0 && self.buffer.available_read() == 0 {
+                return Err(anyhow::anyhow!("Ring buffer empty"));
+            }
+            tokio::task::yield_now().await;
         }
-        
-        Ok(vec![0u8; 1024]) // Simulate 1KB event
     }
 
     fn get_stats(&self) -> (u64, u64, u64) {
         (
-            self.write_count.load(Ordering::Relaxed),
-            self.read_count.load(Ordering::Relaxed),
+            self.writes.count.load(Ordering::Relaxed),
+            self.reads.count.load(Ordering::Relaxed),
             self.errors.load(Ordering::Relaxed),
         )
     }
+
+    /// Hand the per-operation timings to the profiler session
+    async fn report(&self, profiler: &PerformanceProfiler) {
+        self.writes.report(profiler, "ring_buffer_write").await;
+        self.reads.report(profiler, "ring_buffer_read").await;
+    }
 }
 
 /// Run a specific ring buffer benchmark
 pub async fn run_benchmark(test_name: &str, config: &BenchmarkConfig) -> Result<BenchmarkResult> {
+    let ring_buffer = Arc::new(RingBufferHarness::new(RING_BUFFER_CAPACITY)?);
+    let profiler = PerformanceProfiler::new(MonitoringConfig::default());
+    let memory_analyzer = MemoryAnalyzer::new(MonitoringConfig::default());
+
+    profiler.start_session(format!("ring_buffer::{}", test_name)).await?;
+    let memory_before = memory_analyzer.take_snapshot().await?;
     let start_time = Instant::now();
     
     let result = match test_name {
         "single_producer_single_consumer" => {
-            single_producer_single_consumer_benchmark(config).await
+            single_producer_single_consumer_benchmark(ring_buffer.clone(), config).await
         }
         "single_producer_multi_consumer" => {
-            single_producer_multi_consumer_benchmark(config).await
+            single_producer_multi_consumer_benchmark(ring_buffer.clone(), config).await
         }
         "multi_producer_single_consumer" => {
-            multi_producer_single_consumer_benchmark(config).await
+            multi_producer_single_consumer_benchmark(ring_buffer.clone(), config).await
         }
         "multi_producer_multi_consumer" => {
-            multi_producer_multi_consumer_benchmark(config).await
+            multi_producer_multi_consumer_benchmark(ring_buffer.clone(), config).await
         }
-        "burst_write_performance" => burst_write_performance_benchmark(config).await,
-        "sustained_throughput" => sustained_throughput_benchmark(config).await,
-        "memory_pressure" => memory_pressure_benchmark(config).await,
-        "lock_contention" => lock_contention_benchmark(config).await,
+        "burst_write_performance" => burst_write_performance_benchmark(ring_buffer.clone(), config).await,
+        "sustained_throughput" => sustained_throughput_benchmark(ring_buffer.clone(), config).await,
+        "memory_pressure" => memory_pressure_benchmark(ring_buffer.clone(), config).await,
+        "lock_contention" => lock_contention_benchmark(ring_buffer.clone(), config).await,
         _ => return Err(anyhow::anyhow!("Unknown benchmark test: {}", test_name)),
     };
 
     let duration = start_time.elapsed();
+    let memory_after = memory_analyzer.take_snapshot().await?;
+    ring_buffer.report(&profiler).await;
+    let session = profiler.end_session().await?;
     
     match result {
         Ok(mut metrics) => {
             metrics.timestamp = chrono::Utc::now();
+            metrics.resources.memory_usage_mb = memory_after.process_memory_mb;
+
+            let mut notes = format!(
+                "Completed in {:.2?}; process memory {:+.1} MB",
+                duration,
+                memory_after.process_memory_mb - memory_before.process_memory_mb
+            );
+            for profile in session.iter().flat_map(|s| &s.profiles) {
+                notes.push_str(&format!(
+                    "; {} {} calls, avg {:.0} ns, max {:.0} ns",
+                    profile.function_name,
+                    profile.call_count,
+                    profile.avg_time_ms * 1_000_000.0,
+                    profile.max_time_ms * 1_000_000.0
+                ));
+            }
             
             // Check if performance targets are met
             let passed = metrics.throughput.events_per_second >= config.targets.ring_buffer_events_per_second as f64;
@@ -118,7 +239,7 @@ pub async fn run_benchmark(test_name: &str, config: &BenchmarkConfig) -> Result<
                 test_name: test_name.to_string(),
                 metrics,
                 passed,
-                notes: Some(format!("Completed in {:.2?}", duration)),
+                notes: Some(notes),
             })
         }
         Err(e) => {
@@ -176,9 +297,9 @@ pub async fn run_all_benchmarks(config: &BenchmarkConfig) -> Result<Vec<Benchmar
 
 /// Single producer, single consumer benchmark
 async fn single_producer_single_consumer_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let data = vec![0u8; 1024]; // 1KB events
     
     // Warmup
@@ -187,6 +308,7 @@ async fn single_producer_single_consumer_benchmark(
     let start_time = Instant::now();
     let rb_producer = ring_buffer.clone();
     let rb_consumer = ring_buffer.clone();
+    ring_buffer.add_producers(1);
     
     // Producer task
     let producer_task = tokio::spawn(async move {
@@ -197,6 +319,7 @@ async fn single_producer_single_consumer_benchmark(
             let _ = rb_producer.write_event(&data).await;
             latencies.push(start.elapsed().as_nanos() as f64 / 1_000_000.0);
         }
+        rb_producer.producer_done();
         
         latencies
     });
@@ -247,9 +370,9 @@ async fn single_producer_single_consumer_benchmark(
 
 /// Single producer, multiple consumers benchmark
 async fn single_producer_multi_consumer_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let data = vec![0u8; 1024];
     let consumer_count = config.concurrency;
     
@@ -257,12 +380,14 @@ async fn single_producer_multi_consumer_benchmark(
     
     let start_time = Instant::now();
     let rb_producer = ring_buffer.clone();
+    ring_buffer.add_producers(1);
     
     // Single producer task
     let producer_task = tokio::spawn(async move {
         for _ in 0..config.iterations {
             let _ = rb_producer.write_event(&data).await;
         }
+        rb_producer.producer_done();
     });
     
     // Multiple consumer tasks
@@ -315,9 +440,9 @@ async fn single_producer_multi_consumer_benchmark(
 
 /// Multiple producers, single consumer benchmark
 async fn multi_producer_single_consumer_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let data = vec![0u8; 1024];
     let producer_count = config.concurrency;
     
@@ -326,6 +451,7 @@ async fn multi_producer_single_consumer_benchmark(
     let start_time = Instant::now();
     
     // Multiple producer tasks
+    ring_buffer.add_producers(producer_count);
     let mut producer_tasks = Vec::new();
     for _ in 0..producer_count {
         let rb_producer = ring_buffer.clone();
@@ -337,6 +463,7 @@ async fn multi_producer_single_consumer_benchmark(
                 let _ = rb_producer.write_event(&data_clone).await;
                 latencies.push(start.elapsed().as_nanos() as f64 / 1_000_000.0);
             }
+            rb_producer.producer_done();
             latencies
         });
         producer_tasks.push(task);
@@ -389,9 +516,9 @@ async fn multi_producer_single_consumer_benchmark(
 
 /// Multiple producers, multiple consumers benchmark
 async fn multi_producer_multi_consumer_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let data = vec![0u8; 1024];
     let producer_count = config.concurrency;
     let consumer_count = config.concurrency;
@@ -401,6 +528,7 @@ async fn multi_producer_multi_consumer_benchmark(
     let start_time = Instant::now();
     
     // Multiple producer tasks
+    ring_buffer.add_producers(producer_count);
     let mut producer_tasks = Vec::new();
     for _ in 0..producer_count {
         let rb_producer = ring_buffer.clone();
@@ -409,6 +537,7 @@ async fn multi_producer_multi_consumer_benchmark(
             for _ in 0..(config.iterations / producer_count) {
                 let _ = rb_producer.write_event(&data_clone).await;
             }
+            rb_producer.producer_done();
         });
         producer_tasks.push(task);
     }
@@ -463,9 +592,9 @@ async fn multi_producer_multi_consumer_benchmark(
 
 /// Burst write performance benchmark
 async fn burst_write_performance_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let data = vec![0u8; 1024];
     
     time::sleep(config.warmup_duration).await;
@@ -473,10 +602,10 @@ async fn burst_write_performance_benchmark(
     let start_time = Instant::now();
     let mut latencies = Vec::new();
     
-    // Burst writes
+    // Burst writes; with no consumer, the backlog is discarded whenever the buffer fills
     for _ in 0..config.iterations {
         let start = Instant::now();
-        ring_buffer.write_event(&data).await?;
+        ring_buffer.write_event_recycling(&data).await?;
         latencies.push(start.elapsed().as_nanos() as f64 / 1_000_000.0);
     }
     
@@ -505,9 +634,9 @@ async fn burst_write_performance_benchmark(
 
 /// Sustained throughput benchmark
 async fn sustained_throughput_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let data = vec![0u8; 1024];
     
     time::sleep(config.warmup_duration).await;
@@ -515,6 +644,7 @@ async fn sustained_throughput_benchmark(
     let start_time = Instant::now();
     let rb_producer = ring_buffer.clone();
     let rb_consumer = ring_buffer.clone();
+    ring_buffer.add_producers(1);
     
     // Sustained producer
     let producer_task = tokio::spawn(async move {
@@ -522,6 +652,7 @@ async fn sustained_throughput_benchmark(
             let _ = rb_producer.write_event(&data).await;
             time::sleep(Duration::from_millis(1)).await;
         }
+        rb_producer.producer_done();
     });
     
     // Sustained consumer
@@ -565,9 +696,9 @@ async fn sustained_throughput_benchmark(
 
 /// Memory pressure benchmark
 async fn memory_pressure_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let large_data = vec![0u8; 64 * 1024]; // 64KB events
     
     time::sleep(config.warmup_duration).await;
@@ -578,7 +709,7 @@ async fn memory_pressure_benchmark(
     // Write large events to test memory pressure
     for _ in 0..config.iterations {
         let start = Instant::now();
-        ring_buffer.write_event(&large_data).await?;
+        ring_buffer.write_event_recycling(&large_data).await?;
         latencies.push(start.elapsed().as_nanos() as f64 / 1_000_000.0);
     }
     
@@ -607,9 +738,9 @@ async fn memory_pressure_benchmark(
 
 /// Lock contention benchmark
 async fn lock_contention_benchmark(
+    ring_buffer: Arc<RingBufferHarness>,
     config: &BenchmarkConfig,
 ) -> Result<PerformanceMetrics> {
-    let ring_buffer = Arc::new(RingBufferSimulator::new(1024 * 1024));
     let data = vec![0u8; 1024];
     let thread_count = config.concurrency * 2; // High contention
     
@@ -626,7 +757,7 @@ async fn lock_contention_benchmark(
             let mut latencies = Vec::new();
             for _ in 0..(config.iterations / thread_count) {
                 let start = Instant::now();
-                let _ = rb.write_event(&data_clone).await;
+                let _ = rb.write_event_recycling(&data_clone).await;
                 latencies.push(start.elapsed().as_nanos() as f64 / 1_000_000.0);
             }
             latencies
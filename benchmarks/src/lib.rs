@@ -16,6 +16,7 @@ pub mod config;
 pub mod dashboard;
 pub mod metrics;
 pub mod monitoring;
+pub mod ring_buffer_ffi;
 pub mod utils;
 
 use anyhow::Result;
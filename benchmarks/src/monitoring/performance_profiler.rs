@@ -32,6 +32,7 @@ pub struct PerformanceProfiler {
     is_running: AtomicBool,
     current_session: Arc<RwLock<Option<ProfilingSession>>>,
     profile_data: Arc<RwLock<HashMap<String, Vec<f64>>>>,
+    aggregates: Arc<RwLock<HashMap<String, ProfileData>>>,
 }
 
 impl PerformanceProfiler {
@@ -41,6 +42,7 @@ impl PerformanceProfiler {
             is_running: AtomicBool::new(false),
             current_session: Arc::new(RwLock::new(None)),
             profile_data: Arc::new(RwLock::new(HashMap::new())),
+            aggregates: Arc::new(RwLock::new(HashMap::new())),
         }
     }
 
@@ -56,6 +58,7 @@ impl PerformanceProfiler {
 
         *self.current_session.write().await = Some(session);
         self.profile_data.write().await.clear();
+        self.aggregates.write().await.clear();
 
         Ok(())
     }
@@ -91,6 +94,9 @@ impl PerformanceProfiler {
                     }
                 })
                 .collect();
+            session
+                .profiles
+                .extend(self.aggregates.read().await.values().cloned());
 
             Ok(Some(session))
         } else {
@@ -106,6 +112,32 @@ impl PerformanceProfiler {
             .push(duration_ms);
     }
 
+    /// Record calls timed elsewhere, e.g. by atomics on a hot path where
+    /// one `record_function_call` per call would cost more than the call
+    pub async fn record_aggregate(
+        &self,
+        function_name: &str,
+        call_count: u64,
+        total_time_ms: f64,
+        min_time_ms: f64,
+        max_time_ms: f64,
+    ) {
+        if call_count == 0 {
+            return;
+        }
+        self.aggregates.write().await.insert(
+            function_name.to_string(),
+            ProfileData {
+                function_name: function_name.to_string(),
+                call_count,
+                total_time_ms,
+                avg_time_ms: total_time_ms / call_count as f64,
+                min_time_ms,
+                max_time_ms,
+            },
+        );
+    }
+
     pub async fn get_current_session(&self) -> Option<ProfilingSession> {
         self.current_session.read().await.clone()
     }
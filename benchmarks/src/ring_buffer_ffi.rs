@@ -0,0 +1,239 @@
+//! Bindings to the C ring buffer in `ring-buffer/` for benchmarking
+//!
+//! `build.rs` compiles `ring_buffer.c` into this crate, so the numbers
+//! measured here are those of the library the collectors and the packer
+//! link, not of a model of it. [`NativeRingBuffer`] is a private,
+//! in-process buffer; the C side is lock-free and safe to share between
+//! threads, so one handle can back any mix of producers and consumers.
+
+use std::os::raw::{c_int, c_void};
+use std::ptr::NonNull;
+
+use anyhow::{anyhow, Result};
+
+/// `RING_BUFFER_ERROR_FULL` and `RING_BUFFER_ERROR_BACKPRESSURE`
+const ERROR_FULL: c_int = -3;
+const ERROR_BACKPRESSURE: c_int = -7;
+
+/// Raw bindings to `ring_buffer.h`
+mod ffi {
+    use super::*;
+
+    /// `ring_buffer_t`, only ever used behind a pointer
+    #[repr(C)]
+    pub struct RingBufferT {
+        _private: [u8; 0],
+    }
+
+    /// `arrow_ipc_header_t`
+    #[repr(C, packed)]
+    #[derive(Debug, Clone, Copy, Default)]
+    pub struct ArrowIpcHeader {
+        pub magic: u32,
+        pub length: u32,
+        pub timestamp: u64,
+        pub checksum: u32,
+        pub reserved: u32,
+    }
+
+    /// `ring_buffer_message_t`
+    #[repr(C)]
+    #[derive(Debug, Clone, Copy)]
+    pub struct RingBufferMessage {
+        pub header: ArrowIpcHeader,
+        pub data: *const c_void,
+        pub data_size: usize,
+    }
+
+    /// `ring_buffer_segment_t`
+    #[repr(C)]
+    #[derive(Clone, Copy)]
+    pub struct RingBufferSegment {
+        pub data: *mut c_void,
+        pub size: usize,
+    }
+
+    /// `ring_buffer_span_t`
+    #[repr(C)]
+    pub struct RingBufferSpan {
+        pub segments: [RingBufferSegment; 2],
+        pub length: usize,
+        pub timestamp: u64,
+        pub start_pos: usize,
+        pub end_pos: usize,
+    }
+
+    extern "C" {
+        pub fn ring_buffer_create(size: usize) -> *mut RingBufferT;
+        pub fn ring_buffer_destroy(rb: *mut RingBufferT);
+        pub fn ring_buffer_write(rb: *mut RingBufferT, data: *const c_void, size: usize) -> c_int;
+        pub fn ring_buffer_write_batch(rb: *mut RingBufferT, iov: *const libc::iovec, count: usize) -> c_int;
+        pub fn ring_buffer_reserve(rb: *mut RingBufferT, size: usize, span: *mut RingBufferSpan) -> c_int;
+        pub fn ring_buffer_span_copy(span: *mut RingBufferSpan, offset: usize, data: *const c_void, size: usize) -> c_int;
+        pub fn ring_buffer_commit(rb: *mut RingBufferT, span: *mut RingBufferSpan) -> c_int;
+        pub fn ring_buffer_read(rb: *mut RingBufferT, msg: *mut RingBufferMessage) -> c_int;
+        pub fn ring_buffer_read_batch(rb: *mut RingBufferT, msgs: *mut RingBufferMessage, max: usize) -> c_int;
+        pub fn ring_buffer_available_read(rb: *const RingBufferT) -> usize;
+        pub fn ring_buffer_error_string(error: c_int) -> *const std::os::raw::c_char;
+    }
+}
+
+/// Scratch for [`NativeRingBuffer::read_batch`], reusable across calls
+pub struct ReadBatch {
+    msgs: Vec<ffi::RingBufferMessage>,
+}
+
+impl ReadBatch {
+    pub fn with_capacity(max: usize) -> Self {
+        let empty = ffi::RingBufferMessage {
+            header: ffi::ArrowIpcHeader::default(),
+            data: std::ptr::null(),
+            data_size: 0,
+        };
+        Self { msgs: vec![empty; max.max(1)] }
+    }
+}
+
+/// Outcome of a write the buffer refused
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum WriteRefused {
+    /// Full, or shedding writes under backpressure
+    Full,
+    /// Any other error code
+    Failed(i32),
+}
+
+/// Owned in-process ring buffer
+pub struct NativeRingBuffer {
+    ptr: NonNull<ffi::RingBufferT>,
+}
+
+// The C buffer is a lock-free MPMC queue; every entry point is thread-safe.
+unsafe impl Send for NativeRingBuffer {}
+unsafe impl Sync for NativeRingBuffer {}
+
+fn refused(code: c_int) -> std::result::Result<(), WriteRefused> {
+    match code {
+        0 => Ok(()),
+        ERROR_FULL | ERROR_BACKPRESSURE => Err(WriteRefused::Full),
+        code => Err(WriteRefused::Failed(code)),
+    }
+}
+
+impl NativeRingBuffer {
+    /// Create a buffer of at least `size` bytes
+    pub fn new(size: usize) -> Result<Self> {
+        let ptr = unsafe { ffi::ring_buffer_create(size) };
+        NonNull::new(ptr)
+            .map(|ptr| Self { ptr })
+            .ok_or_else(|| anyhow!("Failed to create a {} byte ring buffer", size))
+    }
+
+    /// Append one message
+    pub fn write(&self, data: &[u8]) -> std::result::Result<(), WriteRefused> {
+        refused(unsafe { ffi::ring_buffer_write(self.ptr.as_ptr(), data.as_ptr() as *const c_void, data.len()) })
+    }
+
+    /// Append every payload as its own message, with one reservation and commit
+    pub fn write_batch(&self, payloads: &[&[u8]]) -> std::result::Result<(), WriteRefused> {
+        let iov: Vec<libc::iovec> = payloads
+            .iter()
+            .map(|p| libc::iovec { iov_base: p.as_ptr() as *mut c_void, iov_len: p.len() })
+            .collect();
+        refused(unsafe { ffi::ring_buffer_write_batch(self.ptr.as_ptr(), iov.as_ptr(), iov.len()) })
+    }
+
+    /// Append one message by reserving space and copying into it in place
+    pub fn reserve_commit(&self, data: &[u8]) -> std::result::Result<(), WriteRefused> {
+        let mut span = std::mem::MaybeUninit::<ffi::RingBufferSpan>::uninit();
+        refused(unsafe { ffi::ring_buffer_reserve(self.ptr.as_ptr(), data.len(), span.as_mut_ptr()) })?;
+        let mut span = unsafe { span.assume_init() };
+        refused(unsafe { ffi::ring_buffer_span_copy(&mut span, 0, data.as_ptr() as *const c_void, data.len()) })?;
+        refused(unsafe { ffi::ring_buffer_commit(self.ptr.as_ptr(), &mut span) })
+    }
+
+    /// Consume one message, returning its payload size, or `None` if empty
+    pub fn read(&self) -> Option<usize> {
+        let mut msg = std::mem::MaybeUninit::<ffi::RingBufferMessage>::uninit();
+        let code = unsafe { ffi::ring_buffer_read(self.ptr.as_ptr(), msg.as_mut_ptr()) };
+        (code == 0).then(|| unsafe { msg.assume_init() }.data_size)
+    }
+
+    /// Consume up to the batch's capacity, returning messages and payload bytes
+    pub fn read_batch(&self, batch: &mut ReadBatch) -> (usize, usize) {
+        let count = unsafe { ffi::ring_buffer_read_batch(self.ptr.as_ptr(), batch.msgs.as_mut_ptr(), batch.msgs.len()) };
+        if count <= 0 {
+            return (0, 0);
+        }
+        let count = count as usize;
+        (count, batch.msgs[..count].iter().map(|m| m.data_size).sum())
+    }
+
+    /// Bytes published and not yet consumed
+    pub fn available_read(&self) -> usize {
+        unsafe { ffi::ring_buffer_available_read(self.ptr.as_ptr()) }
+    }
+
+    /// Consume everything, making room for writers that have no reader
+    pub fn drain(&self) {
+        let mut batch = ReadBatch::with_capacity(256);
+        while self.read_batch(&mut batch).0 > 0 {}
+    }
+}
+
+impl Drop for NativeRingBuffer {
+    fn drop(&mut self) {
+        unsafe { ffi::ring_buffer_destroy(self.ptr.as_ptr()) }
+    }
+}
+
+impl std::fmt::Display for WriteRefused {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            WriteRefused::Full => write!(f, "ring buffer full"),
+            WriteRefused::Failed(code) => {
+                let message = unsafe { std::ffi::CStr::from_ptr(ffi::ring_buffer_error_string(*code)) };
+                write!(f, "{}", message.to_string_lossy())
+            }
+        }
+    }
+}
+
+impl std::error::Error for WriteRefused {}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_round_trip_through_every_write_path() {
+        let rb = NativeRingBuffer::new(64 * 1024).unwrap();
+        let data = [7u8; 100];
+
+        rb.write(&data).unwrap();
+        rb.reserve_commit(&data).unwrap();
+        rb.write_batch(&[&data, &data[..10]]).unwrap();
+
+        let mut batch = ReadBatch::with_capacity(8);
+        assert_eq!(rb.read_batch(&mut batch), (4, 310));
+        assert_eq!(rb.read(), None);
+    }
+
+    #[test]
+    fn test_write_refused_when_full() {
+        let rb = NativeRingBuffer::new(4096).unwrap();
+        let data = [0u8; 1024];
+        let mut refusal = None;
+        for _ in 0..16 {
+            if let Err(e) = rb.write(&data) {
+                refusal = Some(e);
+                break;
+            }
+        }
+        assert_eq!(refusal, Some(WriteRefused::Full));
+
+        rb.drain();
+        assert_eq!(rb.available_read(), 0);
+        rb.write(&data).unwrap();
+    }
+}
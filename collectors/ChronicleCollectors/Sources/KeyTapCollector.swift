@@ -38,7 +38,8 @@ public class KeyTapCollector: CollectorBase {
             displayName: "Keyboard Events",
             eventTypes: [.keyTap],
             configuration: configuration,
-            ringBufferWriter: ringBufferWriter
+            ringBufferWriter: ringBufferWriter,
+            batching: .default
         )
     }
     
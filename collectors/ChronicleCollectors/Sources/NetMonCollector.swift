@@ -39,7 +39,8 @@ public class NetMonCollector: CollectorBase {
             displayName: "Network Monitor",
             eventTypes: [.networkActivity],
             configuration: configuration,
-            ringBufferWriter: ringBufferWriter
+            ringBufferWriter: ringBufferWriter,
+            batching: .default
         )
     }
     
@@ -54,7 +54,8 @@ public class PointerMonCollector: CollectorBase {
             displayName: "Pointer Monitor",
             eventTypes: [.pointerMove, .pointerClick],
             configuration: configuration,
-            ringBufferWriter: ringBufferWriter
+            ringBufferWriter: ringBufferWriter,
+            batching: .default
         )
     }
     
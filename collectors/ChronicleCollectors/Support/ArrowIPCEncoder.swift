@@ -0,0 +1,541 @@
+//
+//  ArrowIPCEncoder.swift
+//  ChronicleCollectors
+//
+//  Created by Chronicle on 2024-01-01.
+//  Copyright © 2024 Chronicle. All rights reserved.
+//
+
+import Foundation
+
+/// Arrow column types produced by the collectors
+public enum ArrowColumnType {
+    case uint64
+    case utf8
+    case dictionaryUtf8     // Int32 indices into a per-batch string dictionary
+}
+
+/// Arrow schema field
+public struct ArrowField {
+    public let name: String
+    public let type: ArrowColumnType
+    public let nullable: Bool
+    
+    public init(name: String, type: ArrowColumnType, nullable: Bool = false) {
+        self.name = name
+        self.type = type
+        self.nullable = nullable
+    }
+}
+
+/// Column under construction, kept in its Arrow IPC buffer layout
+///
+/// Appending never re-encodes earlier rows, and `removeAll()` keeps the
+/// storage so a column can be refilled without allocating. Dictionary
+/// columns store each distinct string once per batch, which is what makes
+/// repeated values such as bundle identifiers cheap.
+public struct ArrowColumn {
+    public let field: ArrowField
+    public private(set) var count = 0
+    public private(set) var nullCount = 0
+    
+    private var validity: [UInt8] = []      // Empty until the first null
+    private var values: [UInt8] = []        // Fixed-width values, UTF-8 data or dictionary indices
+    private var offsets: [Int32] = [0]      // Utf8 only
+    
+    // Dictionary columns only
+    private var dictionaryIndex: [String: Int32] = [:]
+    private var dictionaryValues: [UInt8] = []
+    private var dictionaryOffsets: [Int32] = [0]
+    
+    /// Distinct strings in a dictionary column
+    public var dictionaryCount: Int {
+        return dictionaryOffsets.count - 1
+    }
+    
+    /// Bytes held in the column's buffers
+    public var byteCount: Int {
+        return validity.count + values.count + 4 * offsets.count + dictionaryValues.count + 4 * dictionaryOffsets.count
+    }
+    
+    public init(field: ArrowField) {
+        self.field = field
+    }
+    
+    public mutating func append(_ value: UInt64) {
+        withUnsafeBytes(of: value.littleEndian) { values.append(contentsOf: $0) }
+        appendValidity(true)
+    }
+    
+    public mutating func append(_ value: String?) {
+        guard var value = value else {
+            appendNull()
+            return
+        }
+        
+        if field.type == .dictionaryUtf8 {
+            let index: Int32
+            if let existing = dictionaryIndex[value] {
+                index = existing
+            } else {
+                index = Int32(dictionaryCount)
+                dictionaryIndex[value] = index
+                value.withUTF8 { dictionaryValues.append(contentsOf: $0) }
+                dictionaryOffsets.append(Int32(dictionaryValues.count))
+            }
+            withUnsafeBytes(of: index.littleEndian) { values.append(contentsOf: $0) }
+        } else {
+            value.withUTF8 { values.append(contentsOf: $0) }
+            offsets.append(Int32(values.count))
+        }
+        appendValidity(true)
+    }
+    
+    /// Append UTF-8 bytes that are already encoded, such as JSON event data
+    public mutating func append(utf8 value: Data) {
+        precondition(field.type == .utf8, "append(utf8:) needs a plain utf8 column")
+        values.append(contentsOf: value)
+        offsets.append(Int32(values.count))
+        appendValidity(true)
+    }
+    
+    public mutating func appendNull() {
+        switch field.type {
+        case .uint64:
+            values.append(contentsOf: repeatElement(0, count: 8))
+        case .utf8:
+            offsets.append(Int32(values.count))
+        case .dictionaryUtf8:
+            values.append(contentsOf: repeatElement(0, count: 4))
+        }
+        appendValidity(false)
+    }
+    
+    public mutating func removeAll() {
+        count = 0
+        nullCount = 0
+        validity.removeAll(keepingCapacity: true)
+        values.removeAll(keepingCapacity: true)
+        offsets.removeAll(keepingCapacity: true)
+        offsets.append(0)
+        dictionaryIndex.removeAll(keepingCapacity: true)
+        dictionaryValues.removeAll(keepingCapacity: true)
+        dictionaryOffsets.removeAll(keepingCapacity: true)
+        dictionaryOffsets.append(0)
+    }
+    
+    /// Buffers in IPC order: validity, then values or offsets and data
+    func forEachBuffer(_ body: (UnsafeRawBufferPointer) throws -> Void) rethrows {
+        try validity.withUnsafeBytes(body)
+        switch field.type {
+        case .uint64, .dictionaryUtf8:
+            try values.withUnsafeBytes(body)
+        case .utf8:
+            try offsets.withUnsafeBytes(body)
+            try values.withUnsafeBytes(body)
+        }
+    }
+    
+    /// Buffers of the dictionary's utf8 values: no validity, offsets, data
+    func forEachDictionaryBuffer(_ body: (UnsafeRawBufferPointer) throws -> Void) rethrows {
+        try body(UnsafeRawBufferPointer(start: nil, count: 0))
+        try dictionaryOffsets.withUnsafeBytes(body)
+        try dictionaryValues.withUnsafeBytes(body)
+    }
+    
+    private mutating func appendValidity(_ valid: Bool) {
+        if !valid && nullCount == 0 {
+            // First null: materialize the bitmap for the rows so far
+            validity = [UInt8](repeating: 0xFF, count: (count + 7) / 8)
+            if count % 8 != 0 {
+                validity[validity.count - 1] = UInt8((1 << (count % 8)) - 1)
+            }
+        }
+        
+        if nullCount > 0 || !valid {
+            if count % 8 == 0 {
+                validity.append(0)
+            }
+            if valid {
+                validity[count / 8] |= UInt8(1 << (count % 8))
+            }
+        }
+        
+        if !valid {
+            nullCount += 1
+        }
+        count += 1
+    }
+}
+
+/// Destination for encoded bytes
+public protocol ArrowIPCSink {
+    mutating func write(_ bytes: UnsafeRawBufferPointer) throws
+}
+
+/// Record batch whose metadata has been encoded, ready to be written
+public struct ArrowPreparedBatch {
+    fileprivate let dictionaryMetadata: [UInt8]    // One DictionaryBatch message per dictionary column
+    fileprivate let metadata: [UInt8]
+    
+    /// Record batch body bytes following the metadata
+    public let bodyLength: Int
+    
+    /// Total stream bytes: schema, dictionaries, record batch and end-of-stream marker
+    public let streamLength: Int
+}
+
+/// Encoder for self-contained Arrow IPC streams
+///
+/// Every encoded message is a complete stream (schema, the dictionaries,
+/// one record batch, end-of-stream marker), which is what the packer
+/// decodes from each ring buffer message. The schema message is encoded
+/// once per encoder; only the small batch headers are built per batch, and
+/// column data is written to the sink straight from the column buffers.
+public struct ArrowIPCEncoder {
+    public let fields: [ArrowField]
+    private let schemaMessage: [UInt8]
+    
+    private static let padding = [UInt8](repeating: 0, count: 8)
+    private static let endOfStream: [UInt8] = [0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0]
+    
+    public init(fields: [ArrowField]) {
+        self.fields = fields
+        self.schemaMessage = ArrowIPCEncoder.encapsulate(ArrowIPCEncoder.schemaFlatBuffer(fields))
+    }
+    
+    /// Empty columns matching the schema
+    public func makeColumns() -> [ArrowColumn] {
+        return fields.map { ArrowColumn(field: $0) }
+    }
+    
+    /// Encode the record batch header for columns that all hold the same number of rows
+    public func prepare(_ columns: [ArrowColumn]) -> ArrowPreparedBatch {
+        // Dictionaries are sent in full with every batch, keyed by field index
+        var dictionaryMetadata = [UInt8]()
+        var dictionaryLength = 0
+        for (index, column) in columns.enumerated() where column.field.type == .dictionaryUtf8 {
+            var buffers: [(offset: Int64, length: Int64)] = []
+            var bodyLength = 0
+            column.forEachDictionaryBuffer { bytes in
+                buffers.append((Int64(bodyLength), Int64(bytes.count)))
+                bodyLength += ArrowIPCEncoder.padded(bytes.count)
+            }
+            
+            let node = (length: Int64(column.dictionaryCount), nullCount: Int64(0))
+            dictionaryMetadata += ArrowIPCEncoder.encapsulate(
+                ArrowIPCEncoder.dictionaryBatchFlatBuffer(id: Int64(index), node: node, buffers: buffers, bodyLength: Int64(bodyLength))
+            )
+            dictionaryLength += bodyLength
+        }
+        
+        var nodes: [(length: Int64, nullCount: Int64)] = []
+        var buffers: [(offset: Int64, length: Int64)] = []
+        var bodyLength = 0
+        
+        for column in columns {
+            nodes.append((Int64(column.count), Int64(column.nullCount)))
+            column.forEachBuffer { bytes in
+                buffers.append((Int64(bodyLength), Int64(bytes.count)))
+                bodyLength += ArrowIPCEncoder.padded(bytes.count)
+            }
+        }
+        
+        let rows = Int64(columns.first?.count ?? 0)
+        let metadata = ArrowIPCEncoder.encapsulate(
+            ArrowIPCEncoder.recordBatchFlatBuffer(rows: rows, nodes: nodes, buffers: buffers, bodyLength: Int64(bodyLength))
+        )
+        
+        return ArrowPreparedBatch(
+            dictionaryMetadata: dictionaryMetadata,
+            metadata: metadata,
+            bodyLength: bodyLength,
+            streamLength: schemaMessage.count + dictionaryMetadata.count + dictionaryLength +
+                metadata.count + bodyLength + ArrowIPCEncoder.endOfStream.count
+        )
+    }
+    
+    /// Write the stream for a prepared batch; exactly `batch.streamLength` bytes
+    public func write<Sink: ArrowIPCSink>(_ batch: ArrowPreparedBatch, columns: [ArrowColumn], into sink: inout Sink) throws {
+        try schemaMessage.withUnsafeBytes { try sink.write($0) }
+        
+        // Each dictionary message is followed by its body
+        var dictionaryMetadata = batch.dictionaryMetadata[...]
+        for column in columns where column.field.type == .dictionaryUtf8 {
+            let length = 8 + Int(ArrowIPCEncoder.readInt32(dictionaryMetadata, at: dictionaryMetadata.startIndex + 4))
+            try dictionaryMetadata.prefix(length).withUnsafeBytes { try sink.write($0) }
+            dictionaryMetadata = dictionaryMetadata.dropFirst(length)
+            
+            try column.forEachDictionaryBuffer { try ArrowIPCEncoder.writePadded($0, into: &sink) }
+        }
+        
+        try batch.metadata.withUnsafeBytes { try sink.write($0) }
+        for column in columns {
+            try column.forEachBuffer { try ArrowIPCEncoder.writePadded($0, into: &sink) }
+        }
+        
+        try ArrowIPCEncoder.endOfStream.withUnsafeBytes { try sink.write($0) }
+    }
+    
+    // MARK: - Private Methods
+    
+    private static func writePadded<Sink: ArrowIPCSink>(_ bytes: UnsafeRawBufferPointer, into sink: inout Sink) throws {
+        try sink.write(bytes)
+        let pad = padded(bytes.count) - bytes.count
+        if pad > 0 {
+            try padding.withUnsafeBytes { try sink.write(UnsafeRawBufferPointer(rebasing: $0[0..<pad])) }
+        }
+    }
+    
+    private static func readInt32(_ bytes: ArraySlice<UInt8>, at index: Int) -> Int32 {
+        return Int32(bitPattern: UInt32(bytes[index]) | UInt32(bytes[index + 1]) << 8 |
+                                 UInt32(bytes[index + 2]) << 16 | UInt32(bytes[index + 3]) << 24)
+    }
+    
+    private static func padded(_ length: Int) -> Int {
+        return (length + 7) & ~7
+    }
+    
+    /// Frame a flatbuffer as an IPC message: continuation marker, length, padded metadata
+    private static func encapsulate(_ flatBuffer: [UInt8]) -> [UInt8] {
+        let metadataLength = padded(8 + flatBuffer.count) - 8
+        
+        var message = [UInt8]()
+        message.reserveCapacity(8 + metadataLength)
+        withUnsafeBytes(of: UInt32(0xFFFF_FFFF).littleEndian) { message.append(contentsOf: $0) }
+        withUnsafeBytes(of: Int32(metadataLength).littleEndian) { message.append(contentsOf: $0) }
+        message.append(contentsOf: flatBuffer)
+        message.append(contentsOf: repeatElement(0, count: metadataLength - flatBuffer.count))
+        return message
+    }
+    
+    // Schema.fbs / Message.fbs constants
+    private static let metadataVersionV5: Int16 = 4
+    private static let headerSchema: UInt8 = 1
+    private static let headerDictionaryBatch: UInt8 = 2
+    private static let headerRecordBatch: UInt8 = 3
+    private static let typeInt: UInt8 = 2
+    private static let typeUtf8: UInt8 = 5
+    
+    private static func schemaFlatBuffer(_ fields: [ArrowField]) -> [UInt8] {
+        var fb = FlatBufferWriter()
+        
+        let message = fb.table([.int16(metadataVersionV5), .uint8(headerSchema), .offset, .int64(0)])
+        fb.setRoot(message.table)
+        
+        let schema = fb.table([.int16(0), .offset])
+        fb.point(message.fields[2], to: schema.table)
+        
+        let fieldVector = fb.vector(count: fields.count, elementSize: 4, alignment: 4)
+        fb.point(schema.fields[1], to: fieldVector)
+        
+        for (index, field) in fields.enumerated() {
+            // A dictionary field has its value type plus a DictionaryEncoding
+            let isDictionary = field.type == .dictionaryUtf8
+            let typeType = field.type == .uint64 ? typeInt : typeUtf8
+            let table = fb.table([.offset, .bool(field.nullable), .uint8(typeType), .offset, isDictionary ? .offset : .none, .offset])
+            fb.point(fb.vectorElement(fieldVector, index, elementSize: 4), to: table.table)
+            
+            fb.point(table.fields[0], to: fb.string(field.name))
+            
+            let type: Int
+            switch field.type {
+            case .uint64:
+                type = fb.table([.int32(64), .bool(false)]).table
+            case .utf8, .dictionaryUtf8:
+                type = fb.table([]).table
+            }
+            fb.point(table.fields[3], to: type)
+            
+            if isDictionary {
+                let encoding = fb.table([.int64(Int64(index)), .offset, .bool(false)])
+                fb.point(table.fields[4], to: encoding.table)
+                fb.point(encoding.fields[1], to: fb.table([.int32(32), .bool(true)]).table)
+            }
+            
+            fb.point(table.fields[5], to: fb.vector(count: 0, elementSize: 4, alignment: 4))
+        }
+        
+        return fb.bytes
+    }
+    
+    private static func recordBatchFlatBuffer(rows: Int64,
+                                              nodes: [(length: Int64, nullCount: Int64)],
+                                              buffers: [(offset: Int64, length: Int64)],
+                                              bodyLength: Int64) -> [UInt8] {
+        var fb = FlatBufferWriter()
+        
+        let message = fb.table([.int16(metadataVersionV5), .uint8(headerRecordBatch), .offset, .int64(bodyLength)])
+        fb.setRoot(message.table)
+        fb.point(message.fields[2], to: recordBatchTable(&fb, rows: rows, nodes: nodes, buffers: buffers))
+        
+        return fb.bytes
+    }
+    
+    private static func dictionaryBatchFlatBuffer(id: Int64,
+                                                  node: (length: Int64, nullCount: Int64),
+                                                  buffers: [(offset: Int64, length: Int64)],
+                                                  bodyLength: Int64) -> [UInt8] {
+        var fb = FlatBufferWriter()
+        
+        let message = fb.table([.int16(metadataVersionV5), .uint8(headerDictionaryBatch), .offset, .int64(bodyLength)])
+        fb.setRoot(message.table)
+        
+        let dictionary = fb.table([.int64(id), .offset, .bool(false)])
+        fb.point(message.fields[2], to: dictionary.table)
+        fb.point(dictionary.fields[1], to: recordBatchTable(&fb, rows: node.length, nodes: [node], buffers: buffers))
+        
+        return fb.bytes
+    }
+    
+    private static func recordBatchTable(_ fb: inout FlatBufferWriter,
+                                         rows: Int64,
+                                         nodes: [(length: Int64, nullCount: Int64)],
+                                         buffers: [(offset: Int64, length: Int64)]) -> Int {
+        let batch = fb.table([.int64(rows), .offset, .offset])
+        
+        // FieldNode and Buffer are both structs of two longs
+        let nodeVector = fb.vector(count: nodes.count, elementSize: 16, alignment: 8)
+        fb.point(batch.fields[1], to: nodeVector)
+        for (index, node) in nodes.enumerated() {
+            let element = fb.vectorElement(nodeVector, index, elementSize: 16)
+            fb.patch(node.length, at: element)
+            fb.patch(node.nullCount, at: element + 8)
+        }
+        
+        let bufferVector = fb.vector(count: buffers.count, elementSize: 16, alignment: 8)
+        fb.point(batch.fields[2], to: bufferVector)
+        for (index, buffer) in buffers.enumerated() {
+            let element = fb.vectorElement(bufferVector, index, elementSize: 16)
+            fb.patch(buffer.offset, at: element)
+            fb.patch(buffer.length, at: element + 8)
+        }
+        
+        return batch.table
+    }
+}
+
+/// Minimal FlatBuffers writer for the Arrow metadata messages
+///
+/// Objects are written front to back: a table is laid out before the
+/// objects it references, and its offset fields are pointed at them once
+/// they have been written, which keeps every uoffset positive as the
+/// format requires.
+struct FlatBufferWriter {
+    enum Slot {
+        case none
+        case bool(Bool)
+        case uint8(UInt8)
+        case int16(Int16)
+        case int32(Int32)
+        case int64(Int64)
+        case offset     // uoffset_t, set later with point(_:to:)
+        
+        var size: Int {
+            switch self {
+            case .none: return 0
+            case .bool, .uint8: return 1
+            case .int16: return 2
+            case .int32, .offset: return 4
+            case .int64: return 8
+            }
+        }
+    }
+    
+    private(set) var bytes: [UInt8] = [0, 0, 0, 0]     // Root uoffset
+    
+    mutating func setRoot(_ table: Int) {
+        point(0, to: table)
+    }
+    
+    /// Write a table and its vtable; returns the table and field positions
+    mutating func table(_ slots: [Slot]) -> (table: Int, fields: [Int]) {
+        // Lay out fields largest first after the soffset so none needs padding
+        var inline = [Int](repeating: 0, count: slots.count)
+        var tableSize = 4
+        for size in [8, 4, 2, 1] {
+            for (index, slot) in slots.enumerated() where slot.size == size {
+                inline[index] = tableSize
+                tableSize += size
+            }
+        }
+        
+        align(2)
+        let vtable = bytes.count
+        append(UInt16(4 + 2 * slots.count))
+        append(UInt16(tableSize))
+        for offset in inline {
+            append(UInt16(offset))
+        }
+        
+        // 8-byte fields start right after the 4-byte soffset
+        if slots.contains(where: { $0.size == 8 }) {
+            align(8, after: 4)
+        } else {
+            align(4)
+        }
+        let table = bytes.count
+        append(Int32(table - vtable))
+        bytes.append(contentsOf: repeatElement(0, count: tableSize - 4))
+        
+        var fields = [Int](repeating: 0, count: slots.count)
+        for (index, slot) in slots.enumerated() where slot.size > 0 {
+            let position = table + inline[index]
+            fields[index] = position
+            switch slot {
+            case .bool(let value): patch(UInt8(value ? 1 : 0), at: position)
+            case .uint8(let value): patch(value, at: position)
+            case .int16(let value): patch(value, at: position)
+            case .int32(let value): patch(value, at: position)
+            case .int64(let value): patch(value, at: position)
+            case .offset, .none: break
+            }
+        }
+        
+        return (table, fields)
+    }
+    
+    /// Write a zeroed vector; returns its position (the length field)
+    mutating func vector(count: Int, elementSize: Int, alignment: Int) -> Int {
+        align(max(alignment, 4), after: 4)
+        let vector = bytes.count
+        append(UInt32(count))
+        bytes.append(contentsOf: repeatElement(0, count: count * elementSize))
+        return vector
+    }
+    
+    func vectorElement(_ vector: Int, _ index: Int, elementSize: Int) -> Int {
+        return vector + 4 + index * elementSize
+    }
+    
+    mutating func string(_ value: String) -> Int {
+        align(4)
+        let string = bytes.count
+        let utf8 = Array(value.utf8)
+        append(UInt32(utf8.count))
+        bytes.append(contentsOf: utf8)
+        bytes.append(0)
+        return string
+    }
+    
+    /// Set the uoffset at `field` to reference `target`
+    mutating func point(_ field: Int, to target: Int) {
+        patch(UInt32(target - field), at: field)
+    }
+    
+    mutating func patch<T: FixedWidthInteger>(_ value: T, at position: Int) {
+        withUnsafeBytes(of: value.littleEndian) { raw in
+            bytes.replaceSubrange(position..<position + raw.count, with: raw)
+        }
+    }
+    
+    private mutating func append<T: FixedWidthInteger>(_ value: T) {
+        withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+    }
+    
+    private mutating func align(_ alignment: Int, after extra: Int = 0) {
+        while (bytes.count + extra) % alignment != 0 {
+            bytes.append(0)
+        }
+    }
+}
@@ -120,6 +120,8 @@ open class CollectorBase: CollectorProtocol {
     // Internal state
     private let logger: Logger
     private let ringBufferWriter: PerformantRingBufferWriter
+    private let producer: RingBufferProducer?   // Used on `queue` only
+    private let batchProducer: RingBufferBatchProducer?     // Used on `queue` only; nil writes events one by one
     private let queue: DispatchQueue
     private let statisticsQueue: DispatchQueue
     private var startTime: TimeInterval = 0
@@ -138,17 +140,26 @@ open class CollectorBase: CollectorProtocol {
                 displayName: String,
                 eventTypes: [ChronicleEventType],
                 configuration: CollectorConfiguration = .default,
-                ringBufferWriter: PerformantRingBufferWriter) {
+                ringBufferWriter: PerformantRingBufferWriter,
+                batching: RingBufferBatchPolicy? = nil) {
+        let queue = DispatchQueue(label: "com.chronicle.collector.\(identifier)", qos: .utility)
+        
         self.identifier = identifier
         self.displayName = displayName
         self.eventTypes = eventTypes
         self.configuration = configuration
         self.ringBufferWriter = ringBufferWriter
+        self.producer = ringBufferWriter.makeProducer()
+        self.batchProducer = batching.flatMap { ringBufferWriter.makeBatchProducer(policy: $0, queue: queue) }
         self.logger = Logger(subsystem: "com.chronicle.collectors", category: identifier)
-        self.queue = DispatchQueue(label: "com.chronicle.collector.\(identifier)", qos: .utility)
+        self.queue = queue
         self.statisticsQueue = DispatchQueue(label: "com.chronicle.collector.\(identifier).stats", qos: .utility)
         self.performanceMonitor = PerformanceMonitor(identifier: identifier)
         
+        batchProducer?.onFlush = { [weak self] events, result in
+            self?.recordFlush(events: events, result: result)
+        }
+        
         logger.info("Collector \(displayName) initialized")
     }
     
@@ -213,6 +224,11 @@ open class CollectorBase: CollectorProtocol {
             // Stop the collector
             try stopCollector()
             
+            // Write out events still waiting for their batch deadline
+            queue.sync {
+                batchProducer?.flush()
+            }
+            
             setState(.stopped)
             logger.info("Collector \(displayName) stopped successfully")
         } catch {
@@ -298,24 +314,37 @@ open class CollectorBase: CollectorProtocol {
         queue.async { [weak self] in
             guard let self = self else { return }
             
+            guard let producer = self.producer else {
+                self.incrementDroppedEvents()
+                return
+            }
+            
+            // Check event size
+            guard event.data.count <= self.configuration.maxEventSize else {
+                self.incrementDroppedEvents()
+                self.logger.warning("Event too large, dropping: \(event.data.count) bytes")
+                return
+            }
+            
+            // Batched events are counted when their batch is written
+            if let batchProducer = self.batchProducer {
+                batchProducer.append(event)
+                self.updateLastActivityTime()
+                return
+            }
+            
             do {
-                // Check event size
-                let eventData = try JSONEncoder().encode(event)
-                guard eventData.count <= self.configuration.maxEventSize else {
-                    self.incrementDroppedEvents()
-                    self.logger.warning("Event too large, dropping: \(eventData.count) bytes")
-                    return
-                }
-                
-                // Write to ring buffer
-                self.ringBufferWriter.writeAsync(event)
+                // Encode straight into the ring buffer from this collector's queue
+                let size = try producer.write(event)
                 
                 // Update statistics
                 self.incrementCollectedEvents()
-                self.addEventSize(Int64(eventData.count))
+                self.addEventSize(Int64(size))
                 self.updateLastActivityTime()
                 
                 self.logger.debug("Emitted event \(event.id) of type \(event.type)")
+            } catch ChronicleCollectorError.backpressure {
+                self.incrementDroppedEvents()
             } catch {
                 self.incrementErrorCount()
                 self.logger.error("Failed to emit event: \(error)")
@@ -334,6 +363,21 @@ open class CollectorBase: CollectorProtocol {
     
     // MARK: - Private Methods
     
+    private func recordFlush(events: Int, result: Result<Int, Error>) {
+        switch result {
+        case .success(let size):
+            incrementCollectedEvents(by: Int64(events))
+            addEventSize(Int64(size))
+            logger.debug("Emitted batch of \(events) events (\(size) bytes)")
+        case .failure(ChronicleCollectorError.backpressure):
+            incrementDroppedEvents(by: Int64(events))
+        case .failure(let error):
+            incrementErrorCount()
+            incrementDroppedEvents(by: Int64(events))
+            logger.error("Failed to emit batch of \(events) events: \(error)")
+        }
+    }
+    
     private func setState(_ newState: CollectorState) {
         state = newState
         logger.debug("Collector \(identifier) state changed to \(newState.rawValue)")
@@ -367,15 +411,15 @@ open class CollectorBase: CollectorProtocol {
         lastActivityTime = Date().timeIntervalSince1970
     }
     
-    private func incrementCollectedEvents() {
+    private func incrementCollectedEvents(by count: Int64 = 1) {
         statisticsQueue.async {
-            OSAtomicIncrement64(&self.eventsCollected)
+            OSAtomicAdd64(count, &self.eventsCollected)
         }
     }
     
-    private func incrementDroppedEvents() {
+    private func incrementDroppedEvents(by count: Int64 = 1) {
         statisticsQueue.async {
-            OSAtomicIncrement64(&self.eventsDropped)
+            OSAtomicAdd64(count, &self.eventsDropped)
         }
     }
     
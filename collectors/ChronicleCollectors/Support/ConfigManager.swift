@@ -381,6 +381,12 @@ extension ChronicleConfig {
             throw ChronicleCollectorError.configurationError("Max event size cannot exceed ring buffer size")
         }
         
+        if ringBuffer.elastic {
+            guard ringBuffer.initialSize > 0 && ringBuffer.initialSize <= ringBuffer.bufferSize else {
+                throw ChronicleCollectorError.configurationError("Ring buffer initial size must be between 1 and the ring buffer size")
+            }
+        }
+        
         // Validate performance configuration
         guard performance.maxCpuUsage > 0 && performance.maxCpuUsage <= 100 else {
             throw ChronicleCollectorError.configurationError("Max CPU usage must be between 0 and 100")
@@ -347,6 +347,7 @@ public enum ChronicleCollectorError: Error, CustomStringConvertible {
     case collectorNotStarted(String)
     case collectorAlreadyStarted(String)
     case ringBufferWriteError(String)
+    case backpressure(String)
     case systemError(String)
     case configurationError(String)
     case serializationError(String)
@@ -361,6 +362,8 @@ public enum ChronicleCollectorError: Error, CustomStringConvertible {
             return "Collector already started: \(message)"
         case .ringBufferWriteError(let message):
             return "Ring buffer write error: \(message)"
+        case .backpressure(let message):
+            return "Ring buffer backpressure: \(message)"
         case .systemError(let message):
             return "System error: \(message)"
         case .configurationError(let message):
@@ -0,0 +1,124 @@
+//
+//  RingBufferBatchProducer.swift
+//  ChronicleCollectors
+//
+//  Created by Chronicle on 2024-01-01.
+//  Copyright © 2024 Chronicle. All rights reserved.
+//
+
+import Foundation
+import CRingBuffer
+
+/// When a batching producer writes out the events it has coalesced
+public struct RingBufferBatchPolicy {
+    /// Rows per record batch
+    public let maxRows: Int
+    
+    /// Column bytes per record batch, well under the ring buffer's message limit
+    public let maxBytes: Int
+    
+    /// Longest an event waits before its batch is written
+    public let maxLatency: TimeInterval
+    
+    public init(maxRows: Int = 512,
+                maxBytes: Int = 256 * 1024,
+                maxLatency: TimeInterval = 0.25) {
+        self.maxRows = maxRows
+        self.maxBytes = maxBytes
+        self.maxLatency = maxLatency
+    }
+    
+    public static let `default` = RingBufferBatchPolicy()
+}
+
+/// Producer that coalesces a collector's events into Arrow record batches
+///
+/// High-rate collectors would otherwise pay the ring buffer's message
+/// header, checksum and timestamp for every pointer move or key tap. Rows
+/// are appended to columns owned by the producer, with repeated strings
+/// dictionary-encoded, and each batch is written as one IPC message once
+/// it reaches the policy's size or its oldest event reaches the latency
+/// deadline. A batch is written at the highest priority of its events and
+/// stamped with the time of its first.
+///
+/// The producer is confined to the serial queue it was created with:
+/// call `append` and `flush` on it only, and deadlines run there too.
+public final class RingBufferBatchProducer {
+    /// Outcome of a flush: events in the batch and the bytes written or the error
+    public typealias FlushHandler = (_ events: Int, _ result: Result<Int, Error>) -> Void
+    
+    private let writer: RingBufferWriter
+    private let policy: RingBufferBatchPolicy
+    private let queue: DispatchQueue
+    private var columns: [ArrowColumn]
+    private var priority = RING_BUFFER_PRIORITY_LOW
+    private var firstTimestamp: TimeInterval = 0  // Header stamp of the pending batch
+    private var generation = 0      // Bumped per flush so stale deadlines are ignored
+    
+    /// Called on the producer's queue after every flush
+    public var onFlush: FlushHandler?
+    
+    /// Events appended and not yet written
+    public var pendingCount: Int {
+        return columns[0].count
+    }
+    
+    init(writer: RingBufferWriter, policy: RingBufferBatchPolicy, queue: DispatchQueue) {
+        self.writer = writer
+        self.policy = policy
+        self.queue = queue
+        self.columns = writer.batchEncoder.makeColumns()
+    }
+    
+    /// Add an event to the current batch, writing the batch out if it is full
+    public func append(_ event: ChronicleEvent) {
+        if pendingCount == 0 {
+            firstTimestamp = event.timestamp
+        }
+        ChronicleEventSchema.append(event, sessionId: writer.sessionId, to: &columns)
+        
+        let eventPriority = ChronicleEventSchema.priority(of: event.type)
+        if eventPriority.rawValue > priority.rawValue {
+            priority = eventPriority
+        }
+        
+        if pendingCount >= policy.maxRows || columns.reduce(0, { $0 + $1.byteCount }) >= policy.maxBytes {
+            flush()
+        } else if pendingCount == 1 {
+            scheduleDeadline()
+        }
+    }
+    
+    /// Write the pending events as one record batch
+    public func flush() {
+        let events = pendingCount
+        guard events > 0 else { return }
+        
+        let result: Result<Int, Error>
+        do {
+            result = .success(try writer.enqueue(columns, encoder: writer.batchEncoder,
+                                                priority: priority, timestamp: firstTimestamp))
+        } catch {
+            result = .failure(error)
+        }
+        
+        // A failed batch is dropped rather than retried so the collector never stalls
+        for index in columns.indices {
+            columns[index].removeAll()
+        }
+        priority = RING_BUFFER_PRIORITY_LOW
+        generation &+= 1
+        
+        onFlush?(events, result)
+    }
+    
+    // MARK: - Private Methods
+    
+    private func scheduleDeadline() {
+        let scheduled = generation
+        queue.asyncAfter(deadline: .now() + policy.maxLatency) { [weak self] in
+            guard let self = self, self.generation == scheduled else { return }
+            self.flush()
+        }
+    }
+}
@@ -8,220 +8,279 @@
 
 import Foundation
 import os.log
+import CRingBuffer
 
-/// C ring buffer interface
-private struct RingBuffer {
-    var buffer: UnsafeMutableRawPointer
-    var size: Int
-    var head: Int
-    var tail: Int
-    var count: Int
-    var mutex: pthread_mutex_t
+/// Arrow schema of the events written to the ring buffer; matches the packer's Parquet schema
+public enum ChronicleEventSchema {
+    public static let fields = [
+        ArrowField(name: "timestamp_ns", type: .uint64),
+        ArrowField(name: "event_type", type: .utf8),
+        ArrowField(name: "app_bundle_id", type: .utf8, nullable: true),
+        ArrowField(name: "window_title", type: .utf8, nullable: true),
+        ArrowField(name: "data", type: .utf8),
+        ArrowField(name: "session_id", type: .utf8),
+        ArrowField(name: "event_id", type: .utf8)
+    ]
+    
+    /// Same schema with the strings that repeat across a batch dictionary-encoded
+    public static let batchFields = [
+        ArrowField(name: "timestamp_ns", type: .uint64),
+        ArrowField(name: "event_type", type: .dictionaryUtf8),
+        ArrowField(name: "app_bundle_id", type: .dictionaryUtf8, nullable: true),
+        ArrowField(name: "window_title", type: .dictionaryUtf8, nullable: true),
+        ArrowField(name: "data", type: .utf8),
+        ArrowField(name: "session_id", type: .dictionaryUtf8),
+        ArrowField(name: "event_id", type: .utf8)
+    ]
+    
+    /// Append one event as a row of `columns`, which must follow `fields`
+    static func append(_ event: ChronicleEvent, sessionId: String, to columns: inout [ArrowColumn]) {
+        columns[0].append(UInt64(event.timestamp * 1_000_000_000))
+        columns[1].append(event.type.rawValue)
+        columns[2].append(event.metadata["bundle_identifier"])
+        columns[3].append(event.metadata["window_title"])
+        columns[4].append(utf8: event.data)
+        columns[5].append(sessionId)
+        columns[6].append(event.id.uuidString)
+    }
+    
+    /// Large, repetitive payloads worth compressing before they enter the ring
+    static func isBulk(_ type: ChronicleEventType) -> Bool {
+        return type == .screenCapture || type == .clipboardChange
+    }
+    
+    /// Screen frames are shed first under backpressure; input and focus events last
+    static func priority(of type: ChronicleEventType) -> ring_buffer_priority_t {
+        switch type {
+        case .screenCapture:
+            return RING_BUFFER_PRIORITY_LOW
+        case .keyTap, .windowFocus:
+            return RING_BUFFER_PRIORITY_HIGH
+        default:
+            return RING_BUFFER_PRIORITY_NORMAL
+        }
+    }
 }
 
-/// Ring buffer writer for Chronicle events
+/// Shared connection to the C ring buffer the packer drains
+///
+/// The buffer is lock-free for any number of producers, so the writer
+/// itself holds no lock: each collector gets its own `RingBufferProducer`
+/// and writes through it without coordinating with the others.
 public class RingBufferWriter {
     private let logger = Logger(subsystem: "com.chronicle.collectors", category: "RingBufferWriter")
-    private var ringBuffer: UnsafeMutablePointer<RingBuffer>?
-    private let bufferSize: Int
-    private let encoder = JSONEncoder()
+    fileprivate let ringBuffer: UnsafeMutablePointer<ring_buffer_t>
+    fileprivate let encoder = ArrowIPCEncoder(fields: ChronicleEventSchema.fields)
+    let batchEncoder = ArrowIPCEncoder(fields: ChronicleEventSchema.batchFields)
+    let sessionId = UUID().uuidString
+    fileprivate let compressionEnabled: Bool
     
-    /// Initialize ring buffer writer
-    /// - Parameter bufferSize: Size of the ring buffer in bytes
-    public init(bufferSize: Int = 1024 * 1024 * 100) { // 100MB default
-        self.bufferSize = bufferSize
-        self.encoder.dateEncodingStrategy = .secondsSince1970
+    /// Attach to the ring buffer file, creating it if it doesn't exist yet
+    /// - Parameters:
+    ///   - path: Backing file shared with the packer
+    ///   - bufferSize: Size of a newly created ring buffer in bytes
+    ///   - compressionEnabled: LZ4-compress screen and clipboard events in the ring
+    ///   - initialSize: If nonzero, create an elastic buffer that starts out
+    ///     holding this many bytes, grows to bufferSize on demand and is
+    ///     trimmed back by the packer once drained
+    /// - Throws: ChronicleCollectorError if the buffer can't be mapped
+    public init(path: String, bufferSize: Int = 1024 * 1024 * 100, compressionEnabled: Bool = true, // 100MB default
+                initialSize: Int = 0) throws {
+        self.compressionEnabled = compressionEnabled
         
-        // Initialize ring buffer
-        self.ringBuffer = UnsafeMutablePointer<RingBuffer>.allocate(capacity: 1)
-        self.ringBuffer?.pointee = RingBuffer(
-            buffer: UnsafeMutableRawPointer.allocate(byteCount: bufferSize, alignment: 8),
-            size: bufferSize,
-            head: 0,
-            tail: 0,
-            count: 0,
-            mutex: pthread_mutex_t()
-        )
+        // Reopen first so that events the packer hasn't drained yet survive a restart
+        if let existing = ring_buffer_open_shared(path, 0) {
+            self.ringBuffer = existing
+        } else {
+            try FileManager.default.createDirectory(
+                atPath: (path as NSString).deletingLastPathComponent,
+                withIntermediateDirectories: true
+            )
+            
+            var config = ring_buffer_config_t()
+            config.size = bufferSize
+            if initialSize > 0 {
+                config.flags = RING_BUFFER_FLAG_ELASTIC
+                config.initial_size = initialSize
+            }
+            guard let created = ring_buffer_create_shared(path, &config) else {
+                throw ChronicleCollectorError.ringBufferWriteError("Failed to create ring buffer at \(path)")
+            }
+            self.ringBuffer = created
+        }
         
-        // Initialize mutex
-        var attr = pthread_mutexattr_t()
-        pthread_mutexattr_init(&attr)
-        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE)
-        pthread_mutex_init(&ringBuffer!.pointee.mutex, &attr)
-        pthread_mutexattr_destroy(&attr)
+        // Messages without an event time, such as compressed ones, are stamped
+        // from the tick-cached clock rather than a full clock read
+        ring_buffer_set_clock(ringBuffer, RING_BUFFER_CLOCK_COARSE)
         
-        logger.info("Ring buffer writer initialized with size: \(bufferSize) bytes")
+        logger.info("Ring buffer writer attached to \(path) (\(self.ringBuffer.pointee.size) bytes)")
     }
     
     deinit {
-        guard let ringBuffer = ringBuffer else { return }
-        
-        // Clean up
-        pthread_mutex_destroy(&ringBuffer.pointee.mutex)
-        ringBuffer.pointee.buffer.deallocate()
-        ringBuffer.deallocate()
-        
+        ring_buffer_destroy(ringBuffer)
         logger.info("Ring buffer writer deinitialized")
     }
     
-    /// Write event to ring buffer
-    /// - Parameter event: Chronicle event to write
-    /// - Throws: ChronicleCollectorError if write fails
-    public func write(_ event: ChronicleEvent) throws {
-        guard let ringBuffer = ringBuffer else {
-            throw ChronicleCollectorError.ringBufferWriteError("Ring buffer not initialized")
-        }
-        
-        // Serialize event to JSON
-        let eventData: Data
-        do {
-            eventData = try encoder.encode(event)
-        } catch {
-            throw ChronicleCollectorError.serializationError("Failed to encode event: \(error)")
-        }
-        
-        // Create Arrow IPC message
-        let arrowData = try createArrowIPCMessage(from: eventData)
-        
-        // Write to ring buffer
-        let result = pthread_mutex_lock(&ringBuffer.pointee.mutex)
-        guard result == 0 else {
-            throw ChronicleCollectorError.ringBufferWriteError("Failed to lock mutex: \(result)")
-        }
-        
-        defer {
-            pthread_mutex_unlock(&ringBuffer.pointee.mutex)
-        }
-        
-        // Check if we have enough space
-        let messageSize = arrowData.count + MemoryLayout<UInt32>.size
-        if availableSpace(in: ringBuffer) < messageSize {
-            // Make space by advancing tail
-            try makeSpace(in: ringBuffer, needed: messageSize)
-        }
-        
-        // Write message size first
-        let sizeData = withUnsafeBytes(of: UInt32(arrowData.count)) { Data($0) }
-        try writeData(sizeData, to: ringBuffer)
-        
-        // Write message data
-        try writeData(arrowData, to: ringBuffer)
-        
-        logger.debug("Wrote event \(event.id) of type \(event.type) to ring buffer")
+    /// Create a producer handle; use each handle from one thread or serial queue at a time
+    public func makeProducer() -> RingBufferProducer {
+        return RingBufferProducer(writer: self)
+    }
+    
+    /// Create a batching producer confined to `queue`, which also runs its flush deadlines
+    public func makeBatchProducer(policy: RingBufferBatchPolicy, queue: DispatchQueue) -> RingBufferBatchProducer {
+        return RingBufferBatchProducer(writer: self, policy: policy, queue: queue)
     }
     
     /// Get ring buffer statistics
     public func getStatistics() -> RingBufferStatistics {
-        guard let ringBuffer = ringBuffer else {
-            return RingBufferStatistics(size: 0, used: 0, available: 0, eventCount: 0)
-        }
+        var stats = ring_buffer_stats_t()
+        ring_buffer_get_stats(ringBuffer, &stats)
         
-        pthread_mutex_lock(&ringBuffer.pointee.mutex)
-        defer { pthread_mutex_unlock(&ringBuffer.pointee.mutex) }
-        
-        let used = usedSpace(in: ringBuffer)
-        let available = availableSpace(in: ringBuffer)
+        let size = Int(ringBuffer.pointee.size)
+        let available = Int(ring_buffer_available_write(ringBuffer))
         
         return RingBufferStatistics(
-            size: bufferSize,
-            used: used,
+            size: size,
+            used: size - available,
             available: available,
-            eventCount: ringBuffer.pointee.count
+            eventCount: Int(stats.messages_written > stats.messages_read ? stats.messages_written - stats.messages_read : 0)
         )
     }
     
-    /// Clear ring buffer
+    /// Clear ring buffer by consuming every unread message
     public func clear() {
-        guard let ringBuffer = ringBuffer else { return }
-        
-        pthread_mutex_lock(&ringBuffer.pointee.mutex)
-        defer { pthread_mutex_unlock(&ringBuffer.pointee.mutex) }
-        
-        ringBuffer.pointee.head = 0
-        ringBuffer.pointee.tail = 0
-        ringBuffer.pointee.count = 0
+        var messages = [ring_buffer_message_t](repeating: ring_buffer_message_t(), count: 64)
+        var drained: Int32
+        repeat {
+            drained = ring_buffer_read_batch(ringBuffer, &messages, messages.count)
+        } while drained > 0
         
         logger.info("Ring buffer cleared")
     }
     
-    // MARK: - Private Methods
+    /// Encode `columns` as one Arrow IPC message straight into reserved ring buffer space
+    /// - Parameter timestamp: Event time stamped into the message header, in seconds since the epoch
+    /// - Returns: Bytes written, excluding the ring buffer's message header
+    func enqueue(_ columns: [ArrowColumn], encoder: ArrowIPCEncoder, priority: ring_buffer_priority_t,
+                 timestamp: TimeInterval) throws -> Int {
+        let batch = encoder.prepare(columns)
+        
+        var span = ring_buffer_span_t()
+        let result = ring_buffer_reserve_priority(ringBuffer, batch.streamLength, priority, &span)
+        guard result == RING_BUFFER_SUCCESS else {
+            throw RingBufferWriter.error(for: result)
+        }
+        span.timestamp = UInt64(max(timestamp, 0) * 1_000_000_000)
+        
+        var sink = SpanSink(span: span)
+        do {
+            try encoder.write(batch, columns: columns, into: &sink)
+        } catch {
+            ring_buffer_abort(ringBuffer, &span)
+            throw error
+        }
+        
+        let committed = ring_buffer_commit(ringBuffer, &span)
+        guard committed == RING_BUFFER_SUCCESS else {
+            throw RingBufferWriter.error(for: committed)
+        }
+        
+        return batch.streamLength
+    }
     
-    private func createArrowIPCMessage(from data: Data) throws -> Data {
-        // Simple Arrow IPC format implementation
-        // In a real implementation, this would use proper Arrow IPC format
-        let header = ArrowIPCHeader(
-            metadataLength: 0,
-            bodyLength: UInt64(data.count),
-            timestamp: UInt64(Date().timeIntervalSince1970 * 1000)
-        )
+    /// Encode `columns` into `scratch` and write them LZ4-compressed
+    ///
+    /// Compression needs the whole stream up front, so unlike `enqueue`
+    /// this encodes off-ring; the C side only reserves the compressed size.
+    /// - Returns: Uncompressed bytes written
+    fileprivate func enqueueCompressed(_ columns: [ArrowColumn], encoder: ArrowIPCEncoder,
+                                       priority: ring_buffer_priority_t, scratch: inout DataSink) throws -> Int {
+        let batch = encoder.prepare(columns)
         
-        var result = Data()
-        result.append(withUnsafeBytes(of: header) { Data($0) })
-        result.append(data)
+        scratch.data.removeAll(keepingCapacity: true)
+        try encoder.write(batch, columns: columns, into: &scratch)
         
-        return result
+        let result = scratch.data.withUnsafeBytes { bytes in
+            ring_buffer_write_compressed(ringBuffer, bytes.baseAddress, bytes.count, RING_BUFFER_CODEC_LZ4, priority)
+        }
+        guard result == RING_BUFFER_SUCCESS else {
+            throw RingBufferWriter.error(for: result)
+        }
+        
+        return batch.streamLength
     }
     
-    private func availableSpace(in ringBuffer: UnsafeMutablePointer<RingBuffer>) -> Int {
-        let rb = ringBuffer.pointee
-        if rb.head == rb.tail && rb.count == 0 {
-            return rb.size
-        } else if rb.head == rb.tail {
-            return 0
-        } else if rb.head > rb.tail {
-            return rb.size - rb.head + rb.tail
-        } else {
-            return rb.tail - rb.head
+    fileprivate static func error(for result: ring_buffer_error_t) -> ChronicleCollectorError {
+        let message = String(cString: ring_buffer_error_string(result))
+        if result == RING_BUFFER_ERROR_BACKPRESSURE || result == RING_BUFFER_ERROR_FULL {
+            return .backpressure(message)
         }
+        return .ringBufferWriteError(message)
     }
+}
+
+/// Lock-free producer handle for one collector
+///
+/// Events are encoded as Arrow IPC streams straight into space reserved in
+/// the shared mapping: only the small record batch header is built in
+/// scratch memory, and the column buffers are reused across writes. Screen
+/// and clipboard events are the exception when compression is enabled:
+/// they are encoded into a reused scratch buffer and stored LZ4-compressed.
+public final class RingBufferProducer {
+    private let writer: RingBufferWriter
+    private var columns: [ArrowColumn]
+    private var scratch = DataSink()
     
-    private func usedSpace(in ringBuffer: UnsafeMutablePointer<RingBuffer>) -> Int {
-        return bufferSize - availableSpace(in: ringBuffer)
+    fileprivate init(writer: RingBufferWriter) {
+        self.writer = writer
+        self.columns = writer.encoder.makeColumns()
     }
     
-    private func makeSpace(in ringBuffer: UnsafeMutablePointer<RingBuffer>, needed: Int) throws {
-        // Advance tail to make space
-        var freed = 0
+    /// Write event to ring buffer
+    /// - Parameter event: Chronicle event to write
+    /// - Returns: Bytes written, excluding the ring buffer's message header
+    /// - Throws: ChronicleCollectorError.backpressure if the event was shed, otherwise ringBufferWriteError
+    @discardableResult
+    public func write(_ event: ChronicleEvent) throws -> Int {
+        for index in columns.indices {
+            columns[index].removeAll()
+        }
+        ChronicleEventSchema.append(event, sessionId: writer.sessionId, to: &columns)
         
-        while freed < needed && ringBuffer.pointee.count > 0 {
-            // Read message size
-            let sizeBytes = UnsafeMutablePointer<UInt32>.allocate(capacity: 1)
-            defer { sizeBytes.deallocate() }
-            
-            let sizeData = ringBuffer.pointee.buffer.advanced(by: ringBuffer.pointee.tail)
-            sizeData.copyMemory(from: sizeBytes, byteCount: MemoryLayout<UInt32>.size)
-            
-            let messageSize = Int(sizeBytes.pointee)
-            let totalSize = messageSize + MemoryLayout<UInt32>.size
-            
-            // Advance tail
-            ringBuffer.pointee.tail = (ringBuffer.pointee.tail + totalSize) % ringBuffer.pointee.size
-            ringBuffer.pointee.count -= 1
-            freed += totalSize
+        let priority = ChronicleEventSchema.priority(of: event.type)
+        if writer.compressionEnabled && ChronicleEventSchema.isBulk(event.type) {
+            return try writer.enqueueCompressed(columns, encoder: writer.encoder, priority: priority, scratch: &scratch)
         }
+        return try writer.enqueue(columns, encoder: writer.encoder, priority: priority, timestamp: event.timestamp)
+    }
+}
+
+/// Writes encoded bytes into a reserved span, across the wrap split if there is one
+private struct SpanSink: ArrowIPCSink {
+    var span: ring_buffer_span_t
+    var offset = 0
+    
+    init(span: ring_buffer_span_t) {
+        self.span = span
     }
     
-    private func writeData(_ data: Data, to ringBuffer: UnsafeMutablePointer<RingBuffer>) throws {
-        let rb = ringBuffer.pointee
+    mutating func write(_ bytes: UnsafeRawBufferPointer) throws {
+        guard let base = bytes.baseAddress, bytes.count > 0 else { return }
         
-        data.withUnsafeBytes { bytes in
-            let bytesToWrite = bytes.count
-            
-            if rb.head + bytesToWrite <= rb.size {
-                // Write in one piece
-                rb.buffer.advanced(by: rb.head).copyMemory(from: bytes.baseAddress!, byteCount: bytesToWrite)
-            } else {
-                // Write in two pieces (wrap around)
-                let firstPart = rb.size - rb.head
-                let secondPart = bytesToWrite - firstPart
-                
-                rb.buffer.advanced(by: rb.head).copyMemory(from: bytes.baseAddress!, byteCount: firstPart)
-                rb.buffer.copyMemory(from: bytes.baseAddress!.advanced(by: firstPart), byteCount: secondPart)
-            }
+        let result = ring_buffer_span_copy(&span, offset, base, bytes.count)
+        guard result == RING_BUFFER_SUCCESS else {
+            throw RingBufferWriter.error(for: result)
         }
-        
-        ringBuffer.pointee.head = (rb.head + data.count) % rb.size
-        ringBuffer.pointee.count += 1
+        offset += bytes.count
+    }
+}
+
+/// Collects encoded bytes in memory, keeping its capacity across writes
+struct DataSink: ArrowIPCSink {
+    var data = Data()
+    
+    mutating func write(_ bytes: UnsafeRawBufferPointer) throws {
+        data.append(contentsOf: bytes)
     }
 }
 
@@ -237,69 +296,113 @@ public struct RingBufferStatistics {
     }
 }
 
-/// Arrow IPC header structure
-private struct ArrowIPCHeader {
-    let metadataLength: UInt32
-    let bodyLength: UInt64
-    let timestamp: UInt64
-}
-
 /// Ring buffer configuration
-public struct RingBufferConfig {
-    public let bufferSize: Int
+///
+/// Keys missing from a stored configuration take their defaults, so
+/// configurations saved before a setting existed still load.
+public struct RingBufferConfig: Codable {
+    public let path: String
+    public let bufferSize: Int      // Most an elastic buffer grows to
+    public let elastic: Bool        // Start at initialSize, grow on demand, trimmed back once drained
+    public let initialSize: Int
     public let maxEventSize: Int
     public let compressionEnabled: Bool
     public let flushInterval: TimeInterval
     
-    public init(bufferSize: Int = 1024 * 1024 * 100,
+    /// Same location the packer reads by default
+    public static let defaultPath = FileManager.default
+        .urls(for: .cachesDirectory, in: .userDomainMask)[0]
+        .appendingPathComponent("chronicle/ring_buffer").path
+    
+    public init(path: String = RingBufferConfig.defaultPath,
+                bufferSize: Int = 1024 * 1024 * 100,
                 maxEventSize: Int = 1024 * 1024,
                 compressionEnabled: Bool = true,
-                flushInterval: TimeInterval = 5.0) {
+                flushInterval: TimeInterval = 5.0,
+                elastic: Bool = true,
+                initialSize: Int = 1024 * 1024) {
+        self.path = path
         self.bufferSize = bufferSize
+        self.elastic = elastic
+        self.initialSize = initialSize
         self.maxEventSize = maxEventSize
         self.compressionEnabled = compressionEnabled
         self.flushInterval = flushInterval
     }
     
+    public init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+        let defaults = RingBufferConfig.default
+        path = try container.decodeIfPresent(String.self, forKey: .path) ?? defaults.path
+        bufferSize = try container.decodeIfPresent(Int.self, forKey: .bufferSize) ?? defaults.bufferSize
+        elastic = try container.decodeIfPresent(Bool.self, forKey: .elastic) ?? defaults.elastic
+        initialSize = try container.decodeIfPresent(Int.self, forKey: .initialSize) ?? defaults.initialSize
+        maxEventSize = try container.decodeIfPresent(Int.self, forKey: .maxEventSize) ?? defaults.maxEventSize
+        compressionEnabled = try container.decodeIfPresent(Bool.self, forKey: .compressionEnabled) ?? defaults.compressionEnabled
+        flushInterval = try container.decodeIfPresent(TimeInterval.self, forKey: .flushInterval) ?? defaults.flushInterval
+    }
+    
     public static let `default` = RingBufferConfig()
 }
 
-/// Thread-safe ring buffer writer with performance optimizations
+/// Ring buffer writer shared by all collectors
 public class PerformantRingBufferWriter {
-    private let writer: RingBufferWriter
+    private let writer: RingBufferWriter?
     private let queue: DispatchQueue
     private let config: RingBufferConfig
+    private var producer: RingBufferProducer?   // Used on `queue` only
     private var writeCount: Int64 = 0
-    private var lastFlushTime: TimeInterval = 0
     private let logger = Logger(subsystem: "com.chronicle.collectors", category: "PerformantRingBufferWriter")
     
     public init(config: RingBufferConfig = .default) {
         self.config = config
-        self.writer = RingBufferWriter(bufferSize: config.bufferSize)
         self.queue = DispatchQueue(label: "com.chronicle.ringbuffer", qos: .utility)
-        self.lastFlushTime = Date().timeIntervalSince1970
+        
+        do {
+            self.writer = try RingBufferWriter(
+                path: config.path,
+                bufferSize: config.bufferSize,
+                compressionEnabled: config.compressionEnabled,
+                initialSize: config.elastic ? config.initialSize : 0
+            )
+        } catch {
+            self.writer = nil
+            logger.error("Ring buffer unavailable, events will be dropped: \(error)")
+        }
+        self.producer = writer?.makeProducer()
+    }
+    
+    /// Create a producer handle for a collector's own thread or queue
+    public func makeProducer() -> RingBufferProducer? {
+        return writer?.makeProducer()
+    }
+    
+    /// Create a batching producer for a collector's serial queue
+    public func makeBatchProducer(policy: RingBufferBatchPolicy, queue: DispatchQueue) -> RingBufferBatchProducer? {
+        return writer?.makeBatchProducer(policy: policy, queue: queue)
     }
     
     /// Write event asynchronously
     public func writeAsync(_ event: ChronicleEvent) {
         queue.async { [weak self] in
-            self?.writeSync(event)
+            self?.writeOnQueue(event)
         }
     }
     
     /// Write event synchronously
     public func writeSync(_ event: ChronicleEvent) {
+        queue.sync {
+            writeOnQueue(event)
+        }
+    }
+    
+    /// Write through the shared producer, which is confined to `queue`
+    private func writeOnQueue(_ event: ChronicleEvent) {
+        guard let producer = producer else { return }
+        
         do {
-            try writer.write(event)
-            
+            try producer.write(event)
             OSAtomicIncrement64(&writeCount)
-            
-            // Check if we should flush
-            let now = Date().timeIntervalSince1970
-            if now - lastFlushTime >= config.flushInterval {
-                flush()
-                lastFlushTime = now
-            }
         } catch {
             logger.error("Failed to write event: \(error)")
         }
@@ -307,20 +410,20 @@ public class PerformantRingBufferWriter {
     
     /// Force flush buffer
     public func flush() {
-        // In a real implementation, this would flush to disk
+        // Commits are visible to the packer immediately; nothing is buffered here
         logger.debug("Flushed ring buffer (write count: \(writeCount))")
     }
     
     /// Get statistics
     public func getStatistics() -> RingBufferStatistics {
-        return writer.getStatistics()
+        return writer?.getStatistics() ?? RingBufferStatistics(size: 0, used: 0, available: 0, eventCount: 0)
     }
     
     /// Clear buffer
     public func clear() {
         queue.sync {
-            writer.clear()
+            writer?.clear()
             OSAtomicAnd64(0, &writeCount)
         }
     }
-}
\ No newline at end of file
+}
@@ -254,6 +254,125 @@ class EventTypeTests: XCTestCase {
     }
 }
 
+// MARK: - Ring Buffer Tests
+
+class RingBufferWriterTests: XCTestCase {
+    
+    func testArrowStreamLayout() throws {
+        let encoder = ArrowIPCEncoder(fields: ChronicleEventSchema.fields)
+        var columns = encoder.makeColumns()
+        let event = ChronicleEvent(type: .windowFocus, data: Data("{}".utf8), metadata: ["window_title": "Notes"])
+        ChronicleEventSchema.append(event, sessionId: "session", to: &columns)
+        
+        let batch = encoder.prepare(columns)
+        var sink = DataSink()
+        try encoder.write(batch, columns: columns, into: &sink)
+        
+        // Schema and record batch messages, then the end-of-stream marker
+        XCTAssertEqual(sink.data.count, batch.streamLength)
+        XCTAssertEqual(sink.data.count % 8, 0)
+        XCTAssertEqual(Array(sink.data.prefix(4)), [0xFF, 0xFF, 0xFF, 0xFF])
+        XCTAssertEqual(Array(sink.data.suffix(8)), [0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0])
+        
+        // One null app_bundle_id sets up a validity bitmap
+        XCTAssertEqual(columns[2].nullCount, 1)
+        XCTAssertEqual(columns[3].nullCount, 0)
+    }
+    
+    func testProducerWritesToSharedBuffer() throws {
+        let path = FileManager.default.temporaryDirectory
+            .appendingPathComponent("ring_buffer_\(UUID().uuidString)").path
+        defer { try? FileManager.default.removeItem(atPath: path) }
+        
+        let writer = try RingBufferWriter(path: path, bufferSize: 1024 * 1024)
+        let producers = [writer.makeProducer(), writer.makeProducer()]
+        
+        for (index, producer) in producers.enumerated() {
+            let event = ChronicleEvent(type: .keyTap, data: Data("{\"index\":\(index)}".utf8))
+            XCTAssertGreaterThan(try producer.write(event), 0)
+        }
+        
+        let stats = writer.getStatistics()
+        XCTAssertEqual(stats.eventCount, 2)
+        XCTAssertGreaterThan(stats.used, 0)
+        
+        // Reattaching keeps the events the packer hasn't drained
+        let reopened = try RingBufferWriter(path: path)
+        XCTAssertEqual(reopened.getStatistics().used, stats.used)
+    }
+    
+    func testDictionaryColumnStoresEachStringOnce() throws {
+        let encoder = ArrowIPCEncoder(fields: ChronicleEventSchema.batchFields)
+        var columns = encoder.makeColumns()
+        for _ in 0..<100 {
+            let event = ChronicleEvent(type: .pointerMove, data: Data("{}".utf8), metadata: ["bundle_identifier": "com.apple.Safari"])
+            ChronicleEventSchema.append(event, sessionId: "session", to: &columns)
+        }
+        
+        XCTAssertEqual(columns[1].count, 100)
+        XCTAssertEqual(columns[1].dictionaryCount, 1)
+        XCTAssertEqual(columns[2].dictionaryCount, 1)
+        XCTAssertEqual(columns[3].nullCount, 100)
+        
+        // Schema, one dictionary message per dictionary column, record batch, end of stream
+        let batch = encoder.prepare(columns)
+        var sink = DataSink()
+        try encoder.write(batch, columns: columns, into: &sink)
+        XCTAssertEqual(sink.data.count, batch.streamLength)
+        XCTAssertEqual(Array(sink.data.suffix(8)), [0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0])
+    }
+    
+    func testBatchProducerCoalescesEvents() throws {
+        let path = FileManager.default.temporaryDirectory
+            .appendingPathComponent("ring_buffer_\(UUID().uuidString)").path
+        defer { try? FileManager.default.removeItem(atPath: path) }
+        
+        let writer = try RingBufferWriter(path: path, bufferSize: 1024 * 1024)
+        let queue = DispatchQueue(label: "test.batch")
+        let producer = writer.makeBatchProducer(policy: RingBufferBatchPolicy(maxRows: 10, maxLatency: 0.05), queue: queue)
+        
+        var flushed: [Int] = []
+        let deadline = expectation(description: "deadline flush")
+        producer.onFlush = { events, result in
+            XCTAssertGreaterThan(try! result.get(), 0)
+            flushed.append(events)
+            if events == 5 {
+                deadline.fulfill()
+            }
+        }
+        
+        queue.sync {
+            for _ in 0..<25 {
+                producer.append(ChronicleEvent(type: .pointerMove, data: Data("{}".utf8)))
+            }
+        }
+        
+        // Two full batches right away, the rest once the deadline passes
+        wait(for: [deadline], timeout: 1.0)
+        queue.sync {
+            XCTAssertEqual(flushed, [10, 10, 5])
+            XCTAssertEqual(producer.pendingCount, 0)
+        }
+        XCTAssertEqual(writer.getStatistics().eventCount, 3)
+    }
+    
+    func testScreenCapturesAreCompressed() throws {
+        let frame = Data(String(repeating: "{\"pixels\":\"AAAAAAAA\"}", count: 2000).utf8)
+        var used: [Bool: Int] = [:]
+        for compressionEnabled in [false, true] {
+            let path = FileManager.default.temporaryDirectory
+                .appendingPathComponent("ring_buffer_\(UUID().uuidString)").path
+            defer { try? FileManager.default.removeItem(atPath: path) }
+            
+            let writer = try RingBufferWriter(path: path, bufferSize: 1024 * 1024, compressionEnabled: compressionEnabled)
+            try writer.makeProducer().write(ChronicleEvent(type: .screenCapture, data: frame))
+            used[compressionEnabled] = writer.getStatistics().used
+        }
+        
+        XCTAssertLessThan(used[true]!, used[false]! / 4)
+    }
+}
+
 // MARK: - Configuration Tests
 
 class ConfigurationTests: XCTestCase {
@@ -303,6 +422,23 @@ class ConfigurationTests: XCTestCase {
             }
         }
     }
+    
+    func testRingBufferConfigDefaultsToElastic() throws {
+        // Saved before the elastic settings existed
+        let json = Data("{\"bufferSize\": 67108864}".utf8)
+        let config = try JSONDecoder().decode(RingBufferConfig.self, from: json)
+        
+        XCTAssertEqual(config.bufferSize, 64 * 1024 * 1024)
+        XCTAssertTrue(config.elastic)
+        XCTAssertEqual(config.initialSize, 1024 * 1024)
+        XCTAssertEqual(config.path, RingBufferConfig.defaultPath)
+        
+        let fixed = try JSONDecoder().decode(RingBufferConfig.self, from: Data("{\"elastic\": false}".utf8))
+        XCTAssertFalse(fixed.elastic)
+        
+        let oversized = ChronicleConfig(ringBuffer: RingBufferConfig(bufferSize: 1024 * 1024, initialSize: 2 * 1024 * 1024))
+        XCTAssertThrowsError(try oversized.validate())
+    }
 }
 
 // MARK: - Permission Tests
@@ -0,0 +1,22 @@
+//! Compile the C ring buffer into the packer
+
+fn main() {
+    let ring_buffer_dir = std::path::Path::new("../ring-buffer");
+
+    cc::Build::new()
+        .file(ring_buffer_dir.join("ring_buffer.c"))
+        .file(ring_buffer_dir.join("ring_spill.c"))
+        .include(ring_buffer_dir)
+        .flag_if_supported("-std=c11")
+        .define("_GNU_SOURCE", None)
+        .define("_POSIX_C_SOURCE", "200809L")
+        .opt_level(3)
+        .compile("ringbuffer");
+
+    println!("cargo:rustc-link-lib=pthread");
+    println!("cargo:rustc-link-lib=m");
+    println!("cargo:rerun-if-changed=../ring-buffer/ring_buffer.c");
+    println!("cargo:rerun-if-changed=../ring-buffer/ring_buffer.h");
+    println!("cargo:rerun-if-changed=../ring-buffer/ring_spill.c");
+    println!("cargo:rerun-if-changed=../ring-buffer/ring_spill.h");
+}
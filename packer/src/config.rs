@@ -217,9 +217,18 @@ pub struct RingBufferConfig {
     /// Ring buffer path
     pub path: PathBuf,
     
-    /// Ring buffer size in bytes
+    /// Ring buffer size in bytes; the most an elastic buffer grows to
     pub size: usize,
     
+    /// Create the buffer elastic: it starts at `initial_size`, grows on
+    /// demand and is trimmed back once drained
+    #[serde(default = "default_elastic")]
+    pub elastic: bool,
+    
+    /// Starting size of an elastic buffer in bytes
+    #[serde(default = "default_initial_size")]
+    pub initial_size: usize,
+    
     /// Backpressure threshold (0.0-1.0)
     pub backpressure_threshold: f64,
     
@@ -231,6 +240,23 @@ pub struct RingBufferConfig {
     
     /// Write timeout in milliseconds
     pub write_timeout: u32,
+    
+    /// Continuous spill to segment files; without one the daily job
+    /// drains the buffer itself
+    pub spill: Option<SpillConfig>,
+}
+
+/// Continuous spill of the ring buffer to segment files
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct SpillConfig {
+    /// Directory the segment files are written to
+    pub directory: PathBuf,
+    
+    /// Segment size in bytes before rolling over to a new file
+    pub segment_size: usize,
+    
+    /// How often committed messages are written out, in milliseconds
+    pub interval_ms: u64,
 }
 
 /// Metrics configuration
@@ -456,14 +482,25 @@ impl Default for RingBufferConfig {
         Self {
             path: default_path,
             size: 64 * 1024 * 1024, // 64MB
+            elastic: default_elastic(),
+            initial_size: default_initial_size(),
             backpressure_threshold: 0.8,
             max_message_size: 16 * 1024 * 1024, // 16MB
             read_timeout: 5000, // 5 seconds
             write_timeout: 1000, // 1 second
+            spill: None,
         }
     }
 }
 
+fn default_elastic() -> bool {
+    true
+}
+
+fn default_initial_size() -> usize {
+    1024 * 1024 // 1MB
+}
+
 impl Default for MetricsConfig {
     fn default() -> Self {
         Self {
@@ -674,6 +711,30 @@ impl PackerConfig {
             });
         }
         
+        if self.ring_buffer.elastic
+            && (self.ring_buffer.initial_size == 0 || self.ring_buffer.initial_size > self.ring_buffer.size)
+        {
+            return Err(ConfigError::InvalidValue { 
+                field: "ring_buffer.initial_size".to_string(), 
+                value: self.ring_buffer.initial_size.to_string() 
+            });
+        }
+        
+        if let Some(spill) = &self.ring_buffer.spill {
+            if spill.segment_size == 0 {
+                return Err(ConfigError::InvalidValue { 
+                    field: "ring_buffer.spill.segment_size".to_string(), 
+                    value: "0".to_string() 
+                });
+            }
+            if spill.interval_ms == 0 {
+                return Err(ConfigError::InvalidValue { 
+                    field: "ring_buffer.spill.interval_ms".to_string(), 
+                    value: "0".to_string() 
+                });
+            }
+        }
+        
         Ok(())
     }
     
@@ -736,6 +797,38 @@ mod tests {
         config.storage.compression_level = 6;
         config.performance.cpu_limit = 1.5;
         assert!(config.validate().is_err());
+        
+        // Test a spill that never runs
+        config.performance.cpu_limit = 0.5;
+        config.ring_buffer.spill = Some(SpillConfig {
+            directory: PathBuf::from("/tmp/chronicle-spill"),
+            segment_size: 64 * 1024 * 1024,
+            interval_ms: 0,
+        });
+        assert!(config.validate().is_err());
+        
+        // Test an elastic buffer that starts out larger than it may grow
+        config.ring_buffer.spill = None;
+        config.ring_buffer.initial_size = config.ring_buffer.size * 2;
+        assert!(config.validate().is_err());
+        
+        config.ring_buffer.elastic = false;
+        assert!(config.validate().is_ok());
+    }
+    
+    #[test]
+    fn test_ring_buffer_defaults_to_elastic() {
+        // Configs written before the elastic mode existed leave the keys out
+        let config: RingBufferConfig = toml::from_str(r#"
+            path = "/tmp/chronicle_ring_buffer"
+            size = 67108864
+            backpressure_threshold = 0.8
+            max_message_size = 16777216
+            read_timeout = 5000
+            write_timeout = 1000
+        "#).unwrap();
+        assert!(config.elastic);
+        assert_eq!(config.initial_size, 1024 * 1024);
     }
     
     #[test]
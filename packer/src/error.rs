@@ -343,6 +343,7 @@ impl From<i32> for RingBufferError {
             -5 => RingBufferError::MessageTooLarge { size: 0 },
             -6 => RingBufferError::Corrupted,
             -7 => RingBufferError::Backpressure,
+            -11 => RingBufferError::WriteError { reason: "Spill segment I/O failed".to_string() },
             _ => RingBufferError::FfiError { code },
         }
     }
@@ -7,6 +7,7 @@
 pub mod config;
 pub mod error;
 pub mod packer;
+pub mod ring_buffer;
 pub mod storage;
 pub mod encryption;
 pub mod integrity;
@@ -28,6 +29,7 @@ pub mod security_monitoring;
 pub use config::PackerConfig;
 pub use error::{PackerError, Result};
 pub use packer::PackerService;
+pub use ring_buffer::RingBuffer;
 pub use storage::StorageManager;
 pub use encryption::EncryptionService;
 pub use integrity::IntegrityService;
@@ -0,0 +1,918 @@
+//! Safe wrapper around the C ring buffer in `ring-buffer/`
+//!
+//! The collectors write Arrow IPC messages into a shared, file-backed
+//! ring buffer and the packer is its only consumer. A drain borrows the
+//! messages straight from the shared mapping, batch by batch, without
+//! consuming them; the read position only moves when the drain is
+//! released, which the packer does once the data is durable on disk. A
+//! drain dropped without a release leaves everything for the next run.
+//!
+//! Producers may compress payloads; [`Message::decode`] hands back the
+//! original bytes, borrowing uncompressed ones and decompressing the rest
+//! into a reusable arena. Small records may arrive packed into slabs,
+//! several to a message; [`Message::records`] walks them.
+//!
+//! Instead of being drained, the buffer can be spilled continuously to
+//! segment files, which keeps the backlog on disk rather than in the
+//! mapping. [`Segment`] reads the messages back for the daily merge.
+
+use std::ffi::CString;
+use std::os::raw::{c_char, c_int, c_void};
+use std::os::unix::ffi::OsStrExt;
+use std::path::{Path, PathBuf};
+use std::ptr::NonNull;
+use std::time::Duration;
+
+use crate::error::{RingBufferError, RingBufferResult};
+
+/// Messages borrowed per peek into the C buffer
+pub const DRAIN_BATCH_SIZE: usize = 256;
+
+/// `ring_buffer_codec_t` values recorded in bits 8-15 of the header's `reserved`
+pub const CODEC_NONE: u8 = 0;
+pub const CODEC_LZ4: u8 = 1;
+pub const CODEC_ZSTD: u8 = 2;
+
+/// `RING_BUFFER_CODEC_PREFIX_SIZE`: uncompressed length in front of compressed payloads
+const CODEC_PREFIX_SIZE: usize = 4;
+
+/// `RING_BUFFER_HEADER_SLAB`: the payload packs several small records
+const HEADER_SLAB: u32 = 0x0001_0000;
+
+/// `RING_BUFFER_SLAB_CAPACITY` as the C library is built here
+const SLAB_CAPACITY: usize = 1024;
+
+/// `RING_BUFFER_FLAG_ELASTIC`: grow on demand up to the size, trim when idle
+const FLAG_ELASTIC: u32 = 1 << 6;
+
+/// `RING_BUFFER_ERROR_EMPTY`
+const ERROR_EMPTY: c_int = -4;
+
+/// `RING_BUFFER_ERROR_UNSUPPORTED`
+const ERROR_UNSUPPORTED: c_int = -9;
+
+/// `RING_SPILL_SEGMENT_PREFIX` and `RING_SPILL_SEGMENT_SUFFIX`
+const SEGMENT_PREFIX: &str = "spill-";
+const SEGMENT_SUFFIX: &str = ".seg";
+
+/// `RING_SPILL_SEGMENT_SEALED`
+const SEGMENT_SEALED: u32 = 1 << 0;
+
+/// Raw bindings to `ring_buffer.h`
+mod ffi {
+    use super::*;
+
+    /// `ring_buffer_t`, only ever used behind a pointer
+    #[repr(C)]
+    pub struct RingBufferT {
+        _private: [u8; 0],
+    }
+
+    /// `arrow_ipc_header_t`
+    #[repr(C, packed)]
+    #[derive(Debug, Clone, Copy)]
+    pub struct ArrowIpcHeader {
+        pub magic: u32,
+        pub length: u32,
+        pub timestamp: u64,
+        pub checksum: u32,
+        pub reserved: u32,
+    }
+
+    /// `ring_buffer_message_t`
+    #[repr(C)]
+    #[derive(Debug, Clone, Copy)]
+    pub struct RingBufferMessage {
+        pub header: ArrowIpcHeader,
+        pub data: *const c_void,
+        pub data_size: usize,
+    }
+
+    /// `ring_buffer_cursor_t`
+    #[repr(C)]
+    #[derive(Default)]
+    pub struct RingBufferCursor {
+        pub pos: usize,
+        pub messages: u64,
+        pub bytes: u64,
+    }
+
+    /// `ring_buffer_slab_t`
+    #[repr(C)]
+    pub struct RingBufferSlab {
+        pub priority: c_int,
+        pub count: u32,
+        pub length: usize,
+        pub first_timestamp: u64,
+        pub last_timestamp: u64,
+        pub data: [u8; SLAB_CAPACITY],
+    }
+
+    /// `ring_buffer_config_t`
+    #[repr(C)]
+    #[derive(Default)]
+    pub struct RingBufferConfig {
+        pub size: usize,
+        pub flags: u32,
+        pub high_watermark: f64,
+        pub low_watermark: f64,
+        pub initial_size: usize,
+    }
+
+    /// `ring_spill_t`, only ever used behind a pointer
+    #[repr(C)]
+    pub struct RingSpillT {
+        _private: [u8; 0],
+    }
+
+    /// `ring_spill_segment_t`, only ever used behind a pointer
+    #[repr(C)]
+    pub struct RingSpillSegmentT {
+        _private: [u8; 0],
+    }
+
+    /// `ring_spill_config_t`
+    #[repr(C)]
+    pub struct RingSpillConfig {
+        pub directory: *const c_char,
+        pub segment_size: usize,
+        pub batch_size: usize,
+        pub flags: u32,
+    }
+
+    /// `ring_spill_segment_header_t`
+    #[repr(C)]
+    pub struct RingSpillSegmentHeader {
+        pub magic: u32,
+        pub version: u32,
+        pub data_offset: u32,
+        pub flags: u32,
+        pub base_pos: u64,
+        pub first_pos: u64,
+        pub end_pos: u64,
+        pub created_ns: u64,
+        pub checksum: u32,
+        pub reserved: u32,
+    }
+
+    extern "C" {
+        pub fn ring_buffer_create_shared(path: *const c_char, config: *const RingBufferConfig) -> *mut RingBufferT;
+        pub fn ring_buffer_open_shared(path: *const c_char, flags: u32) -> *mut RingBufferT;
+        pub fn ring_buffer_destroy(rb: *mut RingBufferT);
+        pub fn ring_buffer_write(rb: *mut RingBufferT, data: *const c_void, size: usize) -> c_int;
+        pub fn ring_buffer_write_compressed(
+            rb: *mut RingBufferT,
+            data: *const c_void,
+            size: usize,
+            codec: c_int,
+            priority: c_int,
+        ) -> c_int;
+        pub fn ring_buffer_slab_init(slab: *mut RingBufferSlab, priority: c_int);
+        pub fn ring_buffer_slab_append(
+            rb: *mut RingBufferT,
+            slab: *mut RingBufferSlab,
+            data: *const c_void,
+            size: usize,
+            timestamp: u64,
+        ) -> c_int;
+        pub fn ring_buffer_slab_flush(rb: *mut RingBufferT, slab: *mut RingBufferSlab) -> c_int;
+        pub fn ring_buffer_peek_batch(
+            rb: *mut RingBufferT,
+            cursor: *mut RingBufferCursor,
+            msgs: *mut RingBufferMessage,
+            max: usize,
+        ) -> c_int;
+        pub fn ring_buffer_release(rb: *mut RingBufferT, cursor: *mut RingBufferCursor) -> c_int;
+        pub fn ring_buffer_seek_time(rb: *mut RingBufferT, timestamp: u64, cursor: *mut RingBufferCursor) -> c_int;
+        pub fn ring_buffer_decode(
+            msg: *const RingBufferMessage,
+            arena: *mut c_void,
+            arena_size: usize,
+            data: *mut *const c_void,
+            size: *mut usize,
+        ) -> c_int;
+        pub fn ring_buffer_available_read(rb: *const RingBufferT) -> usize;
+        pub fn ring_buffer_trim(rb: *mut RingBufferT) -> c_int;
+        pub fn ring_buffer_capacity(rb: *const RingBufferT) -> usize;
+        pub fn ring_buffer_utilization(rb: *const RingBufferT) -> f64;
+        pub fn ring_buffer_validate(rb: *const RingBufferT) -> bool;
+        pub fn ring_spill_create(rb: *mut RingBufferT, config: *const RingSpillConfig) -> *mut RingSpillT;
+        pub fn ring_spill_poll(spill: *mut RingSpillT, timeout_ns: i64) -> c_int;
+        pub fn ring_spill_seal(spill: *mut RingSpillT) -> c_int;
+        pub fn ring_spill_destroy(spill: *mut RingSpillT);
+        pub fn ring_spill_segment_open(path: *const c_char) -> *mut RingSpillSegmentT;
+        pub fn ring_spill_segment_next(segment: *mut RingSpillSegmentT, msg: *mut RingBufferMessage) -> c_int;
+        pub fn ring_spill_segment_header(segment: *const RingSpillSegmentT) -> *const RingSpillSegmentHeader;
+        pub fn ring_spill_segment_close(segment: *mut RingSpillSegmentT);
+    }
+}
+
+/// Map a C return code to a result
+fn check(code: c_int) -> RingBufferResult<()> {
+    if code >= 0 {
+        Ok(())
+    } else {
+        Err(RingBufferError::from(code))
+    }
+}
+
+fn path_to_cstring(path: &Path) -> RingBufferResult<CString> {
+    CString::new(path.as_os_str().as_bytes()).map_err(|_| RingBufferError::InitializationFailed {
+        reason: format!("invalid ring buffer path: {}", path.display()),
+    })
+}
+
+/// Handle on a shared ring buffer file
+pub struct RingBuffer {
+    ptr: NonNull<ffi::RingBufferT>,
+    spill: Option<NonNull<ffi::RingSpillT>>,
+}
+
+// The C buffer is lock-free and safe to use from any thread
+unsafe impl Send for RingBuffer {}
+unsafe impl Sync for RingBuffer {}
+
+impl RingBuffer {
+    /// Attach to the ring buffer the collectors created at `path`
+    pub fn open(path: &Path) -> RingBufferResult<Self> {
+        let c_path = path_to_cstring(path)?;
+        let ptr = unsafe { ffi::ring_buffer_open_shared(c_path.as_ptr(), 0) };
+
+        NonNull::new(ptr)
+            .map(|ptr| Self { ptr, spill: None })
+            .ok_or_else(|| RingBufferError::InitializationFailed {
+                reason: format!("cannot open ring buffer at {}", path.display()),
+            })
+    }
+
+    /// Create a ring buffer file, truncating any existing one
+    pub fn create(path: &Path, size: usize) -> RingBufferResult<Self> {
+        Self::create_with(path, ffi::RingBufferConfig { size, ..Default::default() })
+    }
+
+    /// Create an elastic ring buffer file that starts out admitting
+    /// `initial_size` bytes and grows on demand up to `size`
+    pub fn create_elastic(path: &Path, size: usize, initial_size: usize) -> RingBufferResult<Self> {
+        Self::create_with(path, ffi::RingBufferConfig { size, flags: FLAG_ELASTIC, initial_size, ..Default::default() })
+    }
+
+    fn create_with(path: &Path, config: ffi::RingBufferConfig) -> RingBufferResult<Self> {
+        let c_path = path_to_cstring(path)?;
+        let ptr = unsafe { ffi::ring_buffer_create_shared(c_path.as_ptr(), &config) };
+
+        NonNull::new(ptr)
+            .map(|ptr| Self { ptr, spill: None })
+            .ok_or_else(|| RingBufferError::InitializationFailed {
+                reason: format!("cannot create ring buffer at {}", path.display()),
+            })
+    }
+
+    /// Append one message
+    pub fn write(&self, data: &[u8]) -> RingBufferResult<()> {
+        check(unsafe { ffi::ring_buffer_write(self.ptr.as_ptr(), data.as_ptr() as *const c_void, data.len()) })
+    }
+
+    /// Append one message compressed with `codec`, at normal priority
+    pub fn write_compressed(&self, data: &[u8], codec: u8) -> RingBufferResult<()> {
+        check(unsafe {
+            ffi::ring_buffer_write_compressed(
+                self.ptr.as_ptr(),
+                data.as_ptr() as *const c_void,
+                data.len(),
+                codec as c_int,
+                1, // RING_BUFFER_PRIORITY_NORMAL
+            )
+        })
+    }
+
+    /// Append `(timestamp_ns, bytes)` records packed into slabs, at normal priority
+    pub fn write_records(&self, records: &[(u64, &[u8])]) -> RingBufferResult<()> {
+        let mut slab = std::mem::MaybeUninit::<ffi::RingBufferSlab>::uninit();
+        unsafe { ffi::ring_buffer_slab_init(slab.as_mut_ptr(), 1) }; // RING_BUFFER_PRIORITY_NORMAL
+        let slab = slab.as_mut_ptr();
+        for &(timestamp_ns, data) in records {
+            check(unsafe {
+                ffi::ring_buffer_slab_append(self.ptr.as_ptr(), slab, data.as_ptr() as *const c_void, data.len(), timestamp_ns)
+            })?;
+        }
+        check(unsafe { ffi::ring_buffer_slab_flush(self.ptr.as_ptr(), slab) })
+    }
+
+    /// Bytes published and not yet consumed
+    pub fn available_read(&self) -> usize {
+        unsafe { ffi::ring_buffer_available_read(self.ptr.as_ptr()) }
+    }
+
+    /// Bytes writers may currently fill; below the size only for an elastic buffer
+    pub fn capacity(&self) -> usize {
+        unsafe { ffi::ring_buffer_capacity(self.ptr.as_ptr()) }
+    }
+
+    /// Shrink an elastic buffer back toward its initial capacity
+    ///
+    /// Memory behind the dropped capacity goes back to the OS once the
+    /// buffer is drained. A fixed-size buffer has nothing to trim.
+    pub fn trim(&self) -> RingBufferResult<()> {
+        match unsafe { ffi::ring_buffer_trim(self.ptr.as_ptr()) } {
+            ERROR_UNSUPPORTED => Ok(()),
+            code => check(code),
+        }
+    }
+
+    /// Fraction of the buffer in use (0.0-1.0)
+    pub fn utilization(&self) -> f64 {
+        unsafe { ffi::ring_buffer_utilization(self.ptr.as_ptr()) }
+    }
+
+    /// Fully check the control block and positions
+    ///
+    /// Reads only check the handle itself, so a damaged file is caught here
+    /// rather than as a stream of unreadable records.
+    pub fn validate(&self) -> RingBufferResult<()> {
+        if unsafe { ffi::ring_buffer_validate(self.ptr.as_ptr()) } {
+            Ok(())
+        } else {
+            Err(RingBufferError::Corrupted)
+        }
+    }
+
+    /// Start spilling committed messages to segment files in `dir`,
+    /// rolling over to a new file past `segment_size` bytes
+    ///
+    /// The spill becomes the buffer's consumer: messages are released
+    /// as soon as they are durable in a segment, so nothing may drain
+    /// the buffer while it runs. [`RingBuffer::spill`] moves it along.
+    pub fn start_spill(&mut self, dir: &Path, segment_size: usize) -> RingBufferResult<()> {
+        if self.spill.is_some() {
+            return Err(RingBufferError::InvalidOperation);
+        }
+
+        let c_dir = path_to_cstring(dir)?;
+        let config = ffi::RingSpillConfig { directory: c_dir.as_ptr(), segment_size, batch_size: 0, flags: 0 };
+        let ptr = unsafe { ffi::ring_spill_create(self.ptr.as_ptr(), &config) };
+        self.spill = Some(NonNull::new(ptr).ok_or_else(|| RingBufferError::InitializationFailed {
+            reason: format!("cannot spill ring buffer to {}", dir.display()),
+        })?);
+        Ok(())
+    }
+
+    /// Whether [`RingBuffer::start_spill`] has been called
+    pub fn is_spilling(&self) -> bool {
+        self.spill.is_some()
+    }
+
+    /// Collect the spill's finished write, if any, and start the next
+    /// one without waiting; returns the messages released
+    ///
+    /// After an error the same messages are written again next time.
+    pub fn spill(&mut self) -> RingBufferResult<usize> {
+        self.spill_wait(Duration::ZERO)
+    }
+
+    /// Like [`RingBuffer::spill`], but wait up to `timeout` for the
+    /// write in flight to finish first
+    pub fn spill_wait(&mut self, timeout: Duration) -> RingBufferResult<usize> {
+        let spill = self.spill.ok_or(RingBufferError::InvalidOperation)?;
+        let timeout_ns = i64::try_from(timeout.as_nanos()).unwrap_or(i64::MAX);
+        let released = unsafe { ffi::ring_spill_poll(spill.as_ptr(), timeout_ns) };
+        check(released)?;
+        Ok(released as usize)
+    }
+
+    /// Write out everything committed so far and seal the open segment
+    ///
+    /// Every segment in the spill directory is complete afterwards and
+    /// may be merged and deleted.
+    pub fn seal_spill(&mut self) -> RingBufferResult<()> {
+        let spill = self.spill.ok_or(RingBufferError::InvalidOperation)?;
+        check(unsafe { ffi::ring_spill_seal(spill.as_ptr()) })
+    }
+
+    /// Start borrowing the backlog; see [`Drain`]
+    pub fn drain(&mut self) -> Drain<'_> {
+        Drain {
+            rb: self,
+            cursor: ffi::RingBufferCursor::default(),
+            batch: Vec::with_capacity(DRAIN_BATCH_SIZE),
+            start: None,
+        }
+    }
+
+    /// Start borrowing at the first message written at or after
+    /// `timestamp_ns`, found through the buffer's time index
+    ///
+    /// Releasing this drain also consumes the messages it skipped.
+    pub fn drain_since(&mut self, timestamp_ns: u64) -> RingBufferResult<Drain<'_>> {
+        let mut drain = self.drain();
+        let code = unsafe { ffi::ring_buffer_seek_time(drain.rb.ptr.as_ptr(), timestamp_ns, &mut drain.cursor) };
+        if code != ERROR_EMPTY {
+            check(code)?;
+        }
+        Ok(drain)
+    }
+}
+
+impl Drop for RingBuffer {
+    fn drop(&mut self) {
+        // The spill seals its segment and releases the buffer last
+        if let Some(spill) = self.spill.take() {
+            unsafe { ffi::ring_spill_destroy(spill.as_ptr()) }
+        }
+        unsafe { ffi::ring_buffer_destroy(self.ptr.as_ptr()) }
+    }
+}
+
+/// A message borrowed from the ring buffer
+#[derive(Debug, Clone, Copy)]
+pub struct Message<'a> {
+    /// Write time recorded by the producer, in nanoseconds since the epoch
+    pub timestamp_ns: u64,
+
+    /// Payload codec, one of the `CODEC_*` constants
+    pub codec: u8,
+
+    /// Whether the payload is a slab of small records
+    pub slab: bool,
+
+    /// Payload as stored, straight from the shared mapping
+    pub payload: &'a [u8],
+
+    raw: ffi::RingBufferMessage,
+}
+
+impl<'a> Message<'a> {
+    /// Borrow a message the C library filled in; it must outlive `'a`
+    unsafe fn from_raw(msg: &ffi::RingBufferMessage) -> Self {
+        Message {
+            timestamp_ns: { msg.header.timestamp },
+            codec: ({ msg.header.reserved } >> 8) as u8,
+            slab: { msg.header.reserved } & HEADER_SLAB != 0,
+            payload: std::slice::from_raw_parts(msg.data as *const u8, msg.data_size),
+            raw: *msg,
+        }
+    }
+
+    /// The original Arrow IPC bytes
+    ///
+    /// Uncompressed payloads are borrowed from the mapping; compressed
+    /// ones are decompressed into `arena`, which is reused across calls.
+    /// Zstd is decoded here rather than in C so the packer reads it
+    /// whatever codecs the C library was built with.
+    pub fn decode<'b>(&self, arena: &'b mut Vec<u8>) -> RingBufferResult<&'b [u8]>
+    where
+        'a: 'b,
+    {
+        if self.codec == CODEC_NONE {
+            return Ok(self.payload);
+        }
+
+        let size = match self.payload.get(..CODEC_PREFIX_SIZE) {
+            Some(prefix) => u32::from_le_bytes(prefix.try_into().unwrap()) as usize,
+            None => return Err(RingBufferError::Corrupted),
+        };
+        arena.clear();
+        arena.reserve(size);
+
+        if self.codec == CODEC_ZSTD {
+            let written = zstd::bulk::decompress_to_buffer(&self.payload[CODEC_PREFIX_SIZE..], arena)
+                .map_err(|_| RingBufferError::Corrupted)?;
+            if written != size {
+                return Err(RingBufferError::Corrupted);
+            }
+            return Ok(arena.as_slice());
+        }
+
+        let mut data: *const c_void = std::ptr::null();
+        let mut decoded = 0usize;
+        check(unsafe {
+            ffi::ring_buffer_decode(
+                &self.raw,
+                arena.as_mut_ptr() as *mut c_void,
+                arena.capacity(),
+                &mut data,
+                &mut decoded,
+            )
+        })?;
+
+        // The C side filled the first `decoded` bytes of the arena
+        unsafe { arena.set_len(decoded) };
+        Ok(arena.as_slice())
+    }
+
+    /// The `(timestamp_ns, bytes)` records of a slab, borrowed from the mapping
+    ///
+    /// A message that isn't a slab is its own single record. Slabs are
+    /// never compressed, so the records of a slab need no decoding.
+    pub fn records(&self) -> Records<'a> {
+        Records {
+            rest: self.payload,
+            timestamp_ns: self.timestamp_ns,
+            slab: self.slab,
+        }
+    }
+}
+
+/// Iterator over the records of a [`Message`]
+pub struct Records<'a> {
+    rest: &'a [u8],
+    timestamp_ns: u64,
+    slab: bool,
+}
+
+/// Read a LEB128 varint off the front of `bytes`
+fn take_varint(bytes: &mut &[u8]) -> Option<u64> {
+    let mut value = 0u64;
+    for shift in (0..64).step_by(7) {
+        let (&byte, rest) = bytes.split_first()?;
+        *bytes = rest;
+        value |= u64::from(byte & 0x7F) << shift;
+        if byte & 0x80 == 0 {
+            return Some(value);
+        }
+    }
+    None
+}
+
+impl<'a> Iterator for Records<'a> {
+    type Item = RingBufferResult<(u64, &'a [u8])>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.rest.is_empty() {
+            return None;
+        }
+        if !self.slab {
+            return Some(Ok((self.timestamp_ns, std::mem::take(&mut self.rest))));
+        }
+
+        // Zigzag timestamp delta from the previous record, then the length
+        let mut rest = self.rest;
+        let record = take_varint(&mut rest).zip(take_varint(&mut rest)).and_then(|(delta, length)| {
+            let length = usize::try_from(length).ok().filter(|&n| n > 0 && n <= rest.len())?;
+            let (bytes, tail) = rest.split_at(length);
+            Some((delta, bytes, tail))
+        });
+        let Some((delta, bytes, tail)) = record else {
+            self.rest = &[];
+            return Some(Err(RingBufferError::Corrupted));
+        };
+
+        self.timestamp_ns = self.timestamp_ns.wrapping_add((delta >> 1) ^ (delta & 1).wrapping_neg());
+        self.rest = tail;
+        Some(Ok((self.timestamp_ns, bytes)))
+    }
+}
+
+/// Zero-copy walk over the ring buffer backlog
+///
+/// Messages are peeked, not consumed: producers can't reuse their space
+/// until [`Drain::release`], so nothing is lost if the packer fails
+/// before the data is written out.
+pub struct Drain<'a> {
+    rb: &'a mut RingBuffer,
+    cursor: ffi::RingBufferCursor,
+    batch: Vec<ffi::RingBufferMessage>,
+    start: Option<usize>,
+}
+
+// The borrowed message pointers stay valid wherever the drain moves
+unsafe impl Send for Drain<'_> {}
+
+impl Drain<'_> {
+    /// Borrow up to [`DRAIN_BATCH_SIZE`] further messages; empty once caught up
+    pub fn next_batch(&mut self) -> RingBufferResult<impl ExactSizeIterator<Item = Message<'_>> + '_> {
+        // The first batch starts at the cursor, or at the oldest message past it
+        if self.start.is_none() {
+            let mut oldest = ffi::RingBufferCursor::default();
+            let code = unsafe { ffi::ring_buffer_seek_time(self.rb.ptr.as_ptr(), 0, &mut oldest) };
+            if code != ERROR_EMPTY {
+                check(code)?;
+            }
+            self.start = Some(oldest.pos.max(self.cursor.pos));
+        }
+
+        self.batch.clear();
+        let count = unsafe {
+            ffi::ring_buffer_peek_batch(
+                self.rb.ptr.as_ptr(),
+                &mut self.cursor,
+                self.batch.as_mut_ptr(),
+                self.batch.capacity(),
+            )
+        };
+        check(count)?;
+
+        // The C side filled the first count entries
+        unsafe { self.batch.set_len(count as usize) };
+
+        Ok(self.batch.iter().map(|msg| unsafe { Message::from_raw(msg) }))
+    }
+
+    /// Ring position the drain started at, once a batch was borrowed
+    ///
+    /// Every drain of a backlog starts at the same place until one of
+    /// them is released, so the position can name what is made of it.
+    pub fn start(&self) -> Option<usize> {
+        self.start
+    }
+
+    /// Messages borrowed so far
+    pub fn messages(&self) -> u64 {
+        self.cursor.messages
+    }
+
+    /// Payload bytes borrowed so far
+    pub fn bytes(&self) -> u64 {
+        self.cursor.bytes
+    }
+
+    /// Consume every message borrowed so far; call once it is durable
+    pub fn release(mut self) -> RingBufferResult<()> {
+        check(unsafe { ffi::ring_buffer_release(self.rb.ptr.as_ptr(), &mut self.cursor) })
+    }
+}
+
+/// A spill segment file, read back through the C library
+///
+/// Messages borrow a read-only mapping of the file, checked against the
+/// checksums their producers wrote.
+pub struct Segment {
+    ptr: NonNull<ffi::RingSpillSegmentT>,
+}
+
+// The mapping is read-only and owned by the handle
+unsafe impl Send for Segment {}
+
+impl Segment {
+    /// Open a segment, sealed or left behind by a spill that stopped early
+    pub fn open(path: &Path) -> RingBufferResult<Self> {
+        let c_path = path_to_cstring(path)?;
+        let ptr = unsafe { ffi::ring_spill_segment_open(c_path.as_ptr()) };
+
+        NonNull::new(ptr)
+            .map(|ptr| Self { ptr })
+            .ok_or_else(|| RingBufferError::ReadError {
+                reason: format!("not a spill segment: {}", path.display()),
+            })
+    }
+
+    /// Whether the spill finished this segment and moved on
+    pub fn is_sealed(&self) -> bool {
+        let header = unsafe { &*ffi::ring_spill_segment_header(self.ptr.as_ptr()) };
+        header.flags & SEGMENT_SEALED != 0
+    }
+
+    /// The next message, or `None` at the end of the segment
+    pub fn next_message(&mut self) -> RingBufferResult<Option<Message<'_>>> {
+        let mut msg = std::mem::MaybeUninit::<ffi::RingBufferMessage>::uninit();
+        match unsafe { ffi::ring_spill_segment_next(self.ptr.as_ptr(), msg.as_mut_ptr()) } {
+            ERROR_EMPTY => Ok(None),
+            code => {
+                check(code)?;
+                Ok(Some(unsafe { Message::from_raw(&msg.assume_init()) }))
+            }
+        }
+    }
+}
+
+impl Drop for Segment {
+    fn drop(&mut self) {
+        unsafe { ffi::ring_spill_segment_close(self.ptr.as_ptr()) }
+    }
+}
+
+/// Segment files in `dir`, oldest first
+pub fn spill_segments(dir: &Path) -> RingBufferResult<Vec<PathBuf>> {
+    let entries = std::fs::read_dir(dir).map_err(|e| RingBufferError::ReadError {
+        reason: format!("cannot list {}: {}", dir.display(), e),
+    })?;
+
+    // Names carry the creation time, zero-padded, so they sort in order
+    let mut segments: Vec<PathBuf> = entries
+        .filter_map(|entry| entry.ok())
+        .map(|entry| entry.path())
+        .filter(|path| {
+            path.file_name()
+                .and_then(|name| name.to_str())
+                .is_some_and(|name| name.starts_with(SEGMENT_PREFIX) && name.ends_with(SEGMENT_SUFFIX))
+        })
+        .collect();
+    segments.sort();
+    Ok(segments)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn values(drain: &mut Drain<'_>) -> Vec<u32> {
+        drain
+            .next_batch()
+            .unwrap()
+            .map(|msg| u32::from_le_bytes(msg.payload.try_into().unwrap()))
+            .collect()
+    }
+
+    #[test]
+    fn test_drain_keeps_messages_until_release() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("ring");
+        let writer = RingBuffer::create(&path, 64 * 1024).unwrap();
+        let mut reader = RingBuffer::open(&path).unwrap();
+
+        for i in 0..1000u32 {
+            writer.write(&i.to_le_bytes()).unwrap();
+        }
+        let backlog = reader.available_read();
+
+        // Walk everything, batch by batch, in write order
+        let mut drain = reader.drain();
+        let mut next = 0u32;
+        loop {
+            let batch = values(&mut drain);
+            if batch.is_empty() {
+                break;
+            }
+            assert!(batch.len() <= DRAIN_BATCH_SIZE);
+            for value in batch {
+                assert_eq!(value, next);
+                next += 1;
+            }
+        }
+        assert_eq!(next, 1000);
+        assert_eq!(drain.messages(), 1000);
+        assert_eq!(drain.bytes(), 4000);
+        let start = drain.start().unwrap();
+
+        // Dropping the drain keeps the backlog for the next run
+        drop(drain);
+        assert_eq!(reader.available_read(), backlog);
+
+        // Releasing consumes only what was borrowed
+        let mut drain = reader.drain();
+        assert_eq!(drain.start(), None);
+        assert_eq!(values(&mut drain).len(), DRAIN_BATCH_SIZE);
+        assert_eq!(drain.start(), Some(start));
+        drain.release().unwrap();
+        assert!(reader.available_read() < backlog);
+
+        let mut drain = reader.drain();
+        assert_eq!(values(&mut drain)[0], DRAIN_BATCH_SIZE as u32);
+        assert!(drain.start().unwrap() > start);
+    }
+
+    #[test]
+    fn test_drain_since_timestamp() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("ring");
+        let writer = RingBuffer::create(&path, 1024 * 1024).unwrap();
+        let mut reader = RingBuffer::open(&path).unwrap();
+
+        let payload = [0u8; 1000];
+        for i in 0..600u32 {
+            let mut data = payload;
+            data[..4].copy_from_slice(&i.to_le_bytes());
+            writer.write(&data).unwrap();
+        }
+
+        let mut stamps = Vec::new();
+        let mut drain = reader.drain();
+        loop {
+            let batch: Vec<u64> = drain.next_batch().unwrap().map(|m| m.timestamp_ns).collect();
+            if batch.is_empty() {
+                break;
+            }
+            stamps.extend(batch);
+        }
+        drop(drain);
+
+        // Lands on the first message stamped at or after the target
+        let target = stamps[450];
+        let expected = stamps.iter().position(|&ts| ts >= target).unwrap() as u32;
+        let mut drain = reader.drain_since(target).unwrap();
+        let first = drain.next_batch().unwrap().next().unwrap();
+        assert_eq!(u32::from_le_bytes(first.payload[..4].try_into().unwrap()), expected);
+
+        // Nothing that recent yet
+        let mut drain = reader.drain_since(stamps[599] + 1).unwrap();
+        assert_eq!(drain.next_batch().unwrap().len(), 0);
+    }
+
+    #[test]
+    fn test_decode_compressed_messages() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("ring");
+        let mut rb = RingBuffer::create(&path, 1024 * 1024).unwrap();
+
+        let frame = b"{\"type\":\"screen_capture\",\"pixels\":\"AAAA\"}".repeat(500);
+        rb.write_compressed(&frame, CODEC_LZ4).unwrap();
+        rb.write(b"plain").unwrap();
+
+        let mut arena = Vec::new();
+        let mut drain = rb.drain();
+        let messages: Vec<_> = drain.next_batch().unwrap().collect();
+        assert_eq!(messages.len(), 2);
+
+        assert_eq!(messages[0].codec, CODEC_LZ4);
+        assert!(messages[0].payload.len() < frame.len() / 4);
+        assert_eq!(messages[0].decode(&mut arena).unwrap(), frame.as_slice());
+
+        assert_eq!(messages[1].codec, CODEC_NONE);
+        assert_eq!(messages[1].decode(&mut arena).unwrap(), b"plain");
+    }
+
+    #[test]
+    fn test_slab_records() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("ring");
+        let mut rb = RingBuffer::create(&path, 1024 * 1024).unwrap();
+
+        let records: Vec<(u64, Vec<u8>)> = (0..100u64)
+            .map(|i| (1_700_000_000_000_000_000 + i * 3_000_000 - (i % 5) * 1_000, format!("key {}", i).into_bytes()))
+            .collect();
+        let borrowed: Vec<(u64, &[u8])> = records.iter().map(|(ts, data)| (*ts, data.as_slice())).collect();
+        rb.write_records(&borrowed).unwrap();
+        rb.write(b"plain").unwrap();
+
+        let mut drain = rb.drain();
+        let messages: Vec<_> = drain.next_batch().unwrap().collect();
+        assert!(messages.len() < 10);
+        assert!(messages[..messages.len() - 1].iter().all(|m| m.slab));
+
+        let walked: Vec<(u64, &[u8])> = messages.iter().flat_map(|m| m.records()).map(|r| r.unwrap()).collect();
+        assert_eq!(&walked[..100], borrowed.as_slice());
+        assert_eq!(walked[100], (messages.last().unwrap().timestamp_ns, &b"plain"[..]));
+    }
+
+    #[test]
+    fn test_elastic_trim() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("ring");
+        let writer = RingBuffer::create_elastic(&path, 1024 * 1024, 64 * 1024).unwrap();
+        let mut reader = RingBuffer::open(&path).unwrap();
+        assert_eq!(reader.capacity(), 64 * 1024);
+
+        let data = [7u8; 1000];
+        for _ in 0..256 {
+            writer.write(&data).unwrap();
+        }
+        assert!(reader.capacity() > 256 * 1000);
+
+        let mut drain = reader.drain();
+        while drain.next_batch().unwrap().len() > 0 {}
+        drain.release().unwrap();
+        reader.trim().unwrap();
+        assert_eq!(reader.capacity(), 64 * 1024);
+        writer.write(&data).unwrap();
+    }
+
+    #[test]
+    fn test_spill_segments() {
+        let temp_dir = TempDir::new().unwrap();
+        let path = temp_dir.path().join("ring");
+        let spill_dir = temp_dir.path().join("spill");
+        std::fs::create_dir(&spill_dir).unwrap();
+        let writer = RingBuffer::create(&path, 16 * 1024).unwrap();
+        let mut reader = RingBuffer::open(&path).unwrap();
+        reader.start_spill(&spill_dir, 16 * 1024).unwrap();
+        assert!(matches!(reader.start_spill(&spill_dir, 16 * 1024), Err(RingBufferError::InvalidOperation)));
+
+        // Keep spilling while writing well past the buffer size
+        let text = b"spilled to disk and read back again ".repeat(20);
+        for i in 0..2000u32 {
+            while writer.write(&i.to_le_bytes()).is_err() {
+                reader.spill().unwrap();
+            }
+            if i % 500 == 0 {
+                writer.write_compressed(&text, CODEC_LZ4).unwrap();
+            }
+        }
+        reader.seal_spill().unwrap();
+        assert_eq!(reader.available_read(), 0);
+
+        let segments = spill_segments(&spill_dir).unwrap();
+        assert!(segments.len() > 1);
+        let mut values = Vec::new();
+        let mut arena = Vec::new();
+        for path in &segments {
+            let mut segment = Segment::open(path).unwrap();
+            assert!(segment.is_sealed());
+            while let Some(message) = segment.next_message().unwrap() {
+                if message.codec == CODEC_LZ4 {
+                    assert_eq!(message.decode(&mut arena).unwrap(), text.as_slice());
+                } else {
+                    values.push(u32::from_le_bytes(message.payload.try_into().unwrap()));
+                }
+            }
+        }
+        assert_eq!(values, (0..2000).collect::<Vec<_>>());
+        assert!(Segment::open(&path).is_err());
+    }
+
+    #[test]
+    fn test_open_missing_buffer() {
+        let temp_dir = TempDir::new().unwrap();
+        let result = RingBuffer::open(&temp_dir.path().join("missing"));
+        assert!(matches!(result, Err(RingBufferError::InitializationFailed { .. })));
+    }
+}
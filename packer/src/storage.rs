@@ -270,6 +270,44 @@ impl StorageManager {
             });
         }
         
+        // Convert events to Arrow record batch
+        let record_batch = self.events_to_record_batch(events)?;
+        
+        self.write_batches_to_parquet(std::slice::from_ref(&record_batch), date).await
+    }
+    
+    /// Write record batches sharing one schema to a new Parquet file
+    ///
+    /// The file and its directory entry are synced before returning, so
+    /// the data is durable once this succeeds and its source may be dropped.
+    pub async fn write_batches_to_parquet(
+        &mut self,
+        batches: &[RecordBatch],
+        date: &DateTime<Utc>,
+    ) -> StorageResult<PathBuf> {
+        // Several files can land on the same date
+        let name = Uuid::new_v4().simple().to_string();
+        self.write_batches_to_parquet_named(batches, date, &name).await
+    }
+    
+    /// Write record batches sharing one schema to the Parquet file `name`
+    /// stands for on that date, replacing any earlier file of that name
+    ///
+    /// Writing the same batches again under the same name therefore
+    /// doesn't duplicate them. Durable on return, as with
+    /// [`StorageManager::write_batches_to_parquet`].
+    pub async fn write_batches_to_parquet_named(
+        &mut self,
+        batches: &[RecordBatch],
+        date: &DateTime<Utc>,
+        name: &str,
+    ) -> StorageResult<PathBuf> {
+        if batches.is_empty() {
+            return Err(StorageError::InvalidFormat { 
+                path: "empty record batch array".to_string() 
+            });
+        }
+        
         // Create date directory
         let date_dir = self.get_date_directory(date);
         fs::create_dir_all(&date_dir)
@@ -277,16 +315,12 @@ impl StorageManager {
                 path: date_dir.to_string_lossy().to_string() 
             })?;
         
-        // Create file path
-        let file_name = format!("events_{}.parquet", date.format("%Y%m%d_%H%M%S"));
+        let file_name = format!("events_{}_{}.parquet", date.format("%Y%m%d_%H%M%S"), name);
         let file_path = date_dir.join(&file_name);
         
-        // Convert events to Arrow record batch
-        let record_batch = self.events_to_record_batch(events)?;
-        
         // Write to temporary file first
         let temp_file_path = file_path.with_extension("tmp");
-        self.write_parquet_file(&record_batch, &temp_file_path).await?;
+        self.write_parquet_file(batches, &temp_file_path).await?;
         
         // Encrypt if configured
         if let Some(encryption) = &self.encryption {
@@ -297,12 +331,24 @@ impl StorageManager {
                 })?;
         }
         
-        // Move to final location
+        // Flush the contents, then make the rename itself durable
+        File::open(&temp_file_path)
+            .and_then(|file| file.sync_all())
+            .map_err(|e| StorageError::ParquetWriteError { 
+                reason: format!("Failed to sync {}: {}", temp_file_path.display(), e) 
+            })?;
+        
         fs::rename(&temp_file_path, &file_path)
             .map_err(|_| StorageError::ParquetWriteError { 
                 reason: format!("Failed to rename {} to {}", temp_file_path.display(), file_path.display()) 
             })?;
         
+        File::open(&date_dir)
+            .and_then(|dir| dir.sync_all())
+            .map_err(|e| StorageError::ParquetWriteError { 
+                reason: format!("Failed to sync {}: {}", date_dir.display(), e) 
+            })?;
+        
         // Calculate file size and checksum
         let file_size = fs::metadata(&file_path)
             .map_err(|_| StorageError::FileNotFound { 
@@ -311,6 +357,7 @@ impl StorageManager {
             .len();
         
         let checksum = self.integrity.calculate_file_checksum(&file_path)?;
+        let record_count: usize = batches.iter().map(|batch| batch.num_rows()).sum();
         
         // Create metadata
         let metadata = FileMetadata {
@@ -325,7 +372,7 @@ impl StorageManager {
             encrypted: self.encryption.is_some(),
             checksum,
             schema_version: 1,
-            record_count: Some(events.len() as u64),
+            record_count: Some(record_count as u64),
             metadata: HashMap::new(),
         };
         
@@ -333,7 +380,7 @@ impl StorageManager {
         self.metadata_cache.insert(file_path.clone(), metadata);
         self.save_metadata_cache()?;
         
-        tracing::info!("Wrote {} events to {}", events.len(), file_path.display());
+        tracing::info!("Wrote {} events to {}", record_count, file_path.display());
         Ok(file_path)
     }
     
@@ -376,7 +423,7 @@ impl StorageManager {
     /// Write record batch to Parquet file
     async fn write_parquet_file(
         &self,
-        record_batch: &RecordBatch,
+        batches: &[RecordBatch],
         file_path: &Path,
     ) -> StorageResult<()> {
         let file = File::create(file_path)
@@ -384,15 +431,17 @@ impl StorageManager {
                 reason: format!("Failed to create file: {}", file_path.display()) 
             })?;
         
-        let mut writer = ArrowWriter::try_new(file, record_batch.schema(), Some(self.writer_properties.clone()))
+        let mut writer = ArrowWriter::try_new(file, batches[0].schema(), Some(self.writer_properties.clone()))
             .map_err(|e| StorageError::ParquetWriteError { 
                 reason: format!("Failed to create Arrow writer: {}", e) 
             })?;
         
-        writer.write(record_batch)
-            .map_err(|e| StorageError::ParquetWriteError { 
-                reason: format!("Failed to write record batch: {}", e) 
-            })?;
+        for record_batch in batches {
+            writer.write(record_batch)
+                .map_err(|e| StorageError::ParquetWriteError { 
+                    reason: format!("Failed to write record batch: {}", e) 
+                })?;
+        }
         
         writer.close()
             .map_err(|e| StorageError::ParquetWriteError { 
@@ -403,10 +452,16 @@ impl StorageManager {
     }
     
     /// Process and store HEIF frames
+    ///
+    /// Frames are named after `name` and their index, so storing the same
+    /// frames again under the same name replaces them. The frames and
+    /// their directory entries are synced before returning; thumbnails
+    /// are previews and aren't.
     pub async fn process_heif_frames(
         &mut self,
         frames: &[HeifFrame],
         date: &DateTime<Utc>,
+        name: &str,
     ) -> StorageResult<Vec<PathBuf>> {
         if frames.is_empty() {
             return Ok(Vec::new());
@@ -422,13 +477,21 @@ impl StorageManager {
         let mut processed_files = Vec::new();
         
         for (i, frame) in frames.iter().enumerate() {
-            let file_name = format!("frame_{}_{:06}.heif", date.format("%Y%m%d_%H%M%S"), i);
+            let file_name = format!("frame_{}_{}_{:06}.heif", date.format("%Y%m%d_%H%M%S"), name, i);
             let file_path = heif_dir.join(&file_name);
             
             self.process_single_heif_frame(frame, &file_path).await?;
             processed_files.push(file_path);
         }
         
+        // Make the renames durable, then the metadata that records them
+        File::open(&heif_dir)
+            .and_then(|dir| dir.sync_all())
+            .map_err(|e| StorageError::HeifProcessingError { 
+                reason: format!("Failed to sync {}: {}", heif_dir.display(), e) 
+            })?;
+        self.save_metadata_cache()?;
+        
         tracing::info!("Processed {} HEIF frames to {}", frames.len(), heif_dir.display());
         Ok(processed_files)
     }
@@ -474,7 +537,13 @@ impl StorageManager {
                 })?;
         }
         
-        // Move to final location
+        // Flush the contents, then move to final location
+        File::open(&temp_path)
+            .and_then(|file| file.sync_all())
+            .map_err(|e| StorageError::HeifProcessingError { 
+                reason: format!("Failed to sync {}: {}", temp_path.display(), e) 
+            })?;
+        
         fs::rename(&temp_path, file_path)
             .map_err(|_| StorageError::HeifProcessingError { 
                 reason: format!("Failed to rename {} to {}", temp_path.display(), file_path.display()) 
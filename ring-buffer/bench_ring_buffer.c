@@ -3,7 +3,9 @@
  * @brief Performance benchmarks for the ring buffer implementation
  * 
  * Comprehensive benchmarks to measure throughput, latency, and
- * concurrent performance of the lock-free ring buffer.
+ * concurrent performance of the lock-free ring buffer. Latency is
+ * reported as nanosecond percentiles for diffing runs, optionally as CSV
+ * or JSON.
  */
 
 #include "ring_buffer.h"
@@ -12,6 +14,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
 #include <sys/time.h>
 #include <getopt.h>
@@ -70,6 +73,15 @@ static int pthread_barrier_destroy(pthread_barrier_t *barrier) {
 #define DEFAULT_MESSAGE_SIZE 1024
 #define DEFAULT_THREAD_COUNT 4
 #define DEFAULT_DURATION 10  /* seconds */
+#define DEFAULT_MATRIX_THREADS 4
+#define DEFAULT_CELL_MS 100
+
+/* Latency report output formats */
+typedef enum {
+    OUTPUT_TEXT,
+    OUTPUT_CSV,
+    OUTPUT_JSON
+} output_format_t;
 
 /* Benchmark configuration */
 typedef struct {
@@ -81,6 +93,13 @@ typedef struct {
     bool continuous;
     bool verbose;
     int pattern;
+    double rate;            /* Offered messages per second for latency (0 = closed loop) */
+    output_format_t format; /* Latency report format; CSV and JSON run only that suite */
+    bool latency_only;
+    bool matrix;            /* Run the producer/consumer scaling matrix instead */
+    int max_producers;
+    int max_consumers;
+    int cell_ms;            /* Run time of each matrix cell */
 } bench_config_t;
 
 /* Benchmark results */
@@ -126,11 +145,121 @@ static double get_time(void) {
     return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
 }
 
-/* Get time in microseconds */
-static uint64_t get_time_us(void) {
+/* Get time in nanoseconds */
+static uint64_t get_time_ns(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Log-linear (HDR) latency histogram in nanoseconds. Each power of two
+ * above HDR_SUB_BUCKETS is split into HDR_SUB_BUCKETS linear buckets, so
+ * every recorded value keeps three significant digits, from 1 ns up to
+ * the full 64-bit range, in a fixed 450 KB of counters. */
+#define HDR_SUB_BITS 10
+#define HDR_SUB_BUCKETS (1u << HDR_SUB_BITS)
+#define HDR_BUCKET_COUNT ((64 - HDR_SUB_BITS + 1) * HDR_SUB_BUCKETS)
+
+typedef struct {
+    uint64_t counts[HDR_BUCKET_COUNT];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} hdr_histogram_t;
+
+static void hdr_init(hdr_histogram_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+static size_t hdr_index(uint64_t value) {
+    if (value < HDR_SUB_BUCKETS) {
+        return (size_t)value;
+    }
+    unsigned int shift = (unsigned int)(63 - __builtin_clzll(value)) - HDR_SUB_BITS;
+    return (size_t)(shift + 1) * HDR_SUB_BUCKETS + (size_t)((value >> shift) - HDR_SUB_BUCKETS);
+}
+
+/* Largest value that lands in the bucket, as HdrHistogram reports */
+static uint64_t hdr_value_at_index(size_t index) {
+    if (index < HDR_SUB_BUCKETS) {
+        return index;
+    }
+    unsigned int shift = (unsigned int)(index / HDR_SUB_BUCKETS) - 1;
+    uint64_t sub = HDR_SUB_BUCKETS + index % HDR_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+static void hdr_record(hdr_histogram_t *h, uint64_t value) {
+    h->counts[hdr_index(value)]++;
+    h->total++;
+    h->sum += (double)value;
+    if (value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+}
+
+static uint64_t hdr_percentile(const hdr_histogram_t *h, double percentile) {
+    if (h->total == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)h->total + 0.5);
+    if (rank == 0) rank = 1;
+    
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HDR_BUCKET_COUNT; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t value = hdr_value_at_index(i);
+            return value < h->max ? value : h->max;
+        }
+    }
+    return h->max;
+}
+
+static const double report_percentiles[] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+static const char *const report_percentile_names[] = { "p50", "p90", "p99", "p99.9", "p99.99" };
+#define REPORT_PERCENTILE_COUNT (sizeof(report_percentiles) / sizeof(report_percentiles[0]))
+
+/* Print one histogram; first is set for the first of a report */
+static void print_histogram(output_format_t format, const char *metric, const hdr_histogram_t *h, bool first) {
+    double mean = h->total > 0 ? h->sum / (double)h->total : 0.0;
+    uint64_t min = h->total > 0 ? h->min : 0;
+    
+    switch (format) {
+        case OUTPUT_CSV:
+            if (first) {
+                printf("metric,count,min_ns,mean_ns");
+                for (size_t i = 0; i < REPORT_PERCENTILE_COUNT; i++) {
+                    printf(",%s_ns", report_percentile_names[i]);
+                }
+                printf(",max_ns\n");
+            }
+            printf("%s,%llu,%llu,%.1f", metric, (unsigned long long)h->total, (unsigned long long)min, mean);
+            for (size_t i = 0; i < REPORT_PERCENTILE_COUNT; i++) {
+                printf(",%llu", (unsigned long long)hdr_percentile(h, report_percentiles[i]));
+            }
+            printf(",%llu\n", (unsigned long long)h->max);
+            break;
+        case OUTPUT_JSON:
+            printf("%s    \"%s\": {\"count\": %llu, \"min_ns\": %llu, \"mean_ns\": %.1f",
+                   first ? "" : ",\n", metric, (unsigned long long)h->total, (unsigned long long)min, mean);
+            for (size_t i = 0; i < REPORT_PERCENTILE_COUNT; i++) {
+                printf(", \"%s_ns\": %llu", report_percentile_names[i],
+                       (unsigned long long)hdr_percentile(h, report_percentiles[i]));
+            }
+            printf(", \"max_ns\": %llu}", (unsigned long long)h->max);
+            break;
+        default:
+            printf("%-12s count %-9llu min %-7llu mean %-9.1f", metric, (unsigned long long)h->total,
+                   (unsigned long long)min, mean);
+            for (size_t i = 0; i < REPORT_PERCENTILE_COUNT; i++) {
+                printf(" %s %-7llu", report_percentile_names[i],
+                       (unsigned long long)hdr_percentile(h, report_percentiles[i]));
+            }
+            printf(" max %llu (ns)\n", (unsigned long long)h->max);
+            break;
+    }
 }
 
 /* Generate benchmark data */
@@ -378,7 +507,38 @@ static void bench_concurrent_write(bench_config_t *config, bench_results_t *resu
     ring_buffer_destroy(rb);
 }
 
-/* Latency benchmark */
+/* Print the write, read and end-to-end histograms of a latency run */
+static void print_latency_report(const bench_config_t *config, const hdr_histogram_t *hists) {
+    static const char *const metrics[] = { "write", "read", "end_to_end" };
+    
+    if (config->format == OUTPUT_JSON) {
+        printf("{\n  \"benchmark\": \"latency\",\n  \"message_size\": %zu,\n  \"rate\": %.0f,\n"
+               "  \"histograms\": {\n", config->message_size, config->rate);
+    } else if (config->format == OUTPUT_TEXT) {
+        if (config->rate > 0) {
+            printf("\nLatency percentiles at %.0f msgs/sec, corrected for coordinated omission:\n", config->rate);
+        } else {
+            printf("\nLatency percentiles, closed loop:\n");
+        }
+    }
+    
+    for (size_t i = 0; i < 3; i++) {
+        print_histogram(config->format, metrics[i], &hists[i], i == 0);
+    }
+    
+    if (config->format == OUTPUT_JSON) {
+        printf("\n  }\n}\n");
+    }
+}
+
+/* Latency benchmark
+ * 
+ * Times each write and read call and the whole round trip in nanoseconds.
+ * With a fixed offered rate every message has an intended send time on
+ * the schedule, and end-to-end latency counts from that time rather than
+ * from when the write actually started. A stall then shows up in every
+ * message that should have been sent during it, as a client on the
+ * schedule would see it, instead of as a single slow sample. */
 static void bench_latency(bench_config_t *config, bench_results_t *results) {
     ring_buffer_t *rb = ring_buffer_create(config->buffer_size);
     if (!rb) {
@@ -395,28 +555,45 @@ static void bench_latency(bench_config_t *config, bench_results_t *results) {
     
     generate_bench_data(data, config->message_size, config->pattern);
     
-    uint64_t *latencies = malloc(config->message_count * sizeof(uint64_t));
-    if (!latencies) {
-        printf("Failed to allocate latency array\n");
+    /* Write, read and end-to-end */
+    hdr_histogram_t *hists = malloc(3 * sizeof(hdr_histogram_t));
+    if (!hists) {
+        printf("Failed to allocate latency histograms\n");
         free(data);
         ring_buffer_destroy(rb);
         return;
     }
+    for (int i = 0; i < 3; i++) {
+        hdr_init(&hists[i]);
+    }
     
     memset(results, 0, sizeof(bench_results_t));
     results->start_time = get_time();
-    results->min_latency_us = UINT64_MAX;
-    results->max_latency_us = 0;
     
-    int successful_ops = 0;
+    uint64_t interval_ns = config->rate > 0 ? (uint64_t)(1e9 / config->rate) : 0;
+    uint64_t next_send = get_time_ns();
+    
     for (int i = 0; i < config->message_count && !g_stop_benchmark; i++) {
-        uint64_t start = get_time_us();
+        uint64_t intended = 0;
+        if (interval_ns > 0) {
+            intended = next_send;
+            next_send += interval_ns;
+            while (get_time_ns() < intended) {
+                /* Spin until the scheduled send time */
+            }
+        }
+        
+        uint64_t start = get_time_ns();
+        if (interval_ns == 0) {
+            intended = start;
+        }
         
         ring_buffer_error_t write_result = ring_buffer_write(rb, data, config->message_size);
         if (write_result != RING_BUFFER_SUCCESS) {
             results->errors++;
             continue;
         }
+        uint64_t written = get_time_ns();
         
         ring_buffer_message_t msg;
         ring_buffer_error_t read_result = ring_buffer_read(rb, &msg);
@@ -424,34 +601,28 @@ static void bench_latency(bench_config_t *config, bench_results_t *results) {
             results->errors++;
             continue;
         }
+        uint64_t end = get_time_ns();
         
-        uint64_t end = get_time_us();
-        uint64_t latency = end - start;
+        hdr_record(&hists[0], written - start);
+        hdr_record(&hists[1], end - written);
+        hdr_record(&hists[2], end - intended);
         
-        latencies[successful_ops] = latency;
-        results->avg_latency_us += latency;
-        
-        if (latency < results->min_latency_us) {
-            results->min_latency_us = latency;
-        }
-        if (latency > results->max_latency_us) {
-            results->max_latency_us = latency;
-        }
-        
-        successful_ops++;
         results->messages_processed++;
         results->bytes_processed += config->message_size;
     }
     
     results->end_time = get_time();
+    calculate_stats(results);
     
-    if (successful_ops > 0) {
-        results->avg_latency_us /= successful_ops;
+    if (hists[2].total > 0) {
+        results->avg_latency_us = hists[2].sum / (double)hists[2].total / 1000.0;
+        results->min_latency_us = (double)hists[2].min / 1000.0;
+        results->max_latency_us = (double)hists[2].max / 1000.0;
     }
     
-    calculate_stats(results);
+    print_latency_report(config, hists);
     
-    free(latencies);
+    free(hists);
     free(data);
     ring_buffer_destroy(rb);
 }
@@ -503,6 +674,410 @@ static void bench_memory_usage(bench_config_t *config) {
     ring_buffer_destroy(rb);
 }
 
+/* Scaling matrix: producers x consumers x message size x pinning,
+ * free-running or held near the backpressure threshold */
+
+/* Where matrix threads run */
+typedef enum {
+    PIN_NONE,           /* Scheduler's choice */
+    PIN_SAME_CORE,      /* Every thread on the SMT siblings of one core */
+    PIN_SAME_CLUSTER,   /* Spread over the CPUs sharing one last-level cache (the P cluster on Apple) */
+    PIN_CROSS_CLUSTER,  /* Producers on one cluster, consumers on another (E cores on Apple) */
+    PIN_MODE_COUNT
+} pin_mode_t;
+
+static const char *const pin_mode_names[] = { "none", "same-core", "same-cluster", "cross-cluster" };
+
+#define MATRIX_MAX_CPUS 256
+#define MATRIX_MIN_MESSAGE 64
+#define MATRIX_MAX_MESSAGE (4 * 1024 * 1024)
+
+/* CPU sets used for pinning, read once from sysfs */
+typedef struct {
+    int core[MATRIX_MAX_CPUS];
+    int core_count;
+    int cluster[MATRIX_MAX_CPUS];
+    int cluster_count;
+    int other[MATRIX_MAX_CPUS];     /* Online CPUs outside the cluster */
+    int other_count;
+} cpu_topology_t;
+
+/* One cell of the matrix */
+typedef struct {
+    int producers;
+    int consumers;
+    size_t message_size;
+    pin_mode_t pinning;
+    bool steady;
+} matrix_cell_t;
+
+/* Per-thread state of a matrix cell */
+typedef struct {
+    ring_buffer_t *rb;
+    const matrix_cell_t *cell;
+    const cpu_topology_t *topology;
+    int index;              /* Among the producers or the consumers */
+    bool producer;
+    size_t steady_bytes;    /* Occupancy consumers hold the buffer at in steady mode */
+    volatile bool *stop_flag;
+    pthread_barrier_t *start_barrier;
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t rejected;      /* Writes refused as full or under backpressure */
+} matrix_worker_t;
+
+#if defined(__linux__)
+/* Parse a sysfs CPU list such as "0-3,8-11" */
+static int read_cpu_list(const char *path, int *cpus, int max) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+    
+    int count = 0;
+    int first, last;
+    char separator;
+    while (count < max && fscanf(file, "%d", &first) == 1) {
+        last = first;
+        separator = (char)fgetc(file);
+        if (separator == '-') {
+            if (fscanf(file, "%d", &last) != 1) {
+                break;
+            }
+            separator = (char)fgetc(file);
+        }
+        for (int cpu = first; cpu <= last && count < max; cpu++) {
+            cpus[count++] = cpu;
+        }
+        if (separator != ',') {
+            break;
+        }
+    }
+    
+    fclose(file);
+    return count;
+}
+
+static bool cpu_in_list(int cpu, const int *cpus, int count) {
+    for (int i = 0; i < count; i++) {
+        if (cpus[i] == cpu) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+/* Find the core, cluster and remaining CPUs around the CPU we start on */
+static void detect_topology(cpu_topology_t *topology) {
+    memset(topology, 0, sizeof(*topology));
+    
+#if defined(__linux__)
+    int home = sched_getcpu();
+    if (home < 0) {
+        home = 0;
+    }
+    
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", home);
+    topology->core_count = read_cpu_list(path, topology->core, MATRIX_MAX_CPUS);
+    
+    /* The highest cache index is the last-level cache */
+    for (int index = 0; index < 8; index++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", home, index);
+        int count = read_cpu_list(path, topology->cluster, MATRIX_MAX_CPUS);
+        if (count == 0) {
+            break;
+        }
+        topology->cluster_count = count;
+    }
+    
+    int online[MATRIX_MAX_CPUS];
+    int online_count = read_cpu_list("/sys/devices/system/cpu/online", online, MATRIX_MAX_CPUS);
+    for (int i = 0; i < online_count; i++) {
+        if (!cpu_in_list(online[i], topology->cluster, topology->cluster_count)) {
+            topology->other[topology->other_count++] = online[i];
+        }
+    }
+#elif defined(__APPLE__)
+    /* No hard affinity; clusters are chosen through QoS classes instead */
+    topology->cluster_count = 1;
+    topology->other_count = 1;
+#endif
+}
+
+/* Whether the platform can place threads as the mode asks */
+static bool pin_mode_available(const cpu_topology_t *topology, pin_mode_t mode) {
+    switch (mode) {
+        case PIN_NONE:
+            return true;
+        case PIN_SAME_CORE:
+            return topology->core_count > 0;
+        case PIN_SAME_CLUSTER:
+            return topology->cluster_count > 0;
+        case PIN_CROSS_CLUSTER:
+            return topology->cluster_count > 0 && topology->other_count > 0;
+        default:
+            return false;
+    }
+}
+
+/* Pin the calling matrix thread, spreading threads round-robin over the set */
+static void pin_worker(const matrix_worker_t *worker) {
+    pin_mode_t mode = worker->cell->pinning;
+    if (mode == PIN_NONE) {
+        return;
+    }
+    
+#if defined(__linux__)
+    const cpu_topology_t *topology = worker->topology;
+    const int *cpus = topology->cluster;
+    int count = topology->cluster_count;
+    int slot = worker->producer ? worker->index : worker->cell->producers + worker->index;
+    
+    if (mode == PIN_SAME_CORE) {
+        cpus = topology->core;
+        count = topology->core_count;
+    } else if (mode == PIN_CROSS_CLUSTER && !worker->producer) {
+        cpus = topology->other;
+        count = topology->other_count;
+        slot = worker->index;
+    }
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[slot % count], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(__APPLE__)
+    /* User-interactive work runs on the P cores, background on the E cores */
+    bool efficiency = mode == PIN_CROSS_CLUSTER && !worker->producer;
+    pthread_set_qos_class_self_np(efficiency ? QOS_CLASS_BACKGROUND : QOS_CLASS_USER_INTERACTIVE, 0);
+#endif
+}
+
+static void *matrix_producer(void *arg) {
+    matrix_worker_t *worker = (matrix_worker_t *)arg;
+    size_t size = worker->cell->message_size;
+    char *message = malloc(size);
+    
+    pin_worker(worker);
+    if (message) {
+        generate_bench_data(message, size, worker->index);
+    }
+    pthread_barrier_wait(worker->start_barrier);
+    
+    while (message && !*worker->stop_flag) {
+        ring_buffer_error_t result = ring_buffer_write(worker->rb, message, size);
+        if (result == RING_BUFFER_SUCCESS) {
+            worker->messages++;
+            worker->bytes += size;
+        } else {
+            worker->rejected++;
+            sched_yield();
+        }
+    }
+    
+    free(message);
+    return NULL;
+}
+
+static void *matrix_consumer(void *arg) {
+    matrix_worker_t *worker = (matrix_worker_t *)arg;
+    ring_buffer_message_t msgs[32];
+    
+    pin_worker(worker);
+    pthread_barrier_wait(worker->start_barrier);
+    
+    while (!*worker->stop_flag) {
+        /* Steady state: let the backlog build up to just under the
+         * threshold, and drain only what's above it or backpressure */
+        if (worker->steady_bytes > 0 && ring_buffer_available_read(worker->rb) < worker->steady_bytes &&
+            !ring_buffer_is_backpressure(worker->rb)) {
+            sched_yield();
+            continue;
+        }
+        
+        int count = ring_buffer_read_batch(worker->rb, msgs, worker->steady_bytes > 0 ? 1 : 32);
+        if (count <= 0) {
+            sched_yield();
+            continue;
+        }
+        for (int i = 0; i < count; i++) {
+            worker->bytes += msgs[i].data_size;
+        }
+        worker->messages += (uint64_t)count;
+    }
+    
+    return NULL;
+}
+
+/* Run one cell for duration_ms; returns false if it couldn't start */
+static bool run_matrix_cell(const bench_config_t *config, const cpu_topology_t *topology,
+                            const matrix_cell_t *cell, int duration_ms, matrix_worker_t *totals) {
+    /* Room for a healthy backlog of the largest messages */
+    size_t buffer_size = config->buffer_size;
+    size_t backlog = ring_buffer_next_power_of_2(8 * (cell->message_size + sizeof(arrow_ipc_header_t)));
+    if (buffer_size < backlog) {
+        buffer_size = backlog;
+    }
+    
+    ring_buffer_t *rb = ring_buffer_create(buffer_size);
+    if (!rb) {
+        return false;
+    }
+    
+    int threads = cell->producers + cell->consumers;
+    pthread_t *tids = malloc((size_t)threads * sizeof(pthread_t));
+    matrix_worker_t *workers = calloc((size_t)threads, sizeof(matrix_worker_t));
+    if (!tids || !workers) {
+        free(tids);
+        free(workers);
+        ring_buffer_destroy(rb);
+        return false;
+    }
+    
+    volatile bool stop_flag = false;
+    pthread_barrier_t start_barrier;
+    pthread_barrier_init(&start_barrier, NULL, (unsigned int)threads + 1);
+    
+    /* Hold the backlog a few messages under the backpressure threshold */
+    size_t steady_bytes = 0;
+    if (cell->steady) {
+        size_t threshold = (size_t)(RING_BUFFER_BACKPRESSURE_THRESHOLD * (double)rb->size);
+        size_t margin = 4 * (cell->message_size + sizeof(arrow_ipc_header_t));
+        steady_bytes = threshold > 2 * margin ? threshold - margin : threshold / 2;
+        
+        /* Start the clock with the backlog already in place */
+        char *fill = calloc(1, cell->message_size);
+        while (fill && ring_buffer_available_read(rb) < steady_bytes &&
+               ring_buffer_write(rb, fill, cell->message_size) == RING_BUFFER_SUCCESS) {
+        }
+        free(fill);
+    }
+    
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        matrix_worker_t *worker = &workers[i];
+        worker->rb = rb;
+        worker->cell = cell;
+        worker->topology = topology;
+        worker->producer = i < cell->producers;
+        worker->index = worker->producer ? i : i - cell->producers;
+        worker->steady_bytes = steady_bytes;
+        worker->stop_flag = &stop_flag;
+        worker->start_barrier = &start_barrier;
+        if (pthread_create(&tids[i], NULL, worker->producer ? matrix_producer : matrix_consumer, worker) != 0) {
+            break;
+        }
+        started++;
+    }
+    
+    if (started == threads) {
+        pthread_barrier_wait(&start_barrier);
+        double start = get_time();
+        usleep((useconds_t)duration_ms * 1000);
+        stop_flag = true;
+        
+        for (int i = 0; i < threads; i++) {
+            pthread_join(tids[i], NULL);
+        }
+        double elapsed = get_time() - start;
+        
+        memset(totals, 0, sizeof(*totals));
+        for (int i = 0; i < threads; i++) {
+            if (workers[i].producer) {
+                totals->rejected += workers[i].rejected;
+            } else {
+                totals->messages += workers[i].messages;
+                totals->bytes += workers[i].bytes;
+            }
+        }
+        /* Reuse the fields as rates for the caller */
+        totals->messages = (uint64_t)((double)totals->messages / elapsed);
+        totals->bytes = (uint64_t)((double)totals->bytes / elapsed);
+    } else {
+        /* Release the threads that did start so they can exit */
+        stop_flag = true;
+        printf("Failed to create matrix threads\n");
+    }
+    
+    pthread_barrier_destroy(&start_barrier);
+    free(tids);
+    free(workers);
+    ring_buffer_destroy(rb);
+    return started == threads;
+}
+
+/* Producer and consumer counts: powers of two up to max, and max itself */
+static int next_thread_count(int count, int max) {
+    return count < max && count * 2 > max ? max : count * 2;
+}
+
+static void bench_matrix(const bench_config_t *config) {
+    cpu_topology_t topology;
+    detect_topology(&topology);
+    
+    if (config->format == OUTPUT_TEXT) {
+        printf("\n=== Producer/Consumer Matrix (%d ms per cell) ===\n", config->cell_ms);
+        printf("%-7s %-13s %9s %9s %10s %14s %12s %12s\n", "mode", "pinning", "producers", "consumers",
+               "msg_size", "msgs/sec", "MB/s", "rejected");
+    } else if (config->format == OUTPUT_CSV) {
+        printf("mode,pinning,producers,consumers,message_size,msgs_per_sec,mb_per_sec,rejected_writes\n");
+    } else {
+        printf("[");
+    }
+    
+    bool first = true;
+    for (int steady = 0; steady <= 1 && !g_stop_benchmark; steady++) {
+        for (pin_mode_t pinning = PIN_NONE; pinning < PIN_MODE_COUNT && !g_stop_benchmark; pinning++) {
+            if (!pin_mode_available(&topology, pinning)) {
+                if (config->format == OUTPUT_TEXT && steady == 0) {
+                    printf("(pinning %s unavailable on this machine, skipping)\n", pin_mode_names[pinning]);
+                }
+                continue;
+            }
+            
+            for (int producers = 1; producers <= config->max_producers && !g_stop_benchmark;
+                 producers = next_thread_count(producers, config->max_producers)) {
+                for (int consumers = 1; consumers <= config->max_consumers && !g_stop_benchmark;
+                     consumers = next_thread_count(consumers, config->max_consumers)) {
+                    for (size_t size = MATRIX_MIN_MESSAGE; size <= MATRIX_MAX_MESSAGE && !g_stop_benchmark; size *= 4) {
+                        matrix_cell_t cell = { producers, consumers, size, pinning, steady != 0 };
+                        matrix_worker_t totals;
+                        if (!run_matrix_cell(config, &topology, &cell, config->cell_ms, &totals)) {
+                            continue;
+                        }
+                        
+                        const char *mode = steady ? "steady" : "free";
+                        double mbps = (double)totals.bytes / (1024 * 1024);
+                        if (config->format == OUTPUT_TEXT) {
+                            printf("%-7s %-13s %9d %9d %10zu %14llu %12.2f %12llu\n", mode, pin_mode_names[pinning],
+                                   producers, consumers, size, (unsigned long long)totals.messages, mbps,
+                                   (unsigned long long)totals.rejected);
+                        } else if (config->format == OUTPUT_CSV) {
+                            printf("%s,%s,%d,%d,%zu,%llu,%.2f,%llu\n", mode, pin_mode_names[pinning],
+                                   producers, consumers, size, (unsigned long long)totals.messages, mbps,
+                                   (unsigned long long)totals.rejected);
+                        } else {
+                            printf("%s\n  {\"mode\": \"%s\", \"pinning\": \"%s\", \"producers\": %d, \"consumers\": %d, "
+                                   "\"message_size\": %zu, \"msgs_per_sec\": %llu, \"mb_per_sec\": %.2f, "
+                                   "\"rejected_writes\": %llu}", first ? "" : ",", mode, pin_mode_names[pinning],
+                                   producers, consumers, size, (unsigned long long)totals.messages, mbps,
+                                   (unsigned long long)totals.rejected);
+                        }
+                        first = false;
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+    
+    if (config->format == OUTPUT_JSON) {
+        printf("\n]\n");
+    }
+}
+
 /* Print usage information */
 static void print_usage(const char *program_name) {
     printf("Usage: %s [OPTIONS]\n", program_name);
@@ -515,13 +1090,25 @@ static void print_usage(const char *program_name) {
     printf("  -c, --continuous          Run continuous benchmark\n");
     printf("  -v, --verbose             Verbose output\n");
     printf("  -p, --pattern PATTERN     Data pattern (default: 0)\n");
+    printf("  -r, --rate MSGS           Offered rate for the latency suite in msgs/sec (default: closed loop)\n");
+    printf("  -f, --format FORMAT       Latency report format: text, csv or json (default: text)\n");
+    printf("  -l, --latency-only        Run only the latency suite (implied by csv and json)\n");
+    printf("  -M, --matrix              Run the producer/consumer scaling matrix instead\n");
+    printf("  -P, --producers COUNT     Most producers in the matrix (default: %d)\n", DEFAULT_MATRIX_THREADS);
+    printf("  -C, --consumers COUNT     Most consumers in the matrix (default: %d)\n", DEFAULT_MATRIX_THREADS);
+    printf("  -T, --cell-ms MS          Run time of each matrix cell (default: %d)\n", DEFAULT_CELL_MS);
     printf("  -h, --help                Show this help message\n");
     printf("\nBenchmarks:\n");
     printf("  - Single-threaded write throughput\n");
     printf("  - Single-threaded read throughput\n");
     printf("  - Multi-threaded write throughput\n");
-    printf("  - Round-trip latency\n");
+    printf("  - Write, read and end-to-end latency percentiles\n");
     printf("  - Memory usage analysis\n");
+    printf("\nMatrix (-M), also in the --format chosen:\n");
+    printf("  - 1..P producers x 1..C consumers, message sizes %d B to %d MB\n", MATRIX_MIN_MESSAGE,
+           MATRIX_MAX_MESSAGE / (1024 * 1024));
+    printf("  - Unpinned, same core, same cluster and across clusters\n");
+    printf("  - Free-running, and steady state just under the backpressure threshold\n");
 }
 
 /* Parse command line arguments */
@@ -535,6 +1122,13 @@ static bool parse_args(int argc, char *argv[], bench_config_t *config) {
         {"continuous", no_argument, 0, 'c'},
         {"verbose", no_argument, 0, 'v'},
         {"pattern", required_argument, 0, 'p'},
+        {"rate", required_argument, 0, 'r'},
+        {"format", required_argument, 0, 'f'},
+        {"latency-only", no_argument, 0, 'l'},
+        {"matrix", no_argument, 0, 'M'},
+        {"producers", required_argument, 0, 'P'},
+        {"consumers", required_argument, 0, 'C'},
+        {"cell-ms", required_argument, 0, 'T'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
@@ -542,7 +1136,7 @@ static bool parse_args(int argc, char *argv[], bench_config_t *config) {
     int option_index = 0;
     int c;
     
-    while ((c = getopt_long(argc, argv, "s:m:z:t:d:cvp:h", long_options, &option_index)) != -1) {
+    while ((c = getopt_long(argc, argv, "s:m:z:t:d:cvp:r:f:lMP:C:T:h", long_options, &option_index)) != -1) {
         switch (c) {
             case 's':
                 config->buffer_size = (size_t)atoll(optarg);
@@ -568,6 +1162,37 @@ static bool parse_args(int argc, char *argv[], bench_config_t *config) {
             case 'p':
                 config->pattern = atoi(optarg);
                 break;
+            case 'r':
+                config->rate = atof(optarg);
+                break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) {
+                    config->format = OUTPUT_TEXT;
+                } else if (strcmp(optarg, "csv") == 0) {
+                    config->format = OUTPUT_CSV;
+                } else if (strcmp(optarg, "json") == 0) {
+                    config->format = OUTPUT_JSON;
+                } else {
+                    fprintf(stderr, "Unknown format: %s\n", optarg);
+                    print_usage(argv[0]);
+                    return false;
+                }
+                break;
+            case 'l':
+                config->latency_only = true;
+                break;
+            case 'M':
+                config->matrix = true;
+                break;
+            case 'P':
+                config->max_producers = atoi(optarg);
+                break;
+            case 'C':
+                config->max_consumers = atoi(optarg);
+                break;
+            case 'T':
+                config->cell_ms = atoi(optarg);
+                break;
             case 'h':
                 print_usage(argv[0]);
                 return false;
@@ -590,13 +1215,40 @@ int main(int argc, char *argv[]) {
         .duration = DEFAULT_DURATION,
         .continuous = false,
         .verbose = false,
-        .pattern = 0
+        .pattern = 0,
+        .rate = 0.0,
+        .format = OUTPUT_TEXT,
+        .latency_only = false,
+        .matrix = false,
+        .max_producers = DEFAULT_MATRIX_THREADS,
+        .max_consumers = DEFAULT_MATRIX_THREADS,
+        .cell_ms = DEFAULT_CELL_MS
     };
     
     if (!parse_args(argc, argv, &config)) {
         return 1;
     }
     
+    if (config.matrix) {
+        if (config.max_producers < 1 || config.max_consumers < 1 || config.cell_ms < 1) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        signal(SIGINT, signal_handler);
+        signal(SIGTERM, signal_handler);
+        bench_matrix(&config);
+        return 0;
+    }
+    
+    /* Machine-readable output holds only the latency report */
+    bench_results_t results;
+    if (config.format != OUTPUT_TEXT) {
+        signal(SIGINT, signal_handler);
+        signal(SIGTERM, signal_handler);
+        bench_latency(&config, &results);
+        return 0;
+    }
+    
     /* Install signal handlers */
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
@@ -610,7 +1262,12 @@ int main(int argc, char *argv[]) {
     printf("Thread Count: %d\n", config.thread_count);
     printf("==========================================\n");
     
-    bench_results_t results;
+    if (config.latency_only) {
+        printf("\nRunning latency benchmark...\n");
+        bench_latency(&config, &results);
+        print_results("Latency", &results);
+        return 0;
+    }
     
     /* Single-threaded write benchmark */
     printf("\nRunning single-threaded write benchmark...\n");
@@ -0,0 +1,786 @@
+/**
+ * @file distributed_buffer.c
+ * @brief Sharded ring buffer implementation
+ *
+ * Each shard is an independent ring_buffer_t, optionally file-backed and
+ * bound to a NUMA node. Writes are routed by partition key and stamped
+ * with a global sequence number in a small record prefix; the merged
+ * reader picks the lowest sequence among the shard heads.
+ */
+
+#include "distributed_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+/* Linux memory policy for mbind(2), without depending on libnuma */
+#define MPOL_PREFERRED_MODE 1
+#define NUMA_NODE_MASK_BITS 1024
+
+/* Routing table reader slots; writer threads are spread across them */
+#define ROUTING_READER_SLOTS 64
+
+/* Longest a replicator sleeps before checking for new data or a stop */
+#define REPLICATION_POLL_NS 10000000
+
+/* Prefix written in front of every payload */
+typedef struct {
+    uint64_t sequence;
+    uint64_t partition_key;
+} shard_record_t;
+
+/* One key range of the routing table */
+typedef struct {
+    uint64_t key_start;
+    uint64_t key_end;
+    uint32_t shard;  /* Index into rings */
+} route_t;
+
+/* Immutable routing snapshot; routes are sorted by key_start */
+typedef struct {
+    uint32_t num_hashed;
+    uint32_t hashed[DISTRIBUTED_BUFFER_MAX_SHARDS];  /* Shards taking keys outside every range */
+    uint32_t num_routes;
+    route_t routes[];
+} routing_table_t;
+
+/* Head of a shard as seen by the merged reader */
+typedef struct {
+    bool valid;
+    ring_buffer_message_t message;
+    shard_record_t record;
+} merge_head_t;
+
+/* Background copy of one shard into a standby */
+typedef struct {
+    pthread_t thread;
+    ring_buffer_t* source;
+    ring_buffer_t* target;
+    uint32_t source_index;
+    bool running;
+    atomic_bool stop;
+} replicator_t;
+
+/* Writers currently looking at the routing table, by epoch parity */
+typedef struct {
+    _Alignas(RING_BUFFER_CACHE_LINE_SIZE) atomic_uint active[2];
+} reader_slot_t;
+
+/* Private state behind the public handle */
+typedef struct {
+    distributed_buffer_t base;
+    merge_head_t heads[DISTRIBUTED_BUFFER_MAX_SHARDS];
+    
+    /* Routing table updates: serialized by update_lock, never taken by writers */
+    pthread_mutex_t update_lock;
+    atomic_uint epoch;
+    reader_slot_t slots[ROUTING_READER_SLOTS];
+    
+    /* Replication into standby shards, indexed by the standby */
+    replicator_t replicators[DISTRIBUTED_BUFFER_MAX_SHARDS];
+} distributed_buffer_impl_t;
+
+static inline distributed_buffer_impl_t* impl_of(distributed_buffer_t* buffer) {
+    return (distributed_buffer_impl_t*)buffer;
+}
+
+/* Round-robin slot assignment for writer threads; 0 means unassigned */
+static atomic_uint reader_slot_counter;
+static _Thread_local unsigned int reader_slot_index;
+
+static inline reader_slot_t* reader_slot(distributed_buffer_impl_t* impl) {
+    unsigned int index = reader_slot_index;
+    if (index == 0) {
+        index = atomic_fetch_add_explicit(&reader_slot_counter, 1, memory_order_relaxed)
+                % ROUTING_READER_SLOTS + 1;
+        reader_slot_index = index;
+    }
+    return &impl->slots[index - 1];
+}
+
+/* Wait until no writer can still hold a routing table published before
+ * the current one. Writers announce themselves in their slot under the
+ * epoch parity they saw; flipping the epoch twice and draining the old
+ * parity each time covers writers that read the epoch just before a flip. */
+static void synchronize_routing(distributed_buffer_impl_t* impl) {
+    for (int flip = 0; flip < 2; flip++) {
+        unsigned int parity = atomic_fetch_add(&impl->epoch, 1) & 1;
+        for (int i = 0; i < ROUTING_READER_SLOTS; i++) {
+            while (atomic_load(&impl->slots[i].active[parity]) != 0) {
+                sched_yield();
+            }
+        }
+    }
+}
+
+/* Swap in a new routing table and free the old one after a grace period */
+static void publish_routing_table(distributed_buffer_impl_t* impl, routing_table_t* table) {
+    void* old = atomic_exchange(&impl->base.routing_table, (void*)table);
+    synchronize_routing(impl);
+    free(old);
+}
+
+/* Spread keys without a range over all shards */
+static inline uint64_t mix_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+static int compare_routes(const void* a, const void* b) {
+    const route_t* ra = (const route_t*)a;
+    const route_t* rb = (const route_t*)b;
+    return (ra->key_start > rb->key_start) - (ra->key_start < rb->key_start);
+}
+
+/* Build a routing snapshot from the shard configs, rejecting overlaps
+ * and tables with only standby shards */
+static routing_table_t* build_routing_table(const buffer_shard_config_t* shards, uint32_t num_shards) {
+    routing_table_t* table = calloc(1, sizeof(routing_table_t) + num_shards * sizeof(route_t));
+    if (!table) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < num_shards; i++) {
+        if (shards[i].flags & DISTRIBUTED_SHARD_FLAG_STANDBY) {
+            continue;
+        }
+        table->hashed[table->num_hashed++] = i;
+        if (shards[i].flags & DISTRIBUTED_SHARD_FLAG_NO_RANGE) {
+            continue;
+        }
+        route_t* route = &table->routes[table->num_routes++];
+        route->key_start = shards[i].partition_key_start;
+        route->key_end = shards[i].partition_key_end;
+        route->shard = i;
+    }
+
+    if (table->num_hashed == 0) {
+        free(table);
+        return NULL;
+    }
+
+    qsort(table->routes, table->num_routes, sizeof(route_t), compare_routes);
+    for (uint32_t i = 1; i < table->num_routes; i++) {
+        if (table->routes[i].key_start <= table->routes[i - 1].key_end) {
+            free(table);
+            return NULL;
+        }
+    }
+
+    return table;
+}
+
+/* Find the shard for a key: its range if one covers it, else a hash */
+static uint32_t route_key(const routing_table_t* table, uint64_t key) {
+    uint32_t lo = 0;
+    uint32_t hi = table->num_routes;
+
+    /* Last route starting at or before key */
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (table->routes[mid].key_start <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo > 0 && key <= table->routes[lo - 1].key_end) {
+        return table->routes[lo - 1].shard;
+    }
+
+    return table->hashed[mix_key(key) % table->num_hashed];
+}
+
+/* Ask the kernel to place the shard's pages on a NUMA node. Best effort:
+ * on systems without NUMA the pages simply stay where they are. */
+static void bind_to_node(ring_buffer_t* rb, uint32_t node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long mask[NUMA_NODE_MASK_BITS / (8 * sizeof(unsigned long))] = {0};
+    if (node >= NUMA_NODE_MASK_BITS) {
+        return;
+    }
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+
+    /* The data region is page aligned and untouched, so the pages are
+     * allocated on the node when the producer first writes them */
+    syscall(SYS_mbind, rb->buffer, rb->size, MPOL_PREFERRED_MODE, mask, NUMA_NODE_MASK_BITS, 0);
+#else
+    (void)rb;
+    (void)node;
+#endif
+}
+
+/* Create the ring buffer backing one shard, or with reopen set attach to
+ * the file a previous run left behind */
+static ring_buffer_t* create_shard(const buffer_shard_config_t* shard, bool reopen) {
+    ring_buffer_config_t config = { .size = shard->capacity };
+    ring_buffer_t* rb;
+
+    if (shard->mmap_path) {
+        /* The existing file's size wins over capacity */
+        rb = reopen ? ring_buffer_open_shared(shard->mmap_path, 0) : NULL;
+        if (!rb) {
+            rb = ring_buffer_create_shared(shard->mmap_path, &config);
+        }
+    } else {
+        rb = ring_buffer_create_ex(&config);
+    }
+
+    if (rb && (shard->flags & DISTRIBUTED_SHARD_FLAG_NUMA_BIND)) {
+        bind_to_node(rb, shard->numa_node);
+    }
+
+    return rb;
+}
+
+/* Advance the global sequence past a recovered shard's newest message */
+static void restore_sequence(distributed_buffer_t* buffer, const ring_buffer_message_t* last) {
+    shard_record_t record;
+    if (last->data_size < sizeof(record)) {
+        return;
+    }
+    memcpy(&record, last->data, sizeof(record));
+
+    uint_fast64_t current = atomic_load(&buffer->global_sequence);
+    while (current <= record.sequence &&
+           !atomic_compare_exchange_weak(&buffer->global_sequence, &current, record.sequence + 1)) {
+    }
+}
+
+/* Rescan shard i and drop the merged reader's view of it */
+static int recover_shard(distributed_buffer_impl_t* impl, uint32_t i) {
+    ring_buffer_message_t last;
+    int count = ring_buffer_recover(impl->base.rings[i], &last);
+
+    impl->heads[i].valid = false;
+    if (count < 0) {
+        return count;
+    }
+    if (count > 0) {
+        restore_sequence(&impl->base, &last);
+    }
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Open shard i, recovering its file if asked to; a file that can't be
+ * recovered is started over */
+static int open_shard(distributed_buffer_impl_t* impl, uint32_t i) {
+    const buffer_shard_config_t* shard = &impl->base.shards[i];
+    bool reopen = (shard->flags & DISTRIBUTED_SHARD_FLAG_RECOVER) && shard->mmap_path;
+
+    impl->base.rings[i] = create_shard(shard, reopen);
+    if (reopen && impl->base.rings[i] && recover_shard(impl, i) != RING_BUFFER_SUCCESS) {
+        ring_buffer_destroy(impl->base.rings[i]);
+        impl->base.rings[i] = create_shard(shard, false);
+    }
+
+    return impl->base.rings[i] ? RING_BUFFER_SUCCESS : RING_BUFFER_ERROR_MEMORY;
+}
+
+/* Index of the shard with the given id, or UINT32_MAX */
+static uint32_t find_shard(distributed_buffer_t* buffer, uint32_t shard_id) {
+    uint32_t num_shards = atomic_load(&buffer->num_shards);
+    for (uint32_t i = 0; i < num_shards; i++) {
+        if (buffer->shards[i].shard_id == shard_id) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/* Copy a shard config, taking ownership of a private mmap_path copy */
+static int copy_shard_config(buffer_shard_config_t* dst, const buffer_shard_config_t* src) {
+    if (!(src->flags & (DISTRIBUTED_SHARD_FLAG_NO_RANGE | DISTRIBUTED_SHARD_FLAG_STANDBY)) &&
+        src->partition_key_start > src->partition_key_end) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    *dst = *src;
+    if (src->mmap_path) {
+        dst->mmap_path = strdup(src->mmap_path);
+        if (!dst->mmap_path) {
+            return RING_BUFFER_ERROR_MEMORY;
+        }
+    }
+    return RING_BUFFER_SUCCESS;
+}
+
+int distributed_buffer_create(distributed_buffer_t** buffer,
+                             const buffer_shard_config_t* config,
+                             uint32_t num_shards) {
+    if (!buffer || !config || num_shards == 0 || num_shards > DISTRIBUTED_BUFFER_MAX_SHARDS) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    *buffer = NULL;
+
+    void* memory = NULL;
+    if (posix_memalign(&memory, RING_BUFFER_CACHE_LINE_SIZE, sizeof(distributed_buffer_impl_t)) != 0) {
+        return RING_BUFFER_ERROR_MEMORY;
+    }
+    memset(memory, 0, sizeof(distributed_buffer_impl_t));
+    distributed_buffer_t* db = &((distributed_buffer_impl_t*)memory)->base;
+    pthread_mutex_init(&((distributed_buffer_impl_t*)memory)->update_lock, NULL);
+
+    db->shards = calloc(DISTRIBUTED_BUFFER_MAX_SHARDS, sizeof(buffer_shard_config_t));
+    if (!db->shards) {
+        free(memory);
+        return RING_BUFFER_ERROR_MEMORY;
+    }
+
+    db->replication_factor = 1;
+    atomic_init(&db->global_sequence, 0);
+
+    int result = RING_BUFFER_SUCCESS;
+    for (uint32_t i = 0; i < num_shards && result == RING_BUFFER_SUCCESS; i++) {
+        for (uint32_t j = 0; j < i; j++) {
+            if (config[j].shard_id == config[i].shard_id) {
+                result = RING_BUFFER_ERROR_INVALID_PARAM;
+            }
+        }
+        if (result == RING_BUFFER_SUCCESS) {
+            result = copy_shard_config(&db->shards[i], &config[i]);
+        }
+        if (result == RING_BUFFER_SUCCESS) {
+            atomic_store(&db->num_shards, i + 1);
+        }
+    }
+
+    if (result == RING_BUFFER_SUCCESS) {
+        routing_table_t* table = build_routing_table(db->shards, num_shards);
+        atomic_store(&db->routing_table, (void*)table);
+        if (!table) {
+            result = RING_BUFFER_ERROR_INVALID_PARAM;
+        }
+    }
+
+    for (uint32_t i = 0; i < num_shards && result == RING_BUFFER_SUCCESS; i++) {
+        result = open_shard((distributed_buffer_impl_t*)memory, i);
+    }
+
+    if (result != RING_BUFFER_SUCCESS) {
+        distributed_buffer_destroy(db);
+        return result;
+    }
+
+    *buffer = db;
+    return RING_BUFFER_SUCCESS;
+}
+
+int distributed_buffer_write(distributed_buffer_t* buffer,
+                            const void* data,
+                            size_t data_size,
+                            uint64_t partition_key) {
+    if (!buffer || !data || data_size == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    if (data_size > RING_BUFFER_MAX_MESSAGE_SIZE - sizeof(shard_record_t)) {
+        return RING_BUFFER_ERROR_TOO_LARGE;
+    }
+
+    /* Route under the reader slot so the table can't be freed under us */
+    reader_slot_t* slot = reader_slot(impl_of(buffer));
+    unsigned int parity = atomic_load(&impl_of(buffer)->epoch) & 1;
+    atomic_fetch_add(&slot->active[parity], 1);
+    const routing_table_t* table = (const routing_table_t*)atomic_load(&buffer->routing_table);
+    ring_buffer_t* rb = buffer->rings[route_key(table, partition_key)];
+    atomic_fetch_sub_explicit(&slot->active[parity], 1, memory_order_release);
+
+    ring_buffer_span_t span;
+    ring_buffer_error_t result = ring_buffer_reserve(rb, sizeof(shard_record_t) + data_size, &span);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+
+    /* Taking the sequence after the reservation keeps it increasing
+     * within the shard whenever the shard has a single producer */
+    shard_record_t record = {
+        .sequence = atomic_fetch_add_explicit(&buffer->global_sequence, 1, memory_order_relaxed),
+        .partition_key = partition_key
+    };
+
+    ring_buffer_span_copy(&span, 0, &record, sizeof(record));
+    ring_buffer_span_copy(&span, sizeof(record), data, data_size);
+
+    return ring_buffer_commit(rb, &span);
+}
+
+/* Make sure the merged reader knows the head of shard i */
+static int load_head(distributed_buffer_impl_t* impl, uint32_t i) {
+    merge_head_t* head = &impl->heads[i];
+    if (head->valid) {
+        return RING_BUFFER_SUCCESS;
+    }
+
+    ring_buffer_error_t result = ring_buffer_peek(impl->base.rings[i], &head->message);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+
+    if (head->message.data_size < sizeof(shard_record_t)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+
+    memcpy(&head->record, head->message.data, sizeof(shard_record_t));
+    head->valid = true;
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Consume the cached head of shard i and describe it in message */
+static int take_head(distributed_buffer_impl_t* impl, uint32_t i, distributed_message_t* message) {
+    merge_head_t* head = &impl->heads[i];
+    ring_buffer_message_t consumed;
+
+    head->valid = false;
+    ring_buffer_error_t result = ring_buffer_read(impl->base.rings[i], &consumed);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+
+    message->sequence = head->record.sequence;
+    message->partition_key = head->record.partition_key;
+    message->shard_id = impl->base.shards[i].shard_id;
+    message->timestamp = consumed.header.timestamp;
+    message->data = (const uint8_t*)consumed.data + sizeof(shard_record_t);
+    message->data_size = consumed.data_size - sizeof(shard_record_t);
+    return RING_BUFFER_SUCCESS;
+}
+
+int distributed_buffer_read_next(distributed_buffer_t* buffer,
+                                distributed_message_t* message) {
+    if (!buffer || !message) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    distributed_buffer_impl_t* impl = impl_of(buffer);
+    uint32_t num_shards = atomic_load(&buffer->num_shards);
+    uint32_t best = UINT32_MAX;
+
+    for (uint32_t i = 0; i < num_shards; i++) {
+        /* Standby shards hold copies of messages read from their source */
+        if (buffer->shards[i].flags & DISTRIBUTED_SHARD_FLAG_STANDBY) {
+            continue;
+        }
+        int result = load_head(impl, i);
+        if (result == RING_BUFFER_ERROR_EMPTY) {
+            continue;
+        }
+        if (result != RING_BUFFER_SUCCESS) {
+            return result;
+        }
+        if (best == UINT32_MAX || impl->heads[i].record.sequence < impl->heads[best].record.sequence) {
+            best = i;
+        }
+    }
+
+    if (best == UINT32_MAX) {
+        return RING_BUFFER_ERROR_EMPTY;
+    }
+
+    return take_head(impl, best, message);
+}
+
+int distributed_buffer_read(distributed_buffer_t* buffer,
+                           void** data,
+                           size_t* data_size,
+                           uint32_t shard_id,
+                           uint64_t offset) {
+    if (!buffer || !data || !data_size || offset != 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    distributed_message_t message;
+    int result;
+
+    if (shard_id == DISTRIBUTED_BUFFER_ANY_SHARD) {
+        result = distributed_buffer_read_next(buffer, &message);
+    } else {
+        uint32_t i = find_shard(buffer, shard_id);
+        if (i == UINT32_MAX) {
+            return RING_BUFFER_ERROR_INVALID_PARAM;
+        }
+
+        result = load_head(impl_of(buffer), i);
+        if (result == RING_BUFFER_SUCCESS) {
+            result = take_head(impl_of(buffer), i, &message);
+        }
+    }
+
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+
+    *data = (void*)message.data;
+    *data_size = message.data_size;
+    return RING_BUFFER_SUCCESS;
+}
+
+int distributed_buffer_add_shard(distributed_buffer_t* buffer,
+                                const buffer_shard_config_t* new_shard) {
+    if (!buffer || !new_shard) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    distributed_buffer_impl_t* impl = impl_of(buffer);
+    pthread_mutex_lock(&impl->update_lock);
+
+    uint32_t n = atomic_load(&buffer->num_shards);
+    int result = n < DISTRIBUTED_BUFFER_MAX_SHARDS ? RING_BUFFER_SUCCESS : RING_BUFFER_ERROR_FULL;
+    for (uint32_t i = 0; i < n && result == RING_BUFFER_SUCCESS; i++) {
+        if (buffer->shards[i].shard_id == new_shard->shard_id) {
+            result = RING_BUFFER_ERROR_INVALID_PARAM;
+        }
+    }
+
+    if (result == RING_BUFFER_SUCCESS) {
+        result = copy_shard_config(&buffer->shards[n], new_shard);
+    }
+
+    /* Validate the new routing before creating the shard's memory */
+    routing_table_t* table = NULL;
+    if (result == RING_BUFFER_SUCCESS) {
+        table = build_routing_table(buffer->shards, n + 1);
+        if (!table) {
+            result = RING_BUFFER_ERROR_INVALID_PARAM;
+        }
+    }
+
+    if (result == RING_BUFFER_SUCCESS) {
+        result = open_shard(impl, n);
+    }
+
+    if (result == RING_BUFFER_SUCCESS) {
+        /* The ring must be visible before any table routes to it */
+        atomic_store(&buffer->num_shards, n + 1);
+        publish_routing_table(impl, table);
+    } else {
+        free(table);
+        if (n < DISTRIBUTED_BUFFER_MAX_SHARDS) {
+            free(buffer->shards[n].mmap_path);
+            memset(&buffer->shards[n], 0, sizeof(buffer->shards[n]));
+        }
+    }
+
+    pthread_mutex_unlock(&impl->update_lock);
+    return result;
+}
+
+int distributed_buffer_rebalance(distributed_buffer_t* buffer) {
+    if (!buffer) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    distributed_buffer_impl_t* impl = impl_of(buffer);
+    pthread_mutex_lock(&impl->update_lock);
+
+    uint32_t n = atomic_load(&buffer->num_shards);
+    uint32_t active = 0;
+    uint64_t span_start = UINT64_MAX;
+    uint64_t span_end = 0;
+    bool ranged = false;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const buffer_shard_config_t* shard = &buffer->shards[i];
+        if (shard->flags & DISTRIBUTED_SHARD_FLAG_STANDBY) {
+            continue;
+        }
+        active++;
+        if (shard->flags & DISTRIBUTED_SHARD_FLAG_NO_RANGE) {
+            continue;
+        }
+        span_start = shard->partition_key_start < span_start ? shard->partition_key_start : span_start;
+        span_end = shard->partition_key_end > span_end ? shard->partition_key_end : span_end;
+        ranged = true;
+    }
+
+    /* Nothing but hashed keys: already spread evenly */
+    if (!ranged) {
+        pthread_mutex_unlock(&impl->update_lock);
+        return RING_BUFFER_SUCCESS;
+    }
+
+    /* Give the first (span % active) + 1 shards one key more than the
+     * rest; if there are more shards than keys the extra shards get no
+     * range. Standby shards keep out of it. */
+    uint64_t span = span_end - span_start;  /* Keys covered, minus one */
+    uint64_t quotient = span / active;
+    uint64_t remainder = span % active;
+    uint64_t next = span_start;
+    uint32_t k = 0;
+
+    buffer_shard_config_t updated[DISTRIBUTED_BUFFER_MAX_SHARDS];
+    memcpy(updated, buffer->shards, n * sizeof(buffer_shard_config_t));
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (updated[i].flags & DISTRIBUTED_SHARD_FLAG_STANDBY) {
+            continue;
+        }
+        if (k++ > remainder && quotient == 0) {
+            updated[i].flags |= DISTRIBUTED_SHARD_FLAG_NO_RANGE;
+            continue;
+        }
+        uint64_t last = next + (k - 1 <= remainder ? quotient : quotient - 1);
+        updated[i].flags &= ~DISTRIBUTED_SHARD_FLAG_NO_RANGE;
+        updated[i].partition_key_start = next;
+        updated[i].partition_key_end = last;
+        next = last + 1;
+    }
+
+    routing_table_t* table = build_routing_table(updated, n);
+    if (!table) {
+        pthread_mutex_unlock(&impl->update_lock);
+        return RING_BUFFER_ERROR_MEMORY;
+    }
+
+    memcpy(buffer->shards, updated, n * sizeof(buffer_shard_config_t));
+    publish_routing_table(impl, table);
+
+    pthread_mutex_unlock(&impl->update_lock);
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Stream committed records of the source into the standby until stopped */
+static void* replicator_main(void* arg) {
+    replicator_t* rep = (replicator_t*)arg;
+    size_t cursor = 0;
+
+    while (!atomic_load(&rep->stop)) {
+        size_t before = cursor;
+        ring_buffer_error_t result = ring_buffer_replicate(rep->source, rep->target, &cursor);
+        if (result == RING_BUFFER_SUCCESS && cursor != before) {
+            continue;
+        }
+
+        /* Park until more is published than the backlog just copied */
+        size_t backlog = ring_buffer_available_read(rep->source);
+        if (result == RING_BUFFER_SUCCESS && backlog < rep->source->size) {
+            ring_buffer_wait_readable(rep->source, backlog + 1, REPLICATION_POLL_NS);
+        } else {
+            struct timespec pause = { 0, REPLICATION_POLL_NS };
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    return NULL;
+}
+
+static int start_replicator(distributed_buffer_impl_t* impl, uint32_t source, uint32_t target) {
+    replicator_t* rep = &impl->replicators[target];
+    rep->source = impl->base.rings[source];
+    rep->target = impl->base.rings[target];
+    rep->source_index = source;
+    atomic_store(&rep->stop, false);
+
+    rep->running = pthread_create(&rep->thread, NULL, replicator_main, rep) == 0;
+    return rep->running ? RING_BUFFER_SUCCESS : RING_BUFFER_ERROR_MEMORY;
+}
+
+static void stop_replicator(replicator_t* rep) {
+    if (rep->running) {
+        atomic_store(&rep->stop, true);
+        pthread_join(rep->thread, NULL);
+        rep->running = false;
+    }
+}
+
+int distributed_buffer_replicate(distributed_buffer_t* buffer,
+                                uint32_t source_shard,
+                                uint32_t target_shard) {
+    if (!buffer || source_shard == target_shard) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    distributed_buffer_impl_t* impl = impl_of(buffer);
+    pthread_mutex_lock(&impl->update_lock);
+
+    uint32_t source = find_shard(buffer, source_shard);
+    uint32_t target = find_shard(buffer, target_shard);
+    int result;
+
+    if (source == UINT32_MAX || target == UINT32_MAX ||
+        (buffer->shards[source].flags & DISTRIBUTED_SHARD_FLAG_STANDBY) ||
+        !(buffer->shards[target].flags & DISTRIBUTED_SHARD_FLAG_STANDBY) ||
+        impl->replicators[target].running ||
+        buffer->rings[source]->size != buffer->rings[target]->size) {
+        result = RING_BUFFER_ERROR_INVALID_PARAM;
+    } else {
+        result = start_replicator(impl, source, target);
+    }
+
+    pthread_mutex_unlock(&impl->update_lock);
+    return result;
+}
+
+int distributed_buffer_recover(distributed_buffer_t* buffer,
+                              uint32_t failed_shard) {
+    if (!buffer) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    distributed_buffer_impl_t* impl = impl_of(buffer);
+    pthread_mutex_lock(&impl->update_lock);
+
+    uint32_t i = find_shard(buffer, failed_shard);
+    if (i == UINT32_MAX) {
+        pthread_mutex_unlock(&impl->update_lock);
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    /* Replication must not run while the positions move. A recovered
+     * standby keeps its copy; copies taken from the shard start over. */
+    uint32_t num_shards = atomic_load(&buffer->num_shards);
+    bool restart[DISTRIBUTED_BUFFER_MAX_SHARDS] = {false};
+    for (uint32_t t = 0; t < num_shards; t++) {
+        replicator_t* rep = &impl->replicators[t];
+        if (rep->running && (t == i || rep->source_index == i)) {
+            stop_replicator(rep);
+            restart[t] = t != i;
+        }
+    }
+
+    int result = recover_shard(impl, i);
+
+    for (uint32_t t = 0; t < num_shards; t++) {
+        if (restart[t] && start_replicator(impl, i, t) != RING_BUFFER_SUCCESS && result == RING_BUFFER_SUCCESS) {
+            result = RING_BUFFER_ERROR_MEMORY;
+        }
+    }
+
+    pthread_mutex_unlock(&impl->update_lock);
+    return result;
+}
+
+void distributed_buffer_destroy(distributed_buffer_t* buffer) {
+    if (!buffer) return;
+
+    for (uint32_t i = 0; i < DISTRIBUTED_BUFFER_MAX_SHARDS; i++) {
+        stop_replicator(&impl_of(buffer)->replicators[i]);
+    }
+
+    for (uint32_t i = 0; i < DISTRIBUTED_BUFFER_MAX_SHARDS; i++) {
+        ring_buffer_destroy(buffer->rings[i]);
+    }
+
+    if (buffer->shards) {
+        for (uint32_t i = 0; i < atomic_load(&buffer->num_shards); i++) {
+            free(buffer->shards[i].mmap_path);
+        }
+        free(buffer->shards);
+    }
+
+    free(atomic_load(&buffer->routing_table));
+    pthread_mutex_destroy(&impl_of(buffer)->update_lock);
+    free(impl_of(buffer));
+}
@@ -1,6 +1,12 @@
 /*
  * Distributed Ring Buffer Architecture
  * Future-proof design for scalability and reliability
+ *
+ * A distributed buffer is a set of ring buffer shards. Producers write
+ * with a partition key (for example the collector id) that the routing
+ * table maps to one shard, so producers on different cores never contend
+ * on the same reservation cursor. Every message carries a global sequence
+ * number so a merged reader can restore the cross-shard write order.
  */
 
 #ifndef DISTRIBUTED_BUFFER_H
@@ -8,25 +14,54 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdatomic.h>
+#include "ring_buffer.h"
+
+// Upper bound on shards per buffer
+#define DISTRIBUTED_BUFFER_MAX_SHARDS 64
+
+// Shard id accepted by distributed_buffer_read() for a merged read
+#define DISTRIBUTED_BUFFER_ANY_SHARD UINT32_MAX
+
+// Shard configuration flags
+#define DISTRIBUTED_SHARD_FLAG_NUMA_BIND (1u << 0)  // Place shard memory on numa_node
+#define DISTRIBUTED_SHARD_FLAG_NO_RANGE  (1u << 1)  // Ignore the key range; only hashed keys land here
+#define DISTRIBUTED_SHARD_FLAG_STANDBY   (1u << 2)  // Replica target: never routed to, skipped by merged reads
+#define DISTRIBUTED_SHARD_FLAG_RECOVER   (1u << 3)  // Reopen and recover an existing mmap_path instead of truncating it
 
 // Buffer shard configuration
 typedef struct {
     uint32_t shard_id;
-    size_t capacity;
-    char* mmap_path;
+    size_t capacity;                // Ring buffer size in bytes (0 = default)
+    char* mmap_path;                // Backing file for a shared shard, NULL for private memory
     uint64_t partition_key_start;
-    uint64_t partition_key_end;
+    uint64_t partition_key_end;     // Inclusive
+    uint32_t flags;                 // DISTRIBUTED_SHARD_FLAG_*
+    uint32_t numa_node;             // Node for DISTRIBUTED_SHARD_FLAG_NUMA_BIND
 } buffer_shard_config_t;
 
 // Distributed buffer manager
 typedef struct {
     buffer_shard_config_t* shards;
-    uint32_t num_shards;
+    _Atomic(uint32_t) num_shards;       // Grows with distributed_buffer_add_shard()
     uint32_t replication_factor;
-    uint64_t global_sequence;
-    void* routing_table;
+    _Atomic(void*) routing_table;       // Immutable snapshot, replaced RCU-style
+    ring_buffer_t* rings[DISTRIBUTED_BUFFER_MAX_SHARDS];  // Parallel to shards
+
+    // Incremented by every write; on its own line since all producers share it
+    _Alignas(RING_BUFFER_CACHE_LINE_SIZE) atomic_uint_fast64_t global_sequence;
 } distributed_buffer_t;
 
+// Message returned by a merged read
+typedef struct {
+    uint64_t sequence;              // Position in the global write order
+    uint64_t partition_key;
+    uint32_t shard_id;
+    uint64_t timestamp;             // Write time from the shard's message header
+    const void* data;               // Valid until the next read from this buffer
+    size_t data_size;
+} distributed_message_t;
+
 // Buffer operations
 typedef enum {
     BUFFER_OP_WRITE,
@@ -36,35 +71,73 @@ typedef enum {
 } buffer_operation_t;
 
 // Future-proof API
-int distributed_buffer_create(distributed_buffer_t** buffer, 
+// All functions returning int return RING_BUFFER_SUCCESS or a negative
+// ring_buffer_error_t.
+
+// Create one ring buffer per shard config. Key ranges must not overlap;
+// keys outside every range are hashed across all shards.
+int distributed_buffer_create(distributed_buffer_t** buffer,
                              const buffer_shard_config_t* config,
                              uint32_t num_shards);
 
+// Route a message to its shard by partition key. Lock-free; writers to
+// different shards share only the global sequence counter.
 int distributed_buffer_write(distributed_buffer_t* buffer,
                             const void* data,
                             size_t data_size,
                             uint64_t partition_key);
 
+// Read the next message from one shard, or from all shards in global
+// sequence order with DISTRIBUTED_BUFFER_ANY_SHARD. Offset is reserved
+// and must be 0. Reads must come from a single consumer thread.
 int distributed_buffer_read(distributed_buffer_t* buffer,
                            void** data,
                            size_t* data_size,
                            uint32_t shard_id,
                            uint64_t offset);
 
+// Merged read returning the message metadata. Among the messages
+// currently published, the one with the lowest sequence is returned;
+// per-shard order is preserved as long as each shard has one producer.
+int distributed_buffer_read_next(distributed_buffer_t* buffer,
+                                distributed_message_t* message);
+
 // Scaling operations
+// Both publish a new routing table while writers keep running: writers
+// never block, and the old table is freed once no writer can still be
+// using it. Messages already buffered stay in their shard; the merged
+// reader still returns them in sequence order.
+
+// Add a shard for a key range that doesn't overlap the existing ones, or
+// with DISTRIBUTED_SHARD_FLAG_NO_RANGE for hashed keys only until the
+// next rebalance.
 int distributed_buffer_add_shard(distributed_buffer_t* buffer,
                                 const buffer_shard_config_t* new_shard);
 
+// Split the key span covered by the current ranges evenly over all
+// shards, in shard order, updating their partition_key_start/_end.
 int distributed_buffer_rebalance(distributed_buffer_t* buffer);
 
 // Reliability operations
+
+// Start a background thread that streams the committed records of the
+// source shard into a standby shard of the same capacity, a batch per
+// pass, copying straight between the two mappings. The standby mirrors
+// the source's unread backlog; give it an mmap_path so the copy survives
+// a crash of this process. Runs until the buffer is destroyed.
 int distributed_buffer_replicate(distributed_buffer_t* buffer,
                                 uint32_t source_shard,
                                 uint32_t target_shard);
 
+// Rescan a shard after a process sharing its file crashed, keeping the
+// records whose magic and checksum verify (see ring_buffer_recover()),
+// and move the global sequence past them. Writers and readers of the
+// shard must be stopped. Replication out of the shard starts over; a
+// recovered standby stops receiving copies so it can be read directly.
+// Shards created with DISTRIBUTED_SHARD_FLAG_RECOVER get this at create.
 int distributed_buffer_recover(distributed_buffer_t* buffer,
                               uint32_t failed_shard);
 
 void distributed_buffer_destroy(distributed_buffer_t* buffer);
 
-#endif // DISTRIBUTED_BUFFER_H
\ No newline at end of file
+#endif // DISTRIBUTED_BUFFER_H
@@ -16,7 +16,29 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <time.h>
+#include <sched.h>
+#include <pthread.h>
 #include <assert.h>
+#include <limits.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#include <mach/vm_statistics.h>
+#endif
+#if RING_BUFFER_WITH_ZSTD
+#include <zstd.h>
+#endif
 
 /* Magic number for buffer validation */
 #define RING_BUFFER_MAGIC 0x52424652  /* "RBFR" */
@@ -24,6 +46,23 @@
 /* CRC32 polynomial (IEEE 802.3) */
 #define CRC32_POLYNOMIAL 0xEDB88320
 
+/* CRC32C polynomial (Castagnoli) */
+#define CRC32C_POLYNOMIAL 0x82F63B78
+
+/* Checksum algorithm used for new messages */
+#define RING_BUFFER_WRITE_CHECKSUM RING_BUFFER_CHECKSUM_CRC32C
+
+/* Flags that describe the buffer rather than a handle; kept in the control
+ * block, so every handle attached to the buffer shares them */
+#define RING_BUFFER_MODE_FLAGS \
+    (RING_BUFFER_FLAG_ELASTIC | RING_BUFFER_FLAG_SINGLE_PRODUCER | RING_BUFFER_FLAG_SINGLE_CONSUMER)
+
+/* Flags chosen per handle when it is created or opened */
+#define RING_BUFFER_HANDLE_FLAGS (RING_BUFFER_FLAG_TRUSTED | RING_BUFFER_FLAG_NO_STATS)
+
+/* Zstd level for ring_buffer_write_compressed(); low levels keep up with capture rates */
+#define RING_BUFFER_ZSTD_LEVEL 1
+
 /* Memory barriers for different architectures */
 #ifdef __x86_64__
 #define memory_barrier() __asm__ __volatile__("mfence" ::: "memory")
@@ -35,470 +74,3383 @@
 #define write_barrier() __sync_synchronize()
 #endif
 
+/* Spin-wait hint for busy loops */
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+/* Spins before an ordered committer starts yielding its time slice */
+#define COMMIT_SPIN_LIMIT 128
+
+/* Least log2 of the bytes between time index entries (64 KB) */
+#define INDEX_MIN_SHIFT 16
+
+/* Reader slot states, in the low two bits of the owner word */
+#define READER_FREE 0
+#define READER_ACTIVE 1
+#define READER_EVICTED 2
+#define READER_CLAIMED 3    /* Being set up; not yet honoured by writers */
+#define READER_STATE(owner) ((owner) & 3)
+
+/* Readiness checks before a waiter parks, and the sleep used when the
+ * platform has no wait-on-address primitive */
+#define WAIT_SPIN_LIMIT 256
+#define WAIT_POLL_NS 100000
+
+#if RING_BUFFER_STATS
+/* Round-robin shard assignment for new threads; 0 means unassigned */
+static atomic_uint stats_shard_counter;
+static _Thread_local unsigned int stats_shard_slot;
+
+static inline ring_buffer_stats_shard_t *stats_shard(ring_buffer_control_t *control) {
+    unsigned int slot = stats_shard_slot;
+    if (slot == 0) {
+        slot = atomic_fetch_add_explicit(&stats_shard_counter, 1, memory_order_relaxed)
+               % RING_BUFFER_STATS_SHARDS + 1;
+        stats_shard_slot = slot;
+    }
+    return &control->stats[slot - 1];
+}
+
+/* Handles opened with RING_BUFFER_FLAG_NO_STATS don't count anything */
+#define STAT_ADD(rb, field, n) do { \
+    if (!((rb)->flags & RING_BUFFER_FLAG_NO_STATS)) { \
+        atomic_fetch_add_explicit(&stats_shard((rb)->control)->field, (n), memory_order_relaxed); \
+    } \
+} while (0)
+#else
+#define STAT_ADD(rb, field, n) ((void)(rb), (void)(n))
+#endif
+
+/* Static tracing probes, compiled in with RING_BUFFER_WITH_PROBES=1.
+ * 
+ * Linux gets USDT probes under the provider chronicle_ring_buffer, for
+ * bpftrace, perf or SystemTap; Apple platforms get os_signpost events in
+ * subsystem com.chronicle.ring-buffer, for Instruments. Each probe site
+ * only does its argument work, such as a clock read, once a tracer is
+ * attached, and without the flag every probe compiles to nothing.
+ * 
+ *   reserve(rb, pos, bytes)                 space claimed by a writer
+ *   commit(rb, pos, bytes, wait_ns)         range published; wait_ns spent behind earlier writers
+ *   read(rb, pos, bytes, count, age_ns)     messages consumed; age_ns since the first was stamped
+ *   backpressure_enter(rb, used, high)      high watermark crossed
+ *   backpressure_exit(rb, used, low)        drained back to the low watermark
+ *   crc_failure(rb, pos, length, checksum)  checksum mismatch while scanning
+ */
+#if RING_BUFFER_WITH_PROBES && defined(__linux__)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+/* Raised by the tracer while a probe is attached */
+#define PROBE_SEMAPHORE(name) \
+    __extension__ unsigned short chronicle_ring_buffer_##name##_semaphore \
+    __attribute__((unused)) __attribute__((section(".probes")))
+
+PROBE_SEMAPHORE(reserve);
+PROBE_SEMAPHORE(commit);
+PROBE_SEMAPHORE(read);
+PROBE_SEMAPHORE(backpressure_enter);
+PROBE_SEMAPHORE(backpressure_exit);
+PROBE_SEMAPHORE(crc_failure);
+
+#define PROBE_ENABLED(name) __builtin_expect(chronicle_ring_buffer_##name##_semaphore != 0, 0)
+#define PROBE_RESERVE(rb, pos, bytes) \
+    STAP_PROBE3(chronicle_ring_buffer, reserve, rb, pos, bytes)
+#define PROBE_COMMIT(rb, pos, bytes, wait_ns) \
+    STAP_PROBE4(chronicle_ring_buffer, commit, rb, pos, bytes, wait_ns)
+#define PROBE_READ(rb, pos, bytes, count, age_ns) \
+    STAP_PROBE5(chronicle_ring_buffer, read, rb, pos, bytes, count, age_ns)
+#define PROBE_BACKPRESSURE_ENTER(rb, used, watermark) \
+    STAP_PROBE3(chronicle_ring_buffer, backpressure_enter, rb, used, watermark)
+#define PROBE_BACKPRESSURE_EXIT(rb, used, watermark) \
+    STAP_PROBE3(chronicle_ring_buffer, backpressure_exit, rb, used, watermark)
+#define PROBE_CRC_FAILURE(rb, pos, length, checksum) \
+    STAP_PROBE4(chronicle_ring_buffer, crc_failure, rb, pos, length, checksum)
+
+#elif RING_BUFFER_WITH_PROBES && defined(__APPLE__)
+#include <os/log.h>
+#include <os/signpost.h>
+
+static os_log_t probe_log_handle;
+static pthread_once_t probe_log_once = PTHREAD_ONCE_INIT;
+
+static void probe_log_init(void) {
+    probe_log_handle = os_log_create("com.chronicle.ring-buffer", "ring_buffer");
+}
+
+static inline os_log_t probe_log(void) {
+    pthread_once(&probe_log_once, probe_log_init);
+    return probe_log_handle;
+}
+
+/* Signposts are only recorded while Instruments is capturing the subsystem */
+#define PROBE_ENABLED(name) os_signpost_enabled(probe_log())
+#define PROBE_EVENT(name, format, ...) \
+    os_signpost_event_emit(probe_log(), OS_SIGNPOST_ID_EXCLUSIVE, name, format, __VA_ARGS__)
+#define PROBE_RESERVE(rb, pos, bytes) \
+    PROBE_EVENT("reserve", "rb=%p pos=%zu bytes=%zu", (void *)(rb), (size_t)(pos), (size_t)(bytes))
+#define PROBE_COMMIT(rb, pos, bytes, wait_ns) \
+    PROBE_EVENT("commit", "rb=%p pos=%zu bytes=%zu wait_ns=%llu", (void *)(rb), (size_t)(pos), \
+                (size_t)(bytes), (unsigned long long)(wait_ns))
+#define PROBE_READ(rb, pos, bytes, count, age_ns) \
+    PROBE_EVENT("read", "rb=%p pos=%zu bytes=%llu count=%d age_ns=%llu", (void *)(rb), (size_t)(pos), \
+                (unsigned long long)(bytes), (int)(count), (unsigned long long)(age_ns))
+/* Backpressure is an interval per buffer, so Instruments draws how long it lasted */
+#define PROBE_BACKPRESSURE_ENTER(rb, used, watermark) \
+    os_signpost_interval_begin(probe_log(), os_signpost_id_make_with_pointer(probe_log(), (rb)->control), \
+                               "backpressure", "rb=%p used=%zu high=%zu", (void *)(rb), \
+                               (size_t)(used), (size_t)(watermark))
+#define PROBE_BACKPRESSURE_EXIT(rb, used, watermark) \
+    os_signpost_interval_end(probe_log(), os_signpost_id_make_with_pointer(probe_log(), (rb)->control), \
+                             "backpressure", "rb=%p used=%zu low=%zu", (void *)(rb), \
+                             (size_t)(used), (size_t)(watermark))
+#define PROBE_CRC_FAILURE(rb, pos, length, checksum) \
+    PROBE_EVENT("crc_failure", "rb=%p pos=%zu length=%u checksum=%08x", (void *)(rb), (size_t)(pos), \
+                (unsigned)(length), (unsigned)(checksum))
+
+#else
+#define PROBE_ENABLED(name) 0
+#define PROBE_RESERVE(rb, pos, bytes) ((void)(rb), (void)(pos), (void)(bytes))
+#define PROBE_COMMIT(rb, pos, bytes, wait_ns) ((void)(rb), (void)(pos), (void)(bytes), (void)(wait_ns))
+#define PROBE_READ(rb, pos, bytes, count, age_ns) \
+    ((void)(rb), (void)(pos), (void)(bytes), (void)(count), (void)(age_ns))
+#define PROBE_BACKPRESSURE_ENTER(rb, used, watermark) ((void)(rb), (void)(used), (void)(watermark))
+#define PROBE_BACKPRESSURE_EXIT(rb, used, watermark) ((void)(rb), (void)(used), (void)(watermark))
+#define PROBE_CRC_FAILURE(rb, pos, length, checksum) \
+    ((void)(rb), (void)(pos), (void)(length), (void)(checksum))
+#endif
+
+_Static_assert(sizeof(ring_buffer_control_t) <= RING_BUFFER_CONTROL_SIZE,
+               "control block must fit in front of the data region");
+
 /* Align size to message alignment */
 static inline size_t align_size(size_t size) {
     return (size + MESSAGE_ALIGNMENT - 1) & ~(MESSAGE_ALIGNMENT - 1);
 }
 
-/* Safe memory copy with bounds checking */
-static inline int safe_memcpy(void *dest, const void *src, size_t n, size_t dest_size) {
-    if (dest == NULL || src == NULL || n > dest_size) {
-        return -1; /* Invalid parameters or buffer overflow */
-    }
-    memcpy(dest, src, n);
-    return 0;
-}
-
 /* Calculate total message size including header */
 static inline size_t total_message_size(size_t data_size) {
     return align_size(sizeof(arrow_ipc_header_t) + data_size);
 }
 
-/* CRC32 table for fast computation */
-static uint32_t crc32_table[256];
-static bool crc32_table_initialized = false;
+/* Largest copy a wrapped message can need. Messages are handed out as
+ * one contiguous zero-copy view; one that wraps around the end of an
+ * unmirrored buffer is copied into such a target first. */
+static inline size_t wrap_copy_size(size_t size) {
+    size_t max_msg = total_message_size(RING_BUFFER_MAX_MESSAGE_SIZE);
+    return size < max_msg ? size : max_msg;
+}
 
-/* Initialize CRC32 lookup table */
-static void init_crc32_table(void) {
-    if (crc32_table_initialized) return;
+/* Map a monotonic position to an offset within the buffer */
+static inline size_t ring_offset(const ring_buffer_t *rb, size_t pos) {
+    return pos & (rb->size - 1);
+}
+
+/* Copy data into the buffer at position, splitting at the end
+ * (never needed for mirrored buffers) */
+static inline void ring_copy_in(ring_buffer_t *rb, size_t pos, const void *src, size_t n) {
+    uint8_t *buffer = (uint8_t *)rb->buffer;
+    pos = ring_offset(rb, pos);
+    size_t first_part = rb->linear_size - pos;
+    
+    if (n <= first_part) {
+        memcpy(buffer + pos, src, n);
+    } else {
+        memcpy(buffer + pos, src, first_part);
+        memcpy(buffer, (const uint8_t *)src + first_part, n - first_part);
+    }
+}
+
+/* Copy data out of the buffer at position, joining a wrapped range */
+static inline void ring_copy_out(const ring_buffer_t *rb, size_t pos, void *dst, size_t n) {
+    const uint8_t *buffer = (const uint8_t *)rb->buffer;
+    pos = ring_offset(rb, pos);
+    size_t first_part = rb->linear_size - pos;
+    
+    if (n <= first_part) {
+        memcpy(dst, buffer + pos, n);
+    } else {
+        memcpy(dst, buffer + pos, first_part);
+        memcpy((uint8_t *)dst + first_part, buffer, n - first_part);
+    }
+}
+
+/* Contiguous view of [pos, pos + n). Mirrored buffers and ranges that
+ * don't wrap are viewed in place; otherwise the range is copied to wrap,
+ * a private target of at least n bytes. Without one there is no view. */
+static inline const uint8_t *ring_view(ring_buffer_t *rb, size_t pos, size_t n, uint8_t *wrap) {
+    uint8_t *buffer = (uint8_t *)rb->buffer;
+    pos = ring_offset(rb, pos);
+    
+    if (pos + n <= rb->linear_size) {
+        return buffer + pos;
+    }
+    if (!wrap) {
+        return NULL;
+    }
+    
+    size_t head = pos + n - rb->size;
+    memcpy(wrap, buffer + pos, n - head);
+    memcpy(wrap + n - head, buffer, head);
+    return wrap;
+}
+
+/* Lazily allocate a private copy target for wrapped messages in *wrap;
+ * mirrored buffers never need one */
+static bool reserve_wrap(const ring_buffer_t *rb, uint8_t **wrap) {
+    if (rb->flags & RING_BUFFER_FLAG_MIRRORED) {
+        return true;
+    }
+    if (!*wrap) {
+        *wrap = malloc(wrap_copy_size(rb->size));
+    }
+    return *wrap != NULL;
+}
+
+/* Per-thread copy target for wrapped messages read or peeked through the
+ * shared read position, freed at thread exit */
+static pthread_key_t wrap_scratch_key;
+static pthread_once_t wrap_scratch_once = PTHREAD_ONCE_INIT;
+static _Thread_local uint8_t *wrap_scratch;
+static _Thread_local size_t wrap_scratch_size;
+
+static void init_wrap_scratch_key(void) {
+    pthread_key_create(&wrap_scratch_key, free);
+}
+
+static uint8_t *wrap_scratch_reserve(size_t size) {
+    if (size <= wrap_scratch_size) {
+        return wrap_scratch;
+    }
     
+    pthread_once(&wrap_scratch_once, init_wrap_scratch_key);
+    uint8_t *grown = realloc(wrap_scratch, size);
+    if (!grown) {
+        return NULL;
+    }
+    wrap_scratch = grown;
+    wrap_scratch_size = size;
+    pthread_setspecific(wrap_scratch_key, grown);
+    return grown;
+}
+
+/* Software CRC tables: slice-by-8 for both polynomials */
+static uint32_t crc32_table[8][256];
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc_tables_once = PTHREAD_ONCE_INIT;
+
+/* Runtime-selected CRC32C implementation */
+typedef uint32_t (*crc_update_fn)(uint32_t crc, const void *data, size_t size);
+static crc_update_fn crc32c_update_impl;
+static const char *crc32c_impl_name;
+
+/* Build the slice-by-8 tables for a reflected polynomial */
+static void build_crc_tables(uint32_t table[8][256], uint32_t polynomial) {
     for (int i = 0; i < 256; i++) {
-        uint32_t crc = i;
+        uint32_t crc = (uint32_t)i;
         for (int j = 0; j < 8; j++) {
             if (crc & 1) {
-                crc = (crc >> 1) ^ CRC32_POLYNOMIAL;
+                crc = (crc >> 1) ^ polynomial;
             } else {
                 crc >>= 1;
             }
         }
-        crc32_table[i] = crc;
+        table[0][i] = crc;
+    }
+    
+    for (int i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+        }
+    }
+}
+
+/* Slice-by-8 update of a running (pre-inverted) CRC */
+static inline uint32_t crc_update_slice8(uint32_t table[8][256], uint32_t crc,
+                                         const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    
+    /* Align to 8 bytes so the wide loads below are cheap */
+    while (size > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc = table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+        size--;
+    }
+    
+    while (size >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, bytes, 4);
+        memcpy(&hi, bytes + 4, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+              table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+              table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+        bytes += 8;
+        size -= 8;
+    }
+    
+    while (size > 0) {
+        crc = table[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+        size--;
+    }
+    
+    return crc;
+}
+
+/* Feed more bytes into a running (pre-inverted) CRC32 */
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t size) {
+    return crc_update_slice8(crc32_table, crc, data, size);
+}
+
+static uint32_t crc32c_update_sw(uint32_t crc, const void *data, size_t size) {
+    return crc_update_slice8(crc32c_table, crc, data, size);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+/* SSE4.2 crc32 instruction, 8 bytes per step */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_update_sse42(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint64_t crc64 = crc;
+    
+    while (size > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc64 = __builtin_ia32_crc32qi((uint32_t)crc64, *bytes++);
+        size--;
+    }
+    
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+        bytes += 8;
+        size -= 8;
+    }
+    
+    while (size > 0) {
+        crc64 = __builtin_ia32_crc32qi((uint32_t)crc64, *bytes++);
+        size--;
+    }
+    
+    return (uint32_t)crc64;
+}
+#define HAVE_CRC32C_SSE42 1
+#endif
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_CRC32) || (defined(__linux__) && defined(__GNUC__)))
+/* ARMv8 CRC32C instructions (always present on Apple Silicon) */
+#if !defined(__ARM_FEATURE_CRC32)
+#if defined(__clang__)
+__attribute__((target("crc")))
+#else
+__attribute__((target("+crc")))
+#endif
+#endif
+static uint32_t crc32c_update_armv8(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    
+    while (size > 0 && ((uintptr_t)bytes & 7) != 0) {
+        crc = __builtin_arm_crc32cb(crc, *bytes++);
+        size--;
+    }
+    
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        crc = __builtin_arm_crc32cd(crc, word);
+        bytes += 8;
+        size -= 8;
+    }
+    
+    while (size > 0) {
+        crc = __builtin_arm_crc32cb(crc, *bytes++);
+        size--;
+    }
+    
+    return crc;
+}
+#define HAVE_CRC32C_ARMV8 1
+#endif
+
+/* Build the tables and pick the fastest CRC32C implementation */
+static void init_crc_tables_once(void) {
+    build_crc_tables(crc32_table, CRC32_POLYNOMIAL);
+    build_crc_tables(crc32c_table, CRC32C_POLYNOMIAL);
+    
+    crc32c_update_impl = crc32c_update_sw;
+    crc32c_impl_name = "slice-by-8";
+    
+#if defined(HAVE_CRC32C_SSE42)
+    if (__builtin_cpu_supports("sse4.2")) {
+        crc32c_update_impl = crc32c_update_sse42;
+        crc32c_impl_name = "sse4.2";
+    }
+#elif defined(HAVE_CRC32C_ARMV8)
+#if defined(__ARM_FEATURE_CRC32)
+    crc32c_update_impl = crc32c_update_armv8;
+    crc32c_impl_name = "armv8-crc";
+#elif defined(__linux__)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        crc32c_update_impl = crc32c_update_armv8;
+        crc32c_impl_name = "armv8-crc";
+    }
+#endif
+#endif
+}
+
+/* Initialize CRC lookup tables and dispatch */
+static void init_crc32_table(void) {
+    pthread_once(&crc_tables_once, init_crc_tables_once);
+}
+
+/* Feed more bytes into a running (pre-inverted) checksum */
+static inline uint32_t checksum_update(ring_buffer_checksum_t algorithm, uint32_t crc,
+                                       const void *data, size_t size) {
+    if (algorithm == RING_BUFFER_CHECKSUM_CRC32C) {
+        return crc32c_update_impl(crc, data, size);
+    }
+    return crc32_update(crc, data, size);
+}
+
+uint32_t ring_buffer_crc32(const void *data, size_t size) {
+    init_crc32_table();
+    return crc32_update(0xFFFFFFFF, data, size) ^ 0xFFFFFFFF;
+}
+
+uint32_t ring_buffer_crc32c(const void *data, size_t size) {
+    init_crc32_table();
+    return crc32c_update_impl(0xFFFFFFFF, data, size) ^ 0xFFFFFFFF;
+}
+
+uint32_t ring_buffer_checksum(ring_buffer_checksum_t algorithm, const void *data, size_t size) {
+    init_crc32_table();
+    return checksum_update(algorithm, 0xFFFFFFFF, data, size) ^ 0xFFFFFFFF;
+}
+
+const char *ring_buffer_checksum_implementation(void) {
+    init_crc32_table();
+    return crc32c_impl_name;
+}
+
+/* LZ4 block codec: greedy single-probe matcher, compatible with the
+ * reference decoder. Matches end at least LZ4_LAST_LITERALS bytes before
+ * the end of the block and none start in the last LZ4_MFLIMIT bytes. */
+#define LZ4_HASH_LOG 12
+#define LZ4_MIN_MATCH 4
+#define LZ4_MFLIMIT 12
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_SKIP_TRIGGER 6  /* Probe further apart after 2^6 misses in a row */
+
+/* Worst-case LZ4 output for n bytes of input */
+static inline size_t lz4_compress_bound(size_t n) {
+    return n + n / 255 + 16;
+}
+
+static inline uint32_t load32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+/* Emit the continuation bytes of a length that didn't fit in its token nibble */
+static inline uint8_t *lz4_write_length(uint8_t *op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+/* Emit a sequence: token, literals and, unless match_length is 0, a match */
+static inline uint8_t *lz4_write_sequence(uint8_t *op, const uint8_t *literals, size_t literal_length,
+                                          size_t offset, size_t match_length) {
+    uint8_t *token = op++;
+    
+    if (literal_length >= 15) {
+        *token = 15 << 4;
+        op = lz4_write_length(op, literal_length - 15);
+    } else {
+        *token = (uint8_t)(literal_length << 4);
+    }
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    
+    if (match_length == 0) {
+        return op;
+    }
+    
+    op[0] = (uint8_t)offset;
+    op[1] = (uint8_t)(offset >> 8);
+    op += 2;
+    
+    match_length -= LZ4_MIN_MATCH;
+    if (match_length >= 15) {
+        *token |= 15;
+        op = lz4_write_length(op, match_length - 15);
+    } else {
+        *token |= (uint8_t)match_length;
+    }
+    return op;
+}
+
+/* Compress src into dst; returns the compressed size, or 0 if it exceeds capacity */
+static size_t lz4_compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+    uint32_t table[1 << LZ4_HASH_LOG] = {0};
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+    const uint8_t *end = src + size;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + capacity;
+    
+    if (size > LZ4_MFLIMIT) {
+        const uint8_t *match_start_limit = end - LZ4_MFLIMIT;
+        const uint8_t *match_end_limit = end - LZ4_LAST_LITERALS;
+        size_t misses = 0;
+        
+        while (ip < match_start_limit) {
+            uint32_t sequence = load32(ip);
+            uint32_t h = lz4_hash(sequence);
+            const uint8_t *ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+            
+            if (ref >= ip || (size_t)(ip - ref) > LZ4_MAX_OFFSET || load32(ref) != sequence) {
+                ip += 1 + (misses++ >> LZ4_SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+            
+            /* Extend the match backwards into the pending literals, then forwards */
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t *match_end = ip + LZ4_MIN_MATCH;
+            const uint8_t *ref_end = ref + LZ4_MIN_MATCH;
+            while (match_end < match_end_limit && *match_end == *ref_end) {
+                match_end++;
+                ref_end++;
+            }
+            
+            size_t literal_length = (size_t)(ip - anchor);
+            size_t match_length = (size_t)(match_end - ip);
+            size_t worst = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+            if (worst > (size_t)(op_end - op)) {
+                return 0;
+            }
+            
+            op = lz4_write_sequence(op, anchor, literal_length, (size_t)(ip - ref), match_length);
+            ip = match_end;
+            anchor = ip;
+        }
+    }
+    
+    /* The block always ends with a literals-only sequence */
+    size_t literal_length = (size_t)(end - anchor);
+    if (1 + literal_length / 255 + 1 + literal_length > (size_t)(op_end - op)) {
+        return 0;
+    }
+    op = lz4_write_sequence(op, anchor, literal_length, 0, 0);
+    
+    return (size_t)(op - dst);
+}
+
+/* Read a length continuation; false if it runs past the input */
+static inline bool lz4_read_length(const uint8_t **ip, const uint8_t *end, size_t *length) {
+    uint8_t b;
+    do {
+        if (*ip >= end) {
+            return false;
+        }
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+/* Decompress an LZ4 block that must expand to exactly dst_size bytes,
+ * bounds-checking every read and write */
+static bool lz4_decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t dst_size) {
+    const uint8_t *ip = src;
+    const uint8_t *end = src + size;
+    uint8_t *op = dst;
+    uint8_t *op_end = dst + dst_size;
+    
+    while (ip < end) {
+        uint8_t token = *ip++;
+        
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !lz4_read_length(&ip, end, &literal_length)) {
+            return false;
+        }
+        if (literal_length > (size_t)(end - ip) || literal_length > (size_t)(op_end - op)) {
+            return false;
+        }
+        memcpy(op, ip, literal_length);
+        op += literal_length;
+        ip += literal_length;
+        
+        /* The last sequence has no match */
+        if (ip == end) {
+            break;
+        }
+        if (end - ip < 2) {
+            return false;
+        }
+        
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return false;
+        }
+        
+        size_t match_length = token & 15;
+        if (match_length == 15 && !lz4_read_length(&ip, end, &match_length)) {
+            return false;
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (match_length > (size_t)(op_end - op)) {
+            return false;
+        }
+        
+        /* Overlapping matches repeat the last offset bytes, so copy forwards */
+        const uint8_t *ref = op - offset;
+        if (offset >= match_length) {
+            memcpy(op, ref, match_length);
+            op += match_length;
+        } else {
+            for (size_t i = 0; i < match_length; i++) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    
+    return op == op_end;
+}
+
+/* Per-thread scratch that compressed payloads are staged in, freed at thread exit */
+static pthread_key_t codec_scratch_key;
+static pthread_once_t codec_scratch_once = PTHREAD_ONCE_INIT;
+static _Thread_local uint8_t *codec_scratch;
+static _Thread_local size_t codec_scratch_size;
+
+static void init_codec_scratch_key(void) {
+    pthread_key_create(&codec_scratch_key, free);
+}
+
+static uint8_t *codec_scratch_reserve(size_t size) {
+    if (size <= codec_scratch_size) {
+        return codec_scratch;
+    }
+    
+    pthread_once(&codec_scratch_once, init_codec_scratch_key);
+    uint8_t *grown = realloc(codec_scratch, size);
+    if (!grown) {
+        return NULL;
+    }
+    codec_scratch = grown;
+    codec_scratch_size = size;
+    pthread_setspecific(codec_scratch_key, grown);
+    return grown;
+}
+
+static inline size_t codec_compress_bound(ring_buffer_codec_t codec, size_t size) {
+#if RING_BUFFER_WITH_ZSTD
+    if (codec == RING_BUFFER_CODEC_ZSTD) {
+        return ZSTD_compressBound(size);
+    }
+#endif
+    (void)codec;
+    return lz4_compress_bound(size);
+}
+
+/* Compress with a supported codec; returns the compressed size, or 0 if it didn't fit */
+static size_t codec_compress(ring_buffer_codec_t codec, const void *src, size_t size,
+                             uint8_t *dst, size_t capacity) {
+#if RING_BUFFER_WITH_ZSTD
+    if (codec == RING_BUFFER_CODEC_ZSTD) {
+        size_t n = ZSTD_compress(dst, capacity, src, size, RING_BUFFER_ZSTD_LEVEL);
+        return ZSTD_isError(n) ? 0 : n;
+    }
+#endif
+    (void)codec;
+    return lz4_compress((const uint8_t *)src, size, dst, capacity);
+}
+
+static bool codec_decompress(ring_buffer_codec_t codec, const void *src, size_t size,
+                             void *dst, size_t dst_size) {
+#if RING_BUFFER_WITH_ZSTD
+    if (codec == RING_BUFFER_CODEC_ZSTD) {
+        size_t n = ZSTD_decompress(dst, dst_size, src, size);
+        return !ZSTD_isError(n) && n == dst_size;
+    }
+#endif
+    (void)codec;
+    return lz4_decompress((const uint8_t *)src, size, (uint8_t *)dst, dst_size);
+}
+
+bool ring_buffer_codec_supported(ring_buffer_codec_t codec) {
+    switch (codec) {
+        case RING_BUFFER_CODEC_NONE:
+        case RING_BUFFER_CODEC_LZ4:
+            return true;
+        case RING_BUFFER_CODEC_ZSTD:
+            return RING_BUFFER_WITH_ZSTD;
+        default:
+            return false;
+    }
+}
+
+uint64_t ring_buffer_timestamp(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Header timestamp clocks. The CPU counter is converted with a 32.32
+ * fixed-point ns-per-tick multiplier, which needs a 128-bit product. */
+#define CLOCK_MULT_SHIFT 32
+#define CLOCK_CALIBRATION_NS 1000000  /* Window the x86 counter rate is measured over */
+
+#if defined(__SIZEOF_INT128__) && defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define HAVE_CPU_COUNTER 1
+__extension__ typedef unsigned __int128 clock_u128;
+
+#if defined(__x86_64__)
+static inline uint64_t cpu_counter(void) {
+    return __rdtsc();
+}
+
+/* Only an invariant TSC ticks at one rate across cores and P-states */
+static bool cpu_counter_usable(void) {
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+}
+#else
+static inline uint64_t cpu_counter(void) {
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+}
+
+/* The generic timer is architecturally constant-rate */
+static bool cpu_counter_usable(void) {
+    return true;
+}
+#endif
+#endif
+
+#if defined(__APPLE__)
+/* mach_continuous_approximate_time() ticks to ns; set before first use */
+static mach_timebase_info_data_t coarse_timebase;
+static pthread_once_t coarse_timebase_once = PTHREAD_ONCE_INIT;
+
+static void init_coarse_timebase(void) {
+    mach_timebase_info(&coarse_timebase);
+}
+#endif
+
+/* Wall clock at scheduler-tick resolution, without touching a counter */
+static inline uint64_t coarse_now(const ring_buffer_t *rb) {
+#if defined(CLOCK_REALTIME_COARSE)
+    (void)rb;
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#elif defined(__APPLE__)
+    /* The time cached at the last context switch, counting sleep, moved
+     * onto the wall clock by an offset taken when the clock was chosen */
+    uint64_t ticks = mach_continuous_approximate_time();
+    return ticks * coarse_timebase.numer / coarse_timebase.denom + (uint64_t)rb->clock_offset_ns;
+#else
+    (void)rb;
+    return ring_buffer_timestamp();
+#endif
+}
+
+#if HAVE_CPU_COUNTER
+/* Scale the counter through the shared anchor; falls back to the wall
+ * clock until some handle has calibrated it */
+static inline uint64_t counter_now(ring_buffer_control_t *control) {
+    uint64_t ticks = cpu_counter();
+    uint64_t anchor_ticks, anchor_ns, mult;
+    unsigned int seq;
+    
+    do {
+        seq = atomic_load_explicit(&control->clock_seq, memory_order_acquire);
+        anchor_ticks = atomic_load_explicit(&control->clock_anchor_ticks, memory_order_relaxed);
+        anchor_ns = atomic_load_explicit(&control->clock_anchor_ns, memory_order_relaxed);
+        mult = atomic_load_explicit(&control->clock_mult, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&control->clock_seq, memory_order_relaxed));
+    
+    if (mult == 0) {
+        return ring_buffer_timestamp();
+    }
+    if (ticks >= anchor_ticks) {
+        return anchor_ns + (uint64_t)(((clock_u128)(ticks - anchor_ticks) * mult) >> CLOCK_MULT_SHIFT);
+    }
+    return anchor_ns - (uint64_t)(((clock_u128)(anchor_ticks - ticks) * mult) >> CLOCK_MULT_SHIFT);
+}
+
+/* Measure the counter rate and store a fresh anchor. If another thread
+ * or process is re-anchoring at the same moment, its anchor wins. */
+static void calibrate_counter(ring_buffer_control_t *control) {
+    uint64_t mult;
+#if defined(__aarch64__)
+    uint64_t frequency;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+    mult = (uint64_t)(((clock_u128)1000000000 << CLOCK_MULT_SHIFT) / frequency);
+#else
+    uint64_t t0 = monotonic_ns();
+    uint64_t c0 = cpu_counter();
+    uint64_t t1, c1;
+    do {
+        cpu_relax();
+        t1 = monotonic_ns();
+        c1 = cpu_counter();
+    } while (t1 - t0 < CLOCK_CALIBRATION_NS);
+    mult = (uint64_t)(((clock_u128)(t1 - t0) << CLOCK_MULT_SHIFT) / (c1 - c0));
+#endif
+    
+    /* Anchor the counter to the wall clock read right next to it */
+    uint64_t anchor_ns = ring_buffer_timestamp();
+    uint64_t anchor_ticks = cpu_counter();
+    
+    unsigned int seq = atomic_load_explicit(&control->clock_seq, memory_order_relaxed);
+    if ((seq & 1) || !atomic_compare_exchange_strong_explicit(&control->clock_seq, &seq, seq + 1,
+                                                              memory_order_relaxed, memory_order_relaxed)) {
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&control->clock_anchor_ticks, anchor_ticks, memory_order_relaxed);
+    atomic_store_explicit(&control->clock_anchor_ns, anchor_ns, memory_order_relaxed);
+    atomic_store_explicit(&control->clock_mult, mult, memory_order_relaxed);
+    atomic_store_explicit(&control->clock_seq, seq + 2, memory_order_release);
+}
+#endif
+
+/* Timestamp for a header, from the handle's clock */
+static inline uint64_t handle_now(const ring_buffer_t *rb) {
+    switch (rb->clock) {
+        case RING_BUFFER_CLOCK_COARSE:
+            return coarse_now(rb);
+#if HAVE_CPU_COUNTER
+        case RING_BUFFER_CLOCK_COUNTER:
+            return counter_now(rb->control);
+#endif
+        default:
+            return ring_buffer_timestamp();
+    }
+}
+
+ring_buffer_error_t ring_buffer_set_clock(ring_buffer_t *rb, ring_buffer_clock_t clock) {
+    if (!rb) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    switch (clock) {
+        case RING_BUFFER_CLOCK_REALTIME:
+            break;
+        case RING_BUFFER_CLOCK_COARSE:
+#if defined(__APPLE__) && !defined(CLOCK_REALTIME_COARSE)
+            pthread_once(&coarse_timebase_once, init_coarse_timebase);
+            rb->clock_offset_ns = 0;
+            rb->clock_offset_ns = (int64_t)(ring_buffer_timestamp() - coarse_now(rb));
+#endif
+            break;
+        case RING_BUFFER_CLOCK_COUNTER:
+#if HAVE_CPU_COUNTER
+            if (!cpu_counter_usable()) {
+                return RING_BUFFER_ERROR_UNSUPPORTED;
+            }
+            if (atomic_load(&rb->control->clock_mult) == 0) {
+                calibrate_counter(rb->control);
+            }
+            break;
+#else
+            return RING_BUFFER_ERROR_UNSUPPORTED;
+#endif
+        default:
+            return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    rb->clock = clock;
+    return RING_BUFFER_SUCCESS;
+}
+
+ring_buffer_error_t ring_buffer_calibrate_clock(ring_buffer_t *rb) {
+    if (!rb) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+#if HAVE_CPU_COUNTER
+    if (cpu_counter_usable()) {
+        calibrate_counter(rb->control);
+        return RING_BUFFER_SUCCESS;
+    }
+#endif
+    return RING_BUFFER_ERROR_UNSUPPORTED;
+}
+
+uint64_t ring_buffer_now(const ring_buffer_t *rb) {
+    return rb ? handle_now(rb) : ring_buffer_timestamp();
+}
+
+size_t ring_buffer_next_power_of_2(size_t n) {
+    if (n == 0) return 1;
+    n--;
+    n |= n >> 1;
+    n |= n >> 2;
+    n |= n >> 4;
+    n |= n >> 8;
+    n |= n >> 16;
+    n |= n >> 32;
+    return n + 1;
+}
+
+/* Create an anonymous shared-memory object to back a mirrored mapping */
+static int create_backing_fd(size_t size) {
+    int fd = -1;
+    
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    fd = memfd_create("chronicle-ring-buffer", MFD_CLOEXEC);
+#endif
+    
+    if (fd < 0) {
+        /* Portable fallback (macOS): a uniquely named POSIX shm object
+         * that is unlinked straight away, leaving only our descriptor */
+        static atomic_uint shm_counter;
+        char name[32];
+        
+        for (int attempt = 0; attempt < 16 && fd < 0; attempt++) {
+            snprintf(name, sizeof(name), "/chronicle-rb-%d-%u", (int)getpid(),
+                     atomic_fetch_add(&shm_counter, 1));
+            fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd >= 0) {
+                shm_unlink(name);
+            } else if (errno != EEXIST) {
+                break;
+            }
+        }
+    }
+    
+    if (fd >= 0 && ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    
+    return fd;
+}
+
+/* Point the handle at a mapping laid out as [control][data][mirror] */
+static void attach_mapping(ring_buffer_t *rb, uint8_t *base, size_t mapped_size,
+                           size_t size, bool mirrored) {
+    rb->mapping = base;
+    rb->mapped_size = mapped_size;
+    rb->control = (ring_buffer_control_t *)base;
+    rb->buffer = base + RING_BUFFER_CONTROL_SIZE;
+    rb->size = size;
+    rb->linear_size = mirrored ? 2 * size : size;
+    if (mirrored) {
+        rb->flags |= RING_BUFFER_FLAG_MIRRORED;
+    }
+}
+
+/* Huge page size the data region is aligned to */
+#define HUGE_PAGE_SIZE (2u * 1024 * 1024)
+
+/* Map len bytes of private anonymous memory. With huge_aligned the
+ * mapping is placed so that the data region after the control block
+ * starts on a huge page boundary, since transparent huge pages only back
+ * aligned ranges. */
+static void *map_region(size_t len, int prot, bool huge_aligned) {
+    size_t slack = huge_aligned ? HUGE_PAGE_SIZE : 0;
+    uint8_t *base = mmap(NULL, len + slack, prot, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (base == MAP_FAILED || slack == 0) {
+        return base;
+    }
+    
+    /* Trim the slack on either side of the aligned range */
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t data = ((uintptr_t)base + RING_BUFFER_CONTROL_SIZE + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    uint8_t *aligned = (uint8_t *)(data - RING_BUFFER_CONTROL_SIZE);
+    uint8_t *end = (uint8_t *)(((uintptr_t)(aligned + len) + page_size - 1) & ~(uintptr_t)(page_size - 1));
+    if (aligned > base) {
+        munmap(base, (size_t)(aligned - base));
+    }
+    if (end < base + len + slack) {
+        munmap(end, (size_t)(base + len + slack - end));
+    }
+    return aligned;
+}
+
+/* Map the whole buffer from the explicit huge page pool: hugetlbfs pages
+ * on Linux, superpages on macOS. The pool is often empty, so callers fall
+ * back to regular pages. */
+static bool map_huge_pages(ring_buffer_t *rb, size_t alloc_size, size_t size) {
+    size_t huge_size = (alloc_size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+    void *base = MAP_FAILED;
+    
+#if defined(MAP_HUGETLB)
+    base = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+#elif defined(__APPLE__) && defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+    base = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+#else
+    (void)huge_size;
+#endif
+    
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    
+    attach_mapping(rb, base, huge_size, size, false);
+    rb->flags |= RING_BUFFER_FLAG_HUGE_PAGES;
+    return true;
+}
+
+/* Fault in every page of a mapping without changing its contents, which
+ * other processes may be writing to */
+static void prefault_range(void *start, size_t len) {
+#if defined(MADV_POPULATE_WRITE)
+    if (madvise(start, len, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    /* Adding zero atomically is a write fault that can't lose a
+     * concurrent store */
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    for (size_t offset = 0; offset < len; offset += page_size) {
+        __atomic_fetch_add((uint8_t *)start + offset, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* Apply the memory options in flags to a new mapping. Options that the
+ * platform or resource limits refuse are left cleared in rb->flags. */
+static void apply_memory_flags(ring_buffer_t *rb, uint32_t flags) {
+    if (rb->mapped_size == 0) {
+        return;  /* Heap fallback */
+    }
+    
+#if defined(MADV_HUGEPAGE)
+    if ((flags & RING_BUFFER_FLAG_HUGE_PAGES) && !(rb->flags & RING_BUFFER_FLAG_HUGE_PAGES) &&
+        madvise(rb->mapping, rb->mapped_size, MADV_HUGEPAGE) == 0) {
+        rb->flags |= RING_BUFFER_FLAG_HUGE_PAGES;
+    }
+#endif
+    
+    if (flags & RING_BUFFER_FLAG_PREFAULT) {
+        prefault_range(rb->mapping, rb->mapped_size);
+        rb->flags |= RING_BUFFER_FLAG_PREFAULT;
+    }
+    
+    /* Locked pages are never paged out; usually bounded by RLIMIT_MEMLOCK */
+    if ((flags & RING_BUFFER_FLAG_LOCKED) && mlock(rb->mapping, rb->mapped_size) == 0) {
+        rb->flags |= RING_BUFFER_FLAG_LOCKED;
+    }
+}
+
+/* Map a control block and data region stored in fd. With mirrored set the
+ * data pages are mapped a second time right after the first view, so that
+ * any region of up to size bytes starting inside the buffer is contiguous
+ * in virtual memory. */
+static bool map_file(ring_buffer_t *rb, int fd, size_t size, bool mirrored, uint32_t flags) {
+    size_t total_size = RING_BUFFER_CONTROL_SIZE + size + (mirrored ? size : 0);
+    
+    /* Reserve address space for all views, then map the file over it */
+    uint8_t *base = map_region(total_size, PROT_NONE, (flags & RING_BUFFER_FLAG_HUGE_PAGES) != 0);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    
+    if (mmap(base, RING_BUFFER_CONTROL_SIZE + size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, total_size);
+        return false;
+    }
+    
+    if (mirrored &&
+        mmap(base + RING_BUFFER_CONTROL_SIZE + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+             fd, (off_t)RING_BUFFER_CONTROL_SIZE) == MAP_FAILED) {
+        munmap(base, total_size);
+        return false;
+    }
+    
+    attach_mapping(rb, base, total_size, size, mirrored);
+    return true;
+}
+
+/* Map a private control block and buffer in anonymous memory */
+static bool map_anonymous(ring_buffer_t *rb, size_t size, uint32_t flags) {
+    size_t alloc_size = RING_BUFFER_CONTROL_SIZE + size;
+    bool huge = (flags & RING_BUFFER_FLAG_HUGE_PAGES) != 0;
+    void *base;
+    
+    if (huge && map_huge_pages(rb, alloc_size, size)) {
+        return true;
+    }
+    
+    /* Try MAP_ANON first (macOS) */
+#if defined(MAP_ANON)
+    base = map_region(alloc_size, PROT_READ | PROT_WRITE, huge);
+    if (base == MAP_FAILED) {
+#elif defined(MAP_ANONYMOUS)
+    base = mmap(NULL, alloc_size, PROT_READ | PROT_WRITE, 
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+#else
+    /* Force fallback */
+    base = MAP_FAILED;
+    if (true) {
+#endif
+        /* Fallback to regular malloc, keeping the control block's
+         * cache-line alignment */
+        if (posix_memalign(&base, RING_BUFFER_CACHE_LINE_SIZE, alloc_size) != 0) {
+            return false;
+        }
+        memset(base, 0, alloc_size);
+        attach_mapping(rb, base, 0, size, false);
+        return true;
+    }
+    
+    attach_mapping(rb, base, alloc_size, size, false);
+    return true;
+}
+
+/* Zero every statistics shard */
+static void reset_stats(ring_buffer_control_t *control) {
+    for (int i = 0; i < RING_BUFFER_STATS_SHARDS; i++) {
+        ring_buffer_stats_shard_t *shard = &control->stats[i];
+        atomic_store_explicit(&shard->messages_written, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->messages_read, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->bytes_written, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->bytes_read, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->write_errors, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->read_errors, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->backpressure_events, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->backpressure_exits, 0, memory_order_relaxed);
+        atomic_store_explicit(&shard->messages_shed, 0, memory_order_relaxed);
+    }
+}
+
+/* Convert watermark fractions to byte thresholds */
+static bool watermarks_to_bytes(size_t size, double high, double low,
+                                size_t *high_bytes, size_t *low_bytes) {
+    if (!(high > 0.0 && high <= 1.0) || !(low >= 0.0 && low <= high)) {
+        return false;
+    }
+    
+    *high_bytes = (size_t)(high * (double)size);
+    *low_bytes = (size_t)(low * (double)size);
+    return true;
+}
+
+/* Resolve the watermark fractions of a creation config. Zero selects a
+ * default; a low watermark left unset scales with a custom high one, so
+ * raising or lowering only the high watermark keeps the same hysteresis. */
+static bool config_watermarks(const ring_buffer_config_t *config, double *high, double *low) {
+    *high = config->high_watermark != 0.0 ? config->high_watermark : RING_BUFFER_BACKPRESSURE_THRESHOLD;
+    if (config->low_watermark != 0.0) {
+        *low = config->low_watermark;
+    } else {
+        *low = *high * (RING_BUFFER_LOW_WATERMARK / RING_BUFFER_BACKPRESSURE_THRESHOLD);
+    }
+    return *high > 0.0 && *high <= 1.0 && *low > 0.0 && *low <= *high;
+}
+
+/* Initialize a fresh control block. The magic is stored last so that
+ * processes attaching to a shared buffer never see a half-built one. */
+static void init_control(ring_buffer_control_t *control, size_t size, uint32_t flags,
+                         const ring_buffer_config_t *config) {
+    memset(control, 0, sizeof(*control));
+    
+    control->version = RING_BUFFER_CONTROL_VERSION;
+    control->control_size = RING_BUFFER_CONTROL_SIZE;
+    control->size = size;
+    control->flags = flags;
+    
+    /* Index intervals cover the whole buffer with RING_BUFFER_INDEX_ENTRIES entries */
+    control->index_shift = INDEX_MIN_SHIFT;
+    while (((size_t)RING_BUFFER_INDEX_ENTRIES << control->index_shift) < size) {
+        control->index_shift++;
+    }
+    
+    /* Backpressure watermarks; the creators have already validated them */
+    double high, low;
+    size_t high_bytes, low_bytes;
+    config_watermarks(config, &high, &low);
+    watermarks_to_bytes(size, high, low, &high_bytes, &low_bytes);
+    atomic_store(&control->high_watermark, high_bytes);
+    atomic_store(&control->low_watermark, low_bytes);
+    
+    /* Elastic buffers start small; the capacity of any other is its size */
+    size_t capacity = size;
+    if (flags & RING_BUFFER_FLAG_ELASTIC) {
+        capacity = config->initial_size > 0 ? config->initial_size : RING_BUFFER_ELASTIC_INITIAL_SIZE;
+        if (capacity > size) {
+            capacity = size;
+        }
+    }
+    control->initial_capacity = capacity;
+    atomic_store(&control->capacity, capacity);
+    atomic_store(&control->trim_skip, 0);
+    atomic_store(&control->trimming, false);
+    
+    /* Initialize atomic positions */
+    atomic_store(&control->write_pos, 0);
+    atomic_store(&control->read_pos, 0);
+    atomic_store(&control->commit_pos, 0);
+    atomic_store(&control->cached_read_pos, 0);
+    atomic_store(&control->cached_commit_pos, 0);
+    atomic_store(&control->is_full, false);
+    atomic_store(&control->backpressure, false);
+    
+    /* Initialize statistics */
+    reset_stats(control);
+    
+    atomic_thread_fence(memory_order_release);
+    control->magic = RING_BUFFER_CONTROL_MAGIC;
+}
+
+/* Apply the default size, round to a power of 2 and, where the layout
+ * needs it, to at least one page */
+static size_t normalize_size(size_t size, bool page_aligned) {
+    if (size == 0) {
+        size = RING_BUFFER_DEFAULT_SIZE;
+    }
+    
+    /* Ensure size is power of 2 for efficient modulo operations */
+    size = ring_buffer_next_power_of_2(size);
+    
+    if (page_aligned) {
+        size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+        if (size < page_size) {
+            size = page_size;
+        }
+    }
+    
+    return size;
+}
+
+ring_buffer_t *ring_buffer_create(size_t size) {
+    ring_buffer_config_t config = { .size = size };
+    return ring_buffer_create_ex(&config);
+}
+
+ring_buffer_t *ring_buffer_create_ex(const ring_buffer_config_t *config) {
+    double high, low;
+    if (!config || !config_watermarks(config, &high, &low)) {
+        return NULL;
+    }
+    
+    bool mirrored = (config->flags & RING_BUFFER_FLAG_MIRRORED) != 0;
+    
+    /* Both views of a mirrored buffer must start on a page boundary */
+    size_t size = normalize_size(config->size, mirrored);
+    
+    /* Allocate ring buffer structure */
+    ring_buffer_t *rb = calloc(1, sizeof(ring_buffer_t));
+    if (!rb) {
+        return NULL;
+    }
+    
+    /* Allocate buffer memory - fallback to malloc for compatibility */
+    rb->fd = -1;
+    
+    bool mapped = false;
+    if (mirrored) {
+        int fd = create_backing_fd(RING_BUFFER_CONTROL_SIZE + size);
+        if (fd >= 0) {
+            mapped = map_file(rb, fd, size, true, config->flags);
+            if (mapped) {
+                rb->fd = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    
+    if (!mapped && !map_anonymous(rb, size, config->flags)) {
+        free(rb);
+        return NULL;
+    }
+    apply_memory_flags(rb, config->flags);
+    
+    /* Initialize buffer structure */
+    rb->magic = RING_BUFFER_MAGIC;
+    rb->flags |= config->flags & (RING_BUFFER_HANDLE_FLAGS | RING_BUFFER_MODE_FLAGS);
+    init_control(rb->control, size, rb->flags, config);
+    
+    /* Initialize CRC tables and pick the checksum implementation */
+    init_crc32_table();
+    
+    return rb;
+}
+
+ring_buffer_t *ring_buffer_create_shared(const char *path, const ring_buffer_config_t *config) {
+    double high, low;
+    if (!path || !config || !config_watermarks(config, &high, &low)) {
+        return NULL;
+    }
+    
+    /* The data region is mapped separately from the control block */
+    size_t size = normalize_size(config->size, true);
+    
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+    
+    if (ftruncate(fd, (off_t)(RING_BUFFER_CONTROL_SIZE + size)) != 0) {
+        close(fd);
+        return NULL;
+    }
+    
+    ring_buffer_t *rb = calloc(1, sizeof(ring_buffer_t));
+    if (!rb) {
+        close(fd);
+        return NULL;
+    }
+    
+    rb->fd = fd;
+    rb->flags = RING_BUFFER_FLAG_SHARED | (config->flags & (RING_BUFFER_HANDLE_FLAGS | RING_BUFFER_MODE_FLAGS));
+    
+    bool mirrored = (config->flags & RING_BUFFER_FLAG_MIRRORED) != 0;
+    if (!(mirrored && map_file(rb, fd, size, true, config->flags)) && !map_file(rb, fd, size, false, config->flags)) {
+        close(fd);
+        free(rb);
+        return NULL;
+    }
+    apply_memory_flags(rb, config->flags);
+    
+    rb->magic = RING_BUFFER_MAGIC;
+    init_control(rb->control, size, rb->flags, config);
+    
+    init_crc32_table();
+    
+    return rb;
+}
+
+ring_buffer_t *ring_buffer_open_shared(const char *path, uint32_t flags) {
+    if (!path) {
+        return NULL;
+    }
+    
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    
+    /* Peek at the control block to learn the buffer geometry */
+    struct stat st;
+    ring_buffer_control_t *control = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= RING_BUFFER_CONTROL_SIZE) {
+        control = mmap(NULL, RING_BUFFER_CONTROL_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    if (control == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    
+    uint32_t magic = control->magic;
+    atomic_thread_fence(memory_order_acquire);
+    size_t size = (size_t)control->size;
+    uint32_t modes = control->flags & RING_BUFFER_MODE_FLAGS;
+    bool valid = magic == RING_BUFFER_CONTROL_MAGIC &&
+                 control->version == RING_BUFFER_CONTROL_VERSION &&
+                 control->control_size == RING_BUFFER_CONTROL_SIZE &&
+                 size > 0 && (size & (size - 1)) == 0 &&
+                 (size_t)st.st_size >= RING_BUFFER_CONTROL_SIZE + size;
+    munmap(control, RING_BUFFER_CONTROL_SIZE);
+    
+    if (!valid) {
+        close(fd);
+        return NULL;
+    }
+    
+    ring_buffer_t *rb = calloc(1, sizeof(ring_buffer_t));
+    if (!rb) {
+        close(fd);
+        return NULL;
+    }
+    
+    rb->fd = fd;
+    rb->flags = RING_BUFFER_FLAG_SHARED | modes | (flags & RING_BUFFER_HANDLE_FLAGS);
+    
+    /* Mirroring is a property of this process's mapping, not of the file */
+    bool mirrored = (flags & RING_BUFFER_FLAG_MIRRORED) != 0;
+    if (!(mirrored && map_file(rb, fd, size, true, flags)) && !map_file(rb, fd, size, false, flags)) {
+        close(fd);
+        free(rb);
+        return NULL;
+    }
+    apply_memory_flags(rb, flags);
+    
+    rb->magic = RING_BUFFER_MAGIC;
+    
+    init_crc32_table();
+    
+    return rb;
+}
+
+void ring_buffer_destroy(ring_buffer_t *rb) {
+    if (!rb) return;
+    
+    if (rb->mapping) {
+        /* Check if it was allocated with mmap or malloc */
+        if (rb->mapped_size > 0) {
+            munmap(rb->mapping, rb->mapped_size);
+        } else {
+            free(rb->mapping);
+        }
+    }
+    
+    if (rb->fd >= 0) {
+        close(rb->fd);
+    }
+    
+    for (int i = 0; i < RING_BUFFER_MAX_READERS; i++) {
+        free(rb->reader_wrap[i]);
+    }
+    free(rb->peek_wrap);
+    free(rb);
+}
+
+/* Note that something consumes through the shared read position, which
+ * from then on holds up writers alongside the registered readers */
+static inline void mark_shared_reads(ring_buffer_control_t *control) {
+    if (!atomic_load_explicit(&control->shared_reads, memory_order_relaxed)) {
+        atomic_store(&control->shared_reads, true);
+    }
+}
+
+/* While nothing consumes through read_pos, carry it along to the slowest
+ * registered reader. Otherwise it would pin the oldest message forever
+ * and writers could never reclaim anything the readers released. Only
+ * writers looking for space do this, so a consumer that starts late
+ * still finds everything that was never needed for new messages. */
+static void follow_readers(ring_buffer_control_t *control) {
+    if (atomic_load(&control->shared_reads)) {
+        return;
+    }
+    
+    size_t floor = SIZE_MAX;
+    for (int i = 0; i < RING_BUFFER_MAX_READERS; i++) {
+        const ring_buffer_reader_slot_t *slot = &control->readers[i];
+        if (READER_STATE(atomic_load(&slot->owner)) == READER_ACTIVE) {
+            size_t reader_pos = atomic_load(&slot->pos);
+            if (reader_pos < floor) {
+                floor = reader_pos;
+            }
+        }
+    }
+    if (floor == SIZE_MAX) {
+        return;  /* No readers left; keep what they hadn't released */
+    }
+    
+    size_t read_pos = atomic_load(&control->read_pos);
+    while (read_pos < floor &&
+           !atomic_compare_exchange_weak(&control->read_pos, &read_pos, floor)) {
+    }
+}
+
+/* Oldest position still needed: the shared read position, or an active
+ * registered reader behind it. read_pos is loaded before the slots, which
+ * ring_buffer_reader_open() relies on to start readers safely. */
+static inline size_t reclaim_pos(const ring_buffer_control_t *control) {
+    size_t pos = atomic_load(&control->read_pos);
+    if (atomic_load(&control->reader_count) == 0) {
+        return pos;
+    }
+    
+    for (int i = 0; i < RING_BUFFER_MAX_READERS; i++) {
+        const ring_buffer_reader_slot_t *slot = &control->readers[i];
+        if (READER_STATE(atomic_load(&slot->owner)) == READER_ACTIVE) {
+            size_t reader_pos = atomic_load(&slot->pos);
+            if (reader_pos < pos) {
+                pos = reader_pos;
+            }
+        }
+    }
+    return pos;
+}
+
+/* Reload the consumer cursor and share it with the other producers.
+ * The cached copies are stored with release and loaded with acquire, so
+ * a thread using another thread's refresh inherits its synchronization
+ * with the opposite side. A racing refresh can store an older value;
+ * that only makes the cache more conservative. */
+static inline size_t refresh_read_pos(ring_buffer_control_t *control) {
+    if (atomic_load(&control->reader_count) != 0) {
+        follow_readers(control);
+    }
+    size_t read_pos = reclaim_pos(control);
+    atomic_store_explicit(&control->cached_read_pos, read_pos, memory_order_release);
+    return read_pos;
+}
+
+/* Evict every evictable reader behind all the others, so writers can
+ * reclaim up to the slowest remaining consumer. Without a shared consumer
+ * or a reader that can't be evicted, that is the most advanced evictable
+ * reader. Returns whether any was evicted. */
+static bool evict_lagging_readers(ring_buffer_control_t *control) {
+    if (atomic_load(&control->reader_count) == 0) {
+        return false;
+    }
+    
+    size_t floor = atomic_load(&control->shared_reads) ? atomic_load(&control->read_pos) : SIZE_MAX;
+    size_t lead = 0;
+    for (int i = 0; i < RING_BUFFER_MAX_READERS; i++) {
+        ring_buffer_reader_slot_t *slot = &control->readers[i];
+        if (READER_STATE(atomic_load(&slot->owner)) != READER_ACTIVE) {
+            continue;
+        }
+        size_t reader_pos = atomic_load(&slot->pos);
+        if (atomic_load_explicit(&slot->flags, memory_order_relaxed) & RING_BUFFER_READER_EVICTABLE) {
+            lead = reader_pos > lead ? reader_pos : lead;
+        } else if (reader_pos < floor) {
+            floor = reader_pos;
+        }
+    }
+    if (floor == SIZE_MAX) {
+        floor = lead;
+    }
+    
+    bool evicted = false;
+    for (int i = 0; i < RING_BUFFER_MAX_READERS; i++) {
+        ring_buffer_reader_slot_t *slot = &control->readers[i];
+        uint64_t owner = atomic_load(&slot->owner);
+        if (READER_STATE(owner) == READER_ACTIVE &&
+            (atomic_load_explicit(&slot->flags, memory_order_relaxed) & RING_BUFFER_READER_EVICTABLE) &&
+            atomic_load(&slot->pos) < floor &&
+            atomic_compare_exchange_strong(&slot->owner, &owner, (owner & ~3ull) | READER_EVICTED)) {
+            atomic_fetch_sub(&control->reader_count, 1);
+            evicted = true;
+        }
+    }
+    return evicted;
+}
+
+/* Reload the commit cursor and share it with the other consumers */
+static inline size_t refresh_commit_pos(ring_buffer_control_t *control) {
+    size_t commit_pos = atomic_load(&control->commit_pos);
+    atomic_store_explicit(&control->cached_commit_pos, commit_pos, memory_order_release);
+    return commit_pos;
+}
+
+/* Park the calling thread while *word == expected, for at most timeout_ns
+ * (negative = no limit). Spurious and early returns are allowed. */
+#if defined(__linux__)
+static void futex_wait_word(atomic_uint *word, uint32_t expected, int64_t timeout_ns, bool shared) {
+    struct timespec ts;
+    struct timespec *tsp = NULL;
+    if (timeout_ns >= 0) {
+        ts.tv_sec = (time_t)(timeout_ns / 1000000000LL);
+        ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+        tsp = &ts;
+    }
+    syscall(SYS_futex, word, shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, tsp, NULL, 0);
+}
+
+static void futex_wake_word(atomic_uint *word, bool shared) {
+    syscall(SYS_futex, word, shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+#elif defined(__APPLE__)
+/* Darwin's compare-and-wait primitive, as used by libc++ and the Swift runtime */
+extern int __ulock_wait(uint32_t operation, void *addr, uint64_t value, uint32_t timeout_us);
+extern int __ulock_wake(uint32_t operation, void *addr, uint64_t wake_value);
+#define UL_COMPARE_AND_WAIT 1
+#define UL_COMPARE_AND_WAIT_SHARED 3
+#define ULF_WAKE_ALL 0x00000100
+
+static void futex_wait_word(atomic_uint *word, uint32_t expected, int64_t timeout_ns, bool shared) {
+    /* A timeout of 0 means forever; round short waits up to 1 us */
+    uint32_t timeout_us = 0;
+    if (timeout_ns >= 0) {
+        int64_t us = (timeout_ns + 999) / 1000;
+        timeout_us = us < 1 ? 1 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+    }
+    __ulock_wait(shared ? UL_COMPARE_AND_WAIT_SHARED : UL_COMPARE_AND_WAIT,
+                 word, expected, timeout_us);
+}
+
+static void futex_wake_word(atomic_uint *word, bool shared) {
+    __ulock_wake((shared ? UL_COMPARE_AND_WAIT_SHARED : UL_COMPARE_AND_WAIT) | ULF_WAKE_ALL, word, 0);
+}
+#else
+/* No wait-on-address primitive: poll with short sleeps */
+static void futex_wait_word(atomic_uint *word, uint32_t expected, int64_t timeout_ns, bool shared) {
+    (void)shared;
+    int64_t nap = timeout_ns >= 0 && timeout_ns < WAIT_POLL_NS ? timeout_ns : WAIT_POLL_NS;
+    struct timespec ts = { 0, (long)nap };
+    if (atomic_load(word) == expected) {
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void futex_wake_word(atomic_uint *word, bool shared) {
+    (void)word;
+    (void)shared;
+}
+#endif
+
+/* Wake threads parked on an event, paying for the syscall only when the
+ * waiter count says someone is asleep. The caller's cursor update must be
+ * ordered before the waiter check; waiters order theirs the other way
+ * round, so one side always sees the other. */
+static inline void notify_waiters(ring_buffer_t *rb, atomic_uint *seq, atomic_uint *waiters) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(waiters, memory_order_relaxed) != 0) {
+        atomic_fetch_add(seq, 1);
+        futex_wake_word(seq, (rb->flags & RING_BUFFER_FLAG_SHARED) != 0);
+    }
+}
+
+/* Block until ready(rb, min_bytes) holds or the timeout expires. Spins
+ * briefly first so a busy pipeline never sleeps, then parks on seq. */
+static ring_buffer_error_t wait_for(ring_buffer_t *rb, size_t min_bytes, int64_t timeout_ns,
+                                    bool (*ready)(ring_buffer_t *, size_t),
+                                    atomic_uint *seq, atomic_uint *waiters) {
+    if (ready(rb, min_bytes)) {
+        return RING_BUFFER_SUCCESS;
+    }
+    
+    if (timeout_ns == 0) {
+        return RING_BUFFER_ERROR_TIMEOUT;
+    }
+    
+    for (unsigned int spins = 0; spins < WAIT_SPIN_LIMIT; spins++) {
+        cpu_relax();
+        if (ready(rb, min_bytes)) {
+            return RING_BUFFER_SUCCESS;
+        }
+    }
+    
+    bool shared = (rb->flags & RING_BUFFER_FLAG_SHARED) != 0;
+    uint64_t deadline = timeout_ns >= 0 ? monotonic_ns() + (uint64_t)timeout_ns : 0;
+    
+    for (;;) {
+        int64_t remaining = -1;
+        if (timeout_ns >= 0) {
+            uint64_t now = monotonic_ns();
+            if (now >= deadline) {
+                return ready(rb, min_bytes) ? RING_BUFFER_SUCCESS : RING_BUFFER_ERROR_TIMEOUT;
+            }
+            remaining = (int64_t)(deadline - now);
+        }
+        
+        /* Announce ourselves before the final check, so a cursor update
+         * racing with it is guaranteed to see the waiter and wake us */
+        uint32_t expected = atomic_load(seq);
+        atomic_fetch_add(waiters, 1);
+        if (ready(rb, min_bytes)) {
+            atomic_fetch_sub(waiters, 1);
+            return RING_BUFFER_SUCCESS;
+        }
+        
+        futex_wait_word(seq, expected, remaining, shared);
+        atomic_fetch_sub(waiters, 1);
+        
+        if (ready(rb, min_bytes)) {
+            return RING_BUFFER_SUCCESS;
+        }
+    }
+}
+
+double ring_buffer_utilization(const ring_buffer_t *rb) {
+    if (!rb) return 0.0;
+    
+    size_t write_pos = atomic_load(&rb->control->write_pos);
+    size_t read_pos = reclaim_pos(rb->control);
+    
+    return (double)(write_pos - read_pos) / (double)rb->size;
+}
+
+size_t ring_buffer_capacity(const ring_buffer_t *rb) {
+    if (!rb) return 0;
+    return atomic_load_explicit(&rb->control->capacity, memory_order_relaxed);
+}
+
+size_t ring_buffer_available_write(const ring_buffer_t *rb) {
+    if (!rb) return 0;
+    
+    size_t write_pos = atomic_load(&rb->control->write_pos);
+    size_t read_pos = atomic_load_explicit(&rb->control->cached_read_pos, memory_order_acquire);
+    
+    /* Only touch the consumer line when the answer might matter */
+    if (read_pos > write_pos || rb->size - (write_pos - read_pos) < wrap_copy_size(rb->size)) {
+        read_pos = refresh_read_pos(rb->control);
+        write_pos = atomic_load(&rb->control->write_pos);
+    }
+    
+    return rb->size - (write_pos - read_pos);
+}
+
+size_t ring_buffer_available_read(const ring_buffer_t *rb) {
+    if (!rb) return 0;
+    
+    size_t commit_pos = atomic_load(&rb->control->commit_pos);
+    size_t read_pos = atomic_load(&rb->control->read_pos);
+    
+    return commit_pos - read_pos;
+}
+
+ring_buffer_error_t ring_buffer_set_watermarks(ring_buffer_t *rb, double high, double low) {
+    if (!rb || !rb->control) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    size_t high_bytes, low_bytes;
+    if (!watermarks_to_bytes(rb->size, high, low, &high_bytes, &low_bytes)) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    /* Lower the low mark first so the pair never inverts for producers */
+    atomic_store(&rb->control->low_watermark, 0);
+    atomic_store(&rb->control->high_watermark, high_bytes);
+    atomic_store(&rb->control->low_watermark, low_bytes);
+    return RING_BUFFER_SUCCESS;
+}
+
+bool ring_buffer_is_backpressure(const ring_buffer_t *rb) {
+    if (!rb) return false;
+    return atomic_load(&rb->control->backpressure);
+}
+
+void ring_buffer_get_stats(const ring_buffer_t *rb, ring_buffer_stats_t *stats) {
+    if (!rb || !stats) return;
+    
+    memset(stats, 0, sizeof(*stats));
+    
+    /* Sum the shards; each counter is exact, the snapshot as a whole is not */
+    for (int i = 0; i < RING_BUFFER_STATS_SHARDS; i++) {
+        const ring_buffer_stats_shard_t *shard = &rb->control->stats[i];
+        stats->messages_written += atomic_load_explicit(&shard->messages_written, memory_order_relaxed);
+        stats->messages_read += atomic_load_explicit(&shard->messages_read, memory_order_relaxed);
+        stats->bytes_written += atomic_load_explicit(&shard->bytes_written, memory_order_relaxed);
+        stats->bytes_read += atomic_load_explicit(&shard->bytes_read, memory_order_relaxed);
+        stats->write_errors += atomic_load_explicit(&shard->write_errors, memory_order_relaxed);
+        stats->read_errors += atomic_load_explicit(&shard->read_errors, memory_order_relaxed);
+        stats->backpressure_events += atomic_load_explicit(&shard->backpressure_events, memory_order_relaxed);
+        stats->backpressure_exits += atomic_load_explicit(&shard->backpressure_exits, memory_order_relaxed);
+        stats->messages_shed += atomic_load_explicit(&shard->messages_shed, memory_order_relaxed);
+    }
+}
+
+void ring_buffer_reset_stats(ring_buffer_t *rb) {
+    if (!rb) return;
+    
+    reset_stats(rb->control);
+}
+
+bool ring_buffer_validate(const ring_buffer_t *rb) {
+    if (!rb) return false;
+    
+    /* Check magic number */
+    if (rb->magic != RING_BUFFER_MAGIC) {
+        return false;
+    }
+    
+    /* Check buffer pointer */
+    if (!rb->buffer || rb->buffer == MAP_FAILED) {
+        return false;
+    }
+    
+    /* Check the control block, which may be shared with other processes */
+    if (!rb->control || rb->control->magic != RING_BUFFER_CONTROL_MAGIC || rb->control->size != rb->size) {
+        return false;
+    }
+    
+    /* Check size is power of 2 */
+    if (rb->size == 0 || (rb->size & (rb->size - 1)) != 0) {
+        return false;
+    }
+    
+    /* Check positions are ordered and at most one lap apart. Load in
+     * reverse order of advancement so concurrent progress cannot make
+     * a consistent buffer look inverted. */
+    size_t read_pos = atomic_load(&rb->control->read_pos);
+    size_t commit_pos = atomic_load(&rb->control->commit_pos);
+    size_t write_pos = atomic_load(&rb->control->write_pos);
+    
+    if (read_pos > commit_pos || commit_pos > write_pos || write_pos - read_pos > rb->size) {
+        return false;
+    }
+    
+    return true;
+}
+
+/* Per-call handle check on the hot paths. The layout fields
+ * ring_buffer_validate() checks are fixed once a handle is created or
+ * opened, so release builds only check the handle's magic; debug builds
+ * and the cold paths still run the full check. */
+static inline bool handle_valid(const ring_buffer_t *rb) {
+#ifdef DEBUG
+    return ring_buffer_validate(rb);
+#else
+    return rb && rb->magic == RING_BUFFER_MAGIC;
+#endif
+}
+
+const char *ring_buffer_error_string(ring_buffer_error_t error) {
+    switch (error) {
+        case RING_BUFFER_SUCCESS: return "Success";
+        case RING_BUFFER_ERROR_INVALID_PARAM: return "Invalid parameter";
+        case RING_BUFFER_ERROR_MEMORY: return "Memory allocation error";
+        case RING_BUFFER_ERROR_FULL: return "Buffer full";
+        case RING_BUFFER_ERROR_EMPTY: return "Buffer empty";
+        case RING_BUFFER_ERROR_TOO_LARGE: return "Message too large";
+        case RING_BUFFER_ERROR_CORRUPTED: return "Buffer corrupted";
+        case RING_BUFFER_ERROR_BACKPRESSURE: return "Backpressure active";
+        case RING_BUFFER_ERROR_TIMEOUT: return "Timed out";
+        case RING_BUFFER_ERROR_UNSUPPORTED: return "Codec not supported by this build";
+        case RING_BUFFER_ERROR_EVICTED: return "Reader evicted";
+        case RING_BUFFER_ERROR_IO: return "I/O error";
+        default: return "Unknown error";
+    }
+}
+
+/* Backpressure state after observing used bytes: entered at the high
+ * watermark and only left again at the low watermark */
+static inline bool backpressure_after(const ring_buffer_control_t *control, bool active, size_t used) {
+    if (active) {
+        return used > atomic_load_explicit(&control->low_watermark, memory_order_relaxed);
+    }
+    return used >= atomic_load_explicit(&control->high_watermark, memory_order_relaxed);
+}
+
+/* Whether a message of the given priority is turned away */
+static inline bool should_shed(const ring_buffer_control_t *control, ring_buffer_priority_t priority,
+                               bool active, size_t used) {
+    switch (priority) {
+        case RING_BUFFER_PRIORITY_HIGH:
+            return false;
+        case RING_BUFFER_PRIORITY_LOW:
+            return active || used >= atomic_load_explicit(&control->low_watermark, memory_order_relaxed);
+        default:
+            return active;
+    }
+}
+
+/* Move the backpressure state; only the thread that flips it counts the transition */
+static void set_backpressure(ring_buffer_t *rb, bool active, size_t used) {
+    ring_buffer_control_t *control = rb->control;
+    bool expected = !active;
+    if (atomic_compare_exchange_strong(&control->backpressure, &expected, active)) {
+        if (active) {
+            STAT_ADD(rb, backpressure_events, 1);
+            PROBE_BACKPRESSURE_ENTER(rb, used, atomic_load_explicit(&control->high_watermark, memory_order_relaxed));
+        } else {
+            STAT_ADD(rb, backpressure_exits, 1);
+            PROBE_BACKPRESSURE_EXIT(rb, used, atomic_load_explicit(&control->low_watermark, memory_order_relaxed));
+        }
+    }
+}
+
+/* Bytes writers may have in use: the size, or the capacity of an elastic
+ * buffer plus whatever a running trim has fenced off */
+static inline size_t admission_limit(const ring_buffer_t *rb) {
+    if (!(rb->flags & RING_BUFFER_FLAG_ELASTIC)) {
+        return rb->size;
+    }
+    
+    size_t limit = atomic_load_explicit(&rb->control->capacity, memory_order_relaxed) +
+                   atomic_load_explicit(&rb->control->trim_skip, memory_order_acquire);
+    return limit < rb->size ? limit : rb->size;
+}
+
+/* Double an elastic buffer's capacity until needed bytes fit, up to the
+ * size. Returns true if the capacity went up, here or in another thread. */
+static bool grow_capacity(ring_buffer_t *rb, size_t needed) {
+    if (!(rb->flags & RING_BUFFER_FLAG_ELASTIC)) {
+        return false;
+    }
+    
+    size_t capacity = atomic_load(&rb->control->capacity);
+    size_t grown = capacity;
+    while (grown < needed && grown < rb->size) {
+        grown *= 2;
+    }
+    if (grown > rb->size) {
+        grown = rb->size;
+    }
+    if (grown == capacity) {
+        return false;
+    }
+    
+    atomic_compare_exchange_strong(&rb->control->capacity, &capacity, grown);
+    return true;
+}
+
+/* Write a message header at position */
+static inline void write_header(ring_buffer_t *rb, size_t pos, uint32_t magic, size_t length,
+                                uint64_t timestamp, uint32_t checksum, uint32_t reserved) {
+    arrow_ipc_header_t header = {
+        .magic = magic,
+        .length = (uint32_t)length,
+        .timestamp = timestamp,
+        .checksum = checksum,
+        .reserved = reserved
+    };
+    
+    ring_copy_in(rb, pos, &header, sizeof(arrow_ipc_header_t));
+}
+
+/* Cover [pos, pos + bytes) with padding records, none longer than a
+ * message may be and none too short for its header */
+static void write_padding(ring_buffer_t *rb, size_t pos, size_t bytes) {
+    size_t chunk = total_message_size(RING_BUFFER_MAX_MESSAGE_SIZE - sizeof(arrow_ipc_header_t));
+    while (bytes > 0) {
+        size_t len = bytes < chunk ? bytes : chunk;
+        if (bytes - len != 0 && bytes - len < sizeof(arrow_ipc_header_t)) {
+            len -= sizeof(arrow_ipc_header_t);
+        }
+        write_header(rb, pos, RING_BUFFER_PADDING_MAGIC, len - sizeof(arrow_ipc_header_t), 0, 0, 0);
+        pos += len;
+        bytes -= len;
+    }
+}
+
+/* Reserve msg_bytes of buffer space after the admission checks shared by
+ * all write paths. On success *start_pos is the first reserved position. */
+static ring_buffer_error_t reserve_bytes(ring_buffer_t *rb, size_t msg_bytes,
+                                         ring_buffer_priority_t priority, size_t *start_pos) {
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    
+    ring_buffer_control_t *control = rb->control;
+    
+    /* Reserve space atomically */
+    size_t write_pos = atomic_load(&control->write_pos);
+    size_t read_pos = atomic_load_explicit(&control->cached_read_pos, memory_order_acquire);
+    bool refreshed = false;
+    bool evicted = false;
+    
+    /* Try to reserve space with CAS loop */
+    for (;;) {
+        /* A stale write position may trail the reader; refresh it */
+        if (read_pos > write_pos) {
+            write_pos = atomic_load(&control->write_pos);
+            if (read_pos > write_pos) {
+                read_pos = refresh_read_pos(control);
+            }
+            continue;
+        }
+        
+        size_t used = write_pos - read_pos;
+        bool active = atomic_load_explicit(&control->backpressure, memory_order_relaxed);
+        bool next = backpressure_after(control, active, used);
+        bool shed = should_shed(control, priority, next, used);
+        bool full = used + msg_bytes > admission_limit(rb);
+        
+        /* The cached read position may be behind; check the real one
+         * before entering backpressure, shedding or reporting a full buffer */
+        if (((next && !active) || shed || full) && !refreshed) {
+            read_pos = refresh_read_pos(control);
+            refreshed = true;
+            continue;
+        }
+        
+        /* An elastic buffer grows rather than refuse the write */
+        if (full && grow_capacity(rb, used + msg_bytes)) {
+            continue;
+        }
+        
+        /* Then cut loose evictable readers that are all that holds us up */
+        if (((next && !active) || shed || full) && !evicted) {
+            evicted = true;
+            if (evict_lagging_readers(control)) {
+                read_pos = refresh_read_pos(control);
+                continue;
+            }
+        }
+        
+        /* The flag is only written on a transition, never per call */
+        if (next != active) {
+            set_backpressure(rb, next, used);
+        }
+        
+        /* Check backpressure */
+        if (shed) {
+            STAT_ADD(rb, messages_shed, 1);
+            return RING_BUFFER_ERROR_BACKPRESSURE;
+        }
+        
+        /* Check if message fits */
+        if (full) {
+            STAT_ADD(rb, write_errors, 1);
+            return RING_BUFFER_ERROR_FULL;
+        }
+        
+        /* The only producer has nobody to race for the space */
+        if (rb->flags & RING_BUFFER_FLAG_SINGLE_PRODUCER) {
+            atomic_store_explicit(&control->write_pos, write_pos + msg_bytes, memory_order_release);
+            break;
+        }
+        if (atomic_compare_exchange_weak(&control->write_pos, &write_pos, write_pos + msg_bytes)) {
+            break;
+        }
+    }
+    
+    /* Label the reservation, so ring_buffer_recover() can step over it
+     * if we die before committing */
+    write_header(rb, write_pos, RING_BUFFER_PENDING_MAGIC, msg_bytes - sizeof(arrow_ipc_header_t), 0, 0, 0);
+    
+    PROBE_RESERVE(rb, write_pos, msg_bytes);
+    *start_pos = write_pos;
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Make [start_pos, end_pos) visible to readers.
+ * 
+ * Producers commit in reservation order: commit_pos is only handed from
+ * one reservation to the next, so a fast writer can never publish past a
+ * slower writer whose region is still being filled. The release store
+ * orders the header and payload writes before the new commit position. */
+static void publish_range(ring_buffer_t *rb, size_t start_pos, size_t end_pos) {
+    uint64_t wait_start = PROBE_ENABLED(commit) ? monotonic_ns() : 0;
+    
+    /* Wait for earlier reservations to be published */
+    unsigned int spins = 0;
+    while (atomic_load_explicit(&rb->control->commit_pos, memory_order_acquire) != start_pos) {
+        if (++spins < COMMIT_SPIN_LIMIT) {
+            cpu_relax();
+        } else {
+            sched_yield();
+        }
+    }
+    
+    /* Commit the write atomically */
+    atomic_store_explicit(&rb->control->commit_pos, end_pos, memory_order_release);
+    if (wait_start != 0) {
+        PROBE_COMMIT(rb, start_pos, end_pos - start_pos, monotonic_ns() - wait_start);
+    }
+    
+    notify_waiters(rb, &rb->control->readable_seq, &rb->control->readable_waiters);
+}
+
+
+/* Index the message at [start_pos, end_pos) if it holds the first byte of
+ * an interval. Entries are seqlocked through their bucket field, and a
+ * seek checks the position it finds, so a lost race only means a longer
+ * scan. Costs a shift and a compare for all but one message per interval. */
+static inline void index_message(ring_buffer_t *rb, size_t start_pos, size_t end_pos, uint64_t timestamp) {
+    ring_buffer_control_t *control = rb->control;
+    unsigned int shift = control->index_shift;
+    uint64_t bucket = (uint64_t)(end_pos - 1) >> shift;
+    if ((size_t)(bucket << shift) < start_pos) {
+        return;
+    }
+    
+    ring_buffer_index_entry_t *entry = &control->time_index[bucket & (RING_BUFFER_INDEX_ENTRIES - 1)];
+    atomic_store_explicit(&entry->bucket, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&entry->pos, start_pos, memory_order_relaxed);
+    atomic_store_explicit(&entry->timestamp, timestamp, memory_order_relaxed);
+    atomic_store_explicit(&entry->bucket, bucket + 1, memory_order_release);
+}
+
+ring_buffer_error_t ring_buffer_reserve(ring_buffer_t *rb, size_t size, ring_buffer_span_t *span) {
+    return ring_buffer_reserve_priority(rb, size, RING_BUFFER_PRIORITY_NORMAL, span);
+}
+
+ring_buffer_error_t ring_buffer_reserve_priority(ring_buffer_t *rb, size_t size,
+                                                 ring_buffer_priority_t priority,
+                                                 ring_buffer_span_t *span) {
+    if (!rb || !span || size == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    if (size > RING_BUFFER_MAX_MESSAGE_SIZE) {
+        STAT_ADD(rb, write_errors, 1);
+        return RING_BUFFER_ERROR_TOO_LARGE;
+    }
+    
+    size_t msg_size = total_message_size(size);
+    size_t write_pos;
+    
+    ring_buffer_error_t result = reserve_bytes(rb, msg_size, priority, &write_pos);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+    
+    /* Describe the payload region, split at the end of the buffer if needed */
+    uint8_t *buffer = (uint8_t *)rb->buffer;
+    size_t data_start = ring_offset(rb, write_pos + sizeof(arrow_ipc_header_t));
+    size_t first_part = rb->linear_size - data_start;
+    
+    span->segments[0].data = buffer + data_start;
+    if (size <= first_part) {
+        span->segments[0].size = size;
+        span->segments[1].data = NULL;
+        span->segments[1].size = 0;
+    } else {
+        span->segments[0].size = first_part;
+        span->segments[1].data = buffer;
+        span->segments[1].size = size - first_part;
+    }
+    
+    span->length = size;
+    span->timestamp = 0;
+    span->start_pos = write_pos;
+    span->end_pos = write_pos + msg_size;
+    
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Checksum the reserved payload and publish it; format holds the header's
+ * reserved bits other than the checksum algorithm, such as the codec */
+static ring_buffer_error_t commit_span(ring_buffer_t *rb, ring_buffer_span_t *span, uint32_t format) {
+    if (!rb || !span || span->length == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    ring_buffer_checksum_t algorithm = RING_BUFFER_WRITE_CHECKSUM;
+    uint32_t crc = checksum_update(algorithm, 0xFFFFFFFF, span->segments[0].data, span->segments[0].size);
+    if (span->segments[1].size > 0) {
+        crc = checksum_update(algorithm, crc, span->segments[1].data, span->segments[1].size);
+    }
+    
+    uint32_t reserved = RING_BUFFER_HEADER_SET_CHECKSUM(format, algorithm);
+    uint64_t timestamp = span->timestamp != 0 ? span->timestamp : handle_now(rb);
+    write_header(rb, span->start_pos, ARROW_IPC_MAGIC, span->length, timestamp,
+                 crc ^ 0xFFFFFFFF, reserved);
+    index_message(rb, span->start_pos, span->end_pos, timestamp);
+    publish_range(rb, span->start_pos, span->end_pos);
+    
+    /* Update statistics */
+    STAT_ADD(rb, messages_written, 1);
+    STAT_ADD(rb, bytes_written, span->length);
+    
+    span->length = 0;
+    return RING_BUFFER_SUCCESS;
+}
+
+ring_buffer_error_t ring_buffer_commit(ring_buffer_t *rb, ring_buffer_span_t *span) {
+    return commit_span(rb, span, 0);
+}
+
+ring_buffer_error_t ring_buffer_abort(ring_buffer_t *rb, ring_buffer_span_t *span) {
+    if (!rb || !span || span->length == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    write_header(rb, span->start_pos, RING_BUFFER_PADDING_MAGIC, span->length, 0, 0, 0);
+    publish_range(rb, span->start_pos, span->end_pos);
+    
+    span->length = 0;
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Give the whole pages inside buffer offsets [start, end) back to the OS.
+ * Shared mappings punch a hole in the backing file where the platform
+ * can, which frees the memory for every process and both mirror views;
+ * otherwise the pages are dropped from this process's views. */
+static void release_pages(ring_buffer_t *rb, size_t start, size_t end) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    start = (start + page_size - 1) & ~(page_size - 1);
+    end &= ~(page_size - 1);
+    if (end <= start) {
+        return;
+    }
+    
+    uint8_t *pages = (uint8_t *)rb->buffer + start;
+#if defined(MADV_REMOVE)
+    if (rb->fd >= 0 && madvise(pages, end - start, MADV_REMOVE) == 0) {
+        return;
+    }
+#elif defined(F_PUNCHHOLE)
+    fpunchhole_t hole = {
+        .fp_offset = (off_t)(RING_BUFFER_CONTROL_SIZE + start),
+        .fp_length = (off_t)(end - start)
+    };
+    if (rb->fd >= 0 && fcntl(rb->fd, F_PUNCHHOLE, &hole) == 0) {
+        return;
+    }
+#endif
+    madvise(pages, end - start, MADV_DONTNEED);
+    if (rb->flags & RING_BUFFER_FLAG_MIRRORED) {
+        madvise(pages + rb->size, end - start, MADV_DONTNEED);
+    }
+}
+
+ring_buffer_error_t ring_buffer_trim(ring_buffer_t *rb) {
+    if (!rb) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    if (!(rb->flags & RING_BUFFER_FLAG_ELASTIC)) {
+        return RING_BUFFER_ERROR_UNSUPPORTED;
+    }
+    
+    ring_buffer_control_t *control = rb->control;
+    bool idle = false;
+    if (!atomic_compare_exchange_strong(&control->trimming, &idle, true)) {
+        return RING_BUFFER_SUCCESS;  /* Another trim is under way */
+    }
+    
+    /* Halve the capacity while the backlog would fit in a quarter of it */
+    size_t reclaim = reclaim_pos(control);
+    size_t used = atomic_load(&control->write_pos) - reclaim;
+    size_t capacity = atomic_load(&control->capacity);
+    size_t shrunk = capacity;
+    while (shrunk > control->initial_capacity && used <= shrunk / 4) {
+        shrunk = shrunk / 2 > control->initial_capacity ? shrunk / 2 : (size_t)control->initial_capacity;
+    }
+    if (shrunk < capacity && atomic_compare_exchange_strong(&control->capacity, &capacity, shrunk)) {
+        capacity = shrunk;
+    }
+    
+    /* Release everything outside the capacity, but only when nothing is
+     * unread or in flight and no registered reader holds a position. The
+     * fence needs a CAS on the write position, which a single producer's
+     * plain store would overwrite, so such buffers keep their pages. */
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t fence = (rb->size - capacity) & ~(page_size - 1);
+    size_t pos = atomic_load(&control->read_pos);
+    if (rb->mapped_size == 0 || fence == 0 || (rb->flags & RING_BUFFER_FLAG_SINGLE_PRODUCER) ||
+        atomic_load(&control->reader_count) != 0 ||
+        atomic_load(&control->commit_pos) != pos) {
+        atomic_store(&control->trimming, false);
+        return RING_BUFFER_SUCCESS;
+    }
+    
+    /* Reserve [pos, pos + fence) for ourselves. Until it is consumed, the
+     * read position holds writers to the capacity's worth of positions
+     * after it, whose offsets are those just behind pos. */
+    atomic_store(&control->trim_skip, fence);
+    size_t expected = pos;
+    if (atomic_compare_exchange_strong(&control->write_pos, &expected, pos + fence)) {
+        size_t offset = ring_offset(rb, pos);
+        size_t first = rb->size - offset < fence ? rb->size - offset : fence;
+        release_pages(rb, offset, offset + first);
+        release_pages(rb, 0, fence - first);
+        
+        /* Fence it off with padding records readers step over */
+        write_padding(rb, pos, fence);
+        publish_range(rb, pos, pos + fence);
+        
+        /* Consume the padding unless a reader already stepped over it */
+        expected = pos;
+        atomic_compare_exchange_strong(&control->read_pos, &expected, pos + fence);
+        refresh_read_pos(control);
+        notify_waiters(rb, &control->writable_seq, &control->writable_waiters);
+    }
+    atomic_store(&control->trim_skip, 0);
+    
+    atomic_store(&control->trimming, false);
+    return RING_BUFFER_SUCCESS;
+}
+
+ring_buffer_error_t ring_buffer_span_copy(ring_buffer_span_t *span, size_t offset,
+                                          const void *data, size_t size) {
+    if (!span || !data || offset + size > span->length) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    const uint8_t *src = (const uint8_t *)data;
+    size_t first_size = span->segments[0].size;
+    
+    if (offset < first_size) {
+        size_t n = first_size - offset < size ? first_size - offset : size;
+        memcpy((uint8_t *)span->segments[0].data + offset, src, n);
+        src += n;
+        size -= n;
+        offset = 0;
+    } else {
+        offset -= first_size;
+    }
+    
+    if (size > 0) {
+        memcpy((uint8_t *)span->segments[1].data + offset, src, size);
+    }
+    
+    return RING_BUFFER_SUCCESS;
+}
+
+ring_buffer_error_t ring_buffer_write(ring_buffer_t *rb, const void *data, size_t size) {
+    return ring_buffer_write_priority(rb, data, size, RING_BUFFER_PRIORITY_NORMAL);
+}
+
+ring_buffer_error_t ring_buffer_write_priority(ring_buffer_t *rb, const void *data, size_t size,
+                                               ring_buffer_priority_t priority) {
+    if (!rb || !data || size == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    ring_buffer_span_t span;
+    ring_buffer_error_t result = ring_buffer_reserve_priority(rb, size, priority, &span);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+    
+    ring_buffer_span_copy(&span, 0, data, size);
+    
+    return ring_buffer_commit(rb, &span);
+}
+
+ring_buffer_error_t ring_buffer_write_compressed(ring_buffer_t *rb, const void *data, size_t size,
+                                                 ring_buffer_codec_t codec,
+                                                 ring_buffer_priority_t priority) {
+    if (!rb || !data || size == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    if (codec == RING_BUFFER_CODEC_NONE) {
+        return ring_buffer_write_priority(rb, data, size, priority);
+    }
+    if (!ring_buffer_codec_supported(codec)) {
+        return RING_BUFFER_ERROR_UNSUPPORTED;
+    }
+    
+    /* Same limit as uncompressed writes, so a reader arena of the maximum
+     * message size always fits the decompressed payload */
+    if (size > RING_BUFFER_MAX_MESSAGE_SIZE) {
+        STAT_ADD(rb, write_errors, 1);
+        return RING_BUFFER_ERROR_TOO_LARGE;
+    }
+    
+    /* Compress off-ring first: a reservation can't shrink once made */
+    uint8_t *scratch = codec_scratch_reserve(codec_compress_bound(codec, size));
+    if (!scratch) {
+        STAT_ADD(rb, write_errors, 1);
+        return RING_BUFFER_ERROR_MEMORY;
+    }
+    
+    /* Only worth it if the prefix and compressed bytes are smaller */
+    size_t capacity = size > RING_BUFFER_CODEC_PREFIX_SIZE ? size - RING_BUFFER_CODEC_PREFIX_SIZE - 1 : 0;
+    size_t compressed = capacity > 0 ? codec_compress(codec, data, size, scratch, capacity) : 0;
+    if (compressed == 0) {
+        return ring_buffer_write_priority(rb, data, size, priority);
+    }
+    
+    ring_buffer_span_t span;
+    ring_buffer_error_t result = ring_buffer_reserve_priority(rb, RING_BUFFER_CODEC_PREFIX_SIZE + compressed,
+                                                              priority, &span);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+    
+    uint8_t prefix[RING_BUFFER_CODEC_PREFIX_SIZE] = {
+        (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24)
+    };
+    ring_buffer_span_copy(&span, 0, prefix, sizeof(prefix));
+    ring_buffer_span_copy(&span, sizeof(prefix), scratch, compressed);
+    
+    return commit_span(rb, &span, RING_BUFFER_HEADER_SET_CODEC(0, codec));
+}
+
+ring_buffer_error_t ring_buffer_write_batch(ring_buffer_t *rb, const struct iovec *iov, size_t count) {
+    if (!rb || !iov || count == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    /* Size the whole batch up front so it can be reserved in one step */
+    size_t total_size = 0;
+    uint64_t total_bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!iov[i].iov_base || iov[i].iov_len == 0) {
+            return RING_BUFFER_ERROR_INVALID_PARAM;
+        }
+        if (iov[i].iov_len > RING_BUFFER_MAX_MESSAGE_SIZE) {
+            STAT_ADD(rb, write_errors, 1);
+            return RING_BUFFER_ERROR_TOO_LARGE;
+        }
+        total_size += total_message_size(iov[i].iov_len);
+        total_bytes += iov[i].iov_len;
+    }
+    
+    size_t start_pos;
+    ring_buffer_error_t result = reserve_bytes(rb, total_size, RING_BUFFER_PRIORITY_NORMAL, &start_pos);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+    
+    /* One timestamp for the whole batch */
+    ring_buffer_checksum_t algorithm = RING_BUFFER_WRITE_CHECKSUM;
+    uint64_t timestamp = handle_now(rb);
+    size_t pos = start_pos;
+    
+    for (size_t i = 0; i < count; i++) {
+        uint32_t crc = checksum_update(algorithm, 0xFFFFFFFF, iov[i].iov_base, iov[i].iov_len);
+        
+        ring_copy_in(rb, pos + sizeof(arrow_ipc_header_t), iov[i].iov_base, iov[i].iov_len);
+        write_header(rb, pos, ARROW_IPC_MAGIC, iov[i].iov_len, timestamp,
+                     crc ^ 0xFFFFFFFF, RING_BUFFER_HEADER_SET_CHECKSUM(0, algorithm));
+        index_message(rb, pos, pos + total_message_size(iov[i].iov_len), timestamp);
+        pos += total_message_size(iov[i].iov_len);
+    }
+    
+    publish_range(rb, start_pos, pos);
+    
+    /* Update statistics */
+    STAT_ADD(rb, messages_written, count);
+    STAT_ADD(rb, bytes_written, total_bytes);
+    
+    return RING_BUFFER_SUCCESS;
+}
+
+/* LEB128 varint helpers for the slab record framing */
+static inline size_t varint_size(uint64_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static inline uint8_t *varint_put(uint8_t *out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+/* Returns the byte after the varint, or NULL if it runs past end or 64 bits */
+static inline const uint8_t *varint_get(const uint8_t *in, const uint8_t *end, uint64_t *value) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64 && in < end; shift += 7) {
+        uint8_t byte = *in++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return in;
+        }
+    }
+    return NULL;
+}
+
+/* Timestamps can go backwards between producers' clocks, so deltas are signed */
+static inline uint64_t zigzag_encode(uint64_t delta) {
+    return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+}
+
+static inline uint64_t zigzag_decode(uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+void ring_buffer_slab_init(ring_buffer_slab_t *slab, ring_buffer_priority_t priority) {
+    if (!slab) {
+        return;
+    }
+    
+    slab->priority = priority;
+    slab->count = 0;
+    slab->length = 0;
+    slab->first_timestamp = 0;
+    slab->last_timestamp = 0;
+}
+
+ring_buffer_error_t ring_buffer_slab_append(ring_buffer_t *rb, ring_buffer_slab_t *slab,
+                                            const void *data, size_t size, uint64_t timestamp) {
+    if (!rb || !slab || !data || size == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    if (size > RING_BUFFER_SLAB_CAPACITY - RING_BUFFER_SLAB_RECORD_OVERHEAD) {
+        return RING_BUFFER_ERROR_TOO_LARGE;
+    }
+    if (timestamp == 0) {
+        timestamp = handle_now(rb);
+    }
+    
+    uint64_t delta = zigzag_encode(timestamp - (slab->count > 0 ? slab->last_timestamp : timestamp));
+    size_t record_size = varint_size(delta) + varint_size(size) + size;
+    if (slab->length + record_size > RING_BUFFER_SLAB_CAPACITY) {
+        ring_buffer_error_t result = ring_buffer_slab_flush(rb, slab);
+        if (result != RING_BUFFER_SUCCESS) {
+            return result;
+        }
+        delta = zigzag_encode(0);
+    }
+    
+    if (slab->count == 0) {
+        slab->first_timestamp = timestamp;
+    }
+    uint8_t *out = varint_put(slab->data + slab->length, delta);
+    out = varint_put(out, size);
+    memcpy(out, data, size);
+    
+    slab->length = (size_t)(out + size - slab->data);
+    slab->last_timestamp = timestamp;
+    slab->count++;
+    return RING_BUFFER_SUCCESS;
+}
+
+ring_buffer_error_t ring_buffer_slab_flush(ring_buffer_t *rb, ring_buffer_slab_t *slab) {
+    if (!rb || !slab) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    if (slab->count == 0) {
+        return RING_BUFFER_SUCCESS;
+    }
+    
+    ring_buffer_span_t span;
+    ring_buffer_error_t result = ring_buffer_reserve_priority(rb, slab->length, slab->priority, &span);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+    
+    ring_buffer_span_copy(&span, 0, slab->data, slab->length);
+    span.timestamp = slab->first_timestamp;
+    result = commit_span(rb, &span, RING_BUFFER_HEADER_SLAB);
+    if (result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+    
+    slab->count = 0;
+    slab->length = 0;
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Checksum of [pos, pos + n), which may wrap */
+static uint32_t ring_checksum(const ring_buffer_t *rb, ring_buffer_checksum_t algorithm, size_t pos, size_t n) {
+    const uint8_t *buffer = (const uint8_t *)rb->buffer;
+    pos = ring_offset(rb, pos);
+    size_t first_part = rb->linear_size - pos < n ? rb->linear_size - pos : n;
+    
+    uint32_t crc = checksum_update(algorithm, 0xFFFFFFFF, buffer + pos, first_part);
+    crc = checksum_update(algorithm, crc, buffer, n - first_part);
+    return crc ^ 0xFFFFFFFF;
+}
+
+/* Collect up to max committed messages from [read_pos, commit_pos) without
+ * consuming them, stepping over padding records. *end_pos receives the
+ * position after the last record examined and *bytes the payload total.
+ * A message that wraps is viewed through wrap (see ring_view()); with
+ * wrap NULL its data is left NULL and its position stored in *wrapped,
+ * for copy_wrapped(). Scanning never writes to the buffer.
+ * Returns the number of messages collected, or an error if the first
+ * record is invalid. A bad record after valid ones ends the scan early. */
+static int scan_messages(ring_buffer_t *rb, size_t read_pos, size_t commit_pos,
+                         ring_buffer_message_t *msgs, size_t max,
+                         size_t *end_pos, uint64_t *bytes,
+                         uint8_t *wrap, size_t *wrapped) {
+    size_t pos = read_pos;
+    size_t count = 0;
+    *bytes = 0;
+    
+    while (count < max && commit_pos - pos >= sizeof(arrow_ipc_header_t)) {
+        /* Read message header */
+        arrow_ipc_header_t header;
+        ring_copy_out(rb, pos, &header, sizeof(arrow_ipc_header_t));
+        
+        /* Validate header */
+        if ((header.magic != ARROW_IPC_MAGIC && header.magic != RING_BUFFER_PADDING_MAGIC) ||
+            header.length > RING_BUFFER_MAX_MESSAGE_SIZE) {
+            break;
+        }
+        
+        size_t msg_size = total_message_size(header.length);
+        
+        /* Check if complete message is available */
+        if (commit_pos - pos < msg_size) {
+            break;
+        }
+        
+        /* Skip records left behind by aborted reservations */
+        if (header.magic == RING_BUFFER_PADDING_MAGIC) {
+            pos += msg_size;
+            continue;
+        }
+        
+        /* Validate checksum with the algorithm recorded by the writer,
+         * unless this handle trusts its producers */
+        if (!(rb->flags & RING_BUFFER_FLAG_TRUSTED)) {
+            ring_buffer_checksum_t algorithm = RING_BUFFER_HEADER_CHECKSUM(header.reserved);
+            if (algorithm > RING_BUFFER_CHECKSUM_CRC32C ||
+                ring_checksum(rb, algorithm, pos + sizeof(arrow_ipc_header_t), header.length) != header.checksum) {
+                PROBE_CRC_FAILURE(rb, pos, header.length, header.checksum);
+                break;
+            }
+        }
+        
+        /* Wrapped messages are made contiguous, so we can return a direct pointer */
+        const uint8_t *view = ring_view(rb, pos, msg_size, wrap);
+        if (!view) {
+            *wrapped = pos;
+        }
+        
+        msgs[count].header = header;
+        msgs[count].data = view ? view + sizeof(arrow_ipc_header_t) : NULL;
+        msgs[count].data_size = header.length;
+        *bytes += header.length;
+        count++;
+        pos += msg_size;
+    }
+    
+    *end_pos = pos;
+    
+    /* Anything left unexamined in front of us means a corrupt record */
+    if (count == 0 && pos == read_pos && commit_pos - pos > 0) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    return (int)count;
+}
+
+/* Give the message scan_messages() left without a view at pos a copy in
+ * this thread's scratch. Consumers sharing a handle each get their own,
+ * which stays valid until the thread's next read or peek. */
+static bool copy_wrapped(ring_buffer_t *rb, ring_buffer_message_t *msgs, int count, size_t pos) {
+    for (int i = 0; i < count; i++) {
+        if (!msgs[i].data) {
+            size_t n = total_message_size(msgs[i].data_size);
+            uint8_t *scratch = wrap_scratch_reserve(n);
+            if (!scratch) {
+                return false;
+            }
+            msgs[i].data = ring_view(rb, pos, n, scratch) + sizeof(arrow_ipc_header_t);
+        }
+    }
+    return true;
+}
+
+/* Claim up to max messages for this consumer; shared by the read paths */
+static int consume_messages(ring_buffer_t *rb, ring_buffer_message_t *msgs, size_t max) {
+    mark_shared_reads(rb->control);
+    for (;;) {
+        size_t read_pos = atomic_load(&rb->control->read_pos);
+        size_t commit_pos = atomic_load_explicit(&rb->control->cached_commit_pos, memory_order_acquire);
+        size_t end_pos;
+        size_t wrapped = SIZE_MAX;
+        
+        /* Single reads use the cached commit position until it runs dry;
+         * batches want everything published and amortize the reload */
+        if (max > 1 || commit_pos <= read_pos) {
+            commit_pos = refresh_commit_pos(rb->control);
+        }
+        uint64_t bytes;
+        
+        int count = scan_messages(rb, read_pos, commit_pos, msgs, max, &end_pos, &bytes, NULL, &wrapped);
+        if (count < 0) {
+            /* Another consumer may have claimed and recycled this slot */
+            if (atomic_load(&rb->control->read_pos) != read_pos) {
+                continue;
+            }
+            STAT_ADD(rb, read_errors, 1);
+            return count;
+        }
+        
+        if (end_pos == read_pos) {
+            return 0;
+        }
+        
+        /* Copy a wrapped message out while the range is still unclaimed:
+         * writers can't reuse it before the claim, but may right after */
+        if (wrapped != SIZE_MAX && !copy_wrapped(rb, msgs, count, wrapped)) {
+            return RING_BUFFER_ERROR_MEMORY;
+        }
+        
+        /* Claim the messages; retry if another consumer got there first.
+         * The only consumer can just move on: a trim only ever advances
+         * the read position to the end of padding this scan stepped over. */
+        if (rb->flags & RING_BUFFER_FLAG_SINGLE_CONSUMER) {
+            atomic_store_explicit(&rb->control->read_pos, end_pos, memory_order_release);
+        } else if (!atomic_compare_exchange_strong(&rb->control->read_pos, &read_pos, end_pos)) {
+            continue;
+        }
+        
+        notify_waiters(rb, &rb->control->writable_seq, &rb->control->writable_waiters);
+        
+        /* Only padding was consumed; look again */
+        if (count == 0) {
+            continue;
+        }
+        
+        /* Update statistics */
+        STAT_ADD(rb, messages_read, (uint64_t)count);
+        STAT_ADD(rb, bytes_read, bytes);
+        
+        if (PROBE_ENABLED(read)) {
+            uint64_t now = handle_now(rb);
+            uint64_t stamped = msgs[0].header.timestamp;
+            PROBE_READ(rb, read_pos, bytes, count, now > stamped ? now - stamped : 0);
+        }
+        
+        return count;
+    }
+}
+
+ring_buffer_error_t ring_buffer_read(ring_buffer_t *rb, ring_buffer_message_t *msg) {
+    if (!rb || !msg) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    
+    int count = consume_messages(rb, msg, 1);
+    if (count < 0) {
+        return (ring_buffer_error_t)count;
+    }
+    
+    return count == 0 ? RING_BUFFER_ERROR_EMPTY : RING_BUFFER_SUCCESS;
+}
+
+ring_buffer_error_t ring_buffer_peek(ring_buffer_t *rb, ring_buffer_message_t *msg) {
+    if (!rb || !msg) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    
+    mark_shared_reads(rb->control);
+    for (;;) {
+        size_t read_pos = atomic_load(&rb->control->read_pos);
+        size_t commit_pos = refresh_commit_pos(rb->control);
+        size_t end_pos;
+        size_t wrapped = SIZE_MAX;
+        uint64_t bytes;
+        
+        int count = scan_messages(rb, read_pos, commit_pos, msg, 1, &end_pos, &bytes, NULL, &wrapped);
+        if (count < 0) {
+            return (ring_buffer_error_t)count;
+        }
+        if (wrapped == SIZE_MAX) {
+            return count == 0 ? RING_BUFFER_ERROR_EMPTY : RING_BUFFER_SUCCESS;
+        }
+        
+        if (!copy_wrapped(rb, msg, count, wrapped)) {
+            return RING_BUFFER_ERROR_MEMORY;
+        }
+        
+        /* Peeking claims nothing: if a consumer took the message while it
+         * was copied, writers may have torn the copy */
+        if (atomic_load(&rb->control->read_pos) == read_pos) {
+            return RING_BUFFER_SUCCESS;
+        }
+    }
+}
+
+int ring_buffer_peek_batch(ring_buffer_t *rb, ring_buffer_cursor_t *cursor,
+                           ring_buffer_message_t *msgs, size_t max) {
+    if (!rb || !cursor || !msgs || max == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    
+    /* Someone else consumed what we looked at: start over from them */
+    mark_shared_reads(rb->control);
+    size_t read_pos = atomic_load(&rb->control->read_pos);
+    if (cursor->pos < read_pos) {
+        cursor->pos = read_pos;
+        cursor->messages = 0;
+        cursor->bytes = 0;
+    }
+    
+    /* Borrowed messages stay put until released, so at most one of them
+     * wraps and the handle's own copy target outlives every batch */
+    if (!reserve_wrap(rb, &rb->peek_wrap)) {
+        return RING_BUFFER_ERROR_MEMORY;
+    }
+    
+    size_t commit_pos = refresh_commit_pos(rb->control);
+    size_t end_pos;
+    uint64_t bytes;
+    
+    int count = scan_messages(rb, cursor->pos, commit_pos, msgs, max, &end_pos, &bytes, rb->peek_wrap, NULL);
+    if (count < 0) {
+        STAT_ADD(rb, read_errors, 1);
+        return count;
     }
-    crc32_table_initialized = true;
+    
+    cursor->pos = end_pos;
+    cursor->messages += (uint64_t)count;
+    cursor->bytes += bytes;
+    
+    return count;
 }
 
-uint32_t ring_buffer_crc32(const void *data, size_t size) {
-    if (!crc32_table_initialized) {
-        init_crc32_table();
+ring_buffer_error_t ring_buffer_release(ring_buffer_t *rb, ring_buffer_cursor_t *cursor) {
+    if (!rb || !cursor) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
     }
     
-    uint32_t crc = 0xFFFFFFFF;
-    const uint8_t *bytes = (const uint8_t *)data;
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
     
-    for (size_t i = 0; i < size; i++) {
-        crc = crc32_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    size_t read_pos = atomic_load(&rb->control->read_pos);
+    while (read_pos < cursor->pos) {
+        if (atomic_compare_exchange_weak(&rb->control->read_pos, &read_pos, cursor->pos)) {
+            notify_waiters(rb, &rb->control->writable_seq, &rb->control->writable_waiters);
+            
+            STAT_ADD(rb, messages_read, cursor->messages);
+            STAT_ADD(rb, bytes_read, cursor->bytes);
+            /* The peeked headers are gone by now, so the age is unknown */
+            PROBE_READ(rb, read_pos, cursor->bytes, (int)cursor->messages, 0);
+            break;
+        }
     }
     
-    return crc ^ 0xFFFFFFFF;
-}
-
-uint64_t ring_buffer_timestamp(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    cursor->messages = 0;
+    cursor->bytes = 0;
+    return RING_BUFFER_SUCCESS;
 }
 
-size_t ring_buffer_next_power_of_2(size_t n) {
-    if (n == 0) return 1;
-    n--;
-    n |= n >> 1;
-    n |= n >> 2;
-    n |= n >> 4;
-    n |= n >> 8;
-    n |= n >> 16;
-    n |= n >> 32;
-    return n + 1;
+/* Read the index entry of an interval; false if it describes another
+ * interval or was being rewritten */
+static bool index_lookup(const ring_buffer_control_t *control, uint64_t bucket,
+                         size_t *pos, uint64_t *timestamp) {
+    const ring_buffer_index_entry_t *entry = &control->time_index[bucket & (RING_BUFFER_INDEX_ENTRIES - 1)];
+    uint64_t tag = atomic_load_explicit(&entry->bucket, memory_order_acquire);
+    *pos = (size_t)atomic_load_explicit(&entry->pos, memory_order_relaxed);
+    *timestamp = atomic_load_explicit(&entry->timestamp, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    return tag == bucket + 1 && atomic_load_explicit(&entry->bucket, memory_order_relaxed) == tag;
 }
 
-ring_buffer_t *ring_buffer_create(size_t size) {
-    if (size == 0) {
-        size = RING_BUFFER_DEFAULT_SIZE;
+ring_buffer_error_t ring_buffer_seek_time(ring_buffer_t *rb, uint64_t timestamp, ring_buffer_cursor_t *cursor) {
+    if (!rb || !cursor) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
     }
     
-    /* Ensure size is power of 2 for efficient modulo operations */
-    size = ring_buffer_next_power_of_2(size);
-    
-    
-    /* Allocate ring buffer structure */
-    ring_buffer_t *rb = calloc(1, sizeof(ring_buffer_t));
-    if (!rb) {
-        return NULL;
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
     }
     
-    /* Allocate buffer memory - fallback to malloc for compatibility */
-    rb->fd = -1;
+    ring_buffer_control_t *control = rb->control;
+    size_t read_pos = atomic_load(&control->read_pos);
+    size_t commit_pos = refresh_commit_pos(control);
+    size_t pos = read_pos;
     
-    /* Try MAP_ANON first (macOS) */
-#if defined(MAP_ANON)
-    rb->buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, 
-                      MAP_PRIVATE | MAP_ANON, -1, 0);
-    if (rb->buffer == MAP_FAILED) {
-#elif defined(MAP_ANONYMOUS)
-    rb->buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, 
-                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (rb->buffer == MAP_FAILED) {
-#else
-    /* Force fallback */
-    rb->buffer = MAP_FAILED;
-    if (true) {
-#endif
-        /* Fallback to regular malloc */
-        rb->buffer = malloc(size);
-        if (!rb->buffer) {
-            free(rb);
-            return NULL;
+    /* Latest indexed message stamped before the target; entries outside
+     * the live data are consumed or from an earlier lap */
+    if (commit_pos > read_pos) {
+        unsigned int shift = control->index_shift;
+        uint64_t lo = (uint64_t)read_pos >> shift;
+        uint64_t hi = ((uint64_t)(commit_pos - 1) >> shift) + 1;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            size_t entry_pos;
+            uint64_t entry_timestamp;
+            if (!index_lookup(control, mid, &entry_pos, &entry_timestamp) ||
+                entry_pos < read_pos || entry_pos >= commit_pos) {
+                lo = mid + 1;
+            } else if (entry_timestamp < timestamp) {
+                pos = entry_pos;
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
         }
-        memset(rb->buffer, 0, size);
     }
     
-    /* Initialize buffer structure */
-    rb->size = size;
-    rb->magic = RING_BUFFER_MAGIC;
-    rb->backpressure_threshold = RING_BUFFER_BACKPRESSURE_THRESHOLD;
-    
-    /* Initialize atomic positions */
-    atomic_store(&rb->write_pos, 0);
-    atomic_store(&rb->read_pos, 0);
-    atomic_store(&rb->commit_pos, 0);
-    atomic_store(&rb->is_full, false);
-    atomic_store(&rb->backpressure, false);
+    /* Scan forward to the first message at or after the target */
+    for (;;) {
+        ring_buffer_message_t msg;
+        size_t end_pos;
+        uint64_t bytes;
+        
+        size_t wrapped;
+        
+        /* Only headers are needed, so wrapped messages aren't copied */
+        int n = scan_messages(rb, pos, commit_pos, &msg, 1, &end_pos, &bytes, NULL, &wrapped);
+        if (n < 0) {
+            STAT_ADD(rb, read_errors, 1);
+            return (ring_buffer_error_t)n;
+        }
+        if (n == 0) {
+            pos = end_pos;
+            break;
+        }
+        if (msg.header.timestamp >= timestamp) {
+            pos = end_pos - total_message_size(msg.data_size);
+            break;
+        }
+        pos = end_pos;
+    }
     
-    /* Initialize statistics */
-    atomic_store(&rb->messages_written, 0);
-    atomic_store(&rb->messages_read, 0);
-    atomic_store(&rb->bytes_written, 0);
-    atomic_store(&rb->bytes_read, 0);
-    atomic_store(&rb->write_errors, 0);
-    atomic_store(&rb->read_errors, 0);
-    atomic_store(&rb->backpressure_events, 0);
-    
-    /* Initialize CRC32 table */
-    init_crc32_table();
+    cursor->pos = pos;
+    cursor->messages = 0;
+    cursor->bytes = 0;
     
-    return rb;
+    return pos < commit_pos ? RING_BUFFER_SUCCESS : RING_BUFFER_ERROR_EMPTY;
 }
 
-void ring_buffer_destroy(ring_buffer_t *rb) {
-    if (!rb) return;
+ring_buffer_error_t ring_buffer_reader_open(ring_buffer_t *rb, uint32_t flags, ring_buffer_reader_t *reader) {
+    if (!rb || !reader) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
     
-    if (rb->buffer) {
-        /* Check if it was allocated with mmap or malloc */
-        if (rb->fd >= 0) {
-            /* mmap allocated, use munmap */
-            munmap(rb->buffer, rb->size);
-            close(rb->fd);
-        } else {
-            /* Try munmap first, if it fails, it was malloc allocated */
-            if (munmap(rb->buffer, rb->size) != 0) {
-                /* munmap failed, it was malloc allocated */
-                free(rb->buffer);
-            }
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    
+    /* Counted first, so writers that skip the table can't miss us */
+    ring_buffer_control_t *control = rb->control;
+    atomic_fetch_add(&control->reader_count, 1);
+    
+    for (uint32_t i = 0; i < RING_BUFFER_MAX_READERS; i++) {
+        ring_buffer_reader_slot_t *slot = &control->readers[i];
+        uint64_t owner = atomic_load(&slot->owner);
+        if (READER_STATE(owner) != READER_FREE) {
+            continue;
+        }
+        
+        uint64_t generation = (owner >> 2) + 1;
+        if (!atomic_compare_exchange_strong(&slot->owner, &owner, generation << 2 | READER_CLAIMED)) {
+            continue;
+        }
+        
+        /* Hold everything from the read position while the slot goes live.
+         * Writers that missed it loaded read_pos before it did, so any
+         * read_pos loaded afterwards is still intact. */
+        atomic_store(&slot->pos, atomic_load(&control->read_pos));
+        atomic_store_explicit(&slot->flags, flags, memory_order_relaxed);
+        atomic_store(&slot->owner, generation << 2 | READER_ACTIVE);
+        
+        size_t start = atomic_load(&control->read_pos);
+        if (flags & RING_BUFFER_READER_TAIL) {
+            size_t commit_pos = atomic_load(&control->commit_pos);
+            start = commit_pos > start ? commit_pos : start;
         }
+        atomic_store(&slot->pos, start);
+        
+        reader->slot = i;
+        reader->owner = generation << 2 | READER_ACTIVE;
+        reader->cursor.pos = start;
+        reader->cursor.messages = 0;
+        reader->cursor.bytes = 0;
+        return RING_BUFFER_SUCCESS;
     }
     
-    free(rb);
+    atomic_fetch_sub(&control->reader_count, 1);
+    return RING_BUFFER_ERROR_FULL;
 }
 
-double ring_buffer_utilization(const ring_buffer_t *rb) {
-    if (!rb) return 0.0;
+/* Whether the handle still holds its slot */
+static inline bool reader_owned(const ring_buffer_t *rb, const ring_buffer_reader_t *reader) {
+    return atomic_load(&rb->control->readers[reader->slot].owner) == reader->owner;
+}
+
+int ring_buffer_reader_peek(ring_buffer_t *rb, ring_buffer_reader_t *reader,
+                            ring_buffer_message_t *msgs, size_t max) {
+    if (!rb || !reader || !msgs || max == 0 || reader->slot >= RING_BUFFER_MAX_READERS) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
     
-    size_t write_pos = atomic_load(&rb->write_pos);
-    size_t read_pos = atomic_load(&rb->read_pos);
+    if (!reader_owned(rb, reader)) {
+        return RING_BUFFER_ERROR_EVICTED;
+    }
     
-    size_t used;
-    if (write_pos >= read_pos) {
-        used = write_pos - read_pos;
-    } else {
-        used = rb->size - (read_pos - write_pos);
+    /* Readers share messages rather than claim them, so each copies a
+     * wrapped one into its own target */
+    if (!reserve_wrap(rb, &rb->reader_wrap[reader->slot])) {
+        return RING_BUFFER_ERROR_MEMORY;
+    }
+    uint8_t *wrap = rb->reader_wrap[reader->slot];
+    
+    size_t commit_pos = refresh_commit_pos(rb->control);
+    size_t end_pos;
+    uint64_t bytes;
+    
+    int count = scan_messages(rb, reader->cursor.pos, commit_pos, msgs, max, &end_pos, &bytes, wrap, NULL);
+    
+    /* Once evicted, writers may have overwritten what was just scanned */
+    if (!reader_owned(rb, reader)) {
+        return RING_BUFFER_ERROR_EVICTED;
+    }
+    if (count < 0) {
+        return count;
     }
     
-    return (double)used / (double)rb->size;
+    reader->cursor.pos = end_pos;
+    reader->cursor.messages += (uint64_t)count;
+    reader->cursor.bytes += bytes;
+    
+    return count;
 }
 
-size_t ring_buffer_available_write(const ring_buffer_t *rb) {
-    if (!rb) return 0;
+ring_buffer_error_t ring_buffer_reader_release(ring_buffer_t *rb, ring_buffer_reader_t *reader) {
+    if (!rb || !reader || reader->slot >= RING_BUFFER_MAX_READERS) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
     
-    size_t write_pos = atomic_load(&rb->write_pos);
-    size_t read_pos = atomic_load(&rb->read_pos);
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
     
-    if (write_pos >= read_pos) {
-        return rb->size - (write_pos - read_pos) - 1;
-    } else {
-        return read_pos - write_pos - 1;
+    /* An evicted slot is only reused after its owner closes it, so a
+     * store racing with the eviction is harmless */
+    if (!reader_owned(rb, reader)) {
+        return RING_BUFFER_ERROR_EVICTED;
     }
+    
+    atomic_store_explicit(&rb->control->readers[reader->slot].pos, reader->cursor.pos, memory_order_release);
+    notify_waiters(rb, &rb->control->writable_seq, &rb->control->writable_waiters);
+    
+    reader->cursor.messages = 0;
+    reader->cursor.bytes = 0;
+    return RING_BUFFER_SUCCESS;
 }
 
-size_t ring_buffer_available_read(const ring_buffer_t *rb) {
-    if (!rb) return 0;
+ring_buffer_error_t ring_buffer_reader_close(ring_buffer_t *rb, ring_buffer_reader_t *reader) {
+    if (!rb || !reader || reader->slot >= RING_BUFFER_MAX_READERS) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
     
-    size_t write_pos = atomic_load(&rb->commit_pos);
-    size_t read_pos = atomic_load(&rb->read_pos);
+    ring_buffer_control_t *control = rb->control;
+    ring_buffer_reader_slot_t *slot = &control->readers[reader->slot];
+    uint64_t owner = reader->owner;
+    uint64_t freed = owner & ~3ull;
     
-    if (write_pos >= read_pos) {
-        return write_pos - read_pos;
+    if (atomic_compare_exchange_strong(&slot->owner, &owner, freed)) {
+        atomic_fetch_sub(&control->reader_count, 1);
+        notify_waiters(rb, &control->writable_seq, &control->writable_waiters);
     } else {
-        return rb->size - (read_pos - write_pos);
+        uint64_t evicted = freed | READER_EVICTED;
+        atomic_compare_exchange_strong(&slot->owner, &evicted, freed);
     }
+    
+    reader->owner = 0;
+    return RING_BUFFER_SUCCESS;
 }
 
-bool ring_buffer_is_backpressure(const ring_buffer_t *rb) {
-    if (!rb) return false;
-    return atomic_load(&rb->backpressure);
-}
-
-void ring_buffer_get_stats(const ring_buffer_t *rb, ring_buffer_stats_t *stats) {
-    if (!rb || !stats) return;
+int ring_buffer_read_batch(ring_buffer_t *rb, ring_buffer_message_t *msgs, size_t max) {
+    if (!rb || !msgs || max == 0) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
     
-    stats->messages_written = atomic_load(&rb->messages_written);
-    stats->messages_read = atomic_load(&rb->messages_read);
-    stats->bytes_written = atomic_load(&rb->bytes_written);
-    stats->bytes_read = atomic_load(&rb->bytes_read);
-    stats->write_errors = atomic_load(&rb->write_errors);
-    stats->read_errors = atomic_load(&rb->read_errors);
-    stats->backpressure_events = atomic_load(&rb->backpressure_events);
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    
+    return consume_messages(rb, msgs, max);
 }
 
-void ring_buffer_reset_stats(ring_buffer_t *rb) {
-    if (!rb) return;
+size_t ring_buffer_decoded_size(const ring_buffer_message_t *msg) {
+    if (!msg || !msg->data) {
+        return 0;
+    }
+    if (RING_BUFFER_HEADER_CODEC(msg->header.reserved) == RING_BUFFER_CODEC_NONE) {
+        return msg->data_size;
+    }
+    if (msg->data_size <= RING_BUFFER_CODEC_PREFIX_SIZE) {
+        return 0;
+    }
     
-    atomic_store(&rb->messages_written, 0);
-    atomic_store(&rb->messages_read, 0);
-    atomic_store(&rb->bytes_written, 0);
-    atomic_store(&rb->bytes_read, 0);
-    atomic_store(&rb->write_errors, 0);
-    atomic_store(&rb->read_errors, 0);
-    atomic_store(&rb->backpressure_events, 0);
+    const uint8_t *prefix = (const uint8_t *)msg->data;
+    return (size_t)prefix[0] | ((size_t)prefix[1] << 8) | ((size_t)prefix[2] << 16) | ((size_t)prefix[3] << 24);
 }
 
-bool ring_buffer_validate(const ring_buffer_t *rb) {
-    if (!rb) return false;
-    
-    /* Check magic number */
-    if (rb->magic != RING_BUFFER_MAGIC) {
-        return false;
+ring_buffer_error_t ring_buffer_decode(const ring_buffer_message_t *msg, void *arena, size_t arena_size,
+                                       const void **data, size_t *size) {
+    if (!msg || !msg->data || !data || !size) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
     }
     
-    /* Check buffer pointer */
-    if (!rb->buffer || rb->buffer == MAP_FAILED) {
-        return false;
+    ring_buffer_codec_t codec = RING_BUFFER_HEADER_CODEC(msg->header.reserved);
+    if (codec == RING_BUFFER_CODEC_NONE) {
+        *data = msg->data;
+        *size = msg->data_size;
+        return RING_BUFFER_SUCCESS;
+    }
+    if (!ring_buffer_codec_supported(codec)) {
+        return RING_BUFFER_ERROR_UNSUPPORTED;
     }
     
-    /* Check size is power of 2 */
-    if (rb->size == 0 || (rb->size & (rb->size - 1)) != 0) {
-        return false;
+    size_t decoded_size = ring_buffer_decoded_size(msg);
+    if (decoded_size == 0 || decoded_size > RING_BUFFER_MAX_MESSAGE_SIZE) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    if (!arena || arena_size < decoded_size) {
+        return RING_BUFFER_ERROR_TOO_LARGE;
     }
     
-    /* Check positions are within bounds */
-    size_t write_pos = atomic_load(&rb->write_pos);
-    size_t read_pos = atomic_load(&rb->read_pos);
-    size_t commit_pos = atomic_load(&rb->commit_pos);
+    const uint8_t *compressed = (const uint8_t *)msg->data + RING_BUFFER_CODEC_PREFIX_SIZE;
+    if (!codec_decompress(codec, compressed, msg->data_size - RING_BUFFER_CODEC_PREFIX_SIZE, arena, decoded_size)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
     
-    if (write_pos >= rb->size || read_pos >= rb->size || commit_pos >= rb->size) {
-        return false;
+    *data = arena;
+    *size = decoded_size;
+    return RING_BUFFER_SUCCESS;
+}
+
+ring_buffer_error_t ring_buffer_slab_iter_init(ring_buffer_slab_iter_t *iter, const ring_buffer_message_t *msg) {
+    if (!iter || !msg || !msg->data) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
     }
     
-    return true;
+    iter->pos = (const uint8_t *)msg->data;
+    iter->end = iter->pos + msg->data_size;
+    iter->timestamp = msg->header.timestamp;
+    iter->slab = RING_BUFFER_HEADER_IS_SLAB(msg->header.reserved);
+    return RING_BUFFER_SUCCESS;
 }
 
-const char *ring_buffer_error_string(ring_buffer_error_t error) {
-    switch (error) {
-        case RING_BUFFER_SUCCESS: return "Success";
-        case RING_BUFFER_ERROR_INVALID_PARAM: return "Invalid parameter";
-        case RING_BUFFER_ERROR_MEMORY: return "Memory allocation error";
-        case RING_BUFFER_ERROR_FULL: return "Buffer full";
-        case RING_BUFFER_ERROR_EMPTY: return "Buffer empty";
-        case RING_BUFFER_ERROR_TOO_LARGE: return "Message too large";
-        case RING_BUFFER_ERROR_CORRUPTED: return "Buffer corrupted";
-        case RING_BUFFER_ERROR_BACKPRESSURE: return "Backpressure active";
-        default: return "Unknown error";
+ring_buffer_error_t ring_buffer_slab_next(ring_buffer_slab_iter_t *iter, const void **data,
+                                          size_t *size, uint64_t *timestamp) {
+    if (!iter || !data || !size || !timestamp) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+    if (iter->pos >= iter->end) {
+        return RING_BUFFER_ERROR_EMPTY;
     }
+    
+    /* A plain message is its own single record */
+    if (!iter->slab) {
+        *data = iter->pos;
+        *size = (size_t)(iter->end - iter->pos);
+        *timestamp = iter->timestamp;
+        iter->pos = iter->end;
+        return RING_BUFFER_SUCCESS;
+    }
+    
+    uint64_t delta, length;
+    const uint8_t *pos = varint_get(iter->pos, iter->end, &delta);
+    pos = pos ? varint_get(pos, iter->end, &length) : NULL;
+    if (!pos || length == 0 || length > (uint64_t)(iter->end - pos)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
+    
+    iter->timestamp += zigzag_decode(delta);
+    iter->pos = pos + length;
+    *data = pos;
+    *size = (size_t)length;
+    *timestamp = iter->timestamp;
+    return RING_BUFFER_SUCCESS;
 }
 
-ring_buffer_error_t ring_buffer_write(ring_buffer_t *rb, const void *data, size_t size) {
-    if (!rb || !data || size == 0) {
+int ring_buffer_recover(ring_buffer_t *rb, ring_buffer_message_t *last) {
+    if (!rb) {
         return RING_BUFFER_ERROR_INVALID_PARAM;
     }
     
     if (!ring_buffer_validate(rb)) {
-        atomic_fetch_add(&rb->write_errors, 1);
         return RING_BUFFER_ERROR_CORRUPTED;
     }
     
-    if (size > RING_BUFFER_MAX_MESSAGE_SIZE) {
-        atomic_fetch_add(&rb->write_errors, 1);
-        return RING_BUFFER_ERROR_TOO_LARGE;
+    if (last && !reserve_wrap(rb, &rb->peek_wrap)) {
+        return RING_BUFFER_ERROR_MEMORY;
     }
     
-    /* Check backpressure */
-    if (ring_buffer_utilization(rb) >= rb->backpressure_threshold) {
-        atomic_store(&rb->backpressure, true);
-        atomic_fetch_add(&rb->backpressure_events, 1);
-        return RING_BUFFER_ERROR_BACKPRESSURE;
-    } else {
-        atomic_store(&rb->backpressure, false);
+    ring_buffer_control_t *control = rb->control;
+    size_t read_pos = atomic_load(&control->read_pos);
+    size_t commit_pos = atomic_load(&control->commit_pos);
+    size_t write_pos = atomic_load(&control->write_pos);
+    if ((read_pos | commit_pos) & (MESSAGE_ALIGNMENT - 1)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
     }
     
-    size_t msg_size = total_message_size(size);
-    
-    /* Check if message fits */
-    if (msg_size > ring_buffer_available_write(rb)) {
-        atomic_fetch_add(&rb->write_errors, 1);
-        return RING_BUFFER_ERROR_FULL;
+    /* Reservations past the commit position can only be trusted as far
+     * as the positions themselves are sane */
+    if ((write_pos & (MESSAGE_ALIGNMENT - 1)) || write_pos < commit_pos || write_pos - read_pos > rb->size) {
+        write_pos = commit_pos;
     }
     
-    /* Reserve space atomically */
-    size_t write_pos = atomic_load(&rb->write_pos);
-    size_t new_write_pos = (write_pos + msg_size) & (rb->size - 1);
+    /* Walk the published records one at a time, keeping the valid prefix,
+     * then the reserved ones behind them */
+    size_t pos = read_pos;
+    size_t limit = commit_pos;
+    size_t last_pos = read_pos;
+    int count = 0;
     
-    /* Try to reserve space with CAS loop */
-    while (!atomic_compare_exchange_weak(&rb->write_pos, &write_pos, new_write_pos)) {
-        /* Recalculate after position change */
-        new_write_pos = (write_pos + msg_size) & (rb->size - 1);
+    for (;;) {
+        ring_buffer_message_t msg;
+        size_t end_pos;
+        size_t wrapped;
+        uint64_t bytes;
         
-        /* Check if we still have space */
-        if (msg_size > ring_buffer_available_write(rb)) {
-            atomic_fetch_add(&rb->write_errors, 1);
-            return RING_BUFFER_ERROR_FULL;
+        int n = scan_messages(rb, pos, limit, &msg, 1, &end_pos, &bytes, NULL, &wrapped);
+        if (n > 0) {
+            last_pos = end_pos - total_message_size(msg.data_size);
+            pos = end_pos;
+            count++;
+            continue;
         }
-    }
-    
-    /* Write message header */
-    arrow_ipc_header_t header = {
-        .magic = ARROW_IPC_MAGIC,
-        .length = (uint32_t)size,
-        .timestamp = ring_buffer_timestamp(),
-        .checksum = ring_buffer_crc32(data, size),
-        .reserved = 0
-    };
-    
-    uint8_t *buffer = (uint8_t *)rb->buffer;
-    
-    /* Handle wrap-around for header */
-    if (write_pos + sizeof(arrow_ipc_header_t) <= rb->size) {
-        if (safe_memcpy(buffer + write_pos, &header, sizeof(arrow_ipc_header_t), rb->size - write_pos) != 0) {
-            return RING_BUFFER_ERROR;
+        
+        /* Trailing padding is kept; a corrupt published record ends the scan */
+        if (n == 0) {
+            pos = end_pos;
         }
-    } else {
-        /* Header spans across buffer boundary */
-        size_t first_part = rb->size - write_pos;
-        if (safe_memcpy(buffer + write_pos, &header, first_part, first_part) != 0 ||
-            safe_memcpy(buffer, (uint8_t *)&header + first_part, sizeof(arrow_ipc_header_t) - first_part, rb->size) != 0) {
-            return RING_BUFFER_ERROR;
+        if (limit == commit_pos) {
+            if (pos != commit_pos || write_pos == commit_pos) {
+                break;
+            }
+            limit = write_pos;
+            continue;
         }
-    }
-    
-    /* Write message data */
-    size_t data_start = (write_pos + sizeof(arrow_ipc_header_t)) & (rb->size - 1);
-    
-    if (data_start + size <= rb->size) {
-        if (safe_memcpy(buffer + data_start, data, size, rb->size - data_start) != 0) {
-            return RING_BUFFER_ERROR;
+        
+        /* A reservation its writer never committed becomes padding, so
+         * the complete records later writers left behind it are kept */
+        arrow_ipc_header_t header;
+        if (write_pos - pos < sizeof(arrow_ipc_header_t)) {
+            break;
         }
-    } else {
-        /* Data spans across buffer boundary */
-        size_t first_part = rb->size - data_start;
-        if (safe_memcpy(buffer + data_start, data, first_part, first_part) != 0 ||
-            safe_memcpy(buffer, (uint8_t *)data + first_part, size - first_part, rb->size) != 0) {
-            return RING_BUFFER_ERROR;
+        ring_copy_out(rb, pos, &header, sizeof(arrow_ipc_header_t));
+        size_t reserved = total_message_size(header.length);
+        if (header.magic != RING_BUFFER_PENDING_MAGIC || reserved > write_pos - pos) {
+            break;
         }
+        write_padding(rb, pos, reserved);
     }
     
-    /* Memory barrier to ensure data is written before commit */
-    write_barrier();
-    
-    /* Commit the write atomically */
-    atomic_store(&rb->commit_pos, new_write_pos);
+    /* Rescan the newest message for a view; a wrapped one is copied into
+     * the handle's own target */
+    if (last && count > 0) {
+        size_t end_pos;
+        uint64_t bytes;
+        scan_messages(rb, last_pos, pos, last, 1, &end_pos, &bytes, rb->peek_wrap, NULL);
+    }
     
-    /* Update statistics */
-    atomic_fetch_add(&rb->messages_written, 1);
-    atomic_fetch_add(&rb->bytes_written, size);
+    /* Forget reservations and waiters of the crashed processes */
+    atomic_store(&control->commit_pos, pos);
+    atomic_store(&control->write_pos, pos);
+    atomic_store(&control->cached_commit_pos, pos);
+    atomic_store(&control->cached_read_pos, read_pos);
+    atomic_store(&control->is_full, false);
+    atomic_store(&control->backpressure, false);
+    atomic_store(&control->readable_waiters, 0);
+    atomic_store(&control->writable_waiters, 0);
     
-    return RING_BUFFER_SUCCESS;
+    return count;
 }
 
-ring_buffer_error_t ring_buffer_read(ring_buffer_t *rb, ring_buffer_message_t *msg) {
-    if (!rb || !msg) {
+/* Copy [start, end) between buffers of the same size, offset for offset */
+static void copy_range(const ring_buffer_t *source, ring_buffer_t *replica, size_t start, size_t end) {
+    while (start < end) {
+        size_t offset = ring_offset(source, start);
+        size_t n = source->size - offset;
+        if (n > end - start) {
+            n = end - start;
+        }
+        memcpy((uint8_t *)replica->buffer + offset, (const uint8_t *)source->buffer + offset, n);
+        start += n;
+    }
+}
+
+ring_buffer_error_t ring_buffer_replicate(ring_buffer_t *source, ring_buffer_t *replica, size_t *cursor) {
+    if (!source || !replica || !cursor || source == replica || source->size != replica->size) {
         return RING_BUFFER_ERROR_INVALID_PARAM;
     }
     
-    if (!ring_buffer_validate(rb)) {
-        atomic_fetch_add(&rb->read_errors, 1);
+    if (!ring_buffer_validate(source) || !ring_buffer_validate(replica)) {
         return RING_BUFFER_ERROR_CORRUPTED;
     }
     
-    /* Check if data is available */
-    if (ring_buffer_available_read(rb) < sizeof(arrow_ipc_header_t)) {
-        return RING_BUFFER_ERROR_EMPTY;
-    }
+    ring_buffer_control_t *dst = replica->control;
     
-    size_t read_pos = atomic_load(&rb->read_pos);
-    uint8_t *buffer = (uint8_t *)rb->buffer;
+    /* Loading read_pos first guarantees end >= read_pos */
+    size_t read_pos = atomic_load(&source->control->read_pos);
+    size_t end = atomic_load_explicit(&source->control->commit_pos, memory_order_acquire);
     
-    /* Read message header */
-    arrow_ipc_header_t header;
-    if (read_pos + sizeof(arrow_ipc_header_t) <= rb->size) {
-        if (safe_memcpy(&header, buffer + read_pos, sizeof(arrow_ipc_header_t), sizeof(arrow_ipc_header_t)) != 0) {
-            return RING_BUFFER_ERROR;
-        }
-    } else {
-        /* Header spans across buffer boundary */
-        size_t first_part = rb->size - read_pos;
-        if (safe_memcpy(&header, buffer + read_pos, first_part, sizeof(arrow_ipc_header_t)) != 0 ||
-            safe_memcpy((uint8_t *)&header + first_part, buffer, sizeof(arrow_ipc_header_t) - first_part, sizeof(arrow_ipc_header_t) - first_part) != 0) {
-            return RING_BUFFER_ERROR;
+    /* Replica bytes below floor are overwritten by this copy */
+    size_t floor = end > source->size && end - source->size > read_pos ? end - source->size : read_pos;
+    size_t start = *cursor;
+    
+    if (start < floor || start > end || atomic_load(&dst->commit_pos) != start) {
+        /* Not a continuation of the replica's contents: start it over empty */
+        start = floor;
+        if (start >= atomic_load(&dst->write_pos)) {
+            atomic_store(&dst->write_pos, start);
+            atomic_store(&dst->commit_pos, start);
+            atomic_store(&dst->read_pos, start);
+        } else {
+            atomic_store(&dst->read_pos, start);
+            atomic_store(&dst->commit_pos, start);
+            atomic_store(&dst->write_pos, start);
         }
+    } else if (atomic_load(&dst->read_pos) < floor) {
+        atomic_store(&dst->read_pos, floor);
     }
     
-    /* Validate header */
-    if (header.magic != ARROW_IPC_MAGIC) {
-        atomic_fetch_add(&rb->read_errors, 1);
-        return RING_BUFFER_ERROR_CORRUPTED;
-    }
+    copy_range(source, replica, start, end);
     
-    if (header.length > RING_BUFFER_MAX_MESSAGE_SIZE) {
-        atomic_fetch_add(&rb->read_errors, 1);
-        return RING_BUFFER_ERROR_CORRUPTED;
+    /* Bytes the source consumer released during the copy may have been
+     * overwritten, so the replica starts reading past them */
+    size_t released = atomic_load(&source->control->read_pos);
+    size_t new_read = released < end ? released : end;
+    if (new_read < atomic_load(&dst->read_pos)) {
+        new_read = atomic_load(&dst->read_pos);
     }
     
-    size_t msg_size = total_message_size(header.length);
+    atomic_store(&dst->write_pos, end);
+    atomic_store_explicit(&dst->commit_pos, end, memory_order_release);
+    atomic_store(&dst->read_pos, new_read);
+    atomic_store_explicit(&dst->cached_commit_pos, end, memory_order_release);
+    atomic_store_explicit(&dst->cached_read_pos, new_read, memory_order_release);
     
-    /* Check if complete message is available */
-    if (ring_buffer_available_read(rb) < msg_size) {
-        return RING_BUFFER_ERROR_EMPTY;
-    }
+    notify_waiters(replica, &dst->readable_seq, &dst->readable_waiters);
     
-    /* Get pointer to message data */
-    size_t data_start = (read_pos + sizeof(arrow_ipc_header_t)) & (rb->size - 1);
+    *cursor = end;
+    return RING_BUFFER_SUCCESS;
+}
+
+/* At least min_bytes (or one record) published and unread */
+static bool is_readable(ring_buffer_t *rb, size_t min_bytes) {
+    size_t read_pos = atomic_load(&rb->control->read_pos);
+    size_t commit_pos = atomic_load(&rb->control->commit_pos);
+    return commit_pos > read_pos && commit_pos - read_pos >= min_bytes;
+}
+
+/* At least min_bytes free and a normal-priority write would be admitted */
+static bool is_writable(ring_buffer_t *rb, size_t min_bytes) {
+    size_t read_pos = refresh_read_pos(rb->control);
+    size_t write_pos = atomic_load(&rb->control->write_pos);
+    size_t used = write_pos > read_pos ? write_pos - read_pos : 0;
+    bool active = backpressure_after(rb->control, atomic_load(&rb->control->backpressure), used);
+    return rb->size - used >= min_bytes && !active;
+}
+
+ring_buffer_error_t ring_buffer_wait_readable(ring_buffer_t *rb, size_t min_bytes, int64_t timeout_ns) {
+    if (!rb || min_bytes > rb->size) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
     
-    /* For messages that don't wrap around, we can return direct pointer */
-    if (data_start + header.length <= rb->size) {
-        msg->data = buffer + data_start;
-        msg->data_size = header.length;
-        
-        /* Validate checksum */
-        uint32_t checksum = ring_buffer_crc32(msg->data, header.length);
-        if (checksum != header.checksum) {
-            atomic_fetch_add(&rb->read_errors, 1);
-            return RING_BUFFER_ERROR_CORRUPTED;
-        }
-    } else {
-        /* Message wraps around - this is a limitation of zero-copy approach */
-        /* For now, we'll return an error for wrapped messages */
-        /* In a production system, you might want to copy to a temporary buffer */
-        atomic_fetch_add(&rb->read_errors, 1);
+    if (!handle_valid(rb)) {
         return RING_BUFFER_ERROR_CORRUPTED;
     }
     
-    /* Copy header to output */
-    msg->header = header;
-    
-    /* Update read position */
-    size_t new_read_pos = (read_pos + msg_size) & (rb->size - 1);
-    atomic_store(&rb->read_pos, new_read_pos);
+    return wait_for(rb, min_bytes, timeout_ns, is_readable,
+                    &rb->control->readable_seq, &rb->control->readable_waiters);
+}
+
+ring_buffer_error_t ring_buffer_wait_writable(ring_buffer_t *rb, size_t min_bytes, int64_t timeout_ns) {
+    if (!rb || min_bytes > rb->size) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
     
-    /* Update statistics */
-    atomic_fetch_add(&rb->messages_read, 1);
-    atomic_fetch_add(&rb->bytes_read, header.length);
+    if (!handle_valid(rb)) {
+        return RING_BUFFER_ERROR_CORRUPTED;
+    }
     
-    return RING_BUFFER_SUCCESS;
+    return wait_for(rb, min_bytes, timeout_ns, is_writable,
+                    &rb->control->writable_seq, &rb->control->writable_waiters);
 }
-
@@ -14,8 +14,22 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <stdatomic.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+/* Before C++23 C++ has no <stdatomic.h>; its std::atomic types have the
+ * same size and representation, so the control block reads the same */
+#if defined(__cplusplus) && __cplusplus < 202302L
+#include <atomic>
+using std::atomic_bool;
+using std::atomic_uint;
+using std::atomic_size_t;
+using std::atomic_uint_fast64_t;
+#define RING_BUFFER_ALIGNAS(n) alignas(n)
+#else
+#include <stdatomic.h>
+#define RING_BUFFER_ALIGNAS(n) _Alignas(n)
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,18 +38,83 @@ extern "C" {
 /* Default buffer size: 64MB */
 #define RING_BUFFER_DEFAULT_SIZE (64 * 1024 * 1024)
 
+/* Default starting capacity of an elastic buffer: 1MB */
+#define RING_BUFFER_ELASTIC_INITIAL_SIZE (1024 * 1024)
+
 /* Backpressure threshold: 80% full */
 #define RING_BUFFER_BACKPRESSURE_THRESHOLD 0.8
 
+/* Backpressure is released again once usage falls to 60% */
+#define RING_BUFFER_LOW_WATERMARK 0.6
+
 /* Maximum message size: 16MB */
 #define RING_BUFFER_MAX_MESSAGE_SIZE (16 * 1024 * 1024)
 
 /* Arrow IPC message magic number */
 #define ARROW_IPC_MAGIC 0x41524157  /* "ARAW" */
 
+/* Padding record magic number, skipped by readers */
+#define RING_BUFFER_PADDING_MAGIC 0x50414444  /* "PADD" */
+
+/* Header of a reservation not committed yet; never visible to readers */
+#define RING_BUFFER_PENDING_MAGIC 0x50454E44  /* "PEND" */
+
 /* Message alignment in bytes */
 #define MESSAGE_ALIGNMENT 8
 
+/* Buffer creation flags */
+#define RING_BUFFER_FLAG_MIRRORED (1u << 0)  /* Map the buffer twice, back to back */
+#define RING_BUFFER_FLAG_SHARED   (1u << 1)  /* Backed by a file other processes can open */
+#define RING_BUFFER_FLAG_TRUSTED  (1u << 2)  /* Reads through this handle skip checksum verification */
+#define RING_BUFFER_FLAG_HUGE_PAGES (1u << 3)  /* Back the mapping with huge pages where possible */
+#define RING_BUFFER_FLAG_PREFAULT (1u << 4)  /* Fault every page in up front */
+#define RING_BUFFER_FLAG_LOCKED   (1u << 5)  /* mlock() the mapping so it is never paged out */
+#define RING_BUFFER_FLAG_ELASTIC  (1u << 6)  /* Start small, grow up to the size on demand */
+#define RING_BUFFER_FLAG_SINGLE_PRODUCER (1u << 7)  /* At most one writer at a time */
+#define RING_BUFFER_FLAG_SINGLE_CONSUMER (1u << 8)  /* At most one reader at a time */
+#define RING_BUFFER_FLAG_NO_STATS (1u << 9)  /* Operations through this handle aren't counted */
+
+/* Zstd payload compression; build with -DRING_BUFFER_WITH_ZSTD=1 and link libzstd */
+#ifndef RING_BUFFER_WITH_ZSTD
+#define RING_BUFFER_WITH_ZSTD 0
+#endif
+
+/* Static tracing probes (USDT on Linux, os_signpost on Apple platforms);
+ * build with -DRING_BUFFER_WITH_PROBES=1, which on Linux needs <sys/sdt.h> */
+#ifndef RING_BUFFER_WITH_PROBES
+#define RING_BUFFER_WITH_PROBES 0
+#endif
+
+/* Statistics counting; build with -DRING_BUFFER_STATS=0 to compile it out */
+#ifndef RING_BUFFER_STATS
+#define RING_BUFFER_STATS 1
+#endif
+
+/* Number of statistics shards; threads are spread across them round-robin */
+#define RING_BUFFER_STATS_SHARDS 16
+
+/* Destructive interference size; Apple M-series cores use 128-byte lines */
+#if defined(__APPLE__) && defined(__aarch64__)
+#define RING_BUFFER_CACHE_LINE_SIZE 128
+#else
+#define RING_BUFFER_CACHE_LINE_SIZE 64
+#endif
+
+/* Entries in the sparse time index; a power of 2 */
+#define RING_BUFFER_INDEX_ENTRIES 256
+
+/* Registered reader slots; see ring_buffer_reader_open() */
+#define RING_BUFFER_MAX_READERS 8
+
+/* Reader options */
+#define RING_BUFFER_READER_EVICTABLE (1u << 0)  /* Cut loose instead of holding up writers when lagging */
+#define RING_BUFFER_READER_TAIL      (1u << 1)  /* Start after the newest message, not at the oldest */
+
+/* Shared buffer file format */
+#define RING_BUFFER_CONTROL_MAGIC 0x43524246  /* "CRBF" */
+#define RING_BUFFER_CONTROL_VERSION 10
+#define RING_BUFFER_CONTROL_SIZE 16384  /* Control block bytes; a multiple of the page size */
+
 /**
  * @brief Error codes for ring buffer operations
  */
@@ -47,9 +126,104 @@ typedef enum {
     RING_BUFFER_ERROR_EMPTY = -4,
     RING_BUFFER_ERROR_TOO_LARGE = -5,
     RING_BUFFER_ERROR_CORRUPTED = -6,
-    RING_BUFFER_ERROR_BACKPRESSURE = -7
+    RING_BUFFER_ERROR_BACKPRESSURE = -7,
+    RING_BUFFER_ERROR_TIMEOUT = -8,
+    RING_BUFFER_ERROR_UNSUPPORTED = -9,
+    RING_BUFFER_ERROR_EVICTED = -10,
+    RING_BUFFER_ERROR_IO = -11
 } ring_buffer_error_t;
 
+/**
+ * @brief Message checksum algorithms
+ * 
+ * The algorithm used for a message is recorded in the low byte of
+ * arrow_ipc_header_t.reserved. Data written before the field was used
+ * has reserved == 0 and therefore verifies as plain CRC32.
+ */
+typedef enum {
+    RING_BUFFER_CHECKSUM_CRC32 = 0,   /* IEEE 802.3 CRC32, software only */
+    RING_BUFFER_CHECKSUM_CRC32C = 1   /* Castagnoli CRC32C, hardware accelerated */
+} ring_buffer_checksum_t;
+
+/**
+ * @brief Payload compression codecs
+ * 
+ * The codec of a message is recorded in bits 8-15 of
+ * arrow_ipc_header_t.reserved. A compressed payload starts with its
+ * uncompressed length as a 32-bit little-endian integer, followed by the
+ * compressed bytes; the checksum covers the payload as stored.
+ */
+typedef enum {
+    RING_BUFFER_CODEC_NONE = 0,
+    RING_BUFFER_CODEC_LZ4 = 1,    /* LZ4 block format, always available */
+    RING_BUFFER_CODEC_ZSTD = 2    /* Zstandard frame, only with RING_BUFFER_WITH_ZSTD */
+} ring_buffer_codec_t;
+
+/* Bytes in front of a compressed payload holding its uncompressed length */
+#define RING_BUFFER_CODEC_PREFIX_SIZE 4
+
+/* Accessors for the arrow_ipc_header_t.reserved bit fields */
+#define RING_BUFFER_HEADER_CHECKSUM_MASK 0x000000FFu
+#define RING_BUFFER_HEADER_CHECKSUM(reserved) \
+    ((ring_buffer_checksum_t)((reserved) & RING_BUFFER_HEADER_CHECKSUM_MASK))
+#define RING_BUFFER_HEADER_SET_CHECKSUM(reserved, algorithm) \
+    (((reserved) & ~RING_BUFFER_HEADER_CHECKSUM_MASK) | ((uint32_t)(algorithm) & RING_BUFFER_HEADER_CHECKSUM_MASK))
+#define RING_BUFFER_HEADER_CODEC_MASK 0x0000FF00u
+#define RING_BUFFER_HEADER_CODEC(reserved) \
+    ((ring_buffer_codec_t)(((reserved) & RING_BUFFER_HEADER_CODEC_MASK) >> 8))
+#define RING_BUFFER_HEADER_SET_CODEC(reserved, codec) \
+    (((reserved) & ~RING_BUFFER_HEADER_CODEC_MASK) | (((uint32_t)(codec) << 8) & RING_BUFFER_HEADER_CODEC_MASK))
+
+/**
+ * Small-record slabs
+ * 
+ * A message with RING_BUFFER_HEADER_SLAB set in arrow_ipc_header_t.reserved
+ * packs several small records behind one header and one checksum. Each
+ * record is a varint of its zigzag-encoded timestamp delta, a varint of
+ * its length and then its bytes. The first delta is from the header
+ * timestamp, which is the first record's, and every later one from the
+ * record before. Slab payloads are never compressed.
+ */
+#define RING_BUFFER_HEADER_SLAB 0x00010000u
+#define RING_BUFFER_HEADER_IS_SLAB(reserved) (((reserved) & RING_BUFFER_HEADER_SLAB) != 0)
+
+/* Record bytes a slab collects before it is written out as one message */
+#ifndef RING_BUFFER_SLAB_CAPACITY
+#define RING_BUFFER_SLAB_CAPACITY 1024
+#endif
+
+/* Longest record header: two 64-bit varints */
+#define RING_BUFFER_SLAB_RECORD_OVERHEAD 20
+
+/**
+ * @brief Write priorities for backpressure admission
+ * 
+ * Backpressure turns on when usage reaches the high watermark and stays
+ * on until usage falls back to the low watermark. While it is on,
+ * normal writes are rejected; low-priority writes are also rejected
+ * whenever usage is above the low watermark, so bulk data is shed first.
+ * High-priority writes are only ever rejected when the buffer is full.
+ */
+typedef enum {
+    RING_BUFFER_PRIORITY_LOW = 0,       /* Bulk data such as screen frames */
+    RING_BUFFER_PRIORITY_NORMAL = 1,    /* Default for ring_buffer_write() */
+    RING_BUFFER_PRIORITY_HIGH = 2       /* Events that must not be shed, e.g. key and window events */
+} ring_buffer_priority_t;
+
+/**
+ * @brief Sources for the header timestamp
+ * 
+ * Selected per handle with ring_buffer_set_clock(). Every source yields
+ * nanoseconds since the epoch; they differ in what a read costs and in
+ * resolution. Producers that already know when their data was captured
+ * can skip the clock entirely by setting ring_buffer_span_t.timestamp.
+ */
+typedef enum {
+    RING_BUFFER_CLOCK_REALTIME = 0,  /* clock_gettime(CLOCK_REALTIME) on every write (default) */
+    RING_BUFFER_CLOCK_COARSE = 1,    /* Scheduler-tick resolution wall clock, read without a counter access */
+    RING_BUFFER_CLOCK_COUNTER = 2    /* rdtsc / cntvct_el0 scaled by the anchor in the control block */
+} ring_buffer_clock_t;
+
 /**
  * @brief Arrow IPC message header
  * 
@@ -60,8 +234,8 @@ typedef struct {
     uint32_t magic;         /* Magic number for validation */
     uint32_t length;        /* Message length in bytes */
     uint64_t timestamp;     /* Message timestamp (nanoseconds since epoch) */
-    uint32_t checksum;      /* CRC32 checksum of message data */
-    uint32_t reserved;      /* Reserved for future use */
+    uint32_t checksum;      /* Checksum of message data */
+    uint32_t reserved;      /* Bits 0-7: ring_buffer_checksum_t; 8-15: ring_buffer_codec_t; 16: slab; rest reserved */
 } __attribute__((packed)) arrow_ipc_header_t;
 
 /**
@@ -74,32 +248,19 @@ typedef struct {
     uint64_t bytes_read;
     uint64_t write_errors;
     uint64_t read_errors;
-    uint64_t backpressure_events;
+    uint64_t backpressure_events;   /* Times backpressure was turned on */
+    uint64_t backpressure_exits;    /* Times it was turned off again */
+    uint64_t messages_shed;         /* Writes rejected with RING_BUFFER_ERROR_BACKPRESSURE */
 } ring_buffer_stats_t;
 
 /**
- * @brief Lock-free ring buffer structure
+ * @brief One cache line of statistics counters
  * 
- * Uses atomic operations for thread-safe access between multiple
- * readers and writers. Memory is allocated via mmap for efficient
- * virtual memory management.
+ * Each thread updates a single shard, so counting on the hot path is an
+ * uncontended relaxed add rather than a shared read-modify-write.
  */
 typedef struct {
-    /* Memory mapped buffer */
-    void *buffer;
-    size_t size;
-    int fd;  /* File descriptor for mmap */
-    
-    /* Lock-free atomic positions */
-    atomic_size_t write_pos;    /* Next write position */
-    atomic_size_t read_pos;     /* Next read position */
-    atomic_size_t commit_pos;   /* Last committed write position */
-    
-    /* Buffer state flags */
-    atomic_bool is_full;
-    atomic_bool backpressure;
-    
-    /* Statistics (atomic for thread safety) */
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
     atomic_uint_fast64_t messages_written;
     atomic_uint_fast64_t messages_read;
     atomic_uint_fast64_t bytes_written;
@@ -107,9 +268,146 @@ typedef struct {
     atomic_uint_fast64_t write_errors;
     atomic_uint_fast64_t read_errors;
     atomic_uint_fast64_t backpressure_events;
+    atomic_uint_fast64_t backpressure_exits;
+    atomic_uint_fast64_t messages_shed;
+} ring_buffer_stats_shard_t;
+
+/**
+ * @brief One entry of the sparse time index
+ * 
+ * Describes the message holding the first byte of an index interval.
+ * bucket is the interval number plus one, and 0 while the entry is
+ * being rewritten, so readers can tell a torn or reused entry.
+ */
+typedef struct {
+    atomic_uint_fast64_t bucket;
+    atomic_uint_fast64_t pos;        /* Position of the message header */
+    atomic_uint_fast64_t timestamp;  /* Its header timestamp */
+} ring_buffer_index_entry_t;
+
+/**
+ * @brief One registered reader, on its own cache line
+ * 
+ * owner is generation << 2 | state, where the state is free (0), active
+ * (1) or evicted (2). The generation changes on every registration, so a
+ * handle can tell its slot was taken from it.
+ */
+typedef struct {
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
+    atomic_uint_fast64_t owner;
+    atomic_size_t pos;          /* Released up to; writers may not reuse space past it */
+    atomic_uint flags;          /* RING_BUFFER_READER_* */
+} ring_buffer_reader_slot_t;
+
+/**
+ * @brief Shared ring buffer state
+ * 
+ * Stored at the start of every buffer mapping, in front of the data
+ * region. For buffers created with ring_buffer_create_shared() this is
+ * the file header, visible to every process that opens the file, so the
+ * layout is fixed and versioned.
+ * 
+ * Fields are grouped by writer, each group on its own cache line, so
+ * producer CASes, commit stores, consumer stores and statistics updates
+ * don't invalidate each other's lines. Each side keeps a cached copy of
+ * the cursor it depends on and only reloads the other side's line when
+ * the cached value says it is out of space or out of data.
+ * 
+ * Positions increase monotonically and are masked with (size - 1) to
+ * get a buffer offset.
+ */
+typedef struct {
+    /* File identification and configuration (read-mostly) */
+    uint32_t magic;             /* RING_BUFFER_CONTROL_MAGIC once initialized */
+    uint32_t version;           /* RING_BUFFER_CONTROL_VERSION */
+    uint32_t control_size;      /* Bytes in front of the data region */
+    uint32_t flags;             /* RING_BUFFER_FLAG_* of the creator */
+    uint64_t size;              /* Data region size in bytes (power of 2) */
+    uint32_t index_shift;       /* log2 of the bytes between time index entries */
+    uint64_t initial_capacity;  /* Capacity an elastic buffer starts at and shrinks back to */
+    atomic_size_t high_watermark;   /* Bytes in use that turn backpressure on */
+    atomic_size_t low_watermark;    /* Bytes in use that turn it off again */
+    
+    /* CPU counter to wall clock conversion shared by every handle, so all
+     * processes stamp consistently: ns = anchor_ns + (ticks - anchor_ticks)
+     * * mult >> 32. Guarded by a seqlock; mult is 0 until calibrated. */
+    atomic_uint clock_seq;
+    atomic_uint_fast64_t clock_anchor_ticks;
+    atomic_uint_fast64_t clock_anchor_ns;
+    atomic_uint_fast64_t clock_mult;
+    
+    /* Producer line */
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
+    atomic_size_t write_pos;        /* Next write position (reserved up to) */
+    atomic_size_t cached_read_pos;  /* Producers' last view of read_pos (never ahead of it) */
+    atomic_bool is_full;
+    atomic_bool backpressure;
+    atomic_size_t capacity;         /* Bytes writers may have in use; below size only while elastic and small */
+    atomic_size_t trim_skip;        /* Padding placed by a running ring_buffer_trim(), not counted against capacity */
+    
+    /* Publication line: stored by committing producers, polled by consumers */
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
+    atomic_size_t commit_pos;       /* Published up to; advances in reservation order */
+    
+    /* Consumer line */
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
+    atomic_size_t read_pos;         /* Next read position */
+    atomic_size_t cached_commit_pos;  /* Consumers' last view of commit_pos (never ahead of it) */
+    atomic_bool trimming;           /* Held by the one ring_buffer_trim() allowed at a time */
+    atomic_bool shared_reads;       /* Set once anything consumes through read_pos */
+    
+    /* Wait/notify line: futex words, bumped only when someone is parked */
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
+    atomic_uint readable_seq;       /* Bumped by commits while readers wait */
+    atomic_uint readable_waiters;   /* Threads parked in ring_buffer_wait_readable() */
+    atomic_uint writable_seq;       /* Bumped by reads while writers wait */
+    atomic_uint writable_waiters;   /* Threads parked in ring_buffer_wait_writable() */
+    
+    /* Statistics, summed over the shards on demand */
+    ring_buffer_stats_shard_t stats[RING_BUFFER_STATS_SHARDS];
+    
+    /* Sparse time index, slot = interval % RING_BUFFER_INDEX_ENTRIES;
+     * written by committing producers, searched by ring_buffer_seek_time() */
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
+    ring_buffer_index_entry_t time_index[RING_BUFFER_INDEX_ENTRIES];
+    
+    /* Registered readers; space is reclaimed at the slowest of them and
+     * read_pos, which follows them until shared_reads is set. Writers only
+     * scan the slots while reader_count is non-zero. */
+    RING_BUFFER_ALIGNAS(RING_BUFFER_CACHE_LINE_SIZE)
+    atomic_uint reader_count;       /* Active slots */
+    ring_buffer_reader_slot_t readers[RING_BUFFER_MAX_READERS];
+} ring_buffer_control_t;
+
+/**
+ * @brief Lock-free ring buffer structure
+ * 
+ * A per-process handle onto a mapping laid out as
+ * [control block][data][mirror, if mirrored]. Uses atomic operations in
+ * the control block for thread-safe access between multiple readers and
+ * writers, which may live in different processes when the buffer is
+ * shared. Memory is allocated via mmap for efficient virtual memory
+ * management.
+ */
+typedef struct {
+    /* Memory mapped buffer */
+    void *buffer;
+    size_t size;
+    size_t mapped_size;  /* Bytes mapped, including control block and mirror (0 if malloc'd) */
+    size_t linear_size;  /* Bytes writable contiguously from buffer (2 * size when mirrored) */
+    int fd;  /* File descriptor for mmap */
+    uint32_t flags;  /* RING_BUFFER_FLAG_* in effect */
+    void *mapping;  /* Start of the mapping */
+    ring_buffer_clock_t clock;  /* Header timestamp source of this handle */
+    int64_t clock_offset_ns;    /* Wall clock minus the coarse clock, where that isn't wall time */
     
-    /* Configuration */
-    double backpressure_threshold;
+    /* Positions, statistics and configuration */
+    ring_buffer_control_t *control;
+    
+    /* Wrapped messages copied for each registered reader and for
+     * ring_buffer_peek_batch() and ring_buffer_recover() (unmirrored only) */
+    uint8_t *reader_wrap[RING_BUFFER_MAX_READERS];
+    uint8_t *peek_wrap;
     
     /* Validation */
     uint32_t magic;
@@ -125,6 +423,109 @@ typedef struct {
     size_t data_size;
 } ring_buffer_message_t;
 
+/**
+ * @brief Ring buffer creation options
+ * 
+ * Zero-initialize and set only the fields you need; zero values select
+ * the defaults used by ring_buffer_create().
+ * 
+ * The watermarks must satisfy 0 < low <= high <= 1 or creation fails.
+ * An unset low watermark keeps the default ratio to the high one. To
+ * hold backpressure until the buffer is empty, create the buffer and
+ * call ring_buffer_set_watermarks(rb, high, 0).
+ */
+typedef struct {
+    size_t size;        /* Buffer size in bytes, rounded up to a power of 2 (0 = default) */
+    uint32_t flags;     /* RING_BUFFER_FLAG_* */
+    double high_watermark;  /* Fraction in use that turns backpressure on (0 = default) */
+    double low_watermark;   /* Fraction in use that turns it off again (0 = scaled from high) */
+    size_t initial_size;    /* Starting capacity with RING_BUFFER_FLAG_ELASTIC (0 = default) */
+} ring_buffer_config_t;
+
+/**
+ * @brief Contiguous piece of a reserved region
+ */
+typedef struct {
+    void *data;
+    size_t size;
+} ring_buffer_segment_t;
+
+/**
+ * @brief Writable region returned by ring_buffer_reserve()
+ * 
+ * The payload is split into two segments when the reservation wraps
+ * around the end of the buffer; otherwise segments[1].size is 0.
+ * Producers serialize directly into the segments and then publish
+ * the message with ring_buffer_commit(). Setting timestamp before the
+ * commit stamps the message with the caller's own time, such as when
+ * the event was captured, and saves the clock read.
+ */
+typedef struct {
+    ring_buffer_segment_t segments[2];
+    size_t length;          /* Total payload bytes reserved */
+    uint64_t timestamp;     /* Header stamp in ns since the epoch; 0 reads the handle's clock at commit */
+    
+    /* Internal bookkeeping - do not modify */
+    size_t start_pos;       /* Position of the message header */
+    size_t end_pos;         /* Position following the message */
+} ring_buffer_span_t;
+
+/**
+ * @brief Read position of a consumer that releases messages later
+ * 
+ * Zero-initialize before the first ring_buffer_peek_batch(). Messages
+ * peeked through the cursor stay in the buffer, and their views stay
+ * valid, until ring_buffer_release() consumes them.
+ */
+typedef struct {
+    size_t pos;             /* Position after the last message peeked */
+    uint64_t messages;      /* Messages peeked since the last release */
+    uint64_t bytes;         /* Payload bytes peeked since the last release */
+} ring_buffer_cursor_t;
+
+/**
+ * @brief Handle of a registered reader
+ * 
+ * Filled by ring_buffer_reader_open(); each reader sees every message
+ * committed after its start, independently of the others and of
+ * consumers using ring_buffer_read().
+ */
+typedef struct {
+    uint32_t slot;              /* Index in the control block's reader table */
+    uint64_t owner;             /* Slot owner word while this handle holds it */
+    ring_buffer_cursor_t cursor;  /* Peeked up to; released up to is kept in the slot */
+} ring_buffer_reader_t;
+
+/**
+ * @brief Producer-side accumulator of small records
+ * 
+ * Initialize with ring_buffer_slab_init(). A slab belongs to one producer
+ * thread; records appended to it reach the ring only when it fills up or
+ * is flushed, so flush it whenever its records must become visible.
+ */
+typedef struct {
+    ring_buffer_priority_t priority;  /* Admission priority of the slab's message */
+    uint32_t count;                   /* Records collected */
+    size_t length;                    /* Bytes of data in use */
+    uint64_t first_timestamp;         /* Timestamp of the first record, stamped into the header */
+    uint64_t last_timestamp;          /* Timestamp the next record's delta is taken from */
+    uint8_t data[RING_BUFFER_SLAB_CAPACITY];
+} ring_buffer_slab_t;
+
+/**
+ * @brief Position within the records of a message
+ * 
+ * Set up by ring_buffer_slab_iter_init() and advanced by
+ * ring_buffer_slab_next(); it points into the message's view and is only
+ * valid as long as the message is.
+ */
+typedef struct {
+    const uint8_t *pos;     /* Next record */
+    const uint8_t *end;     /* End of the payload */
+    uint64_t timestamp;     /* Timestamp of the previous record */
+    bool slab;              /* False if the message is a single plain record */
+} ring_buffer_slab_iter_t;
+
 /* Function declarations */
 
 /**
@@ -135,9 +536,132 @@ typedef struct {
  */
 ring_buffer_t *ring_buffer_create(size_t size);
 
+/**
+ * @brief Create a new ring buffer with explicit options
+ * 
+ * With RING_BUFFER_FLAG_MIRRORED the data pages are mapped twice, back to
+ * back, so every message is contiguous in virtual memory: reservations
+ * always have a single segment and reads never copy. The size is rounded
+ * up to at least one page. If the platform cannot provide the mirrored
+ * mapping, a regular buffer is created and the flag is cleared in
+ * rb->flags.
+ * 
+ * The memory options trade startup time and resident memory for a
+ * buffer that never takes a page fault or a TLB miss per 4 KB page:
+ * 
+ * - RING_BUFFER_FLAG_HUGE_PAGES first tries the explicit huge page pool
+ *   (MAP_HUGETLB on Linux, superpages on macOS), then falls back to
+ *   regular pages advised with MADV_HUGEPAGE, aligned for transparent
+ *   huge pages.
+ * - RING_BUFFER_FLAG_PREFAULT faults in every page at creation, so the
+ *   first lap around the buffer has no page-fault latency.
+ * - RING_BUFFER_FLAG_LOCKED locks the pages in memory, subject to
+ *   RLIMIT_MEMLOCK.
+ * 
+ * Each is best effort: options that could not be applied are cleared in
+ * rb->flags, as is MIRRORED.
+ * 
+ * With RING_BUFFER_FLAG_ELASTIC the size is a maximum: address space for
+ * all of it is mapped up front, but writers may only have the capacity
+ * in use, which starts at initial_size. A write that doesn't fit doubles
+ * the capacity instead of failing, up to the size, and the watermarks
+ * still apply to the size, so backpressure only sets in near the
+ * maximum. Pages are only backed by memory once written;
+ * ring_buffer_trim() shrinks the capacity again and releases the pages
+ * the buffer is not using.
+ * 
+ * RING_BUFFER_FLAG_SINGLE_PRODUCER and RING_BUFFER_FLAG_SINGLE_CONSUMER
+ * promise that writes, respectively reads and releases, never run
+ * concurrently, in any process. Reservations and claims are then a plain
+ * store instead of a compare-and-swap. Like ELASTIC they are kept in the
+ * control block and apply to every handle. An elastic single-producer
+ * buffer still shrinks its capacity, but ring_buffer_trim() leaves its
+ * pages alone.
+ * 
+ * RING_BUFFER_FLAG_TRUSTED is for same-process handoff, where the payload
+ * never leaves memory the reader trusts: writers still checksum every
+ * message, but reads through the handle accept it without verifying.
+ * 
+ * RING_BUFFER_FLAG_NO_STATS, also per handle, skips the statistics
+ * counters on every path through the handle; ring_buffer_get_stats()
+ * then only reflects the other handles.
+ * 
+ * @param config Creation options
+ * @return Pointer to ring buffer or NULL on error
+ */
+ring_buffer_t *ring_buffer_create_ex(const ring_buffer_config_t *config);
+
+/**
+ * @brief Create a ring buffer backed by a file other processes can open
+ * 
+ * The file holds the control block followed by the data region and is
+ * truncated if it already exists. Any process may then attach with
+ * ring_buffer_open_shared(). The size is rounded up to at least one page.
+ * 
+ * @param path Backing file, e.g. on /dev/shm or tmpfs
+ * @param config Creation options
+ * @return Pointer to ring buffer or NULL on error
+ */
+ring_buffer_t *ring_buffer_create_shared(const char *path, const ring_buffer_config_t *config);
+
+/**
+ * @brief Attach to a shared ring buffer created by another process
+ * 
+ * Maps the file and validates its control block. Every handle on the
+ * file shares positions and statistics, so producers and consumers can
+ * live in different processes. Mirroring is chosen per handle and
+ * falls back to a regular mapping if unavailable.
+ * 
+ * @param path Backing file passed to ring_buffer_create_shared()
+ * @param flags RING_BUFFER_FLAG_MIRRORED, TRUSTED, NO_STATS and the memory options
+ *              of ring_buffer_create_ex(), for this handle
+ * @return Pointer to ring buffer or NULL if the file is missing or invalid
+ */
+ring_buffer_t *ring_buffer_open_shared(const char *path, uint32_t flags);
+
+/**
+ * @brief Rebuild the positions of a shared buffer after a crash
+ * 
+ * A process that dies mid-write leaves a reservation that is never
+ * committed, which stalls every later commit. This rescans the records
+ * from read_pos, checking the header magic and checksum of each, and
+ * carries on past commit_pos through the records later writers finished
+ * but could not publish. Reservations that were never committed become
+ * padding, and commit_pos and write_pos are set to the end of the last
+ * record that verifies. Anything after a corrupt published record, or
+ * after a reservation whose writer died before labelling it, is
+ * discarded. No other thread or process may use the buffer while this
+ * runs.
+ * 
+ * @param rb Ring buffer, typically just reopened with ring_buffer_open_shared()
+ * @param last Optional output for the newest recovered message (NULL to skip)
+ * @return Number of messages left to read, or a negative ring_buffer_error_t
+ */
+int ring_buffer_recover(ring_buffer_t *rb, ring_buffer_message_t *last);
+
+/**
+ * @brief Copy newly committed records to a replica
+ * 
+ * Copies the committed bytes past *cursor straight from the source
+ * mapping into the replica at the same offsets, then publishes them in
+ * the replica, whose read position follows the source's. Records the
+ * source consumer already recycled are skipped. A single thread must own
+ * the replica; the source may be in use by any number of producers and
+ * consumers, and is not modified.
+ * 
+ * @param source Buffer to copy from
+ * @param replica Buffer of the same size that receives the copy
+ * @param cursor Source position replicated up to; start at 0, updated on success
+ * @return RING_BUFFER_SUCCESS or error code
+ */
+ring_buffer_error_t ring_buffer_replicate(ring_buffer_t *source, ring_buffer_t *replica, size_t *cursor);
+
 /**
  * @brief Destroy a ring buffer and free resources
  * 
+ * For shared buffers only this handle is released; the backing file
+ * is left in place for other processes.
+ * 
  * @param rb Ring buffer to destroy
  */
 void ring_buffer_destroy(ring_buffer_t *rb);
@@ -146,8 +670,8 @@ void ring_buffer_destroy(ring_buffer_t *rb);
  * @brief Write an Arrow IPC message to the buffer
  * 
  * This function is lock-free and thread-safe. It will return
- * RING_BUFFER_ERROR_BACKPRESSURE if the buffer is at the
- * backpressure threshold.
+ * RING_BUFFER_ERROR_BACKPRESSURE while the buffer is in backpressure
+ * (see ring_buffer_priority_t).
  * 
  * @param rb Ring buffer
  * @param data Message data
@@ -156,12 +680,100 @@ void ring_buffer_destroy(ring_buffer_t *rb);
  */
 ring_buffer_error_t ring_buffer_write(ring_buffer_t *rb, const void *data, size_t size);
 
+/**
+ * @brief Write a message with an explicit admission priority
+ * 
+ * Same as ring_buffer_write(), which uses RING_BUFFER_PRIORITY_NORMAL.
+ * 
+ * @param rb Ring buffer
+ * @param data Message data
+ * @param size Message size in bytes
+ * @param priority Admission priority under backpressure
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_write_priority(ring_buffer_t *rb, const void *data, size_t size,
+                                               ring_buffer_priority_t priority);
+
+/**
+ * @brief Reserve space for a message of the given size
+ * 
+ * Hands back a writable region inside the buffer so that producers can
+ * serialize straight into mapped memory instead of into a scratch buffer.
+ * The reservation must be finished with either ring_buffer_commit() or
+ * ring_buffer_abort(). Backpressure and size limits are applied exactly
+ * as in ring_buffer_write().
+ * 
+ * Reservations are published in the order they were made, so a producer
+ * that holds a reservation for a long time delays the commits of every
+ * producer that reserved after it.
+ * 
+ * @param rb Ring buffer
+ * @param size Payload size in bytes
+ * @param span Output span describing the reserved region
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_reserve(ring_buffer_t *rb, size_t size, ring_buffer_span_t *span);
+
+/**
+ * @brief Reserve space for a message with an explicit admission priority
+ * 
+ * Same as ring_buffer_reserve(), which uses RING_BUFFER_PRIORITY_NORMAL.
+ * 
+ * @param rb Ring buffer
+ * @param size Payload size in bytes
+ * @param priority Admission priority under backpressure
+ * @param span Output span describing the reserved region
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_reserve_priority(ring_buffer_t *rb, size_t size,
+                                                 ring_buffer_priority_t priority,
+                                                 ring_buffer_span_t *span);
+
+/**
+ * @brief Publish a message previously reserved with ring_buffer_reserve()
+ * 
+ * Computes the checksum over the reserved payload, writes the message
+ * header and makes the message visible to readers. If earlier
+ * reservations are still being filled, this waits until they have been
+ * committed or aborted.
+ * 
+ * @param rb Ring buffer
+ * @param span Span returned by ring_buffer_reserve()
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_commit(ring_buffer_t *rb, ring_buffer_span_t *span);
+
+/**
+ * @brief Give up a reservation without publishing a message
+ * 
+ * The reserved region is turned into a padding record that readers skip.
+ * 
+ * @param rb Ring buffer
+ * @param span Span returned by ring_buffer_reserve()
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_abort(ring_buffer_t *rb, ring_buffer_span_t *span);
+
+/**
+ * @brief Copy bytes into a reserved span, handling the wrap split
+ * 
+ * @param span Span returned by ring_buffer_reserve()
+ * @param offset Payload offset to start writing at
+ * @param data Source data
+ * @param size Number of bytes to copy
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_span_copy(ring_buffer_span_t *span, size_t offset,
+                                          const void *data, size_t size);
+
 /**
  * @brief Read an Arrow IPC message from the buffer
  * 
  * This function is lock-free and thread-safe. The returned message
  * points to memory within the buffer and is valid until the next
- * read operation or until the buffer wraps around.
+ * read operation or until the buffer wraps around. A message that wraps
+ * around the end of an unmirrored buffer is copied into per-thread
+ * storage instead, which the thread's next read or peek reuses.
  * 
  * @param rb Ring buffer
  * @param msg Output message structure
@@ -169,6 +781,392 @@ ring_buffer_error_t ring_buffer_write(ring_buffer_t *rb, const void *data, size_
  */
 ring_buffer_error_t ring_buffer_read(ring_buffer_t *rb, ring_buffer_message_t *msg);
 
+/**
+ * @brief Write a message, compressing the payload first
+ * 
+ * The payload is compressed into a per-thread scratch buffer and only
+ * the compressed bytes are reserved and copied into the ring, so
+ * compressible data such as screen frames takes a fraction of the space.
+ * Payloads that don't shrink are stored uncompressed. Readers get the
+ * original bytes back with ring_buffer_decode().
+ * 
+ * @param rb Ring buffer
+ * @param data Message data
+ * @param size Uncompressed size in bytes, at most RING_BUFFER_MAX_MESSAGE_SIZE
+ * @param codec Compression codec
+ * @param priority Admission priority under backpressure
+ * @return RING_BUFFER_SUCCESS on success, RING_BUFFER_ERROR_UNSUPPORTED if
+ *         the codec isn't compiled in, other error code on failure
+ */
+ring_buffer_error_t ring_buffer_write_compressed(ring_buffer_t *rb, const void *data, size_t size,
+                                                 ring_buffer_codec_t codec,
+                                                 ring_buffer_priority_t priority);
+
+/**
+ * @brief Write several messages with a single reservation and commit
+ * 
+ * Each iovec entry becomes one message. Space for the whole batch is
+ * reserved at once and published at once, so the validation, admission
+ * and statistics costs are paid once per batch instead of per message;
+ * all messages share one timestamp from the handle's clock. The batch
+ * is all-or-nothing: if it does not fit, nothing is written.
+ * 
+ * @param rb Ring buffer
+ * @param iov Message payloads
+ * @param count Number of entries in iov
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_write_batch(ring_buffer_t *rb, const struct iovec *iov, size_t count);
+
+/**
+ * @brief Read up to max messages in one call
+ * 
+ * Fills msgs with zero-copy views of consecutive messages and advances
+ * the read position once for all of them. The views follow the same
+ * lifetime rules as ring_buffer_read().
+ * 
+ * @param rb Ring buffer
+ * @param msgs Output message array
+ * @param max Capacity of msgs
+ * @return Number of messages read (0 if empty), or a negative
+ *         ring_buffer_error_t on failure
+ */
+int ring_buffer_read_batch(ring_buffer_t *rb, ring_buffer_message_t *msgs, size_t max);
+
+/**
+ * @brief Look at the next message without consuming it
+ * 
+ * The message stays in the buffer, so msg->data remains valid until the
+ * message is consumed, or for a wrapped message copied as in
+ * ring_buffer_read() until the thread's next read or peek. With several
+ * consumers another thread may take the message first; the following
+ * read then returns a later one.
+ * 
+ * @param rb Ring buffer
+ * @param msg Output message structure
+ * @return RING_BUFFER_SUCCESS on success, RING_BUFFER_ERROR_EMPTY if none
+ */
+ring_buffer_error_t ring_buffer_peek(ring_buffer_t *rb, ring_buffer_message_t *msg);
+
+/**
+ * @brief Look at the next messages past a cursor without consuming them
+ * 
+ * Continues where the previous call on the same cursor stopped, so a
+ * consumer can walk the whole backlog in batches while the read position
+ * stays put. Producers cannot reuse the space until the messages are
+ * released, which lets the caller make them durable elsewhere first.
+ * Meant for a single consumer; if another one consumes past the cursor,
+ * the cursor restarts at the read position.
+ * 
+ * @param rb Ring buffer
+ * @param cursor Consumer cursor, advanced past the returned messages
+ * @param msgs Output message array
+ * @param max Capacity of msgs
+ * @return Number of messages peeked (0 if caught up), or a negative
+ *         ring_buffer_error_t on failure
+ */
+int ring_buffer_peek_batch(ring_buffer_t *rb, ring_buffer_cursor_t *cursor,
+                           ring_buffer_message_t *msgs, size_t max);
+
+/**
+ * @brief Consume every message peeked through a cursor
+ * 
+ * Advances the read position to the cursor, waking blocked writers, and
+ * counts the messages as read. Views returned by the peeks are invalid
+ * afterwards.
+ * 
+ * @param rb Ring buffer
+ * @param cursor Cursor passed to ring_buffer_peek_batch()
+ * @return RING_BUFFER_SUCCESS or error code
+ */
+ring_buffer_error_t ring_buffer_release(ring_buffer_t *rb, ring_buffer_cursor_t *cursor);
+
+/**
+ * @brief Point a cursor at the first message stamped at or after a time
+ * 
+ * Nothing is consumed. Committed messages are indexed every
+ * max(64 KB, size / RING_BUFFER_INDEX_ENTRIES) bytes, so the seek is a
+ * binary search over the index and a scan of at most one interval; for
+ * "the last 30 seconds" pass ring_buffer_now(rb) - 30000000000. Then
+ * read onwards with ring_buffer_peek_batch(). Releasing the cursor
+ * consumes everything before it too, including the messages skipped.
+ * 
+ * Timestamps are assumed to grow with position. Concurrent producers
+ * stamp before their in-order publication, so a message stamped a little
+ * earlier than the target may still follow the cursor. Messages brought
+ * in by ring_buffer_replicate() are not indexed and are scanned from the
+ * read position.
+ * 
+ * @param rb Ring buffer
+ * @param timestamp Target time in nanoseconds since the epoch
+ * @param cursor Cursor to position; its peek counts are reset
+ * @return RING_BUFFER_SUCCESS, RING_BUFFER_ERROR_EMPTY if no committed
+ *         message is that recent (the cursor then sits after the last
+ *         one), or error code
+ */
+ring_buffer_error_t ring_buffer_seek_time(ring_buffer_t *rb, uint64_t timestamp, ring_buffer_cursor_t *cursor);
+
+/**
+ * @brief Register an independent reader
+ * 
+ * Fans one copy of the data out to several consumers: every registered
+ * reader walks all messages at its own pace, and writers only reuse
+ * space once the slowest reader and ring_buffer_read()'s shared read
+ * position have both moved past it. Readers are kept in the control
+ * block, so they work across processes on a shared buffer.
+ * 
+ * The shared read position only counts once something has used it with
+ * ring_buffer_read(), ring_buffer_read_batch(), ring_buffer_peek() or
+ * ring_buffer_peek_batch(). Until then, writers that run short of space
+ * move it up to the slowest reader, so a buffer served only by
+ * registered readers isn't held at its oldest message. A consumer that
+ * starts late may find the oldest messages already gone.
+ * 
+ * A reader opened with RING_BUFFER_READER_EVICTABLE that falls behind
+ * everyone else is evicted when it would otherwise make a write fail or
+ * turn on backpressure; its next call returns RING_BUFFER_ERROR_EVICTED
+ * and it has to close and reopen. Other readers hold up writers just
+ * like the shared read position does, including after a crash, so only
+ * critical, well-behaved consumers should be registered without it.
+ * 
+ * @param rb Ring buffer
+ * @param flags RING_BUFFER_READER_* options
+ * @param reader Handle to fill
+ * @return RING_BUFFER_SUCCESS, RING_BUFFER_ERROR_FULL if all
+ *         RING_BUFFER_MAX_READERS slots are taken, or error code
+ */
+ring_buffer_error_t ring_buffer_reader_open(ring_buffer_t *rb, uint32_t flags, ring_buffer_reader_t *reader);
+
+/**
+ * @brief Look at a reader's next messages
+ * 
+ * Like ring_buffer_peek_batch() on the reader's own position; the views
+ * stay valid until ring_buffer_reader_release(), unless the reader is
+ * evicted.
+ * 
+ * @param rb Ring buffer
+ * @param reader Registered reader
+ * @param msgs Output message array
+ * @param max Capacity of msgs
+ * @return Number of messages peeked (0 if caught up),
+ *         RING_BUFFER_ERROR_EVICTED, or another negative error code
+ */
+int ring_buffer_reader_peek(ring_buffer_t *rb, ring_buffer_reader_t *reader,
+                            ring_buffer_message_t *msgs, size_t max);
+
+/**
+ * @brief Let writers reuse the space a reader has peeked through
+ * 
+ * @param rb Ring buffer
+ * @param reader Registered reader
+ * @return RING_BUFFER_SUCCESS, RING_BUFFER_ERROR_EVICTED, or error code
+ */
+ring_buffer_error_t ring_buffer_reader_release(ring_buffer_t *rb, ring_buffer_reader_t *reader);
+
+/**
+ * @brief Unregister a reader, evicted or not, and free its slot
+ * 
+ * @param rb Ring buffer
+ * @param reader Registered reader
+ * @return RING_BUFFER_SUCCESS or error code
+ */
+ring_buffer_error_t ring_buffer_reader_close(ring_buffer_t *rb, ring_buffer_reader_t *reader);
+
+/**
+ * @brief Uncompressed payload size of a message
+ * 
+ * @param msg Message returned by a read or peek
+ * @return Bytes ring_buffer_decode() produces, or 0 if the message is malformed
+ */
+size_t ring_buffer_decoded_size(const ring_buffer_message_t *msg);
+
+/**
+ * @brief Get the original payload of a message, decompressing if needed
+ * 
+ * Uncompressed messages are returned as-is without touching the arena,
+ * so *data is the zero-copy view in the buffer. Compressed ones are
+ * decompressed into the caller's arena, which must hold at least
+ * ring_buffer_decoded_size() bytes and can be reused for every message.
+ * 
+ * @param msg Message returned by a read or peek
+ * @param arena Caller-owned output buffer (may be NULL for uncompressed messages)
+ * @param arena_size Capacity of arena in bytes
+ * @param data Output pointer to the payload
+ * @param size Output payload size
+ * @return RING_BUFFER_SUCCESS, RING_BUFFER_ERROR_TOO_LARGE if the arena is
+ *         too small, RING_BUFFER_ERROR_UNSUPPORTED if the codec isn't compiled
+ *         in, or RING_BUFFER_ERROR_CORRUPTED if the payload doesn't decompress
+ */
+ring_buffer_error_t ring_buffer_decode(const ring_buffer_message_t *msg, void *arena, size_t arena_size,
+                                       const void **data, size_t *size);
+
+/**
+ * @brief Check whether a codec is compiled into this build
+ * 
+ * @param codec Compression codec
+ * @return true if ring_buffer_write_compressed() and ring_buffer_decode() support it
+ */
+bool ring_buffer_codec_supported(ring_buffer_codec_t codec);
+
+/**
+ * @brief Prepare an empty slab
+ * 
+ * @param slab Slab to initialize
+ * @param priority Admission priority of the messages it is written out as
+ */
+void ring_buffer_slab_init(ring_buffer_slab_t *slab, ring_buffer_priority_t priority);
+
+/**
+ * @brief Add a small record to a slab
+ * 
+ * The record costs a few bytes of framing instead of a message header,
+ * alignment padding and a checksum of its own. If it doesn't fit in the
+ * space left, the slab is flushed first; should that fail, the error is
+ * returned and both the slab and the record are left as they were.
+ * 
+ * @param rb Ring buffer the slab is flushed to
+ * @param slab Slab to add to
+ * @param data Record bytes
+ * @param size Record size, at most RING_BUFFER_SLAB_CAPACITY - RING_BUFFER_SLAB_RECORD_OVERHEAD
+ * @param timestamp Record time in ns since the epoch; 0 reads the handle's clock
+ * @return RING_BUFFER_SUCCESS on success, RING_BUFFER_ERROR_TOO_LARGE if the
+ *         record can never fit a slab, other error code if a flush failed
+ */
+ring_buffer_error_t ring_buffer_slab_append(ring_buffer_t *rb, ring_buffer_slab_t *slab,
+                                            const void *data, size_t size, uint64_t timestamp);
+
+/**
+ * @brief Write a slab's records to the ring as one message and empty it
+ * 
+ * Statistics count the slab as a single message. Flushing an empty slab
+ * does nothing. On failure the slab keeps its records, so the flush can
+ * be retried.
+ * 
+ * @param rb Ring buffer
+ * @param slab Slab to flush
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_slab_flush(ring_buffer_t *rb, ring_buffer_slab_t *slab);
+
+/**
+ * @brief Start walking the records of a message
+ * 
+ * A message that is not a slab is treated as a single record holding its
+ * payload as stored, so readers can walk every message the same way.
+ * 
+ * @param iter Iterator to set up
+ * @param msg Message returned by a read or peek
+ * @return RING_BUFFER_SUCCESS on success, error code on failure
+ */
+ring_buffer_error_t ring_buffer_slab_iter_init(ring_buffer_slab_iter_t *iter, const ring_buffer_message_t *msg);
+
+/**
+ * @brief Get the next record of a message
+ * 
+ * Slabs are checksummed as a whole when read, so a malformed record means
+ * the slab was read through a trusted handle or written by a broken producer.
+ * 
+ * @param iter Iterator from ring_buffer_slab_iter_init()
+ * @param data Output pointer to the record bytes, a view into the message
+ * @param size Output record size
+ * @param timestamp Output record time in ns since the epoch
+ * @return RING_BUFFER_SUCCESS on success, RING_BUFFER_ERROR_EMPTY after the
+ *         last record, RING_BUFFER_ERROR_CORRUPTED if the framing is malformed
+ */
+ring_buffer_error_t ring_buffer_slab_next(ring_buffer_slab_iter_t *iter, const void **data,
+                                          size_t *size, uint64_t *timestamp);
+
+/**
+ * @brief Wait until messages are available to read
+ * 
+ * Spins briefly, then sleeps in the kernel (futex on Linux, __ulock on
+ * macOS) until a producer commits. Producers only make the wake syscall
+ * while a waiter is parked, so an idle consumer costs no CPU and a busy
+ * one never enters the kernel.
+ * 
+ * @param rb Ring buffer
+ * @param min_bytes Published bytes to wait for, including headers (0 = any message)
+ * @param timeout_ns Maximum wait in nanoseconds (0 = poll, negative = forever)
+ * @return RING_BUFFER_SUCCESS when readable, RING_BUFFER_ERROR_TIMEOUT otherwise
+ */
+ring_buffer_error_t ring_buffer_wait_readable(ring_buffer_t *rb, size_t min_bytes, int64_t timeout_ns);
+
+/**
+ * @brief Wait until a write of min_bytes would be admitted
+ * 
+ * Returns once at least min_bytes of buffer space are free and the buffer
+ * is below its backpressure threshold. Wakes are driven by consumers in
+ * the same way as ring_buffer_wait_readable().
+ * 
+ * @param rb Ring buffer
+ * @param min_bytes Free bytes to wait for, including headers
+ * @param timeout_ns Maximum wait in nanoseconds (0 = poll, negative = forever)
+ * @return RING_BUFFER_SUCCESS when writable, RING_BUFFER_ERROR_TIMEOUT otherwise
+ */
+ring_buffer_error_t ring_buffer_wait_writable(ring_buffer_t *rb, size_t min_bytes, int64_t timeout_ns);
+
+/**
+ * @brief Choose where this handle's header timestamps come from
+ * 
+ * The first handle to select RING_BUFFER_CLOCK_COUNTER calibrates the
+ * counter against CLOCK_REALTIME, which spins for about a millisecond
+ * on x86, and stores the anchor in the control block; other handles and
+ * processes reuse it. Counter stamps drift from the wall clock at the
+ * rate of the oscillator error (typically some ppm) until
+ * ring_buffer_calibrate_clock() re-anchors them.
+ * 
+ * @param rb Ring buffer
+ * @param clock Timestamp source
+ * @return RING_BUFFER_SUCCESS, or RING_BUFFER_ERROR_UNSUPPORTED if the
+ *         platform has no suitable clock (the handle's clock is unchanged)
+ */
+ring_buffer_error_t ring_buffer_set_clock(ring_buffer_t *rb, ring_buffer_clock_t clock);
+
+/**
+ * @brief Re-anchor the shared counter clock against CLOCK_REALTIME
+ * 
+ * Meant to be called now and then, e.g. from a maintenance timer, by
+ * one process using RING_BUFFER_CLOCK_COUNTER. Writers never wait on it.
+ * 
+ * @param rb Ring buffer
+ * @return RING_BUFFER_SUCCESS, or RING_BUFFER_ERROR_UNSUPPORTED without a counter
+ */
+ring_buffer_error_t ring_buffer_calibrate_clock(ring_buffer_t *rb);
+
+/**
+ * @brief Read the handle's timestamp clock
+ * 
+ * @param rb Ring buffer
+ * @return Nanoseconds since the epoch as the next commit would stamp them
+ */
+uint64_t ring_buffer_now(const ring_buffer_t *rb);
+
+/**
+ * @brief Shrink an elastic buffer and give its idle memory back
+ * 
+ * Meant for the consumer once it has caught up, e.g. after each drain.
+ * The capacity is halved toward the initial size for as long as the
+ * backlog fits in a quarter of it. If the buffer is empty, the pages
+ * outside the new capacity are released, punching a hole in the backing
+ * file where the platform can, so they hold no memory until writers
+ * come around to them again. They are fenced off with padding records
+ * while that happens; a burst of more than the capacity at that moment
+ * is refused as full. Skipped while registered readers are open.
+ * 
+ * @param rb Ring buffer
+ * @return RING_BUFFER_SUCCESS on success, RING_BUFFER_ERROR_UNSUPPORTED if
+ *         the buffer isn't elastic, other error code on failure
+ */
+ring_buffer_error_t ring_buffer_trim(ring_buffer_t *rb);
+
+/**
+ * @brief Get the number of bytes writers may currently have in use
+ * 
+ * @param rb Ring buffer
+ * @return The capacity of an elastic buffer, otherwise its size
+ */
+size_t ring_buffer_capacity(const ring_buffer_t *rb);
+
 /**
  * @brief Get current buffer utilization percentage
  * 
@@ -180,6 +1178,11 @@ double ring_buffer_utilization(const ring_buffer_t *rb);
 /**
  * @brief Get number of available bytes for writing
  * 
+ * Computed from the producers' cached read position, so it may
+ * under-report space freed by very recent reads. The consumer cursor is
+ * reloaded whenever the cached figure is too small for a maximum-size
+ * message.
+ * 
  * @param rb Ring buffer
  * @return Available bytes
  */
@@ -201,9 +1204,23 @@ size_t ring_buffer_available_read(const ring_buffer_t *rb);
  */
 bool ring_buffer_is_backpressure(const ring_buffer_t *rb);
 
+/**
+ * @brief Change the backpressure watermarks of a live buffer
+ * 
+ * @param rb Ring buffer
+ * @param high Fraction in use that turns backpressure on (0 < high <= 1)
+ * @param low Fraction in use that turns it off again (0 <= low <= high)
+ * @return RING_BUFFER_SUCCESS or RING_BUFFER_ERROR_INVALID_PARAM
+ */
+ring_buffer_error_t ring_buffer_set_watermarks(ring_buffer_t *rb, double high, double low);
+
 /**
  * @brief Get buffer statistics
  * 
+ * Sums the per-thread shards, so it costs a few cache misses and is
+ * meant for monitoring rather than the hot path. All counters read as
+ * zero when the library is built with RING_BUFFER_STATS=0.
+ * 
  * @param rb Ring buffer
  * @param stats Output statistics structure
  */
@@ -219,6 +1236,11 @@ void ring_buffer_reset_stats(ring_buffer_t *rb);
 /**
  * @brief Validate buffer integrity
  * 
+ * Checks the handle, the control block and the consistency of the
+ * positions. Reads and writes only check the handle's magic, except in
+ * DEBUG builds, so a long-lived consumer that wants early warning of a
+ * damaged shared file should call this periodically.
+ * 
  * @param rb Ring buffer
  * @return true if valid, false if corrupted
  */
@@ -241,9 +1263,41 @@ const char *ring_buffer_error_string(ring_buffer_error_t error);
  */
 uint32_t ring_buffer_crc32(const void *data, size_t size);
 
+/**
+ * @brief Calculate CRC32C (Castagnoli) checksum
+ * 
+ * Uses the SSE4.2 or ARMv8 CRC instructions when the CPU supports them
+ * and a slice-by-8 table implementation otherwise. The choice is made
+ * once at runtime.
+ * 
+ * @param data Input data
+ * @param size Data size
+ * @return CRC32C checksum
+ */
+uint32_t ring_buffer_crc32c(const void *data, size_t size);
+
+/**
+ * @brief Calculate a checksum with the given algorithm
+ * 
+ * @param algorithm Checksum algorithm, e.g. from RING_BUFFER_HEADER_CHECKSUM()
+ * @param data Input data
+ * @param size Data size
+ * @return Checksum value
+ */
+uint32_t ring_buffer_checksum(ring_buffer_checksum_t algorithm, const void *data, size_t size);
+
+/**
+ * @brief Name of the CRC32C implementation selected at runtime
+ * 
+ * @return "sse4.2", "armv8-crc" or "slice-by-8"
+ */
+const char *ring_buffer_checksum_implementation(void);
+
 /**
  * @brief Get current timestamp in nanoseconds
  * 
+ * Always reads CLOCK_REALTIME; ring_buffer_now() reads a handle's clock.
+ * 
  * @return Timestamp in nanoseconds since epoch
  */
 uint64_t ring_buffer_timestamp(void);
@@ -0,0 +1,295 @@
+/**
+ * @file ring_buffer.hpp
+ * @brief Header-only C++ front end with compile-time buffer policies
+ *
+ * RingBuffer<Policy> is a typed, move-only handle on a ring_buffer_t
+ * whose policy is chosen when the program compiles: capacity, producer
+ * and consumer counts, checksum verification and statistics. The C
+ * library stays the one implementation of the shared format, so C++
+ * tools, the collectors and the packer can all attach to the same
+ * buffer file.
+ *
+ * The policy reaches the library as the buffer's size and flags, and the
+ * library picks its paths from those at run time; nothing is compiled
+ * separately per policy. With one producer a reservation is a plain
+ * store rather than a compare-and-swap, and with one consumer so is a
+ * claim. Trusted handles skip checksum verification and handles without
+ * statistics skip the counters. Policies are checked by static_assert;
+ * a buffer created or attached at run time that doesn't match the
+ * policy leaves the handle empty.
+ */
+
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include "ring_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace chronicle {
+
+/* Producer or consumer count with no limit */
+inline constexpr unsigned many = 0;
+
+/* How reads check the CRC32C every message is written with */
+enum class Checksum {
+    crc32c,     /* Verify each payload */
+    trusted     /* Skip verification; see RING_BUFFER_FLAG_TRUSTED */
+};
+
+/**
+ * @brief Compile-time shape of a ring buffer
+ *
+ * Capacity is the buffer size in bytes, a power of 2. Producers and
+ * Consumers are 1 for a single writer or reader at a time, in any
+ * process, or `many`. Stats exposes the counters and needs a library
+ * built with them; without it the handle doesn't update them at all.
+ */
+template <std::size_t Capacity, unsigned Producers = many, unsigned Consumers = many,
+          Checksum Verify = Checksum::crc32c, bool Stats = RING_BUFFER_STATS != 0>
+struct Policy {
+    static constexpr std::size_t capacity = Capacity;
+    static constexpr unsigned producers = Producers;
+    static constexpr unsigned consumers = Consumers;
+    static constexpr Checksum checksum = Verify;
+    static constexpr bool stats = Stats;
+};
+
+/* One producer and one consumer: no compare-and-swap on either side */
+template <std::size_t Capacity, Checksum Verify = Checksum::crc32c, bool Stats = RING_BUFFER_STATS != 0>
+using SpscPolicy = Policy<Capacity, 1, 1, Verify, Stats>;
+
+/* Any number of producers, one consumer */
+template <std::size_t Capacity, Checksum Verify = Checksum::crc32c, bool Stats = RING_BUFFER_STATS != 0>
+using MpscPolicy = Policy<Capacity, many, 1, Verify, Stats>;
+
+template <class P>
+class RingBuffer {
+public:
+    using policy = P;
+
+    static constexpr std::size_t capacity = P::capacity;
+
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of 2");
+    static_assert(capacity <= SIZE_MAX / 2, "capacity too large");
+    static_assert(!P::stats || RING_BUFFER_STATS, "statistics are compiled out of this build");
+
+    /* Flags that record the policy in the buffer itself */
+    static constexpr uint32_t mode_flags =
+        (P::producers == 1 ? RING_BUFFER_FLAG_SINGLE_PRODUCER : 0u) |
+        (P::consumers == 1 ? RING_BUFFER_FLAG_SINGLE_CONSUMER : 0u);
+
+    /* Per-handle flags the policy asks for */
+    static constexpr uint32_t handle_flags =
+        (P::checksum == Checksum::trusted ? RING_BUFFER_FLAG_TRUSTED : 0u) |
+        (P::stats ? 0u : RING_BUFFER_FLAG_NO_STATS);
+
+    /* Memory options a caller may add at creation; see ring_buffer_create_ex() */
+    static constexpr uint32_t memory_options =
+        RING_BUFFER_FLAG_MIRRORED | RING_BUFFER_FLAG_HUGE_PAGES |
+        RING_BUFFER_FLAG_PREFAULT | RING_BUFFER_FLAG_LOCKED;
+
+    /* Zero-copy reservation, committed or aborted through its buffer */
+    class Span {
+    public:
+        /* Copy size bytes to offset within the reservation */
+        ring_buffer_error_t copy(std::size_t offset, const void *data, std::size_t size) noexcept {
+            return ring_buffer_span_copy(&span_, offset, data, size);
+        }
+
+        /* Payload bytes reserved */
+        std::size_t size() const noexcept { return span_.length; }
+
+        /* The payload as one range, or nullptr if it wraps (never when mirrored) */
+        void *contiguous() const noexcept {
+            return span_.segments[1].size == 0 ? span_.segments[0].data : nullptr;
+        }
+
+        /* Header stamp in ns since the epoch; 0 reads the handle's clock at commit */
+        void set_timestamp(uint64_t timestamp) noexcept { span_.timestamp = timestamp; }
+
+        ring_buffer_span_t *get() noexcept { return &span_; }
+
+    private:
+        ring_buffer_span_t span_{};
+    };
+
+    /* An empty handle */
+    RingBuffer() noexcept = default;
+
+    /**
+     * @brief Create a private buffer of the policy's capacity
+     * @param options Any of memory_options
+     */
+    static RingBuffer create(uint32_t options = 0) noexcept {
+        ring_buffer_config_t config = make_config(options);
+        return RingBuffer(ring_buffer_create_ex(&config));
+    }
+
+    /**
+     * @brief Create a buffer file other processes can attach to
+     * @param path Backing file, truncated if it exists
+     * @param options Any of memory_options
+     */
+    static RingBuffer create_shared(const char *path, uint32_t options = 0) noexcept {
+        ring_buffer_config_t config = make_config(options);
+        return RingBuffer(ring_buffer_create_shared(path, &config));
+    }
+
+    /**
+     * @brief Attach to an existing buffer file
+     *
+     * The buffer must have the policy's capacity, and must not promise a
+     * single producer or consumer where the policy allows several.
+     *
+     * @param path Backing file
+     * @param options Any of memory_options
+     */
+    static RingBuffer open_shared(const char *path, uint32_t options = 0) noexcept {
+        return RingBuffer(ring_buffer_open_shared(path, (options & memory_options) | handle_flags));
+    }
+
+    RingBuffer(RingBuffer &&other) noexcept : rb_(std::exchange(other.rb_, nullptr)) {}
+
+    RingBuffer &operator=(RingBuffer &&other) noexcept {
+        if (this != &other) {
+            reset();
+            rb_ = std::exchange(other.rb_, nullptr);
+        }
+        return *this;
+    }
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    ~RingBuffer() { reset(); }
+
+    explicit operator bool() const noexcept { return rb_ != nullptr; }
+
+    /* The C handle, for the parts of ring_buffer.h not wrapped here */
+    ring_buffer_t *get() const noexcept { return rb_; }
+
+    /* Append one message */
+    ring_buffer_error_t write(const void *data, std::size_t size,
+                              ring_buffer_priority_t priority = RING_BUFFER_PRIORITY_NORMAL) noexcept {
+        return ring_buffer_write_priority(rb_, data, size, priority);
+    }
+
+    /* Append a trivially copyable record as one message */
+    template <class T>
+    ring_buffer_error_t write(const T &record,
+                              ring_buffer_priority_t priority = RING_BUFFER_PRIORITY_NORMAL) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>, "records are copied as bytes");
+        static_assert(!std::is_pointer_v<T>, "pass the pointed-to record, or data and size");
+        return ring_buffer_write_priority(rb_, &record, sizeof(T), priority);
+    }
+
+    /* Append each buffer as its own message, all in one reservation */
+    ring_buffer_error_t write_batch(const struct iovec *iov, std::size_t count) noexcept {
+        return ring_buffer_write_batch(rb_, iov, count);
+    }
+
+    ring_buffer_error_t reserve(std::size_t size, Span &span,
+                                ring_buffer_priority_t priority = RING_BUFFER_PRIORITY_NORMAL) noexcept {
+        return ring_buffer_reserve_priority(rb_, size, priority, span.get());
+    }
+
+    ring_buffer_error_t commit(Span &span) noexcept { return ring_buffer_commit(rb_, span.get()); }
+
+    ring_buffer_error_t abort(Span &span) noexcept { return ring_buffer_abort(rb_, span.get()); }
+
+    /* Consume one message */
+    ring_buffer_error_t read(ring_buffer_message_t &msg) noexcept { return ring_buffer_read(rb_, &msg); }
+
+    /* Consume up to N messages; returns the count or a negative error */
+    template <std::size_t N>
+    int read_batch(ring_buffer_message_t (&msgs)[N]) noexcept {
+        static_assert(N > 0, "empty batch");
+        return ring_buffer_read_batch(rb_, msgs, N);
+    }
+
+    /**
+     * @brief Hand every readable message to fn, in batches of Batch, then consume them
+     *
+     * The views passed to fn point into the buffer and stay valid until
+     * the batch is released, after fn has seen all of it.
+     *
+     * @return Messages consumed, or a negative ring_buffer_error_t
+     */
+    template <std::size_t Batch = 64, class F>
+    int drain(F &&fn) {
+        static_assert(Batch > 0, "empty batch");
+        static_assert(std::is_invocable_v<F &, const ring_buffer_message_t &>,
+                      "fn takes a const ring_buffer_message_t &");
+
+        ring_buffer_message_t msgs[Batch];
+        ring_buffer_cursor_t cursor{};
+        int total = 0;
+        for (;;) {
+            int count = ring_buffer_peek_batch(rb_, &cursor, msgs, Batch);
+            if (count <= 0) {
+                return count < 0 ? count : total;
+            }
+            for (int i = 0; i < count; i++) {
+                fn(std::as_const(msgs[i]));
+            }
+            ring_buffer_error_t released = ring_buffer_release(rb_, &cursor);
+            if (released != RING_BUFFER_SUCCESS) {
+                return released;
+            }
+            total += count;
+        }
+    }
+
+    std::size_t available_read() const noexcept { return ring_buffer_available_read(rb_); }
+
+    std::size_t available_write() const noexcept { return ring_buffer_available_write(rb_); }
+
+    double utilization() const noexcept { return ring_buffer_utilization(rb_); }
+
+    ring_buffer_stats_t stats() const noexcept {
+        static_assert(P::stats, "the policy turns statistics off");
+        ring_buffer_stats_t stats;
+        ring_buffer_get_stats(rb_, &stats);
+        return stats;
+    }
+
+private:
+    explicit RingBuffer(ring_buffer_t *rb) noexcept : rb_(rb) {
+        if (rb_ && !matches(rb_)) {
+            reset();
+        }
+    }
+
+    static ring_buffer_config_t make_config(uint32_t options) noexcept {
+        ring_buffer_config_t config{};
+        config.size = capacity;
+        config.flags = (options & memory_options) | mode_flags | handle_flags;
+        return config;
+    }
+
+    /* Mirroring rounds small sizes up to a page, so check what we got */
+    static bool matches(const ring_buffer_t *rb) noexcept {
+        bool single_producer = (rb->flags & RING_BUFFER_FLAG_SINGLE_PRODUCER) != 0;
+        bool single_consumer = (rb->flags & RING_BUFFER_FLAG_SINGLE_CONSUMER) != 0;
+        return rb->size == capacity &&
+               (!single_producer || P::producers == 1) &&
+               (!single_consumer || P::consumers == 1);
+    }
+
+    void reset() noexcept {
+        if (rb_) {
+            ring_buffer_destroy(rb_);
+            rb_ = nullptr;
+        }
+    }
+
+    ring_buffer_t *rb_ = nullptr;
+};
+
+} // namespace chronicle
+
+#endif /* RING_BUFFER_HPP */
@@ -0,0 +1,979 @@
+/**
+ * @file ring_spill.c
+ * @brief Continuous spill of a ring buffer to rolling segment files
+ *
+ * Each batch is a list of operations run in order, stopping at the first
+ * failure: page-aligned writes of ring ranges, a data sync, the header
+ * write and a final sync. io_uring runs them as one linked chain,
+ * dispatch_io behind barriers, and the fallback one after the other.
+ */
+
+#include "ring_spill.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define RING_SPILL_WITH_URING 1
+#endif
+#endif
+#ifndef RING_SPILL_WITH_URING
+#define RING_SPILL_WITH_URING 0
+#endif
+
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#define RING_SPILL_WITH_DISPATCH 1
+#else
+#define RING_SPILL_WITH_DISPATCH 0
+#endif
+
+/* Write ranges per batch; every padding hole splits one */
+#define SPILL_MAX_RANGES 8
+
+/* Writes, split at the wrap, then sync, header and sync */
+#define SPILL_MAX_OPS (2 * SPILL_MAX_RANGES + 3)
+
+/* Submission queue entries; a power of 2 that holds a whole batch */
+#define SPILL_URING_ENTRIES 32
+
+typedef enum {
+    SPILL_OP_WRITE,
+    SPILL_OP_SYNC       /* Data sync; the last one of a batch is a full one */
+} spill_op_kind_t;
+
+typedef struct {
+    spill_op_kind_t kind;
+    struct iovec iov[2];
+    int iovcnt;
+    off_t offset;
+    size_t length;
+} spill_op_t;
+
+/* A message boundary and the totals in front of it */
+typedef struct {
+    size_t pos;
+    uint64_t messages;
+    uint64_t bytes;
+} spill_mark_t;
+
+#if RING_SPILL_WITH_URING
+typedef struct {
+    int fd;
+    unsigned features;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    _Atomic unsigned *sq_head;
+    _Atomic unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    _Atomic unsigned *cq_head;
+    _Atomic unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+} spill_uring_t;
+#endif
+
+struct ring_spill {
+    ring_buffer_t *rb;
+    char directory[PATH_MAX];
+    size_t segment_size;
+    size_t batch_size;
+    size_t align;
+    uint32_t flags;
+
+    /* Current segment; fd is -1 between segments */
+    int fd;
+    ring_spill_segment_header_t *header;    /* An aligned page, written at offset 0 */
+    size_t written;             /* Aligned position up to which the file is complete */
+    size_t end;                 /* Position after the last record in the file */
+
+    /* Message totals since the spill started */
+    spill_mark_t scanned;       /* At end */
+    spill_mark_t releasable;    /* Last boundary not after written */
+    spill_mark_t released;      /* Handed back to the ring */
+
+    /* Batch in flight */
+    bool in_flight;
+    spill_op_t ops[SPILL_MAX_OPS];
+    size_t op_count;
+    size_t ops_done;
+    int error;                  /* First failure, as an errno value */
+    size_t batch_end;
+    size_t batch_written;
+    spill_mark_t batch_scanned;
+    spill_mark_t batch_releasable;
+    ring_spill_segment_header_t batch_header;
+
+#if RING_SPILL_WITH_URING
+    spill_uring_t uring;
+    bool have_uring;
+#endif
+#if RING_SPILL_WITH_DISPATCH
+    dispatch_queue_t queue;
+    dispatch_io_t channel;
+    dispatch_semaphore_t done;      /* Signalled by the last sync of a batch */
+    dispatch_semaphore_t closed;    /* Signalled once the channel lets go of the file */
+    _Atomic int dispatch_error;
+#endif
+};
+
+struct ring_spill_segment {
+    int fd;
+    const uint8_t *map;
+    size_t map_size;
+    ring_spill_segment_header_t header;
+    size_t pos;
+};
+
+static inline size_t align_down(size_t pos, size_t align) {
+    return pos & ~(align - 1);
+}
+
+static inline size_t align_up(size_t pos, size_t align) {
+    return (pos + align - 1) & ~(align - 1);
+}
+
+static inline size_t record_size(uint32_t length) {
+    return (sizeof(arrow_ipc_header_t) + length + MESSAGE_ALIGNMENT - 1) & ~(size_t)(MESSAGE_ALIGNMENT - 1);
+}
+
+static uint64_t wall_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t header_checksum(const ring_spill_segment_header_t *header) {
+    return ring_buffer_crc32c(header, offsetof(ring_spill_segment_header_t, checksum));
+}
+
+/* Copy the record header at a ring position, which may straddle the wrap */
+static void load_header(const ring_buffer_t *rb, size_t pos, arrow_ipc_header_t *header) {
+    size_t offset = pos & (rb->size - 1);
+    size_t first = rb->size - offset;
+    if (rb->linear_size > rb->size || first >= sizeof(*header)) {
+        memcpy(header, (const uint8_t *)rb->buffer + offset, sizeof(*header));
+    } else {
+        memcpy(header, (const uint8_t *)rb->buffer + offset, first);
+        memcpy((uint8_t *)header + first, rb->buffer, sizeof(*header) - first);
+    }
+}
+
+/* Durable on return: a full sync where data syncs only order writes */
+static int sync_file(int fd, bool full) {
+#if defined(__APPLE__)
+    if (full) {
+        return fcntl(fd, F_FULLFSYNC) == 0 || fsync(fd) == 0 ? 0 : errno;
+    }
+#ifdef F_BARRIERFSYNC
+    if (fcntl(fd, F_BARRIERFSYNC) == 0) {
+        return 0;
+    }
+#endif
+    return fsync(fd) == 0 ? 0 : errno;
+#else
+    (void)full;
+    return fdatasync(fd) == 0 ? 0 : errno;
+#endif
+}
+
+/* Operations one after the other in the calling thread */
+static int run_ops_sync(int fd, const spill_op_t *ops, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (ops[i].kind == SPILL_OP_SYNC) {
+            int error = sync_file(fd, i + 1 == count);
+            if (error != 0) {
+                return error;
+            }
+            continue;
+        }
+
+        off_t offset = ops[i].offset;
+        for (int v = 0; v < ops[i].iovcnt; v++) {
+            const uint8_t *data = ops[i].iov[v].iov_base;
+            size_t left = ops[i].iov[v].iov_len;
+            while (left > 0) {
+                ssize_t n = pwrite(fd, data, left, offset);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return n < 0 ? errno : EIO;
+                }
+                data += n;
+                left -= (size_t)n;
+                offset += n;
+            }
+        }
+    }
+    return 0;
+}
+
+#if RING_SPILL_WITH_URING
+
+static int uring_setup(spill_uring_t *ring) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, SPILL_URING_ENTRIES, &params);
+    if (fd < 0) {
+        return -1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = fd;
+    ring->features = params.features;
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (ring->features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    if (ring->features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            munmap(ring->sq_ring, ring->sq_ring_size);
+            close(fd);
+            return -1;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (ring->cq_ring != ring->sq_ring) {
+            munmap(ring->cq_ring, ring->cq_ring_size);
+        }
+        munmap(ring->sq_ring, ring->sq_ring_size);
+        close(fd);
+        return -1;
+    }
+
+    uint8_t *sq = ring->sq_ring;
+    uint8_t *cq = ring->cq_ring;
+    ring->sq_head = (_Atomic unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (_Atomic unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (_Atomic unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (_Atomic unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+static void uring_teardown(spill_uring_t *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+/* Queue the batch as one chain: each operation runs once the one before
+ * it succeeded, and a failure cancels the rest. Returns how many the
+ * kernel took. */
+static int uring_submit(ring_spill_t *spill) {
+    spill_uring_t *ring = &spill->uring;
+    unsigned tail = atomic_load_explicit(ring->sq_tail, memory_order_relaxed);
+    for (size_t i = 0; i < spill->op_count; i++) {
+        const spill_op_t *op = &spill->ops[i];
+        unsigned index = (tail + (unsigned)i) & *ring->sq_mask;
+        struct io_uring_sqe *sqe = &ring->sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = spill->fd;
+        sqe->user_data = i;
+        if (op->kind == SPILL_OP_WRITE) {
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = (uint64_t)(uintptr_t)op->iov;
+            sqe->len = (uint32_t)op->iovcnt;
+            sqe->off = (uint64_t)op->offset;
+        } else {
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        }
+        if (i + 1 < spill->op_count) {
+            sqe->flags = IOSQE_IO_LINK;
+        }
+        ring->sq_array[index] = index;
+    }
+    atomic_store_explicit(ring->sq_tail, tail + (unsigned)spill->op_count, memory_order_release);
+
+    int submitted;
+    do {
+        submitted = (int)syscall(__NR_io_uring_enter, ring->fd, (unsigned)spill->op_count, 0, 0, NULL, 0);
+    } while (submitted < 0 && errno == EINTR);
+    return submitted;
+}
+
+/* Reap completions; true once every operation of the batch has one */
+static bool uring_collect(ring_spill_t *spill, int64_t timeout_ns) {
+    spill_uring_t *ring = &spill->uring;
+    for (;;) {
+        unsigned head = atomic_load_explicit(ring->cq_head, memory_order_relaxed);
+        unsigned tail = atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+        for (; head != tail; head++) {
+            const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+            const spill_op_t *op = &spill->ops[cqe->user_data];
+            if (spill->error == 0) {
+                if (cqe->res < 0) {
+                    spill->error = -cqe->res;
+                } else if (op->kind == SPILL_OP_WRITE && (size_t)cqe->res != op->length) {
+                    spill->error = EIO;
+                }
+            }
+            spill->ops_done++;
+        }
+        atomic_store_explicit(ring->cq_head, head, memory_order_release);
+
+        if (spill->ops_done == spill->op_count || timeout_ns == 0) {
+            return spill->ops_done == spill->op_count;
+        }
+
+        /* Wait for at least one more completion */
+        unsigned flags = IORING_ENTER_GETEVENTS;
+        void *arg = NULL;
+        size_t arg_size = 0;
+#ifdef IORING_ENTER_EXT_ARG
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg getevents;
+        if (timeout_ns > 0 && (ring->features & IORING_FEAT_EXT_ARG)) {
+            ts.tv_sec = timeout_ns / 1000000000;
+            ts.tv_nsec = timeout_ns % 1000000000;
+            memset(&getevents, 0, sizeof(getevents));
+            getevents.ts = (uint64_t)(uintptr_t)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            arg = &getevents;
+            arg_size = sizeof(getevents);
+        }
+#endif
+        int waited = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, flags, arg, arg_size);
+        if (waited < 0 && errno == ETIME) {
+            timeout_ns = 0;     /* One last look, then report it still in flight */
+        } else if (waited < 0 && errno != EINTR) {
+            spill->error = spill->error ? spill->error : errno;
+            return false;
+        }
+    }
+}
+
+#endif /* RING_SPILL_WITH_URING */
+
+#if RING_SPILL_WITH_DISPATCH
+
+/* Writes go to the channel, syncs run behind barriers; the last barrier
+ * signals the batch done. Writes keep pointing into the mapping. */
+static void dispatch_submit(ring_spill_t *spill) {
+    atomic_store(&spill->dispatch_error, 0);
+    for (size_t i = 0; i < spill->op_count; i++) {
+        const spill_op_t *op = &spill->ops[i];
+        bool last = i + 1 == spill->op_count;
+        if (op->kind == SPILL_OP_SYNC) {
+            int fd = spill->fd;
+            ring_spill_t *owner = spill;
+            dispatch_io_barrier(spill->channel, ^{
+                if (atomic_load(&owner->dispatch_error) == 0) {
+                    int error = sync_file(fd, last);
+                    if (error != 0) {
+                        atomic_store(&owner->dispatch_error, error);
+                    }
+                }
+                if (last) {
+                    dispatch_semaphore_signal(owner->done);
+                }
+            });
+            continue;
+        }
+
+        off_t offset = op->offset;
+        for (int v = 0; v < op->iovcnt; v++) {
+            dispatch_data_t data = dispatch_data_create(op->iov[v].iov_base, op->iov[v].iov_len,
+                                                        spill->queue, ^{});
+            ring_spill_t *owner = spill;
+            dispatch_io_write(spill->channel, offset, data, spill->queue,
+                              ^(bool done, dispatch_data_t remaining, int error) {
+                (void)remaining;
+                if (done && error != 0) {
+                    int expected = 0;
+                    atomic_compare_exchange_strong(&owner->dispatch_error, &expected, error);
+                }
+            });
+            dispatch_release(data);
+            offset += (off_t)op->iov[v].iov_len;
+        }
+    }
+}
+
+static bool dispatch_collect(ring_spill_t *spill, int64_t timeout_ns) {
+    dispatch_time_t deadline = timeout_ns < 0 ? DISPATCH_TIME_FOREVER : dispatch_time(DISPATCH_TIME_NOW, timeout_ns);
+    if (dispatch_semaphore_wait(spill->done, deadline) != 0) {
+        return false;
+    }
+    spill->error = atomic_load(&spill->dispatch_error);
+    spill->ops_done = spill->op_count;
+    return true;
+}
+
+/* Wait until the channel is done with the file, so it can be written directly */
+static void close_channel(ring_spill_t *spill) {
+    if (spill->channel) {
+        dispatch_io_close(spill->channel, 0);
+        dispatch_release(spill->channel);
+        spill->channel = NULL;
+        dispatch_semaphore_wait(spill->closed, DISPATCH_TIME_FOREVER);
+    }
+}
+
+#endif /* RING_SPILL_WITH_DISPATCH */
+
+/* Create the next segment file, with its records starting at pos */
+static ring_buffer_error_t open_segment(ring_spill_t *spill, size_t pos) {
+    uint64_t created = wall_clock_ns();
+    char path[PATH_MAX + 64];
+    int fd = -1;
+    for (int attempt = 0; fd < 0 && attempt < 16; attempt++, created++) {
+        snprintf(path, sizeof(path), "%s/" RING_SPILL_SEGMENT_PREFIX "%020" PRIu64 RING_SPILL_SEGMENT_SUFFIX,
+                 spill->directory, created);
+        int mode = O_WRONLY | O_CREAT | O_EXCL;
+#if defined(O_DIRECT)
+        if (!(spill->flags & RING_SPILL_FLAG_BUFFERED)) {
+            fd = open(path, mode | O_DIRECT, 0644);
+            if (fd >= 0 || errno != EINVAL) {
+                continue;
+            }
+        }
+#endif
+        fd = open(path, mode, 0644);
+        if (fd < 0 && errno != EEXIST) {
+            return RING_BUFFER_ERROR_IO;
+        }
+    }
+    if (fd < 0) {
+        return RING_BUFFER_ERROR_IO;
+    }
+#if defined(F_NOCACHE)
+    if (!(spill->flags & RING_SPILL_FLAG_BUFFERED)) {
+        fcntl(fd, F_NOCACHE, 1);
+    }
+#endif
+
+#if RING_SPILL_WITH_DISPATCH
+    if (!(spill->flags & RING_SPILL_FLAG_SYNC_IO)) {
+        dispatch_semaphore_t closed = spill->closed;
+        spill->channel = dispatch_io_create(DISPATCH_IO_RANDOM, fd, spill->queue, ^(int error) {
+            (void)error;
+            dispatch_semaphore_signal(closed);
+        });
+    }
+#endif
+
+    memset(spill->header, 0, spill->align);
+    spill->header->magic = RING_SPILL_SEGMENT_MAGIC;
+    spill->header->version = RING_SPILL_SEGMENT_VERSION;
+    spill->header->data_offset = (uint32_t)spill->align;
+    spill->header->base_pos = align_down(pos, spill->align);
+    spill->header->first_pos = pos;
+    spill->header->end_pos = pos;
+    spill->header->created_ns = created;
+    spill->header->checksum = header_checksum(spill->header);
+
+    spill->fd = fd;
+    spill->written = (size_t)spill->header->base_pos;
+    spill->end = pos;
+    return RING_BUFFER_SUCCESS;
+}
+
+/* Hand everything up to the mark back to the producers */
+static ring_buffer_error_t release_to(ring_spill_t *spill, const spill_mark_t *mark) {
+    if (mark->pos == spill->released.pos) {
+        return RING_BUFFER_SUCCESS;
+    }
+
+    ring_buffer_cursor_t cursor = {
+        .pos = mark->pos,
+        .messages = mark->messages - spill->released.messages,
+        .bytes = mark->bytes - spill->released.bytes
+    };
+    ring_buffer_error_t result = ring_buffer_release(spill->rb, &cursor);
+    if (result == RING_BUFFER_SUCCESS) {
+        spill->released = *mark;
+        spill->releasable = *mark;
+    }
+    return result;
+}
+
+/* Record the final end in the header, trim the whole-page tail to it and
+ * close the file. Everything in it can then be released. */
+static ring_buffer_error_t seal_segment(ring_spill_t *spill) {
+    if (spill->fd < 0) {
+        return RING_BUFFER_SUCCESS;
+    }
+
+#if RING_SPILL_WITH_DISPATCH
+    close_channel(spill);
+#endif
+
+    ring_spill_segment_header_t *header = spill->header;
+    header->end_pos = spill->end;
+    header->flags |= RING_SPILL_SEGMENT_SEALED;
+    header->checksum = header_checksum(header);
+
+    spill_op_t ops[2] = {
+        { .kind = SPILL_OP_WRITE, .iov = { { header, spill->align } }, .iovcnt = 1, .offset = 0, .length = spill->align },
+        { .kind = SPILL_OP_SYNC }
+    };
+    off_t size = (off_t)(spill->align + spill->end - header->base_pos);
+    if (ftruncate(spill->fd, size) != 0 || run_ops_sync(spill->fd, ops, 2) != 0) {
+        return RING_BUFFER_ERROR_IO;
+    }
+
+    close(spill->fd);
+    spill->fd = -1;
+    return release_to(spill, &spill->scanned);
+}
+
+/* Move the releasable mark to the last boundary not after written */
+static void track_boundary(spill_mark_t *releasable, const spill_mark_t *prev, const spill_mark_t *next,
+                           size_t align) {
+    if ((next->pos & (align - 1)) == 0) {
+        *releasable = *next;
+    } else if (align_down(next->pos, align) > align_down(prev->pos, align)) {
+        *releasable = *prev;
+    }
+}
+
+/* Append a write of ring positions [start, end) to the batch */
+static void add_write(ring_spill_t *spill, size_t start, size_t end) {
+    ring_buffer_t *rb = spill->rb;
+    spill_op_t *op = &spill->ops[spill->op_count++];
+    size_t offset = start & (rb->size - 1);
+    size_t length = end - start;
+
+    op->kind = SPILL_OP_WRITE;
+    op->offset = (off_t)(spill->align + start - spill->header->base_pos);
+    op->length = length;
+    op->iov[0].iov_base = (uint8_t *)rb->buffer + offset;
+    if (offset + length <= rb->linear_size) {
+        op->iov[0].iov_len = length;
+        op->iovcnt = 1;
+    } else {
+        op->iov[0].iov_len = rb->size - offset;
+        op->iov[1].iov_base = rb->buffer;
+        op->iov[1].iov_len = length - op->iov[0].iov_len;
+        op->iovcnt = 2;
+    }
+}
+
+/* Plan and submit the next batch; false if there is nothing to write */
+static bool start_batch(ring_spill_t *spill, ring_buffer_error_t *result) {
+    ring_buffer_t *rb = spill->rb;
+    size_t commit = atomic_load_explicit(&rb->control->commit_pos, memory_order_acquire);
+    *result = RING_BUFFER_SUCCESS;
+    if (commit == spill->end) {
+        return false;
+    }
+
+    if (spill->fd < 0) {
+        *result = open_segment(spill, spill->end);
+        if (*result != RING_BUFFER_SUCCESS) {
+            return false;
+        }
+    }
+
+    /* Walk the records up to the batch size, but take at least one */
+    size_t limit = commit - spill->end > spill->batch_size ? spill->end + spill->batch_size : commit;
+    size_t range_start = spill->written;
+    size_t ranges = 0;
+    spill_mark_t mark = spill->scanned;
+    spill_mark_t releasable = spill->releasable;
+    spill->op_count = 0;
+    while (mark.pos < commit) {
+        arrow_ipc_header_t header;
+        load_header(rb, mark.pos, &header);
+        if ((header.magic != ARROW_IPC_MAGIC && header.magic != RING_BUFFER_PADDING_MAGIC) ||
+            header.length > RING_BUFFER_MAX_MESSAGE_SIZE || mark.pos + record_size(header.length) > commit) {
+            if (mark.pos == spill->end) {
+                *result = RING_BUFFER_ERROR_CORRUPTED;
+                return false;
+            }
+            break;
+        }
+
+        spill_mark_t next = mark;
+        next.pos += record_size(header.length);
+        if (next.pos > limit && mark.pos > spill->end) {
+            break;
+        }
+
+        /* Leave the whole pages inside padding as a hole */
+        if (header.magic == RING_BUFFER_PADDING_MAGIC) {
+            size_t hole_start = align_up(mark.pos + sizeof(header), spill->align);
+            size_t hole_end = align_down(next.pos, spill->align);
+            if (hole_end > hole_start) {
+                if (ranges + 1 == SPILL_MAX_RANGES) {
+                    break;
+                }
+                if (hole_start > range_start) {
+                    add_write(spill, range_start, hole_start);
+                    ranges++;
+                }
+                range_start = hole_end;
+            }
+        } else {
+            next.messages++;
+            next.bytes += header.length;
+        }
+
+        track_boundary(&releasable, &mark, &next, spill->align);
+        mark = next;
+    }
+
+    size_t range_end = align_up(mark.pos, spill->align);
+    if (range_end > range_start) {
+        add_write(spill, range_start, range_end);
+    }
+
+    spill->batch_end = mark.pos;
+    spill->batch_written = align_down(mark.pos, spill->align) > range_start ?
+                           align_down(mark.pos, spill->align) : range_start;
+    spill->batch_scanned = mark;
+    spill->batch_releasable = releasable;
+
+    /* Then make the data durable before the header claims it */
+    ring_spill_segment_header_t *header = &spill->batch_header;
+    memcpy(header, spill->header, sizeof(*header));
+    header->end_pos = mark.pos;
+    header->checksum = header_checksum(header);
+    memcpy(spill->header, header, sizeof(*header));
+
+    spill->ops[spill->op_count++] = (spill_op_t){ .kind = SPILL_OP_SYNC };
+    spill->ops[spill->op_count++] = (spill_op_t){
+        .kind = SPILL_OP_WRITE, .iov = { { spill->header, spill->align } }, .iovcnt = 1,
+        .offset = 0, .length = spill->align
+    };
+    spill->ops[spill->op_count++] = (spill_op_t){ .kind = SPILL_OP_SYNC };
+
+    spill->in_flight = true;
+    spill->ops_done = 0;
+    spill->error = 0;
+#if RING_SPILL_WITH_URING
+    if (spill->have_uring) {
+        int submitted = uring_submit(spill);
+        if (submitted == (int)spill->op_count) {
+            return true;
+        }
+
+        /* Wait out what the kernel took, then write without the ring */
+        size_t count = spill->op_count;
+        spill->op_count = submitted > 0 ? (size_t)submitted : 0;
+        while (spill->ops_done < spill->op_count && uring_collect(spill, -1)) {
+        }
+        uring_teardown(&spill->uring);
+        spill->have_uring = false;
+        spill->op_count = count;
+        spill->ops_done = 0;
+        spill->error = 0;
+    }
+#endif
+#if RING_SPILL_WITH_DISPATCH
+    if (spill->channel) {
+        dispatch_submit(spill);
+        return true;
+    }
+#endif
+    spill->error = run_ops_sync(spill->fd, spill->ops, spill->op_count);
+    spill->ops_done = spill->op_count;
+    return true;
+}
+
+/* Finish the batch in flight; false while it still is */
+static bool collect_batch(ring_spill_t *spill, int64_t timeout_ns) {
+    if (spill->ops_done == spill->op_count) {
+        return true;
+    }
+#if RING_SPILL_WITH_URING
+    if (spill->have_uring) {
+        return uring_collect(spill, timeout_ns) || spill->ops_done == spill->op_count;
+    }
+#endif
+#if RING_SPILL_WITH_DISPATCH
+    if (spill->channel) {
+        return dispatch_collect(spill, timeout_ns);
+    }
+#endif
+    (void)timeout_ns;
+    return true;
+}
+
+/* Finish the batch in flight and release what it made durable, sealing
+ * the segment once it is full. RING_BUFFER_ERROR_TIMEOUT while the batch
+ * is still being written. */
+static ring_buffer_error_t finish_batch(ring_spill_t *spill, int64_t timeout_ns) {
+    if (!collect_batch(spill, timeout_ns)) {
+        return RING_BUFFER_ERROR_TIMEOUT;
+    }
+    spill->in_flight = false;
+    if (spill->error != 0) {
+        /* The next batch writes the same ranges again */
+        memcpy(spill->header, &spill->batch_header, sizeof(*spill->header));
+        spill->header->end_pos = spill->end;
+        spill->header->checksum = header_checksum(spill->header);
+        return RING_BUFFER_ERROR_IO;
+    }
+
+    spill->written = spill->batch_written;
+    spill->end = spill->batch_end;
+    spill->scanned = spill->batch_scanned;
+    spill->releasable = spill->batch_releasable;
+    if (spill->end - spill->header->base_pos >= spill->segment_size) {
+        return seal_segment(spill);
+    }
+    return release_to(spill, &spill->releasable);
+}
+
+ring_spill_t *ring_spill_create(ring_buffer_t *rb, const ring_spill_config_t *config) {
+    if (!rb || !config || !config->directory || strlen(config->directory) >= PATH_MAX) {
+        return NULL;
+    }
+
+    size_t align = (size_t)sysconf(_SC_PAGESIZE);
+    if (rb->size < align || rb->mapped_size == 0) {
+        return NULL;
+    }
+
+    ring_spill_t *spill = calloc(1, sizeof(ring_spill_t));
+    if (!spill) {
+        return NULL;
+    }
+    if (posix_memalign((void **)&spill->header, align, align) != 0) {
+        free(spill);
+        return NULL;
+    }
+
+    strcpy(spill->directory, config->directory);
+    spill->rb = rb;
+    spill->align = align;
+    spill->flags = config->flags;
+    spill->segment_size = config->segment_size ? config->segment_size : RING_SPILL_DEFAULT_SEGMENT_SIZE;
+    spill->batch_size = config->batch_size ? config->batch_size : RING_SPILL_DEFAULT_BATCH_SIZE;
+
+    /* A batch plus its partial pages must fit in one lap of the buffer */
+    if (spill->batch_size > rb->size / 2) {
+        spill->batch_size = rb->size / 2;
+    }
+
+    spill->fd = -1;
+    size_t read_pos = atomic_load(&rb->control->read_pos);
+    spill->end = read_pos;
+    spill->scanned.pos = read_pos;
+    spill->releasable.pos = read_pos;
+    spill->released.pos = read_pos;
+
+#if RING_SPILL_WITH_URING
+    spill->have_uring = !(config->flags & RING_SPILL_FLAG_SYNC_IO) && uring_setup(&spill->uring) == 0;
+#endif
+#if RING_SPILL_WITH_DISPATCH
+    spill->queue = dispatch_queue_create("com.chronicle.ringspill", DISPATCH_QUEUE_SERIAL);
+    spill->done = dispatch_semaphore_create(0);
+    spill->closed = dispatch_semaphore_create(0);
+#endif
+    return spill;
+}
+
+int ring_spill_poll(ring_spill_t *spill, int64_t timeout_ns) {
+    if (!spill) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t before = spill->released.messages;
+    ring_buffer_error_t result;
+    if (spill->in_flight) {
+        result = finish_batch(spill, timeout_ns);
+        if (result == RING_BUFFER_ERROR_TIMEOUT) {
+            return 0;
+        }
+        if (result != RING_BUFFER_SUCCESS) {
+            return result;
+        }
+    }
+
+    if (!start_batch(spill, &result) && result != RING_BUFFER_SUCCESS) {
+        return result;
+    }
+    return (int)(spill->released.messages - before);
+}
+
+ring_buffer_error_t ring_spill_seal(ring_spill_t *spill) {
+    if (!spill) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    /* Later commits go to the next segment */
+    size_t target = atomic_load_explicit(&spill->rb->control->commit_pos, memory_order_acquire);
+    ring_buffer_error_t result = RING_BUFFER_SUCCESS;
+    for (;;) {
+        if (spill->in_flight) {
+            result = finish_batch(spill, -1);
+            if (result != RING_BUFFER_SUCCESS) {
+                return result;
+            }
+        }
+        if (spill->end >= target || !start_batch(spill, &result)) {
+            break;
+        }
+    }
+    return result == RING_BUFFER_SUCCESS ? seal_segment(spill) : result;
+}
+
+void ring_spill_destroy(ring_spill_t *spill) {
+    if (!spill) {
+        return;
+    }
+
+    if (spill->in_flight) {
+        finish_batch(spill, -1);
+    }
+    seal_segment(spill);
+    if (spill->fd >= 0) {
+        close(spill->fd);
+    }
+
+#if RING_SPILL_WITH_URING
+    if (spill->have_uring) {
+        uring_teardown(&spill->uring);
+    }
+#endif
+#if RING_SPILL_WITH_DISPATCH
+    close_channel(spill);
+    dispatch_release(spill->closed);
+    dispatch_release(spill->done);
+    dispatch_release(spill->queue);
+#endif
+    free(spill->header);
+    free(spill);
+}
+
+ring_spill_segment_t *ring_spill_segment_open(const char *path) {
+    if (!path) {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    ring_spill_segment_header_t header;
+    struct stat st;
+    bool valid = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && fstat(fd, &st) == 0 &&
+                 header.magic == RING_SPILL_SEGMENT_MAGIC &&
+                 header.version == RING_SPILL_SEGMENT_VERSION &&
+                 header.checksum == header_checksum(&header) &&
+                 header.data_offset >= sizeof(header) &&
+                 header.base_pos <= header.first_pos && header.first_pos <= header.end_pos &&
+                 (uint64_t)st.st_size >= header.data_offset + (header.end_pos - header.base_pos);
+
+    ring_spill_segment_t *segment = valid ? calloc(1, sizeof(ring_spill_segment_t)) : NULL;
+    if (!segment) {
+        close(fd);
+        return NULL;
+    }
+
+    segment->fd = fd;
+    segment->header = header;
+    segment->pos = (size_t)header.first_pos;
+    segment->map_size = (size_t)st.st_size;
+    if (header.end_pos > header.first_pos) {
+        void *map = mmap(NULL, segment->map_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            free(segment);
+            return NULL;
+        }
+        segment->map = map;
+    }
+    return segment;
+}
+
+ring_buffer_error_t ring_spill_segment_next(ring_spill_segment_t *segment, ring_buffer_message_t *msg) {
+    if (!segment || !msg) {
+        return RING_BUFFER_ERROR_INVALID_PARAM;
+    }
+
+    const ring_spill_segment_header_t *info = &segment->header;
+    while (segment->pos < info->end_pos) {
+        const uint8_t *record = segment->map + info->data_offset + (segment->pos - info->base_pos);
+        arrow_ipc_header_t header;
+        memcpy(&header, record, sizeof(header));
+
+        size_t size = record_size(header.length);
+        if ((header.magic != ARROW_IPC_MAGIC && header.magic != RING_BUFFER_PADDING_MAGIC) ||
+            header.length > RING_BUFFER_MAX_MESSAGE_SIZE || segment->pos + size > info->end_pos) {
+            segment->pos = (size_t)info->end_pos;
+            return RING_BUFFER_ERROR_CORRUPTED;
+        }
+        segment->pos += size;
+        if (header.magic == RING_BUFFER_PADDING_MAGIC) {
+            continue;
+        }
+
+        const uint8_t *data = record + sizeof(header);
+        ring_buffer_checksum_t algorithm = RING_BUFFER_HEADER_CHECKSUM(header.reserved);
+        if (algorithm > RING_BUFFER_CHECKSUM_CRC32C ||
+            ring_buffer_checksum(algorithm, data, header.length) != header.checksum) {
+            segment->pos = (size_t)info->end_pos;
+            return RING_BUFFER_ERROR_CORRUPTED;
+        }
+
+        msg->header = header;
+        msg->data = data;
+        msg->data_size = header.length;
+        return RING_BUFFER_SUCCESS;
+    }
+    return RING_BUFFER_ERROR_EMPTY;
+}
+
+const ring_spill_segment_header_t *ring_spill_segment_header(const ring_spill_segment_t *segment) {
+    return segment ? &segment->header : NULL;
+}
+
+void ring_spill_segment_close(ring_spill_segment_t *segment) {
+    if (!segment) {
+        return;
+    }
+
+    if (segment->map) {
+        munmap((void *)segment->map, segment->map_size);
+    }
+    close(segment->fd);
+    free(segment);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file ring_spill.h
+ * @brief Continuous spill of a ring buffer to rolling segment files
+ *
+ * A spill is the consumer of a ring buffer: it writes committed ranges
+ * to segment files straight from the shared mapping, and only moves the
+ * read position once they are durable. The ring then only stages what the
+ * disk hasn't taken yet, and a later job merges the segments.
+ *
+ * A segment is an image of the ring positions it covers. The ring
+ * position p is stored at file offset data_offset + (p - base_pos). The
+ * records keep their headers, checksums, codecs and slabs exactly as
+ * producers wrote them. Pages are written whole and page-aligned, so
+ * they can go from the mapping to the disk without a copy: through
+ * io_uring and O_DIRECT on Linux, and through dispatch_io and F_NOCACHE
+ * on macOS. Elsewhere, or where those aren't available, the spill falls
+ * back to pwrite(). Whole pages inside padding records are left as
+ * holes.
+ *
+ * Each batch is written, synced, recorded in the segment header and
+ * synced again before the ring is released, so after a crash the header
+ * never claims data that isn't on disk. Messages are released once their
+ * page is complete, and the last, partial page is rewritten with the
+ * next batch.
+ */
+
+#ifndef RING_SPILL_H
+#define RING_SPILL_H
+
+#include "ring_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Segment file magic and format version */
+#define RING_SPILL_SEGMENT_MAGIC 0x4C495053  /* "SPIL" */
+#define RING_SPILL_SEGMENT_VERSION 1
+
+/* Defaults for zero config fields */
+#define RING_SPILL_DEFAULT_SEGMENT_SIZE (64 * 1024 * 1024)
+#define RING_SPILL_DEFAULT_BATCH_SIZE (4 * 1024 * 1024)
+
+/* Segment file names: RING_SPILL_SEGMENT_PREFIX, creation time in ns, RING_SPILL_SEGMENT_SUFFIX */
+#define RING_SPILL_SEGMENT_PREFIX "spill-"
+#define RING_SPILL_SEGMENT_SUFFIX ".seg"
+
+/* Spill options */
+#define RING_SPILL_FLAG_BUFFERED (1u << 0)  /* Write through the page cache, not O_DIRECT / F_NOCACHE */
+#define RING_SPILL_FLAG_SYNC_IO  (1u << 1)  /* pwrite() from the caller, not io_uring / dispatch_io */
+
+/* Segment header flags */
+#define RING_SPILL_SEGMENT_SEALED (1u << 0)  /* Complete; the spill has moved on to another file */
+
+/**
+ * @brief First bytes of a segment file, padded to data_offset
+ */
+typedef struct {
+    uint32_t magic;          /* RING_SPILL_SEGMENT_MAGIC */
+    uint32_t version;        /* RING_SPILL_SEGMENT_VERSION */
+    uint32_t data_offset;    /* File offset of base_pos; the write alignment */
+    uint32_t flags;          /* RING_SPILL_SEGMENT_* */
+    uint64_t base_pos;       /* Ring position at data_offset, aligned */
+    uint64_t first_pos;      /* Position of the first record */
+    uint64_t end_pos;        /* Position after the last durable record */
+    uint64_t created_ns;     /* Wall clock time the segment was opened */
+    uint32_t checksum;       /* CRC32C of the fields above */
+    uint32_t reserved;
+} ring_spill_segment_header_t;
+
+/**
+ * @brief Spill options
+ *
+ * Zero-initialize and set only the fields you need.
+ */
+typedef struct {
+    const char *directory;   /* Where segments are created; must exist */
+    size_t segment_size;     /* Roll over to a new segment past this many bytes (0 = default) */
+    size_t batch_size;       /* Most bytes written per batch (0 = default) */
+    uint32_t flags;          /* RING_SPILL_FLAG_* */
+} ring_spill_config_t;
+
+/* Spill handle */
+typedef struct ring_spill ring_spill_t;
+
+/* Open segment file for reading */
+typedef struct ring_spill_segment ring_spill_segment_t;
+
+/**
+ * @brief Start spilling a ring buffer
+ *
+ * The spill takes over consumption from the current read position. No
+ * one else may consume from the buffer while it runs. The buffer must
+ * be at least one page and outlive the spill.
+ *
+ * @param rb Ring buffer to consume
+ * @param config Spill options
+ * @return Spill handle, or NULL on error
+ */
+ring_spill_t *ring_spill_create(ring_buffer_t *rb, const ring_spill_config_t *config);
+
+/**
+ * @brief Move the spill along
+ *
+ * Collects the batch in flight, if any, releasing its messages from the
+ * ring buffer once it is durable, then starts writing the next one.
+ * timeout_ns bounds the wait for the batch in flight: 0 only checks,
+ * and a negative value waits as long as it takes. Must not be called
+ * concurrently with itself or ring_spill_seal().
+ *
+ * @param spill Spill handle
+ * @param timeout_ns Longest wait for the batch in flight
+ * @return Messages released, or a negative ring_buffer_error_t. After
+ *         RING_BUFFER_ERROR_IO the batch is written again by the next call.
+ */
+int ring_spill_poll(ring_spill_t *spill, int64_t timeout_ns);
+
+/**
+ * @brief Write out everything committed so far and seal the segment
+ *
+ * Ends with an empty ring buffer, unless producers keep writing, and no
+ * open segment. The next batch starts a new segment, and every sealed
+ * file may be merged and deleted.
+ *
+ * @param spill Spill handle
+ * @return RING_BUFFER_SUCCESS or error code
+ */
+ring_buffer_error_t ring_spill_seal(ring_spill_t *spill);
+
+/**
+ * @brief Seal the current segment and stop spilling
+ *
+ * @param spill Spill handle, may be NULL
+ */
+void ring_spill_destroy(ring_spill_t *spill);
+
+/**
+ * @brief Open a segment file for reading
+ *
+ * Sealed segments, and those a crashed spill left behind, can be read.
+ * Records are returned up to the end the header has made durable.
+ *
+ * @param path Segment file
+ * @return Segment handle, or NULL if the file isn't a valid segment
+ */
+ring_spill_segment_t *ring_spill_segment_open(const char *path);
+
+/**
+ * @brief Read the next record of a segment
+ *
+ * Padding is skipped and each payload is checked against its checksum.
+ * Views point into a mapping of the file and stay valid until the
+ * segment is closed.
+ *
+ * @param segment Segment handle
+ * @param msg Output message
+ * @return RING_BUFFER_SUCCESS, RING_BUFFER_ERROR_EMPTY at the end, or
+ *         RING_BUFFER_ERROR_CORRUPTED for a damaged record, after which
+ *         the rest of the segment can't be read
+ */
+ring_buffer_error_t ring_spill_segment_next(ring_spill_segment_t *segment, ring_buffer_message_t *msg);
+
+/**
+ * @brief Header of an open segment
+ */
+const ring_spill_segment_header_t *ring_spill_segment_header(const ring_spill_segment_t *segment);
+
+/**
+ * @brief Close a segment
+ *
+ * @param segment Segment handle, may be NULL
+ */
+void ring_spill_segment_close(ring_spill_segment_t *segment);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RING_SPILL_H */
@@ -0,0 +1,518 @@
+/**
+ * @file test_distributed_buffer.c
+ * @brief Unit tests for the sharded distributed buffer
+ * 
+ * Tests cover shard creation, partition key routing, merged reads in
+ * global sequence order and concurrent per-shard producers.
+ */
+
+#include "distributed_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/wait.h>
+
+/* Test configuration */
+#define TEST_SHARD_SIZE (256 * 1024)
+#define TEST_PRODUCER_MESSAGES 5000
+
+/* Test statistics */
+typedef struct {
+    int tests_run;
+    int tests_passed;
+    int tests_failed;
+} test_stats_t;
+
+static test_stats_t g_test_stats = {0, 0, 0};
+
+/* Test utilities */
+#define TEST_ASSERT(condition, message) do { \
+    g_test_stats.tests_run++; \
+    if (!(condition)) { \
+        printf("FAIL: %s - %s\n", __func__, message); \
+        g_test_stats.tests_failed++; \
+        return false; \
+    } \
+    g_test_stats.tests_passed++; \
+} while(0)
+
+#define RUN_TEST(test_func) do { \
+    printf("Running %s...\n", #test_func); \
+    if (test_func()) { \
+        printf("PASS: %s\n", #test_func); \
+    } else { \
+        printf("FAIL: %s\n", #test_func); \
+    } \
+} while(0)
+
+/* Three shards owning keys [0, 99], [100, 199] and [200, 299] */
+static void make_configs(buffer_shard_config_t *configs, uint32_t count) {
+    memset(configs, 0, count * sizeof(*configs));
+    for (uint32_t i = 0; i < count; i++) {
+        configs[i].shard_id = 10 + i;
+        configs[i].capacity = TEST_SHARD_SIZE;
+        configs[i].partition_key_start = i * 100;
+        configs[i].partition_key_end = i * 100 + 99;
+    }
+}
+
+/* Test buffer creation and parameter validation */
+static bool test_create_destroy(void) {
+    buffer_shard_config_t configs[3];
+    distributed_buffer_t *db = NULL;
+    
+    make_configs(configs, 3);
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_SUCCESS, "Failed to create buffer");
+    TEST_ASSERT(db != NULL && db->num_shards == 3, "Unexpected shard count");
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT(db->rings[i] != NULL, "Shard ring buffer missing");
+        TEST_ASSERT(ring_buffer_validate(db->rings[i]), "Shard ring buffer invalid");
+    }
+    distributed_buffer_destroy(db);
+    
+    TEST_ASSERT(distributed_buffer_create(NULL, configs, 3) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL output");
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 0) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject zero shards");
+    
+    /* Overlapping ranges */
+    configs[1].partition_key_start = 50;
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject overlapping ranges");
+    TEST_ASSERT(db == NULL, "Failed create should not return a buffer");
+    
+    /* Duplicate shard ids */
+    make_configs(configs, 3);
+    configs[2].shard_id = configs[0].shard_id;
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject duplicate shard ids");
+    
+    /* Inverted range */
+    make_configs(configs, 3);
+    configs[0].partition_key_start = 99;
+    configs[0].partition_key_end = 0;
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject inverted range");
+    
+    distributed_buffer_destroy(NULL);
+    return true;
+}
+
+/* Test that keys land in the shard owning their range */
+static bool test_partition_routing(void) {
+    buffer_shard_config_t configs[3];
+    distributed_buffer_t *db = NULL;
+    make_configs(configs, 3);
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_SUCCESS, "Failed to create buffer");
+    
+    uint64_t keys[] = { 0, 99, 100, 150, 299 };
+    uint32_t expected[] = { 10, 10, 11, 11, 12 };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        TEST_ASSERT(distributed_buffer_write(db, &keys[i], sizeof(keys[i]), keys[i]) == RING_BUFFER_SUCCESS,
+                    "Failed to write message");
+    }
+    
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        void *data;
+        size_t size;
+        TEST_ASSERT(distributed_buffer_read(db, &data, &size, expected[i], 0) == RING_BUFFER_SUCCESS,
+                    "Message missing from its shard");
+        TEST_ASSERT(size == sizeof(uint64_t) && memcmp(data, &keys[i], size) == 0, "Wrong message in shard");
+    }
+    
+    /* Keys outside every range are hashed onto some shard */
+    uint64_t stray = 123456789;
+    TEST_ASSERT(distributed_buffer_write(db, &stray, sizeof(stray), stray) == RING_BUFFER_SUCCESS,
+                "Failed to write unranged key");
+    distributed_message_t msg;
+    TEST_ASSERT(distributed_buffer_read_next(db, &msg) == RING_BUFFER_SUCCESS, "Unranged key not readable");
+    TEST_ASSERT(msg.partition_key == stray, "Wrong partition key");
+    TEST_ASSERT(distributed_buffer_read_next(db, &msg) == RING_BUFFER_ERROR_EMPTY, "Buffer should be empty");
+    
+    /* Invalid reads */
+    void *data;
+    size_t size;
+    TEST_ASSERT(distributed_buffer_read(db, &data, &size, 99, 0) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject unknown shard");
+    TEST_ASSERT(distributed_buffer_read(db, &data, &size, 10, 1) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject non-zero offset");
+    TEST_ASSERT(distributed_buffer_write(db, NULL, 1, 0) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL data");
+    
+    distributed_buffer_destroy(db);
+    return true;
+}
+
+/* Test that merged reads restore the global write order */
+static bool test_merged_order(void) {
+    buffer_shard_config_t configs[3];
+    distributed_buffer_t *db = NULL;
+    make_configs(configs, 3);
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_SUCCESS, "Failed to create buffer");
+    
+    /* Interleave writes across shards */
+    for (uint32_t i = 0; i < 300; i++) {
+        uint64_t key = (i * 7) % 300;
+        TEST_ASSERT(distributed_buffer_write(db, &i, sizeof(i), key) == RING_BUFFER_SUCCESS, "Failed to write message");
+    }
+    
+    distributed_message_t msg;
+    for (uint32_t i = 0; i < 300; i++) {
+        TEST_ASSERT(distributed_buffer_read_next(db, &msg) == RING_BUFFER_SUCCESS, "Failed to read merged message");
+        TEST_ASSERT(msg.sequence == i, "Merged read out of order");
+        TEST_ASSERT(msg.data_size == sizeof(uint32_t) && *(const uint32_t *)msg.data == i, "Merged data mismatch");
+        TEST_ASSERT(msg.partition_key == (i * 7) % 300, "Merged partition key mismatch");
+        TEST_ASSERT(msg.shard_id == 10 + msg.partition_key / 100, "Merged shard id mismatch");
+    }
+    TEST_ASSERT(distributed_buffer_read_next(db, &msg) == RING_BUFFER_ERROR_EMPTY, "Buffer should be empty");
+    
+    distributed_buffer_destroy(db);
+    return true;
+}
+
+/* Producer bound to one shard's key range */
+typedef struct {
+    distributed_buffer_t *db;
+    uint64_t key;
+} producer_data_t;
+
+static void *producer_thread(void *arg) {
+    producer_data_t *data = (producer_data_t *)arg;
+    for (uint32_t i = 0; i < TEST_PRODUCER_MESSAGES; i++) {
+        while (distributed_buffer_write(data->db, &i, sizeof(i), data->key) != RING_BUFFER_SUCCESS) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* Test one producer per shard with a merged consumer */
+static bool test_concurrent_shards(void) {
+    buffer_shard_config_t configs[3];
+    distributed_buffer_t *db = NULL;
+    make_configs(configs, 3);
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_SUCCESS, "Failed to create buffer");
+    
+    pthread_t threads[3];
+    producer_data_t producers[3];
+    for (int i = 0; i < 3; i++) {
+        producers[i].db = db;
+        producers[i].key = (uint64_t)i * 100;
+        TEST_ASSERT(pthread_create(&threads[i], NULL, producer_thread, &producers[i]) == 0,
+                    "Failed to create producer thread");
+    }
+    
+    /* Each producer's messages arrive in order, sequences per shard increase */
+    uint32_t next_value[3] = {0, 0, 0};
+    uint64_t last_sequence[3] = {0, 0, 0};
+    bool seen[3] = {false, false, false};
+    int received = 0;
+    
+    while (received < 3 * TEST_PRODUCER_MESSAGES) {
+        distributed_message_t msg;
+        int result = distributed_buffer_read_next(db, &msg);
+        if (result == RING_BUFFER_ERROR_EMPTY) {
+            sched_yield();
+            continue;
+        }
+        TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Merged read failed");
+        
+        int shard = (int)(msg.partition_key / 100);
+        TEST_ASSERT(*(const uint32_t *)msg.data == next_value[shard], "Producer messages out of order");
+        TEST_ASSERT(!seen[shard] || msg.sequence > last_sequence[shard], "Shard sequence went backwards");
+        next_value[shard]++;
+        last_sequence[shard] = msg.sequence;
+        seen[shard] = true;
+        received++;
+    }
+    
+    for (int i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    TEST_ASSERT(atomic_load(&db->global_sequence) == 3 * TEST_PRODUCER_MESSAGES, "Global sequence mismatch");
+    
+    distributed_buffer_destroy(db);
+    return true;
+}
+
+/* Test file-backed and NUMA-bound shards */
+static bool test_shard_placement(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-shard-test-%d", (int)getpid());
+    
+    buffer_shard_config_t configs[2];
+    make_configs(configs, 2);
+    configs[0].mmap_path = path;
+    configs[1].flags = DISTRIBUTED_SHARD_FLAG_NUMA_BIND | DISTRIBUTED_SHARD_FLAG_NO_RANGE;
+    configs[1].numa_node = 0;
+    
+    distributed_buffer_t *db = NULL;
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 2) == RING_BUFFER_SUCCESS, "Failed to create buffer");
+    TEST_ASSERT(db->rings[0]->flags & RING_BUFFER_FLAG_SHARED, "Shard should be file-backed");
+    TEST_ASSERT(db->shards[0].mmap_path != path, "Path should be copied");
+    
+    /* Another handle on the shard file sees the message */
+    TEST_ASSERT(distributed_buffer_write(db, "persisted", 9, 5) == RING_BUFFER_SUCCESS, "Failed to write message");
+    ring_buffer_t *rb = ring_buffer_open_shared(path, 0);
+    TEST_ASSERT(rb != NULL, "Failed to open shard file");
+    TEST_ASSERT(ring_buffer_available_read(rb) > 0, "Shard file has no data");
+    ring_buffer_destroy(rb);
+    
+    /* The unranged NUMA-bound shard still works */
+    for (uint64_t key = 1000; key < 1100; key++) {
+        TEST_ASSERT(distributed_buffer_write(db, &key, sizeof(key), key) == RING_BUFFER_SUCCESS, "Failed to write message");
+    }
+    distributed_message_t msg;
+    int count = 0;
+    while (distributed_buffer_read_next(db, &msg) == RING_BUFFER_SUCCESS) {
+        count++;
+    }
+    TEST_ASSERT(count == 101, "Missing messages");
+    
+    distributed_buffer_destroy(db);
+    unlink(path);
+    return true;
+}
+
+/* Test adding a shard and splitting the key space over it */
+static bool test_add_shard_rebalance(void) {
+    buffer_shard_config_t configs[3];
+    distributed_buffer_t *db = NULL;
+    make_configs(configs, 3);
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 2) == RING_BUFFER_SUCCESS, "Failed to create buffer");
+    
+    /* Invalid additions leave the buffer unchanged */
+    buffer_shard_config_t bad = configs[2];
+    bad.shard_id = 10;
+    TEST_ASSERT(distributed_buffer_add_shard(db, &bad) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject duplicate shard id");
+    bad = configs[2];
+    bad.partition_key_start = 150;
+    TEST_ASSERT(distributed_buffer_add_shard(db, &bad) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject overlapping range");
+    TEST_ASSERT(distributed_buffer_add_shard(NULL, &configs[2]) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL buffer");
+    TEST_ASSERT(db->num_shards == 2, "Failed additions changed the shard count");
+    
+    /* An unranged shard takes no keys until the rebalance */
+    configs[2].flags = DISTRIBUTED_SHARD_FLAG_NO_RANGE;
+    TEST_ASSERT(distributed_buffer_add_shard(db, &configs[2]) == RING_BUFFER_SUCCESS, "Failed to add shard");
+    TEST_ASSERT(db->num_shards == 3 && db->rings[2] != NULL, "Shard not added");
+    
+    uint64_t key = 150;
+    TEST_ASSERT(distributed_buffer_write(db, &key, sizeof(key), key) == RING_BUFFER_SUCCESS, "Failed to write message");
+    void *data;
+    size_t size;
+    TEST_ASSERT(distributed_buffer_read(db, &data, &size, 11, 0) == RING_BUFFER_SUCCESS, "Key left its old shard early");
+    
+    TEST_ASSERT(distributed_buffer_rebalance(db) == RING_BUFFER_SUCCESS, "Failed to rebalance");
+    uint64_t starts[] = { 0, 67, 134 };
+    uint64_t ends[] = { 66, 133, 199 };
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT(db->shards[i].partition_key_start == starts[i] && db->shards[i].partition_key_end == ends[i],
+                    "Unexpected rebalanced range");
+        TEST_ASSERT(!(db->shards[i].flags & DISTRIBUTED_SHARD_FLAG_NO_RANGE), "Rebalanced shard should have a range");
+    }
+    
+    uint64_t keys[] = { 0, 66, 67, 133, 134, 199 };
+    uint32_t expected[] = { 10, 10, 11, 11, 12, 12 };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        TEST_ASSERT(distributed_buffer_write(db, &keys[i], sizeof(keys[i]), keys[i]) == RING_BUFFER_SUCCESS,
+                    "Failed to write message");
+    }
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        TEST_ASSERT(distributed_buffer_read(db, &data, &size, expected[i], 0) == RING_BUFFER_SUCCESS,
+                    "Message missing from its rebalanced shard");
+        TEST_ASSERT(memcmp(data, &keys[i], sizeof(keys[i])) == 0, "Wrong message in rebalanced shard");
+    }
+    
+    distributed_buffer_destroy(db);
+    return true;
+}
+
+/* Producer writing across the whole key span */
+static void *spread_producer_thread(void *arg) {
+    distributed_buffer_t *db = (distributed_buffer_t *)arg;
+    for (uint32_t i = 0; i < TEST_PRODUCER_MESSAGES; i++) {
+        while (distributed_buffer_write(db, &i, sizeof(i), i % 300) != RING_BUFFER_SUCCESS) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* Test that writers keep going while shards are added and rebalanced */
+static bool test_online_rebalance(void) {
+    buffer_shard_config_t configs[6];
+    distributed_buffer_t *db = NULL;
+    make_configs(configs, 6);
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 3) == RING_BUFFER_SUCCESS, "Failed to create buffer");
+    
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(pthread_create(&threads[i], NULL, spread_producer_thread, db) == 0,
+                    "Failed to create producer thread");
+    }
+    
+    int received = 0;
+    uint32_t added = 3;
+    while (received < 2 * TEST_PRODUCER_MESSAGES) {
+        if (added < 6 && received >= (int)(added - 2) * 1000) {
+            configs[added].flags = DISTRIBUTED_SHARD_FLAG_NO_RANGE;
+            TEST_ASSERT(distributed_buffer_add_shard(db, &configs[added]) == RING_BUFFER_SUCCESS, "Failed to add shard");
+            TEST_ASSERT(distributed_buffer_rebalance(db) == RING_BUFFER_SUCCESS, "Failed to rebalance");
+            added++;
+        }
+        
+        distributed_message_t msg;
+        int result = distributed_buffer_read_next(db, &msg);
+        if (result == RING_BUFFER_ERROR_EMPTY) {
+            sched_yield();
+            continue;
+        }
+        TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Merged read failed");
+        TEST_ASSERT(msg.data_size == sizeof(uint32_t) && msg.partition_key < 300, "Corrupt message");
+        received++;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    distributed_message_t msg;
+    TEST_ASSERT(added == 6 && db->num_shards == 6, "Not every shard was added");
+    TEST_ASSERT(distributed_buffer_read_next(db, &msg) == RING_BUFFER_ERROR_EMPTY, "No message should be left over");
+    TEST_ASSERT(atomic_load(&db->global_sequence) == 2 * TEST_PRODUCER_MESSAGES, "Global sequence mismatch");
+    
+    distributed_buffer_destroy(db);
+    return true;
+}
+
+/* Wait for the replicator to copy the whole backlog of a shard */
+static bool wait_for_replica(distributed_buffer_t *db, uint32_t source, uint32_t target) {
+    for (int i = 0; i < 5000; i++) {
+        if (ring_buffer_available_read(db->rings[target]) == ring_buffer_available_read(db->rings[source])) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+/* Test standby replication and recovery after a crashed writer process */
+static bool test_replication_recovery(void) {
+    char primary_path[64];
+    char standby_path[64];
+    snprintf(primary_path, sizeof(primary_path), "/tmp/chronicle-shard-primary-%d", (int)getpid());
+    snprintf(standby_path, sizeof(standby_path), "/tmp/chronicle-shard-standby-%d", (int)getpid());
+    
+    buffer_shard_config_t configs[2];
+    make_configs(configs, 2);
+    configs[0].mmap_path = primary_path;
+    configs[1].mmap_path = standby_path;
+    configs[1].flags = DISTRIBUTED_SHARD_FLAG_STANDBY;
+    
+    /* The child replicates, writes and dies mid-reservation */
+    pid_t pid = fork();
+    TEST_ASSERT(pid >= 0, "fork failed");
+    if (pid == 0) {
+        distributed_buffer_t *child = NULL;
+        if (distributed_buffer_create(&child, configs, 2) != RING_BUFFER_SUCCESS ||
+            distributed_buffer_replicate(child, 10, 11) != RING_BUFFER_SUCCESS) {
+            _exit(1);
+        }
+        for (uint32_t i = 0; i < 200; i++) {
+            /* Keys outside the range must not reach the standby either */
+            uint64_t key = i % 2 ? i % 100 : 1000 + i;
+            if (distributed_buffer_write(child, &i, sizeof(i), key) != RING_BUFFER_SUCCESS) {
+                _exit(2);
+            }
+        }
+        if (!wait_for_replica(child, 0, 1)) {
+            _exit(3);
+        }
+        ring_buffer_span_t span;
+        ring_buffer_reserve(child->rings[0], 64, &span);
+        _exit(0);
+    }
+    
+    int status = 0;
+    TEST_ASSERT(waitpid(pid, &status, 0) == pid, "waitpid failed");
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Child writer failed");
+    
+    /* Reopening with the recover flag keeps everything the child wrote */
+    configs[0].flags = DISTRIBUTED_SHARD_FLAG_RECOVER;
+    configs[1].flags = DISTRIBUTED_SHARD_FLAG_STANDBY | DISTRIBUTED_SHARD_FLAG_RECOVER;
+    distributed_buffer_t *db = NULL;
+    TEST_ASSERT(distributed_buffer_create(&db, configs, 2) == RING_BUFFER_SUCCESS, "Failed to reopen buffer");
+    TEST_ASSERT(atomic_load(&db->global_sequence) == 200, "Global sequence not restored");
+    
+    distributed_message_t msg;
+    for (uint32_t i = 0; i < 100; i++) {
+        TEST_ASSERT(distributed_buffer_read_next(db, &msg) == RING_BUFFER_SUCCESS, "Recovered message missing");
+        TEST_ASSERT(msg.sequence == i && *(const uint32_t *)msg.data == i, "Recovered message out of order");
+        TEST_ASSERT(msg.shard_id == 10, "Message read from the standby");
+    }
+    
+    /* The standby holds its own copy of the child's backlog */
+    void *data;
+    size_t size;
+    TEST_ASSERT(distributed_buffer_read(db, &data, &size, 11, 0) == RING_BUFFER_SUCCESS, "Standby copy missing");
+    TEST_ASSERT(size == sizeof(uint32_t) && *(const uint32_t *)data == 0, "Standby copy mismatch");
+    
+    /* New writes continue the sequence after the recovered ones */
+    uint32_t value = 200;
+    TEST_ASSERT(distributed_buffer_write(db, &value, sizeof(value), 5) == RING_BUFFER_SUCCESS, "Write after recovery failed");
+    for (uint32_t i = 100; i <= 200; i++) {
+        TEST_ASSERT(distributed_buffer_read_next(db, &msg) == RING_BUFFER_SUCCESS, "Message missing");
+        TEST_ASSERT(msg.sequence == i && *(const uint32_t *)msg.data == i, "Sequence not continued");
+    }
+    
+    /* Invalid replication pairs */
+    TEST_ASSERT(distributed_buffer_replicate(db, 11, 10) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject standby source");
+    TEST_ASSERT(distributed_buffer_replicate(db, 10, 10) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject same shard");
+    TEST_ASSERT(distributed_buffer_replicate(db, 10, 99) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject unknown shard");
+    TEST_ASSERT(distributed_buffer_replicate(db, 10, 11) == RING_BUFFER_SUCCESS, "Failed to start replication");
+    TEST_ASSERT(distributed_buffer_replicate(db, 10, 11) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject second replicator");
+    
+    /* Recovering a live source restarts its replication */
+    for (uint32_t i = 0; i < 50; i++) {
+        TEST_ASSERT(distributed_buffer_write(db, &i, sizeof(i), 5) == RING_BUFFER_SUCCESS, "Failed to write message");
+    }
+    TEST_ASSERT(distributed_buffer_recover(db, 10) == RING_BUFFER_SUCCESS, "Failed to recover shard");
+    TEST_ASSERT(distributed_buffer_recover(db, 99) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject unknown shard");
+    TEST_ASSERT(wait_for_replica(db, 0, 1), "Replica did not catch up after recovery");
+    TEST_ASSERT(ring_buffer_available_read(db->rings[0]) > 0, "Recovery lost messages");
+    
+    distributed_buffer_destroy(db);
+    unlink(primary_path);
+    unlink(standby_path);
+    return true;
+}
+
+static void run_all_tests(void) {
+    printf("=== Chronicle Distributed Buffer Unit Tests ===\n");
+    printf("Build: %s %s\n", __DATE__, __TIME__);
+    printf("Shard size: %d bytes\n", TEST_SHARD_SIZE);
+    printf("================================================\n\n");
+    
+    RUN_TEST(test_create_destroy);
+    RUN_TEST(test_partition_routing);
+    RUN_TEST(test_merged_order);
+    RUN_TEST(test_concurrent_shards);
+    RUN_TEST(test_shard_placement);
+    RUN_TEST(test_add_shard_rebalance);
+    RUN_TEST(test_online_rebalance);
+    RUN_TEST(test_replication_recovery);
+    
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", g_test_stats.tests_run);
+    printf("Tests passed: %d\n", g_test_stats.tests_passed);
+    printf("Tests failed: %d\n", g_test_stats.tests_failed);
+    printf("Success rate: %.1f%%\n", 
+           (double)g_test_stats.tests_passed / (double)g_test_stats.tests_run * 100.0);
+    
+    if (g_test_stats.tests_failed == 0) {
+        printf("\nAll tests PASSED! ✓\n");
+    } else {
+        printf("\nSome tests FAILED! ✗\n");
+    }
+}
+
+int main(void) {
+    run_all_tests();
+    return (g_test_stats.tests_failed == 0) ? 0 : 1;
+}
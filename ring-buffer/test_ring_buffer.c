@@ -14,7 +14,10 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <time.h>
+#include <sched.h>
 #include <sys/time.h>
+#include <sys/wait.h>
+#include <signal.h>
 
 /* Test configuration */
 #define TEST_BUFFER_SIZE (1024 * 1024)  /* 1MB for tests */
@@ -42,6 +45,13 @@ static test_stats_t g_test_stats = {0, 0, 0};
     g_test_stats.tests_passed++; \
 } while(0)
 
+/* Assertions on counters, skipped when statistics are compiled out */
+#if RING_BUFFER_STATS
+#define TEST_ASSERT_STATS(condition, message) TEST_ASSERT(condition, message)
+#else
+#define TEST_ASSERT_STATS(condition, message) ((void)0)
+#endif
+
 #define RUN_TEST(test_func) do { \
     printf("Running %s...\n", #test_func); \
     if (test_func()) { \
@@ -199,7 +209,7 @@ static bool test_buffer_wraparound(void) {
             generate_test_data(data, sizeof(data), i + round * num_messages);
             
             ring_buffer_error_t result = ring_buffer_write(rb, data, sizeof(data));
-            if (result == RING_BUFFER_ERROR_FULL) {
+            if (result == RING_BUFFER_ERROR_FULL || result == RING_BUFFER_ERROR_BACKPRESSURE) {
                 break;  /* Buffer full, normal for wrap-around test */
             }
             TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to write message");
@@ -213,9 +223,67 @@ static bool test_buffer_wraparound(void) {
                 break;  /* No more messages */
             }
             TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to read message");
+            TEST_ASSERT(msg.data_size == sizeof(data), "Wrapped message size mismatch");
+        }
+    }
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test two-phase reserve/commit writes */
+static bool test_reserve_commit(void) {
+    ring_buffer_t *rb = ring_buffer_create(4096);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    char data[600];
+    ring_buffer_span_t span;
+    ring_buffer_message_t msg;
+    bool saw_split = false;
+    
+    /* Cycle enough messages through a small buffer to force split spans */
+    for (int i = 0; i < 32; i++) {
+        generate_test_data(data, sizeof(data), i);
+        
+        ring_buffer_error_t result = ring_buffer_reserve(rb, sizeof(data), &span);
+        TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to reserve span");
+        TEST_ASSERT(span.segments[0].size + span.segments[1].size == sizeof(data),
+                    "Span segments do not cover the reservation");
+        
+        if (span.segments[1].size > 0) {
+            saw_split = true;
         }
+        
+        /* Serialize in two pieces, as a producer encoding fields would */
+        TEST_ASSERT(ring_buffer_span_copy(&span, 0, data, 100) == RING_BUFFER_SUCCESS,
+                    "Failed to copy into span");
+        TEST_ASSERT(ring_buffer_span_copy(&span, 100, data + 100, sizeof(data) - 100) == RING_BUFFER_SUCCESS,
+                    "Failed to copy into span");
+        TEST_ASSERT(ring_buffer_span_copy(&span, 1, data, sizeof(data)) == RING_BUFFER_ERROR_INVALID_PARAM,
+                    "Should reject copy past end of span");
+        TEST_ASSERT(ring_buffer_commit(rb, &span) == RING_BUFFER_SUCCESS, "Failed to commit span");
+        
+        result = ring_buffer_read(rb, &msg);
+        TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to read committed message");
+        TEST_ASSERT(msg.data_size == sizeof(data), "Message size mismatch");
+        TEST_ASSERT(verify_test_data(msg.data, sizeof(data), i), "Message data mismatch");
     }
     
+    TEST_ASSERT(saw_split, "Expected at least one wrapped reservation");
+    
+    /* Aborted reservations are invisible to readers */
+    TEST_ASSERT(ring_buffer_reserve(rb, 64, &span) == RING_BUFFER_SUCCESS, "Failed to reserve span");
+    TEST_ASSERT(ring_buffer_abort(rb, &span) == RING_BUFFER_SUCCESS, "Failed to abort span");
+    TEST_ASSERT(ring_buffer_write(rb, "after", 5) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read past padding");
+    TEST_ASSERT(msg.data_size == 5 && memcmp(msg.data, "after", 5) == 0, "Padding not skipped");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_ERROR_EMPTY, "Should be empty");
+    
+    TEST_ASSERT(ring_buffer_reserve(NULL, 64, &span) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Should reject NULL buffer");
+    TEST_ASSERT(ring_buffer_reserve(rb, 0, &span) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Should reject zero size");
+    
     ring_buffer_destroy(rb);
     return true;
 }
@@ -274,6 +342,120 @@ static bool test_backpressure(void) {
     return true;
 }
 
+/* Test backpressure hysteresis and priority admission */
+static bool test_backpressure_hysteresis(void) {
+    ring_buffer_config_t config = { .size = 8192, .high_watermark = 0.5, .low_watermark = 0.25 };
+    ring_buffer_t *rb = ring_buffer_create_ex(&config);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    char data[256];
+    generate_test_data(data, sizeof(data), 0);
+    ring_buffer_message_t msg;
+    ring_buffer_stats_t stats;
+    
+    /* Fill up to the high watermark */
+    int written = 0;
+    while (ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS) {
+        written++;
+    }
+    TEST_ASSERT(written > 0, "Should have written at least one message");
+    TEST_ASSERT(ring_buffer_is_backpressure(rb), "Backpressure should be on at the high watermark");
+    TEST_ASSERT(ring_buffer_utilization(rb) >= 0.5, "Backpressure entered below the high watermark");
+    
+    /* Repeated rejections are a single transition */
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_ERROR_BACKPRESSURE,
+                    "Normal write should be shed");
+    }
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT_STATS(stats.backpressure_events == 1, "Expected one backpressure transition");
+    TEST_ASSERT_STATS(stats.messages_shed == 11, "Every rejected write should be counted as shed");
+    
+    /* High priority still gets in, low priority doesn't */
+    TEST_ASSERT(ring_buffer_write_priority(rb, data, sizeof(data), RING_BUFFER_PRIORITY_HIGH) == RING_BUFFER_SUCCESS,
+                "High priority write should be admitted");
+    TEST_ASSERT(ring_buffer_write_priority(rb, data, sizeof(data), RING_BUFFER_PRIORITY_LOW) == RING_BUFFER_ERROR_BACKPRESSURE,
+                "Low priority write should be shed");
+    
+    /* Dropping below the high watermark is not enough to turn it off */
+    while (ring_buffer_utilization(rb) >= 0.5) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    }
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_ERROR_BACKPRESSURE,
+                "Backpressure should hold until the low watermark");
+    TEST_ASSERT(ring_buffer_is_backpressure(rb), "Backpressure flapped off above the low watermark");
+    
+    /* At the low watermark normal writes are admitted again */
+    while (ring_buffer_utilization(rb) > 0.25) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    }
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS,
+                "Normal write should be admitted at the low watermark");
+    TEST_ASSERT(!ring_buffer_is_backpressure(rb), "Backpressure should be off");
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT_STATS(stats.backpressure_exits == 1, "Expected one release transition");
+    
+    /* Bulk data is shed above the low watermark even without backpressure */
+    TEST_ASSERT(ring_buffer_utilization(rb) > 0.25, "Expected usage above the low watermark");
+    TEST_ASSERT(ring_buffer_write_priority(rb, data, sizeof(data), RING_BUFFER_PRIORITY_LOW) == RING_BUFFER_ERROR_BACKPRESSURE,
+                "Low priority write should be shed above the low watermark");
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS,
+                "Normal write should still be admitted");
+    
+    /* Watermarks can be changed on a live buffer */
+    TEST_ASSERT(ring_buffer_set_watermarks(rb, 0.9, 0.95) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Low watermark above high should be rejected");
+    TEST_ASSERT(ring_buffer_set_watermarks(rb, 0.0, 0.0) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Zero high watermark should be rejected");
+    TEST_ASSERT(ring_buffer_set_watermarks(rb, 0.9, 0.8) == RING_BUFFER_SUCCESS, "Failed to set watermarks");
+    TEST_ASSERT(ring_buffer_write_priority(rb, data, sizeof(data), RING_BUFFER_PRIORITY_LOW) == RING_BUFFER_SUCCESS,
+                "Low priority write should be admitted below the new low watermark");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test watermark defaults and validation in the creation config */
+static bool test_watermark_config(void) {
+    ring_buffer_config_t bad[] = {
+        { .size = 8192, .high_watermark = 1.5 },
+        { .size = 8192, .high_watermark = -0.5 },
+        { .size = 8192, .low_watermark = 0.9 },
+        { .size = 8192, .high_watermark = 0.5, .low_watermark = 0.75 },
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        TEST_ASSERT(ring_buffer_create_ex(&bad[i]) == NULL, "Invalid watermarks should be rejected");
+    }
+    
+    /* A high watermark below the default low one scales the low one with it */
+    ring_buffer_config_t config = { .size = 8192, .high_watermark = 0.5 };
+    ring_buffer_t *rb = ring_buffer_create_ex(&config);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    char data[256];
+    generate_test_data(data, sizeof(data), 0);
+    ring_buffer_message_t msg;
+    
+    while (ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS) {
+    }
+    TEST_ASSERT(ring_buffer_is_backpressure(rb), "Backpressure should be on");
+    TEST_ASSERT(ring_buffer_utilization(rb) < 0.6, "High watermark was not applied");
+    
+    while (ring_buffer_utilization(rb) > 0.4) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    }
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_ERROR_BACKPRESSURE,
+                "Backpressure should hold above the derived low watermark");
+    while (ring_buffer_utilization(rb) > 0.375) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    }
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS,
+                "Normal write should be admitted at the derived low watermark");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
 /* Test statistics */
 static bool test_statistics(void) {
     ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
@@ -282,10 +464,10 @@ static bool test_statistics(void) {
     ring_buffer_stats_t stats;
     ring_buffer_get_stats(rb, &stats);
     
-    TEST_ASSERT(stats.messages_written == 0, "Initial messages_written should be 0");
-    TEST_ASSERT(stats.messages_read == 0, "Initial messages_read should be 0");
-    TEST_ASSERT(stats.bytes_written == 0, "Initial bytes_written should be 0");
-    TEST_ASSERT(stats.bytes_read == 0, "Initial bytes_read should be 0");
+    TEST_ASSERT_STATS(stats.messages_written == 0, "Initial messages_written should be 0");
+    TEST_ASSERT_STATS(stats.messages_read == 0, "Initial messages_read should be 0");
+    TEST_ASSERT_STATS(stats.bytes_written == 0, "Initial bytes_written should be 0");
+    TEST_ASSERT_STATS(stats.bytes_read == 0, "Initial bytes_read should be 0");
     
     /* Write some messages */
     const int num_messages = 10;
@@ -298,8 +480,8 @@ static bool test_statistics(void) {
     
     /* Check write statistics */
     ring_buffer_get_stats(rb, &stats);
-    TEST_ASSERT(stats.messages_written == num_messages, "Incorrect messages_written count");
-    TEST_ASSERT(stats.bytes_written == num_messages * sizeof(data), "Incorrect bytes_written count");
+    TEST_ASSERT_STATS(stats.messages_written == num_messages, "Incorrect messages_written count");
+    TEST_ASSERT_STATS(stats.bytes_written == num_messages * sizeof(data), "Incorrect bytes_written count");
     
     /* Read some messages */
     for (int i = 0; i < num_messages / 2; i++) {
@@ -310,8 +492,8 @@ static bool test_statistics(void) {
     
     /* Check read statistics */
     ring_buffer_get_stats(rb, &stats);
-    TEST_ASSERT(stats.messages_read == num_messages / 2, "Incorrect messages_read count");
-    TEST_ASSERT(stats.bytes_read == (num_messages / 2) * sizeof(data), "Incorrect bytes_read count");
+    TEST_ASSERT_STATS(stats.messages_read == num_messages / 2, "Incorrect messages_read count");
+    TEST_ASSERT_STATS(stats.bytes_read == (num_messages / 2) * sizeof(data), "Incorrect bytes_read count");
     
     ring_buffer_destroy(rb);
     return true;
@@ -334,14 +516,104 @@ static bool test_checksum_validation(void) {
     result = ring_buffer_read(rb, &msg);
     TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to read message");
     
-    /* Verify checksum manually */
-    uint32_t expected_checksum = ring_buffer_crc32(data, sizeof(data));
+    /* Verify checksum manually with the algorithm recorded in the header */
+    ring_buffer_checksum_t algorithm = RING_BUFFER_HEADER_CHECKSUM(msg.header.reserved);
+    TEST_ASSERT(algorithm == RING_BUFFER_CHECKSUM_CRC32C, "New messages should use CRC32C");
+    uint32_t expected_checksum = ring_buffer_checksum(algorithm, data, sizeof(data));
     TEST_ASSERT(msg.header.checksum == expected_checksum, "Checksum mismatch");
     
+    /* Messages from older writers (reserved == 0, CRC32) still verify */
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    arrow_ipc_header_t *stored = (arrow_ipc_header_t *)((uint8_t *)rb->buffer + (rb->control->read_pos & (rb->size - 1)));
+    stored->reserved = 0;
+    stored->checksum = ring_buffer_crc32(data, sizeof(data));
+    result = ring_buffer_read(rb, &msg);
+    TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to read legacy CRC32 message");
+    
+    /* A corrupted payload is rejected */
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    uint8_t *payload = (uint8_t *)rb->buffer + (rb->control->read_pos & (rb->size - 1)) + sizeof(arrow_ipc_header_t);
+    payload[17] ^= 0x01;
+    result = ring_buffer_read(rb, &msg);
+    TEST_ASSERT(result == RING_BUFFER_ERROR_CORRUPTED, "Corrupted payload should fail verification");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test that a trusted handle skips read verification and a bad handle is caught cheaply */
+static bool test_trusted_handle(void) {
+    ring_buffer_config_t config = { .size = TEST_BUFFER_SIZE, .flags = RING_BUFFER_FLAG_TRUSTED };
+    ring_buffer_t *rb = ring_buffer_create_ex(&config);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    TEST_ASSERT(rb->flags & RING_BUFFER_FLAG_TRUSTED, "Trusted flag not kept");
+    
+    /* Writers still checksum, but the damaged payload is handed over as-is */
+    char data[256];
+    generate_test_data(data, sizeof(data), 3);
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    uint8_t *payload = (uint8_t *)rb->buffer + (rb->control->read_pos & (rb->size - 1)) + sizeof(arrow_ipc_header_t);
+    payload[17] ^= 0x01;
+    
+    ring_buffer_message_t msg;
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Trusted read should skip verification");
+    TEST_ASSERT(msg.header.checksum == ring_buffer_checksum(RING_BUFFER_CHECKSUM_CRC32C, data, sizeof(data)),
+                "Writer should still checksum");
+    TEST_ASSERT(!verify_test_data(msg.data, msg.data_size, 3), "Expected the damaged payload");
+    
+    /* Hot paths reject a handle whose magic was clobbered */
+    uint32_t magic = rb->magic;
+    rb->magic = 0;
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_ERROR_CORRUPTED, "Write should reject bad handle");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_ERROR_CORRUPTED, "Read should reject bad handle");
+    TEST_ASSERT(!ring_buffer_validate(rb), "Validate should reject bad handle");
+    rb->magic = magic;
+    TEST_ASSERT(ring_buffer_validate(rb), "Invalid ring buffer");
+    
     ring_buffer_destroy(rb);
     return true;
 }
 
+/* Bitwise reference CRC32C for cross-checking the dispatched implementation */
+static uint32_t reference_crc32c(const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= bytes[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0x82F63B78 & (0u - (crc & 1)));
+        }
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+/* Test checksum engine against known answers and the reference */
+static bool test_checksum_engine(void) {
+    printf("  CRC32C implementation: %s\n", ring_buffer_checksum_implementation());
+    
+    const char *check = "123456789";
+    TEST_ASSERT(ring_buffer_crc32(check, 9) == 0xCBF43926, "CRC32 check value mismatch");
+    TEST_ASSERT(ring_buffer_crc32c(check, 9) == 0xE3069283, "CRC32C check value mismatch");
+    TEST_ASSERT(ring_buffer_checksum(RING_BUFFER_CHECKSUM_CRC32, check, 9) == 0xCBF43926,
+                "Dispatch to CRC32 mismatch");
+    TEST_ASSERT(ring_buffer_checksum(RING_BUFFER_CHECKSUM_CRC32C, check, 9) == 0xE3069283,
+                "Dispatch to CRC32C mismatch");
+    
+    /* Cover unaligned starts and every tail length */
+    uint8_t data[1100];
+    generate_test_data(data, sizeof(data), 7);
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t size = 0; size < 40; size++) {
+            TEST_ASSERT(ring_buffer_crc32c(data + offset, size) == reference_crc32c(data + offset, size),
+                        "CRC32C mismatch for short input");
+        }
+        TEST_ASSERT(ring_buffer_crc32c(data + offset, 1024) == reference_crc32c(data + offset, 1024),
+                    "CRC32C mismatch for long input");
+    }
+    
+    return true;
+}
+
 /* Test utility functions */
 static bool test_utility_functions(void) {
     /* Test CRC32 function */
@@ -475,51 +747,1681 @@ static bool test_concurrent_access(void) {
     /* Check statistics */
     ring_buffer_stats_t stats;
     ring_buffer_get_stats(rb, &stats);
-    TEST_ASSERT(stats.messages_written == (uint64_t)total_written, "Statistics mismatch");
-    TEST_ASSERT(stats.messages_read == (uint64_t)total_read, "Statistics mismatch");
+    TEST_ASSERT_STATS(stats.messages_written == (uint64_t)total_written, "Statistics mismatch");
+    TEST_ASSERT_STATS(stats.messages_read == (uint64_t)total_read, "Statistics mismatch");
     
     ring_buffer_destroy(rb);
     return true;
 }
 
-/* Test large messages */
-static bool test_large_messages(void) {
-    ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
+/* Test batched writes and reads */
+static bool test_batch_operations(void) {
+    ring_buffer_t *rb = ring_buffer_create(8192);
     TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
     
-    /* Test message at maximum size */
-    char *large_data = malloc(TEST_LARGE_MESSAGE_SIZE);
-    TEST_ASSERT(large_data != NULL, "Failed to allocate large message");
+    char payloads[16][100];
+    struct iovec iov[16];
+    ring_buffer_message_t msgs[16];
+    size_t expected_bytes = 0;
     
-    generate_test_data(large_data, TEST_LARGE_MESSAGE_SIZE, 0xAB);
+    for (int i = 0; i < 16; i++) {
+        generate_test_data(payloads[i], sizeof(payloads[i]), i);
+        iov[i].iov_base = payloads[i];
+        iov[i].iov_len = 20 + (size_t)i * 5;  /* Vary sizes to exercise alignment */
+        expected_bytes += iov[i].iov_len;
+    }
     
-    ring_buffer_error_t result = ring_buffer_write(rb, large_data, TEST_LARGE_MESSAGE_SIZE);
-    TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to write large message");
+    /* Repeat so batches wrap around the end of the buffer */
+    for (int round = 0; round < 8; round++) {
+        ring_buffer_error_t result = ring_buffer_write_batch(rb, iov, 16);
+        TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to write batch");
+        
+        /* Drain in two reads to cover a partial batch */
+        int count = ring_buffer_read_batch(rb, msgs, 10);
+        TEST_ASSERT(count == 10, "First batch read should be full");
+        int rest = ring_buffer_read_batch(rb, msgs + 10, 16);
+        TEST_ASSERT(rest == 6, "Second batch read should return the remainder");
+        
+        for (int i = 0; i < 16; i++) {
+            TEST_ASSERT(msgs[i].data_size == iov[i].iov_len, "Batch message size mismatch");
+            TEST_ASSERT(verify_test_data(msgs[i].data, msgs[i].data_size, i), "Batch message data mismatch");
+        }
+        TEST_ASSERT(msgs[0].header.timestamp == msgs[15].header.timestamp,
+                    "Batch should share one timestamp");
+        TEST_ASSERT(ring_buffer_read_batch(rb, msgs, 16) == 0, "Buffer should be empty");
+    }
+    
+    ring_buffer_stats_t stats;
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT_STATS(stats.messages_written == 8 * 16, "Incorrect messages_written count");
+    TEST_ASSERT_STATS(stats.messages_read == 8 * 16, "Incorrect messages_read count");
+    TEST_ASSERT_STATS(stats.bytes_read == 8 * expected_bytes, "Incorrect bytes_read count");
+    
+    /* Batch reads interoperate with single writes and padding */
+    ring_buffer_span_t span;
+    TEST_ASSERT(ring_buffer_write(rb, "one", 3) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_reserve(rb, 32, &span) == RING_BUFFER_SUCCESS, "Failed to reserve span");
+    TEST_ASSERT(ring_buffer_abort(rb, &span) == RING_BUFFER_SUCCESS, "Failed to abort span");
+    TEST_ASSERT(ring_buffer_write(rb, "two", 3) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_read_batch(rb, msgs, 16) == 2, "Padding should be skipped in batch reads");
+    TEST_ASSERT(memcmp(msgs[1].data, "two", 3) == 0, "Batch message data mismatch");
+    
+    /* A batch that can never fit is rejected as a whole */
+    static char big[3000];
+    struct iovec too_big[3] = { { big, sizeof(big) }, { big, sizeof(big) }, { big, sizeof(big) } };
+    TEST_ASSERT(ring_buffer_write_batch(rb, too_big, 3) == RING_BUFFER_ERROR_FULL, "Oversized batch should fail");
+    TEST_ASSERT(ring_buffer_available_read(rb) == 0, "Failed batch must not write anything");
+    
+    /* Invalid parameters */
+    TEST_ASSERT(ring_buffer_write_batch(rb, NULL, 1) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL iov");
+    TEST_ASSERT(ring_buffer_write_batch(rb, iov, 0) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject empty batch");
+    TEST_ASSERT(ring_buffer_read_batch(rb, NULL, 4) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL msgs");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test peeking through a cursor and releasing later */
+static bool test_deferred_release(void) {
+    ring_buffer_t *rb = ring_buffer_create(8192);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    char data[200];
+    ring_buffer_message_t msgs[8];
+    ring_buffer_cursor_t cursor = {0};
+    
+    /* Several laps, each drained in batches and released at the end */
+    for (int round = 0; round < 6; round++) {
+        int next = round * 30;
+        for (int i = 0; i < 30; i++) {
+            generate_test_data(data, sizeof(data), round * 30 + i);
+            TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+        }
+        size_t backlog = ring_buffer_available_read(rb);
+        
+        int seen = 0;
+        int count;
+        while ((count = ring_buffer_peek_batch(rb, &cursor, msgs, 8)) > 0) {
+            for (int i = 0; i < count; i++) {
+                TEST_ASSERT(verify_test_data(msgs[i].data, msgs[i].data_size, next + seen + i), "Peeked data mismatch");
+            }
+            seen += count;
+        }
+        TEST_ASSERT(count == 0 && seen == 30, "Wrong number of peeked messages");
+        TEST_ASSERT(ring_buffer_available_read(rb) == backlog, "Peeking must not consume");
+        TEST_ASSERT(cursor.messages == 30 && cursor.bytes == 30 * sizeof(data), "Cursor totals mismatch");
+        
+        /* Held messages keep their space; the last batch was 8 + 8 + 8 + 6 */
+        if (round == 0) {
+            int extra = 0;
+            while (ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS) {
+                extra++;
+            }
+            TEST_ASSERT(extra < 30, "Writers overran held messages");
+            TEST_ASSERT(verify_test_data(msgs[5].data, msgs[5].data_size, 29), "Held view was overwritten");
+            while (ring_buffer_peek_batch(rb, &cursor, msgs, 8) > 0) {
+            }
+            TEST_ASSERT(cursor.messages == (uint64_t)(30 + extra), "Extra messages not peeked");
+        }
+        
+        TEST_ASSERT(ring_buffer_release(rb, &cursor) == RING_BUFFER_SUCCESS, "Failed to release");
+        TEST_ASSERT(ring_buffer_available_read(rb) == 0, "Release should consume everything peeked");
+        TEST_ASSERT(cursor.messages == 0 && cursor.bytes == 0, "Release should reset the totals");
+    }
+    
+    ring_buffer_stats_t stats;
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT_STATS(stats.messages_read == stats.messages_written, "Released messages not counted as read");
+    
+    /* A cursor overtaken by another consumer restarts at the read position */
+    TEST_ASSERT(ring_buffer_write(rb, "one", 3) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_write(rb, "two", 3) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_read(rb, &msgs[0]) == RING_BUFFER_SUCCESS, "Failed to read message");
+    TEST_ASSERT(ring_buffer_peek_batch(rb, &cursor, msgs, 8) == 1, "Cursor should skip consumed messages");
+    TEST_ASSERT(memcmp(msgs[0].data, "two", 3) == 0, "Wrong message after restart");
+    TEST_ASSERT(ring_buffer_release(rb, &cursor) == RING_BUFFER_SUCCESS, "Failed to release");
+    TEST_ASSERT(ring_buffer_read(rb, &msgs[0]) == RING_BUFFER_ERROR_EMPTY, "Buffer should be empty");
+    
+    TEST_ASSERT(ring_buffer_peek_batch(rb, NULL, msgs, 8) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL cursor");
+    TEST_ASSERT(ring_buffer_release(NULL, &cursor) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL buffer");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Write messages i in [first, last) stamped 1000 + 10 * i */
+static bool write_stamped(ring_buffer_t *rb, int first, int last) {
+    char data[1000];
+    for (int i = first; i < last; i++) {
+        ring_buffer_span_t span;
+        generate_test_data(data, sizeof(data), i);
+        TEST_ASSERT(ring_buffer_reserve(rb, sizeof(data), &span) == RING_BUFFER_SUCCESS, "Failed to reserve");
+        ring_buffer_span_copy(&span, 0, data, sizeof(data));
+        span.timestamp = 1000 + 10 * (uint64_t)i;
+        TEST_ASSERT(ring_buffer_commit(rb, &span) == RING_BUFFER_SUCCESS, "Failed to commit");
+    }
+    return true;
+}
+
+/* Test seeking a cursor by timestamp through the time index */
+static bool test_seek_time(void) {
+    ring_buffer_t *rb = ring_buffer_create(1024 * 1024);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    ring_buffer_cursor_t cursor = {0};
+    ring_buffer_message_t msgs[4];
+    TEST_ASSERT(ring_buffer_seek_time(rb, 0, &cursor) == RING_BUFFER_ERROR_EMPTY, "Empty buffer should have nothing to seek to");
+    
+    /* Several index intervals of 1 KB records, then a lap so positions wrap */
+    TEST_ASSERT(write_stamped(rb, 0, 600), "Failed to fill");
+    for (int i = 0; i < 500; i++) {
+        TEST_ASSERT(ring_buffer_read(rb, &msgs[0]) == RING_BUFFER_SUCCESS, "Failed to drain");
+    }
+    TEST_ASSERT(write_stamped(rb, 600, 1200), "Failed to refill");
+    size_t backlog = ring_buffer_available_read(rb);
+    
+    /* Exact, in-between and too-early targets; consumed messages are skipped */
+    const struct { uint64_t timestamp; int expected; } cases[] = {
+        { 1000 + 10 * 900, 900 }, { 1000 + 10 * 1037 - 5, 1037 }, { 1000 + 10 * 1199, 1199 },
+        { 1000 + 10 * 600, 600 }, { 1000 + 10 * 100, 500 }, { 0, 500 },
+    };
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        TEST_ASSERT(ring_buffer_seek_time(rb, cases[c].timestamp, &cursor) == RING_BUFFER_SUCCESS, "Failed to seek");
+        TEST_ASSERT(ring_buffer_peek_batch(rb, &cursor, msgs, 4) > 0, "Nothing after the seek");
+        TEST_ASSERT(msgs[0].header.timestamp == 1000 + 10 * (uint64_t)cases[c].expected, "Seek landed on the wrong message");
+        TEST_ASSERT(verify_test_data(msgs[0].data, msgs[0].data_size, cases[c].expected), "Seeked data mismatch");
+    }
+    TEST_ASSERT(ring_buffer_available_read(rb) == backlog, "Seeking must not consume");
+    
+    /* Past the newest message the cursor waits for new ones */
+    TEST_ASSERT(ring_buffer_seek_time(rb, 1000 + 10 * 1200, &cursor) == RING_BUFFER_ERROR_EMPTY, "Seek past the end should be empty");
+    TEST_ASSERT(ring_buffer_peek_batch(rb, &cursor, msgs, 4) == 0, "Nothing should follow the end");
+    TEST_ASSERT(write_stamped(rb, 1200, 1201), "Failed to append");
+    TEST_ASSERT(ring_buffer_peek_batch(rb, &cursor, msgs, 4) == 1, "New message should follow the cursor");
+    TEST_ASSERT(verify_test_data(msgs[0].data, msgs[0].data_size, 1200), "Appended data mismatch");
+    
+    TEST_ASSERT(ring_buffer_seek_time(NULL, 0, &cursor) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL buffer");
+    TEST_ASSERT(ring_buffer_seek_time(rb, 0, NULL) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL cursor");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test registered readers that each see every message */
+static bool test_broadcast_readers(void) {
+    ring_buffer_t *rb = ring_buffer_create(8192);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    char data[200];
+    ring_buffer_message_t msgs[8];
+    ring_buffer_reader_t critical, lagging;
+    TEST_ASSERT(ring_buffer_reader_open(rb, 0, &critical) == RING_BUFFER_SUCCESS, "Failed to open reader");
+    TEST_ASSERT(ring_buffer_reader_open(rb, RING_BUFFER_READER_EVICTABLE, &lagging) == RING_BUFFER_SUCCESS, "Failed to open reader");
+    
+    for (int i = 0; i < 10; i++) {
+        generate_test_data(data, sizeof(data), i);
+        TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    }
+    size_t free_space = ring_buffer_available_write(rb);
+    
+    /* The shared read position and both readers see all of them */
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT(ring_buffer_read(rb, &msgs[0]) == RING_BUFFER_SUCCESS, "Failed to read message");
+        TEST_ASSERT(verify_test_data(msgs[0].data, msgs[0].data_size, i), "Read data mismatch");
+    }
+    int seen = 0;
+    int count;
+    while ((count = ring_buffer_reader_peek(rb, &critical, msgs, 8)) > 0) {
+        for (int i = 0; i < count; i++) {
+            TEST_ASSERT(verify_test_data(msgs[i].data, msgs[i].data_size, seen + i), "Reader data mismatch");
+        }
+        seen += count;
+    }
+    TEST_ASSERT(count == 0 && seen == 10, "Reader should see every message");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, &lagging, msgs, 4) == 4, "Second reader should see them too");
+    TEST_ASSERT(verify_test_data(msgs[0].data, msgs[0].data_size, 0), "Second reader data mismatch");
+    
+    /* Space comes back only once the slowest reader has released it */
+    TEST_ASSERT(ring_buffer_available_write(rb) == free_space, "Readers should hold their messages");
+    TEST_ASSERT(ring_buffer_reader_release(rb, &critical) == RING_BUFFER_SUCCESS, "Failed to release");
+    TEST_ASSERT(ring_buffer_available_write(rb) == free_space, "Lagging reader should still hold its messages");
+    
+    /* Rather than block writers, the evictable reader is cut loose */
+    int written = 0;
+    while (ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS) {
+        written++;
+    }
+    TEST_ASSERT(written > 0, "Writers should get past the evicted reader");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, &lagging, msgs, 4) == RING_BUFFER_ERROR_EVICTED, "Lagging reader should be evicted");
+    TEST_ASSERT(ring_buffer_reader_release(rb, &lagging) == RING_BUFFER_ERROR_EVICTED, "Evicted reader cannot release");
+    TEST_ASSERT(ring_buffer_reader_close(rb, &lagging) == RING_BUFFER_SUCCESS, "Failed to close evicted reader");
+    
+    /* A critical reader holds writers back even after everything is read */
+    while (ring_buffer_read(rb, &msgs[0]) == RING_BUFFER_SUCCESS) {
+    }
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) != RING_BUFFER_SUCCESS, "Critical reader should hold up writers");
+    while (ring_buffer_reader_peek(rb, &critical, msgs, 8) > 0) {
+    }
+    TEST_ASSERT(ring_buffer_reader_release(rb, &critical) == RING_BUFFER_SUCCESS, "Failed to release");
+    TEST_ASSERT(ring_buffer_write(rb, "late", 4) == RING_BUFFER_SUCCESS, "Release should make room");
+    
+    /* A tail reader only sees what comes after it */
+    ring_buffer_reader_t tail;
+    TEST_ASSERT(ring_buffer_reader_open(rb, RING_BUFFER_READER_TAIL, &tail) == RING_BUFFER_SUCCESS, "Failed to open tail reader");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, &tail, msgs, 8) == 0, "Tail reader should start caught up");
+    TEST_ASSERT(ring_buffer_write(rb, "next", 4) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, &tail, msgs, 8) == 1 && memcmp(msgs[0].data, "next", 4) == 0,
+                "Tail reader should see new messages");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, &critical, msgs, 8) == 2, "Critical reader should see both");
+    
+    /* Slots run out, and closed ones are reused */
+    ring_buffer_reader_t extra[RING_BUFFER_MAX_READERS];
+    int opened = 0;
+    while (ring_buffer_reader_open(rb, 0, &extra[opened]) == RING_BUFFER_SUCCESS) {
+        opened++;
+    }
+    TEST_ASSERT(opened == RING_BUFFER_MAX_READERS - 2, "Wrong number of free reader slots");
+    TEST_ASSERT(ring_buffer_reader_close(rb, &extra[0]) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    TEST_ASSERT(ring_buffer_reader_open(rb, 0, &extra[0]) == RING_BUFFER_SUCCESS, "Closed slot should be reusable");
+    for (int i = 0; i < opened; i++) {
+        TEST_ASSERT(ring_buffer_reader_close(rb, &extra[i]) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    }
+    
+    TEST_ASSERT(ring_buffer_reader_close(rb, &tail) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    TEST_ASSERT(ring_buffer_reader_close(rb, &critical) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    TEST_ASSERT(ring_buffer_reader_open(NULL, 0, &tail) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL buffer");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, NULL, msgs, 8) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL reader");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test a buffer consumed only by registered readers, for several laps */
+static bool test_readers_only(void) {
+    ring_buffer_t *rb = ring_buffer_create(16384);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    char data[200];
+    ring_buffer_message_t msgs[8];
+    ring_buffer_reader_t readers[2], lagging;
+    for (int r = 0; r < 2; r++) {
+        TEST_ASSERT(ring_buffer_reader_open(rb, 0, &readers[r]) == RING_BUFFER_SUCCESS, "Failed to open reader");
+    }
+    TEST_ASSERT(ring_buffer_reader_open(rb, RING_BUFFER_READER_EVICTABLE, &lagging) == RING_BUFFER_SUCCESS,
+                "Failed to open reader");
+    
+    /* Nothing reads through the shared position, yet writers keep going
+     * as long as the readers release; the evictable one never does */
+    int seen[2] = { 0, 0 };
+    int written = 0;
+    while ((size_t)written * sizeof(data) < 8 * 16384) {
+        int batch = 0;
+        for (; batch < 20; batch++) {
+            generate_test_data(data, sizeof(data), written + batch);
+            if (ring_buffer_write(rb, data, sizeof(data)) != RING_BUFFER_SUCCESS) {
+                break;
+            }
+        }
+        TEST_ASSERT(batch > 0, "Writers stalled behind the shared read position");
+        written += batch;
+        
+        for (int r = 0; r < 2; r++) {
+            int count;
+            while ((count = ring_buffer_reader_peek(rb, &readers[r], msgs, 8)) > 0) {
+                for (int i = 0; i < count; i++) {
+                    TEST_ASSERT(verify_test_data(msgs[i].data, msgs[i].data_size, seen[r] + i), "Reader data mismatch");
+                }
+                seen[r] += count;
+            }
+            TEST_ASSERT(count == 0, "Reader peek failed");
+            TEST_ASSERT(ring_buffer_reader_release(rb, &readers[r]) == RING_BUFFER_SUCCESS, "Failed to release");
+        }
+    }
+    TEST_ASSERT(seen[0] == written && seen[1] == written, "Readers should see every message");
+    TEST_ASSERT(ring_buffer_available_write(rb) == rb->size, "Released space should all be reclaimed");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, &lagging, msgs, 8) == RING_BUFFER_ERROR_EVICTED,
+                "Lagging reader should have been evicted");
+    TEST_ASSERT(ring_buffer_reader_close(rb, &lagging) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    
+    /* A reader opened now starts from the oldest message still held */
+    ring_buffer_reader_t late;
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_reader_open(rb, 0, &late) == RING_BUFFER_SUCCESS, "Failed to open reader");
+    TEST_ASSERT(ring_buffer_reader_peek(rb, &late, msgs, 8) == 1, "Late reader should see the unreleased message");
+    
+    TEST_ASSERT(ring_buffer_reader_close(rb, &late) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    for (int r = 0; r < 2; r++) {
+        TEST_ASSERT(ring_buffer_reader_close(rb, &readers[r]) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    }
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test small records packed into slabs behind one header and checksum */
+static bool test_slab_records(void) {
+    ring_buffer_t *rb = ring_buffer_create(64 * 1024);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    ring_buffer_slab_t slab;
+    ring_buffer_slab_init(&slab, RING_BUFFER_PRIORITY_HIGH);
+    char data[40];
+    
+    /* Input-event sized records, with one timestamp going backwards */
+    size_t free_space = ring_buffer_available_write(rb);
+    size_t payload = 0;
+    for (int i = 0; i < 20; i++) {
+        generate_test_data(data, sizeof(data), i);
+        payload += sizeof(data) - (size_t)(i % 3);
+        uint64_t timestamp = i == 7 ? 1000000 : 1000000 + 2500 * (uint64_t)i;
+        TEST_ASSERT(ring_buffer_slab_append(rb, &slab, data, sizeof(data) - (size_t)(i % 3), timestamp) == RING_BUFFER_SUCCESS,
+                    "Failed to append record");
+    }
+    TEST_ASSERT(ring_buffer_available_read(rb) == 0, "Records must wait for the flush");
+    TEST_ASSERT(ring_buffer_slab_flush(rb, &slab) == RING_BUFFER_SUCCESS, "Failed to flush slab");
+    TEST_ASSERT(slab.count == 0 && slab.length == 0, "Flush should empty the slab");
+    TEST_ASSERT(ring_buffer_slab_flush(rb, &slab) == RING_BUFFER_SUCCESS, "Flushing an empty slab should be a no-op");
+    
+    /* Less than half the overhead of a message header per record */
+    size_t used = free_space - ring_buffer_available_write(rb);
+    TEST_ASSERT((used - payload) * 2 < 20 * sizeof(arrow_ipc_header_t), "Slab should save space");
     
     ring_buffer_message_t msg;
-    result = ring_buffer_read(rb, &msg);
-    TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to read large message");
-    TEST_ASSERT(msg.header.length == TEST_LARGE_MESSAGE_SIZE, "Large message size mismatch");
-    TEST_ASSERT(verify_test_data(msg.data, TEST_LARGE_MESSAGE_SIZE, 0xAB), "Large message data corruption");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read slab");
+    TEST_ASSERT(RING_BUFFER_HEADER_IS_SLAB(msg.header.reserved), "Message should be marked as a slab");
+    TEST_ASSERT(msg.header.timestamp == 1000000, "Header should carry the first timestamp");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_ERROR_EMPTY, "Slab should be a single message");
+    
+    ring_buffer_slab_iter_t iter;
+    const void *record;
+    size_t size;
+    uint64_t timestamp;
+    TEST_ASSERT(ring_buffer_slab_iter_init(&iter, &msg) == RING_BUFFER_SUCCESS, "Failed to start iterating");
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT(ring_buffer_slab_next(&iter, &record, &size, &timestamp) == RING_BUFFER_SUCCESS, "Missing record");
+        TEST_ASSERT(size == sizeof(data) - (size_t)(i % 3), "Record size mismatch");
+        TEST_ASSERT(verify_test_data(record, size, i), "Record data mismatch");
+        TEST_ASSERT(timestamp == (i == 7 ? 1000000 : 1000000 + 2500 * (uint64_t)i), "Record timestamp mismatch");
+    }
+    TEST_ASSERT(ring_buffer_slab_next(&iter, &record, &size, &timestamp) == RING_BUFFER_ERROR_EMPTY, "Slab should end");
+    
+    /* A full slab flushes itself before the record that doesn't fit */
+    int appended = 0;
+    while (ring_buffer_available_read(rb) == 0) {
+        generate_test_data(data, sizeof(data), appended);
+        TEST_ASSERT(ring_buffer_slab_append(rb, &slab, data, sizeof(data), 0) == RING_BUFFER_SUCCESS, "Failed to append record");
+        appended++;
+    }
+    TEST_ASSERT(slab.count == 1, "Record that didn't fit should start the next slab");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read full slab");
+    int records = 0;
+    ring_buffer_slab_iter_init(&iter, &msg);
+    while (ring_buffer_slab_next(&iter, &record, &size, &timestamp) == RING_BUFFER_SUCCESS) {
+        TEST_ASSERT(verify_test_data(record, size, records), "Full slab data mismatch");
+        records++;
+    }
+    TEST_ASSERT(records == appended - 1, "Full slab should hold every earlier record");
+    
+    /* Plain messages iterate as a single record */
+    generate_test_data(data, sizeof(data), 99);
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    ring_buffer_slab_iter_init(&iter, &msg);
+    TEST_ASSERT(ring_buffer_slab_next(&iter, &record, &size, &timestamp) == RING_BUFFER_SUCCESS, "Missing plain record");
+    TEST_ASSERT(record == msg.data && size == sizeof(data) && timestamp == msg.header.timestamp, "Plain record mismatch");
+    TEST_ASSERT(ring_buffer_slab_next(&iter, &record, &size, &timestamp) == RING_BUFFER_ERROR_EMPTY, "Plain message has one record");
+    
+    /* Truncated framing is caught */
+    uint8_t truncated[] = { 0x00, 0x10, 'a', 'b' };
+    msg.data = truncated;
+    msg.data_size = sizeof(truncated);
+    msg.header.reserved = RING_BUFFER_HEADER_SLAB;
+    ring_buffer_slab_iter_init(&iter, &msg);
+    TEST_ASSERT(ring_buffer_slab_next(&iter, &record, &size, &timestamp) == RING_BUFFER_ERROR_CORRUPTED, "Should reject a truncated record");
+    
+    char large[RING_BUFFER_SLAB_CAPACITY];
+    memset(large, 0, sizeof(large));
+    TEST_ASSERT(ring_buffer_slab_append(rb, &slab, large, sizeof(large), 0) == RING_BUFFER_ERROR_TOO_LARGE, "Should reject an oversized record");
+    TEST_ASSERT(ring_buffer_slab_append(NULL, &slab, data, sizeof(data), 0) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL buffer");
     
-    free(large_data);
     ring_buffer_destroy(rb);
     return true;
 }
 
-/* Test error conditions */
-static bool test_error_conditions(void) {
+/* Fill with text-like data: runs, repeated phrases and some noise */
+static void generate_compressible_data(uint8_t *data, size_t size, uint32_t seed) {
+    static const char *phrases[] = {
+        "{\"type\":\"screen_capture\",", "\"bundle_id\":\"com.apple.Safari\",", "\"pixels\":\"",
+        "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA", "\"}", "0123456789abcdef"
+    };
+    size_t pos = 0;
+    while (pos < size) {
+        seed = seed * 1103515245u + 12345u;
+        const char *phrase = phrases[(seed >> 16) % 6];
+        size_t n = strlen(phrase);
+        if ((seed >> 8) % 7 == 0) {
+            data[pos++] = (uint8_t)(seed >> 24);   /* Occasional literal noise */
+            continue;
+        }
+        for (size_t i = 0; i < n && pos < size; i++) {
+            data[pos++] = (uint8_t)phrase[i];
+        }
+    }
+}
+
+/* Test compressed writes: codec flag, zero-copy passthrough and round trips */
+static bool test_compression(void) {
     ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
     TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    TEST_ASSERT(ring_buffer_codec_supported(RING_BUFFER_CODEC_LZ4), "LZ4 should always be available");
     
-    /* Test message too large */
-    char *huge_data = malloc(RING_BUFFER_MAX_MESSAGE_SIZE + 1);
-    TEST_ASSERT(huge_data != NULL, "Failed to allocate huge message");
+    size_t size = 64 * 1024;
+    uint8_t *data = malloc(size);
+    uint8_t *arena = malloc(RING_BUFFER_MAX_MESSAGE_SIZE);
+    TEST_ASSERT(data && arena, "Failed to allocate test data");
     
-    ring_buffer_error_t result = ring_buffer_write(rb, huge_data, RING_BUFFER_MAX_MESSAGE_SIZE + 1);
-    TEST_ASSERT(result == RING_BUFFER_ERROR_TOO_LARGE, "Should reject oversized message");
+    /* A compressible payload is stored much smaller and decodes to the original */
+    generate_compressible_data(data, size, 1);
+    TEST_ASSERT(ring_buffer_write_compressed(rb, data, size, RING_BUFFER_CODEC_LZ4, RING_BUFFER_PRIORITY_LOW) == RING_BUFFER_SUCCESS,
+                "Failed to write compressed message");
     
-    free(huge_data);
+    ring_buffer_message_t msg;
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read compressed message");
+    TEST_ASSERT(RING_BUFFER_HEADER_CODEC(msg.header.reserved) == RING_BUFFER_CODEC_LZ4, "Codec not recorded");
+    TEST_ASSERT(RING_BUFFER_HEADER_CHECKSUM(msg.header.reserved) == RING_BUFFER_CHECKSUM_CRC32C, "Checksum bits clobbered");
+    TEST_ASSERT(msg.data_size < size / 2, "Payload should compress");
+    TEST_ASSERT(ring_buffer_decoded_size(&msg) == size, "Wrong decoded size");
+    
+    const void *decoded;
+    size_t decoded_size;
+    TEST_ASSERT(ring_buffer_decode(&msg, arena, size - 1, &decoded, &decoded_size) == RING_BUFFER_ERROR_TOO_LARGE,
+                "Should reject a short arena");
+    TEST_ASSERT(ring_buffer_decode(&msg, arena, size, &decoded, &decoded_size) == RING_BUFFER_SUCCESS, "Failed to decode");
+    TEST_ASSERT(decoded == arena && decoded_size == size, "Should decode into the arena");
+    TEST_ASSERT(memcmp(decoded, data, size) == 0, "Decoded payload mismatch");
+    
+    /* The stored bytes are checksummed, so a damaged stream is caught by decode */
+    uint8_t damaged[64];
+    memcpy(damaged, msg.data, sizeof(damaged));
+    memset(damaged + RING_BUFFER_CODEC_PREFIX_SIZE + 1, 0xFF, 16);
+    ring_buffer_message_t bad = msg;
+    bad.data = damaged;
+    bad.data_size = sizeof(damaged);
+    TEST_ASSERT(ring_buffer_decode(&bad, arena, size, &decoded, &decoded_size) == RING_BUFFER_ERROR_CORRUPTED,
+                "Should reject a damaged stream");
+    
+    /* Incompressible and tiny payloads are stored as-is and decode zero-copy */
+    uint32_t state = 0x9E3779B9;
+    for (size_t i = 0; i < 4096; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        data[i] = (uint8_t)state;
+    }
+    TEST_ASSERT(ring_buffer_write_compressed(rb, data, 4096, RING_BUFFER_CODEC_LZ4, RING_BUFFER_PRIORITY_NORMAL) == RING_BUFFER_SUCCESS,
+                "Failed to write incompressible message");
+    TEST_ASSERT(ring_buffer_write_compressed(rb, "abc", 3, RING_BUFFER_CODEC_LZ4, RING_BUFFER_PRIORITY_NORMAL) == RING_BUFFER_SUCCESS,
+                "Failed to write tiny message");
+    for (size_t expected = 4096; expected > 0; expected = expected == 4096 ? 3 : 0) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read raw message");
+        TEST_ASSERT(RING_BUFFER_HEADER_CODEC(msg.header.reserved) == RING_BUFFER_CODEC_NONE, "Raw message flagged as compressed");
+        TEST_ASSERT(ring_buffer_decode(&msg, NULL, 0, &decoded, &decoded_size) == RING_BUFFER_SUCCESS, "Failed to decode raw message");
+        TEST_ASSERT(decoded == msg.data && decoded_size == expected, "Raw message should decode zero-copy");
+    }
+    
+    /* Round trips over several laps, covering long literal and match runs */
+    for (int i = 0; i < 200; i++) {
+        size_t n = 1 + ((size_t)i * 7919) % (48 * 1024);
+        generate_compressible_data(data, n, (uint32_t)i);
+        if (i % 5 == 0) {
+            memset(data, i, n / 2);
+        }
+        TEST_ASSERT(ring_buffer_write_compressed(rb, data, n, RING_BUFFER_CODEC_LZ4, RING_BUFFER_PRIORITY_NORMAL) == RING_BUFFER_SUCCESS,
+                    "Failed to write compressed message");
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read compressed message");
+        TEST_ASSERT(ring_buffer_decode(&msg, arena, RING_BUFFER_MAX_MESSAGE_SIZE, &decoded, &decoded_size) == RING_BUFFER_SUCCESS,
+                    "Failed to decode");
+        TEST_ASSERT(decoded_size == n && memcmp(decoded, data, n) == 0, "Round trip mismatch");
+    }
+    
+    /* Zstd only when compiled in */
+    generate_compressible_data(data, size, 2);
+    ring_buffer_error_t result = ring_buffer_write_compressed(rb, data, size, RING_BUFFER_CODEC_ZSTD, RING_BUFFER_PRIORITY_NORMAL);
+    if (ring_buffer_codec_supported(RING_BUFFER_CODEC_ZSTD)) {
+        TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to write zstd message");
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read zstd message");
+        TEST_ASSERT(RING_BUFFER_HEADER_CODEC(msg.header.reserved) == RING_BUFFER_CODEC_ZSTD, "Codec not recorded");
+        TEST_ASSERT(ring_buffer_decode(&msg, arena, size, &decoded, &decoded_size) == RING_BUFFER_SUCCESS, "Failed to decode zstd");
+        TEST_ASSERT(decoded_size == size && memcmp(decoded, data, size) == 0, "Zstd round trip mismatch");
+    } else {
+        TEST_ASSERT(result == RING_BUFFER_ERROR_UNSUPPORTED, "Zstd should be unsupported");
+    }
+    
+    TEST_ASSERT(ring_buffer_write_compressed(rb, data, RING_BUFFER_MAX_MESSAGE_SIZE + 1, RING_BUFFER_CODEC_LZ4,
+                                             RING_BUFFER_PRIORITY_NORMAL) == RING_BUFFER_ERROR_TOO_LARGE,
+                "Should reject oversized payloads");
+    TEST_ASSERT(ring_buffer_write_compressed(rb, data, size, (ring_buffer_codec_t)7, RING_BUFFER_PRIORITY_NORMAL) == RING_BUFFER_ERROR_UNSUPPORTED,
+                "Should reject unknown codecs");
+    
+    free(data);
+    free(arena);
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test header timestamps from each clock source and from the caller */
+static bool test_clock_sources(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-rb-clock-%d", (int)getpid());
+    
+    ring_buffer_config_t config = { .size = 16384 };
+    ring_buffer_t *rb = ring_buffer_create_shared(path, &config);
+    TEST_ASSERT(rb != NULL, "Failed to create shared ring buffer");
+    TEST_ASSERT(rb->clock == RING_BUFFER_CLOCK_REALTIME, "Default clock should be realtime");
+    
+    /* Every available clock stamps close to the wall clock */
+    const uint64_t tolerance = 50 * 1000000ULL;
+    ring_buffer_clock_t clocks[] = { RING_BUFFER_CLOCK_REALTIME, RING_BUFFER_CLOCK_COARSE, RING_BUFFER_CLOCK_COUNTER };
+    ring_buffer_message_t msg;
+    char data[64];
+    generate_test_data(data, sizeof(data), 0);
+    for (size_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++) {
+        ring_buffer_error_t result = ring_buffer_set_clock(rb, clocks[i]);
+        if (result == RING_BUFFER_ERROR_UNSUPPORTED) {
+            printf("  (clock %d unavailable, skipping)\n", (int)clocks[i]);
+            continue;
+        }
+        TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to set clock");
+        TEST_ASSERT(rb->clock == clocks[i], "Clock not selected");
+        
+        uint64_t before = ring_buffer_timestamp();
+        TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+        uint64_t after = ring_buffer_timestamp();
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+        TEST_ASSERT(msg.header.timestamp + tolerance >= before && msg.header.timestamp <= after + tolerance,
+                    "Timestamp too far from the wall clock");
+    }
+    
+    /* A caller-supplied stamp is kept as-is */
+    ring_buffer_span_t span;
+    TEST_ASSERT(ring_buffer_reserve(rb, sizeof(data), &span) == RING_BUFFER_SUCCESS, "Failed to reserve");
+    TEST_ASSERT(span.timestamp == 0, "Reserve should clear the timestamp");
+    memcpy(span.segments[0].data, data, span.segments[0].size);
+    if (span.segments[1].size > 0) {
+        memcpy(span.segments[1].data, data + span.segments[0].size, span.segments[1].size);
+    }
+    span.timestamp = 12345;
+    TEST_ASSERT(ring_buffer_commit(rb, &span) == RING_BUFFER_SUCCESS, "Failed to commit");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    TEST_ASSERT(msg.header.timestamp == 12345, "Caller timestamp not kept");
+    TEST_ASSERT(verify_test_data(msg.data, msg.data_size, 0), "Data verification failed");
+    
+    /* The counter anchor lives in the control block and every handle shares it */
+    if (ring_buffer_set_clock(rb, RING_BUFFER_CLOCK_COUNTER) == RING_BUFFER_SUCCESS) {
+        ring_buffer_t *other = ring_buffer_open_shared(path, 0);
+        TEST_ASSERT(other != NULL, "Failed to open shared ring buffer");
+        uint64_t mult = atomic_load(&rb->control->clock_mult);
+        TEST_ASSERT(ring_buffer_set_clock(other, RING_BUFFER_CLOCK_COUNTER) == RING_BUFFER_SUCCESS, "Failed to set clock");
+        TEST_ASSERT(atomic_load(&other->control->clock_mult) == mult, "Anchor should be shared");
+        
+        uint64_t last = 0;
+        for (int i = 0; i < 1000; i++) {
+            uint64_t now = ring_buffer_now(i % 2 ? rb : other);
+            TEST_ASSERT(now >= last, "Counter clock went backwards");
+            last = now;
+        }
+        TEST_ASSERT(ring_buffer_calibrate_clock(other) == RING_BUFFER_SUCCESS, "Failed to recalibrate");
+        TEST_ASSERT((atomic_load(&rb->control->clock_seq) & 1) == 0, "Anchor left mid-update");
+        ring_buffer_destroy(other);
+    }
+    
+    TEST_ASSERT(ring_buffer_set_clock(rb, (ring_buffer_clock_t)9) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Should reject unknown clocks");
+    TEST_ASSERT(ring_buffer_set_clock(NULL, RING_BUFFER_CLOCK_COARSE) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Should reject NULL buffer");
+    
+    ring_buffer_destroy(rb);
+    unlink(path);
+    return true;
+}
+
+/* Test huge page, prefault and mlock options, which are best effort */
+static bool test_memory_options(void) {
+    const uint32_t options = RING_BUFFER_FLAG_HUGE_PAGES | RING_BUFFER_FLAG_PREFAULT | RING_BUFFER_FLAG_LOCKED;
+    ring_buffer_config_t configs[] = {
+        { .size = 4 * 1024 * 1024, .flags = options },
+        { .size = 4 * 1024 * 1024, .flags = options | RING_BUFFER_FLAG_MIRRORED },
+        { .size = 1024, .flags = options },
+    };
+    
+    char data[1100];
+    ring_buffer_message_t msg;
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        ring_buffer_t *rb = ring_buffer_create_ex(&configs[i]);
+        TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+        TEST_ASSERT(ring_buffer_validate(rb), "Invalid ring buffer");
+        TEST_ASSERT((rb->flags & options & ~configs[i].flags) == 0, "Unrequested option set");
+        if (rb->flags & RING_BUFFER_FLAG_HUGE_PAGES) {
+            TEST_ASSERT(((uintptr_t)rb->buffer & (2 * 1024 * 1024 - 1)) == 0 || rb->mapped_size % (2 * 1024 * 1024) == 0,
+                        "Huge page buffer not aligned");
+        }
+        
+        /* The buffer works normally across several laps */
+        size_t laps = 3 * rb->size / sizeof(data) + 1;
+        for (size_t n = 0; n < laps; n++) {
+            if (sizeof(data) > rb->size / 2) {
+                break;
+            }
+            generate_test_data(data, sizeof(data), (int)n);
+            TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+            TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+            TEST_ASSERT(verify_test_data(msg.data, msg.data_size, (int)n), "Data verification failed");
+        }
+        ring_buffer_destroy(rb);
+    }
+    
+    /* Prefaulting an attached buffer leaves its messages intact */
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-rb-mem-%d", (int)getpid());
+    ring_buffer_config_t config = { .size = 65536, .flags = RING_BUFFER_FLAG_HUGE_PAGES };
+    ring_buffer_t *producer = ring_buffer_create_shared(path, &config);
+    TEST_ASSERT(producer != NULL, "Failed to create shared ring buffer");
+    generate_test_data(data, sizeof(data), 7);
+    TEST_ASSERT(ring_buffer_write(producer, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    
+    ring_buffer_t *consumer = ring_buffer_open_shared(path, RING_BUFFER_FLAG_PREFAULT | RING_BUFFER_FLAG_LOCKED);
+    TEST_ASSERT(consumer != NULL, "Failed to open shared ring buffer");
+    TEST_ASSERT(consumer->flags & RING_BUFFER_FLAG_PREFAULT, "Prefault should always apply to a mapping");
+    TEST_ASSERT(ring_buffer_read(consumer, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    TEST_ASSERT(verify_test_data(msg.data, msg.data_size, 7), "Data verification failed");
+    
+    ring_buffer_destroy(consumer);
+    ring_buffer_destroy(producer);
+    unlink(path);
+    return true;
+}
+
+/* Test elastic buffers: the capacity grows under load and trims back */
+static bool test_elastic_buffer(void) {
+    const size_t initial = 64 * 1024;
+    ring_buffer_config_t configs[] = {
+        { .size = 1024 * 1024, .flags = RING_BUFFER_FLAG_ELASTIC, .initial_size = initial },
+        { .size = 1024 * 1024, .flags = RING_BUFFER_FLAG_ELASTIC | RING_BUFFER_FLAG_MIRRORED, .initial_size = initial },
+    };
+    
+    char data[1000];
+    ring_buffer_message_t msg;
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        ring_buffer_t *rb = ring_buffer_create_ex(&configs[i]);
+        TEST_ASSERT(rb != NULL, "Failed to create elastic ring buffer");
+        TEST_ASSERT(rb->flags & RING_BUFFER_FLAG_ELASTIC, "Elastic flag not kept");
+        TEST_ASSERT(ring_buffer_capacity(rb) == initial, "Wrong initial capacity");
+        
+        /* A backlog past the initial capacity grows it instead of failing */
+        int count = (int)(4 * initial / sizeof(data));
+        for (int n = 0; n < count; n++) {
+            generate_test_data(data, sizeof(data), n);
+            TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Elastic write failed");
+        }
+        TEST_ASSERT(ring_buffer_capacity(rb) > 4 * initial, "Capacity did not grow");
+        TEST_ASSERT(ring_buffer_capacity(rb) <= rb->size, "Capacity grew past the size");
+        
+        /* Trimming keeps the capacity a pending backlog needs */
+        TEST_ASSERT(ring_buffer_trim(rb) == RING_BUFFER_SUCCESS, "Trim failed");
+        TEST_ASSERT(ring_buffer_capacity(rb) >= ring_buffer_available_read(rb), "Trim dropped a backlog");
+        for (int n = 0; n < count; n++) {
+            TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+            TEST_ASSERT(verify_test_data(msg.data, msg.data_size, n), "Data verification failed");
+        }
+        
+        /* Once drained it shrinks back, and keeps working across laps */
+        TEST_ASSERT(ring_buffer_trim(rb) == RING_BUFFER_SUCCESS, "Trim failed");
+        TEST_ASSERT(ring_buffer_capacity(rb) == initial, "Capacity not trimmed back");
+        for (int n = 0; n < 3 * (int)(rb->size / sizeof(data)); n++) {
+            generate_test_data(data, sizeof(data), n);
+            TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Write after trim failed");
+            TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Read after trim failed");
+            TEST_ASSERT(verify_test_data(msg.data, msg.data_size, n), "Data verification failed");
+            if (n % 500 == 0) {
+                TEST_ASSERT(ring_buffer_trim(rb) == RING_BUFFER_SUCCESS, "Trim failed");
+            }
+        }
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_ERROR_EMPTY, "Fence padding was delivered");
+        ring_buffer_destroy(rb);
+    }
+    
+    /* An attached handle picks the mode up from the shared control block */
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-rb-elastic-%d", (int)getpid());
+    ring_buffer_t *producer = ring_buffer_create_shared(path, &configs[0]);
+    TEST_ASSERT(producer != NULL, "Failed to create shared ring buffer");
+    ring_buffer_t *consumer = ring_buffer_open_shared(path, 0);
+    TEST_ASSERT(consumer != NULL, "Failed to open shared ring buffer");
+    TEST_ASSERT(consumer->flags & RING_BUFFER_FLAG_ELASTIC, "Elastic flag not shared");
+    TEST_ASSERT(ring_buffer_trim(consumer) == RING_BUFFER_SUCCESS, "Shared trim failed");
+    generate_test_data(data, sizeof(data), 3);
+    TEST_ASSERT(ring_buffer_write(producer, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    TEST_ASSERT(ring_buffer_read(consumer, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    TEST_ASSERT(verify_test_data(msg.data, msg.data_size, 3), "Data verification failed");
+    ring_buffer_destroy(consumer);
+    ring_buffer_destroy(producer);
+    unlink(path);
+    
+    /* A fixed-size buffer has nothing to trim */
+    ring_buffer_t *rb = ring_buffer_create(65536);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    TEST_ASSERT(ring_buffer_capacity(rb) == rb->size, "Fixed capacity is not the size");
+    TEST_ASSERT(ring_buffer_trim(rb) == RING_BUFFER_ERROR_UNSUPPORTED, "Trim of a fixed buffer");
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test single-producer, single-consumer buffers: modes shared through the file */
+static bool test_single_producer_consumer(void) {
+    const uint32_t modes = RING_BUFFER_FLAG_SINGLE_PRODUCER | RING_BUFFER_FLAG_SINGLE_CONSUMER;
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-rb-spsc-%d", (int)getpid());
+    ring_buffer_config_t config = { .size = 65536, .flags = modes | RING_BUFFER_FLAG_ELASTIC, .initial_size = 16384 };
+    ring_buffer_t *producer = ring_buffer_create_shared(path, &config);
+    TEST_ASSERT(producer != NULL, "Failed to create shared ring buffer");
+    TEST_ASSERT((producer->flags & modes) == modes, "Modes not kept");
+    ring_buffer_t *consumer = ring_buffer_open_shared(path, 0);
+    TEST_ASSERT(consumer != NULL, "Failed to open shared ring buffer");
+    TEST_ASSERT((consumer->flags & modes) == modes, "Modes not shared");
+    
+    /* Laps of batches and single messages, growing past the initial capacity */
+    char data[700];
+    ring_buffer_message_t msgs[8];
+    int written = 0, read = 0;
+    for (int round = 0; round < 200; round++) {
+        for (int n = 0; n < 40; n++, written++) {
+            generate_test_data(data, sizeof(data), written);
+            TEST_ASSERT(ring_buffer_write(producer, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+        }
+        while (read < written) {
+            int count = ring_buffer_read_batch(consumer, msgs, read % 2 ? 1 : 8);
+            TEST_ASSERT(count > 0, "Failed to read messages");
+            for (int i = 0; i < count; i++, read++) {
+                TEST_ASSERT(verify_test_data(msgs[i].data, msgs[i].data_size, read), "Data verification failed");
+            }
+        }
+    }
+    TEST_ASSERT(ring_buffer_capacity(producer) > config.initial_size, "Capacity did not grow");
+    
+    /* Trim can't fence writers that reserve by plain store, but still shrinks */
+    TEST_ASSERT(ring_buffer_trim(consumer) == RING_BUFFER_SUCCESS, "Trim failed");
+    TEST_ASSERT(ring_buffer_capacity(consumer) == config.initial_size, "Capacity not trimmed back");
+    generate_test_data(data, sizeof(data), 1);
+    TEST_ASSERT(ring_buffer_write(producer, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Write after trim failed");
+    TEST_ASSERT(ring_buffer_read(consumer, &msgs[0]) == RING_BUFFER_SUCCESS, "Read after trim failed");
+    TEST_ASSERT(verify_test_data(msgs[0].data, msgs[0].data_size, 1), "Data verification failed");
+    
+    ring_buffer_destroy(consumer);
+    ring_buffer_destroy(producer);
+    unlink(path);
+    return true;
+}
+
+/* Test mirrored mapping: wrapped messages are contiguous without copying */
+static bool test_mirrored_buffer(void) {
+    ring_buffer_config_t config = { .size = 16384, .flags = RING_BUFFER_FLAG_MIRRORED };
+    ring_buffer_t *rb = ring_buffer_create_ex(&config);
+    TEST_ASSERT(rb != NULL, "Failed to create mirrored ring buffer");
+    TEST_ASSERT(ring_buffer_validate(rb), "Invalid ring buffer");
+    
+    if (!(rb->flags & RING_BUFFER_FLAG_MIRRORED)) {
+        printf("  (mirrored mapping unavailable, skipping)\n");
+        ring_buffer_destroy(rb);
+        return true;
+    }
+    
+    /* Both views alias the same pages */
+    volatile uint8_t *bytes = (volatile uint8_t *)rb->buffer;
+    bytes[3] = 0x5A;
+    TEST_ASSERT(bytes[rb->size + 3] == 0x5A, "Mirror does not alias the buffer");
+    
+    char data[1100];
+    ring_buffer_span_t span;
+    ring_buffer_message_t msg;
+    bool saw_wrap = false;
+    
+    for (int i = 0; i < 64; i++) {
+        generate_test_data(data, sizeof(data), i);
+        
+        TEST_ASSERT(ring_buffer_reserve(rb, sizeof(data), &span) == RING_BUFFER_SUCCESS,
+                    "Failed to reserve span");
+        TEST_ASSERT(span.segments[1].size == 0, "Mirrored reservation should never split");
+        memcpy(span.segments[0].data, data, sizeof(data));
+        TEST_ASSERT(ring_buffer_commit(rb, &span) == RING_BUFFER_SUCCESS, "Failed to commit span");
+        
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+        TEST_ASSERT(verify_test_data(msg.data, sizeof(data), i), "Message data mismatch");
+        
+        if ((const uint8_t *)msg.data + msg.data_size > (const uint8_t *)rb->buffer + rb->size) {
+            saw_wrap = true;
+        }
+    }
+    
+    TEST_ASSERT(saw_wrap, "Expected at least one message crossing the end of the buffer");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test that wrapped messages of an unmirrored buffer are handed out as
+ * copies, and that borrowed ones outlive reads of other buffers */
+static bool test_wrapped_copies(void) {
+    ring_buffer_t *rb = ring_buffer_create(16384);
+    ring_buffer_t *other = ring_buffer_create(16384);
+    TEST_ASSERT(rb != NULL && other != NULL, "Failed to create ring buffers");
+    
+    char data[1100];
+    ring_buffer_message_t msg, peeked, held;
+    ring_buffer_cursor_t cursor = {0};
+    int copies = 0;
+    
+    for (int i = 0; i < 64; i++) {
+        generate_test_data(data, sizeof(data), i);
+        TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+        TEST_ASSERT(ring_buffer_write(other, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+        
+        TEST_ASSERT(ring_buffer_peek_batch(rb, &cursor, &held, 1) == 1, "Failed to peek batch");
+        TEST_ASSERT(ring_buffer_peek(rb, &peeked) == RING_BUFFER_SUCCESS, "Failed to peek message");
+        TEST_ASSERT(verify_test_data(peeked.data, peeked.data_size, i), "Peeked data mismatch");
+        TEST_ASSERT(ring_buffer_read(other, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+        TEST_ASSERT(verify_test_data(msg.data, msg.data_size, i), "Read data mismatch");
+        TEST_ASSERT(verify_test_data(held.data, held.data_size, i), "Borrowed view was overwritten");
+        
+        const uint8_t *start = (const uint8_t *)rb->buffer;
+        if ((const uint8_t *)held.data < start || (const uint8_t *)held.data >= start + rb->size) {
+            copies++;
+        }
+        TEST_ASSERT(ring_buffer_release(rb, &cursor) == RING_BUFFER_SUCCESS, "Failed to release");
+    }
+    
+    TEST_ASSERT(copies > 0, "Expected at least one message crossing the end of the buffer");
+    
+    ring_buffer_destroy(other);
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test that producer, consumer and statistics fields don't share lines */
+static bool test_control_layout(void) {
+    size_t producer = offsetof(ring_buffer_control_t, write_pos);
+    size_t commit = offsetof(ring_buffer_control_t, commit_pos);
+    size_t consumer = offsetof(ring_buffer_control_t, read_pos);
+    size_t stats = offsetof(ring_buffer_control_t, stats);
+    
+    TEST_ASSERT(producer % RING_BUFFER_CACHE_LINE_SIZE == 0, "Producer line misaligned");
+    TEST_ASSERT(commit - producer >= RING_BUFFER_CACHE_LINE_SIZE, "Commit shares the producer line");
+    TEST_ASSERT(consumer - commit >= RING_BUFFER_CACHE_LINE_SIZE, "Consumer shares the commit line");
+    TEST_ASSERT(stats - consumer >= RING_BUFFER_CACHE_LINE_SIZE, "Statistics share the consumer line");
+    TEST_ASSERT(offsetof(ring_buffer_control_t, cached_read_pos) < commit, "Cached read position off the producer line");
+    TEST_ASSERT(offsetof(ring_buffer_control_t, cached_commit_pos) < stats, "Cached commit position off the consumer line");
+    
+    ring_buffer_t *rb = ring_buffer_create(4096);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    TEST_ASSERT((uintptr_t)rb->control % RING_BUFFER_CACHE_LINE_SIZE == 0, "Control block misaligned");
+    
+    /* Fill the buffer so the producers' cached read position goes stale */
+    char data[256];
+    int written = 0;
+    generate_test_data(data, sizeof(data), 0);
+    while (ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS) {
+        written++;
+    }
+    TEST_ASSERT(written > 0, "Should have written at least one message");
+    
+    ring_buffer_message_t msg;
+    for (int i = 0; i < written; i++) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+    }
+    
+    /* Space freed by the reads must be found again */
+    TEST_ASSERT(ring_buffer_available_write(rb) == rb->size, "Drained buffer should be fully writable");
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Write after drain failed");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Read after drain failed");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Writer thread for the sharded statistics test */
+static void *stats_writer_thread(void *arg) {
+    ring_buffer_t *rb = (ring_buffer_t *)arg;
+    char data[64];
+    memset(data, 0x42, sizeof(data));
+    for (int i = 0; i < 200; i++) {
+        while (ring_buffer_write(rb, data, sizeof(data)) != RING_BUFFER_SUCCESS) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* Test that per-thread statistics shards add up */
+static bool test_sharded_statistics(void) {
+    ring_buffer_t *rb = ring_buffer_create(1024 * 1024);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    /* More threads than shards, so some shards are shared */
+    enum { num_threads = RING_BUFFER_STATS_SHARDS + 4 };
+    pthread_t threads[num_threads];
+    for (int i = 0; i < num_threads; i++) {
+        TEST_ASSERT(pthread_create(&threads[i], NULL, stats_writer_thread, rb) == 0,
+                    "Failed to create writer thread");
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    ring_buffer_stats_t stats;
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT_STATS(stats.messages_written == num_threads * 200, "Shards don't sum to messages written");
+    TEST_ASSERT_STATS(stats.bytes_written == num_threads * 200 * 64, "Shards don't sum to bytes written");
+    
+    ring_buffer_reset_stats(rb);
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT(stats.messages_written == 0 && stats.bytes_written == 0, "Reset should clear every shard");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test a file-backed buffer shared between handles and processes */
+static bool test_shared_buffer(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-rb-test-%d", (int)getpid());
+    
+    ring_buffer_config_t config = { .size = 16384 };
+    ring_buffer_t *producer = ring_buffer_create_shared(path, &config);
+    TEST_ASSERT(producer != NULL, "Failed to create shared ring buffer");
+    TEST_ASSERT(producer->flags & RING_BUFFER_FLAG_SHARED, "Shared flag not set");
+    
+    ring_buffer_t *consumer = ring_buffer_open_shared(path, 0);
+    TEST_ASSERT(consumer != NULL, "Failed to open shared ring buffer");
+    TEST_ASSERT(consumer->size == producer->size, "Attached size mismatch");
+    TEST_ASSERT(consumer->buffer != producer->buffer, "Expected a separate mapping");
+    
+    /* Messages written through one handle are read through the other */
+    char data[1100];
+    ring_buffer_message_t msg;
+    for (int i = 0; i < 40; i++) {
+        generate_test_data(data, sizeof(data), i);
+        TEST_ASSERT(ring_buffer_write(producer, data, sizeof(data)) == RING_BUFFER_SUCCESS,
+                    "Failed to write shared message");
+        TEST_ASSERT(ring_buffer_read(consumer, &msg) == RING_BUFFER_SUCCESS,
+                    "Failed to read shared message");
+        TEST_ASSERT(verify_test_data(msg.data, msg.data_size, i), "Shared message data mismatch");
+    }
+    
+    ring_buffer_stats_t stats;
+    ring_buffer_get_stats(producer, &stats);
+    TEST_ASSERT_STATS(stats.messages_read == 40, "Statistics not shared between handles");
+    
+    /* A child process produces, the parent consumes */
+    pid_t pid = fork();
+    TEST_ASSERT(pid >= 0, "fork failed");
+    if (pid == 0) {
+        ring_buffer_t *child = ring_buffer_open_shared(path, RING_BUFFER_FLAG_MIRRORED);
+        int status = child ? 0 : 1;
+        for (int i = 0; child && i < 8; i++) {
+            generate_test_data(data, sizeof(data), 100 + i);
+            if (ring_buffer_write(child, data, sizeof(data)) != RING_BUFFER_SUCCESS) {
+                status = 1;
+            }
+        }
+        ring_buffer_destroy(child);
+        _exit(status);
+    }
+    
+    int status = 0;
+    TEST_ASSERT(waitpid(pid, &status, 0) == pid, "waitpid failed");
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Child producer failed");
+    
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT(ring_buffer_read(consumer, &msg) == RING_BUFFER_SUCCESS,
+                    "Failed to read message from child");
+        TEST_ASSERT(verify_test_data(msg.data, msg.data_size, 100 + i), "Child message data mismatch");
+    }
+    TEST_ASSERT(ring_buffer_read(consumer, &msg) == RING_BUFFER_ERROR_EMPTY, "Buffer should be empty");
+    
+    ring_buffer_destroy(consumer);
+    ring_buffer_destroy(producer);
+    
+    /* Files that aren't ring buffers are rejected */
+    FILE *f = fopen(path, "w");
+    TEST_ASSERT(f != NULL, "Failed to overwrite test file");
+    fputs("not a ring buffer", f);
+    fclose(f);
+    TEST_ASSERT(ring_buffer_open_shared(path, 0) == NULL, "Should reject invalid file");
+    
+    unlink(path);
+    TEST_ASSERT(ring_buffer_open_shared(path, 0) == NULL, "Should reject missing file");
+    
+    return true;
+}
+
+/* Test rebuilding a shared buffer left behind by a crashed producer */
+static bool test_crash_recovery(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-rb-recover-%d", (int)getpid());
+    
+    ring_buffer_config_t config = { .size = 16384 };
+    ring_buffer_t *rb = ring_buffer_create_shared(path, &config);
+    TEST_ASSERT(rb != NULL, "Failed to create shared ring buffer");
+    ring_buffer_destroy(rb);
+    
+    /* The child dies holding an uncommitted reservation */
+    char data[100];
+    pid_t pid = fork();
+    TEST_ASSERT(pid >= 0, "fork failed");
+    if (pid == 0) {
+        ring_buffer_t *child = ring_buffer_open_shared(path, 0);
+        ring_buffer_span_t span;
+        for (int i = 0; child && i < 5; i++) {
+            generate_test_data(data, sizeof(data), i);
+            ring_buffer_write(child, data, sizeof(data));
+        }
+        if (child && ring_buffer_reserve(child, sizeof(data), &span) == RING_BUFFER_SUCCESS) {
+            ring_buffer_span_copy(&span, 0, data, sizeof(data));
+        }
+        _exit(child ? 0 : 1);
+    }
+    
+    int status = 0;
+    TEST_ASSERT(waitpid(pid, &status, 0) == pid, "waitpid failed");
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Child producer failed");
+    
+    rb = ring_buffer_open_shared(path, 0);
+    TEST_ASSERT(rb != NULL, "Failed to reopen shared ring buffer");
+    TEST_ASSERT(atomic_load(&rb->control->write_pos) > atomic_load(&rb->control->commit_pos),
+                "Expected a dangling reservation");
+    
+    ring_buffer_message_t last;
+    TEST_ASSERT(ring_buffer_recover(rb, &last) == 5, "Wrong number of recovered messages");
+    TEST_ASSERT(verify_test_data(last.data, last.data_size, 4), "Wrong newest message");
+    TEST_ASSERT(atomic_load(&rb->control->write_pos) == atomic_load(&rb->control->commit_pos),
+                "Reservation not discarded");
+    
+    /* Writes work again and the recovered messages come first */
+    generate_test_data(data, sizeof(data), 5);
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Write after recovery failed");
+    ring_buffer_message_t msg;
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read recovered message");
+        TEST_ASSERT(verify_test_data(msg.data, msg.data_size, i), "Recovered message data mismatch");
+    }
+    
+    /* A corrupt record truncates the buffer there */
+    for (int i = 0; i < 3; i++) {
+        generate_test_data(data, sizeof(data), i);
+        TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+    }
+    size_t record_size = (sizeof(arrow_ipc_header_t) + sizeof(data) + MESSAGE_ALIGNMENT - 1) & ~(size_t)(MESSAGE_ALIGNMENT - 1);
+    size_t second = atomic_load(&rb->control->read_pos) + record_size + sizeof(arrow_ipc_header_t);
+    ((uint8_t *)rb->buffer)[second & (rb->size - 1)] ^= 0xFF;
+    
+    TEST_ASSERT(ring_buffer_recover(rb, NULL) == 1, "Corrupt record should end the recovered range");
+    TEST_ASSERT(ring_buffer_available_read(rb) == record_size, "Wrong recovered byte count");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS && verify_test_data(msg.data, msg.data_size, 0),
+                "First message lost");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_ERROR_EMPTY, "Buffer should be empty");
+    TEST_ASSERT(ring_buffer_recover(NULL, NULL) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL buffer");
+    
+    ring_buffer_destroy(rb);
+    unlink(path);
+    return true;
+}
+
+/* Writer stuck behind an uncommitted reservation, for test_recover_past_commit() */
+typedef struct {
+    ring_buffer_t *rb;
+    int seq;
+} blocked_writer_data_t;
+
+static void *blocked_writer_thread(void *arg) {
+    blocked_writer_data_t *data = (blocked_writer_data_t *)arg;
+    char payload[100];
+    generate_test_data(payload, sizeof(payload), data->seq);
+    ring_buffer_write(data->rb, payload, sizeof(payload));
+    return NULL;
+}
+
+/* Wait up to five seconds for the two records after the child's first
+ * four to verify. The child lives in another process, so watching them
+ * isn't a race within this one. Gives up early if the child exits,
+ * storing its status in *status and its pid in *reaped. */
+static bool wait_for_late_records(const ring_buffer_t *rb, pid_t pid, size_t record_size, size_t size,
+                                  int *status, pid_t *reaped) {
+    double deadline = get_time() + 5.0;
+    for (int i = 0; i < 2; i++) {
+        const uint8_t *record = (const uint8_t *)rb->buffer + (4 + i) * record_size;
+        const volatile arrow_ipc_header_t *header = (const volatile arrow_ipc_header_t *)record;
+        while (header->magic != ARROW_IPC_MAGIC || header->timestamp == 0 ||
+               header->checksum != ring_buffer_checksum(RING_BUFFER_HEADER_CHECKSUM(header->reserved),
+                                                        record + sizeof(arrow_ipc_header_t), size)) {
+            if (get_time() > deadline) {
+                return false;
+            }
+            *reaped = waitpid(pid, status, WNOHANG);
+            if (*reaped != 0) {
+                return false;
+            }
+            sched_yield();
+        }
+    }
+    usleep(1000);
+    return true;
+}
+
+/* Test that recovery keeps complete records stuck behind a dead writer's reservation */
+static bool test_recover_past_commit(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/chronicle-rb-recover-past-%d", (int)getpid());
+    
+    ring_buffer_config_t config = { .size = 16384 };
+    ring_buffer_t *rb = ring_buffer_create_shared(path, &config);
+    TEST_ASSERT(rb != NULL, "Failed to create shared ring buffer");
+    ring_buffer_destroy(rb);
+    
+    /* The child reserves and never commits, while two later writers
+     * finish their records and wait to publish them */
+    char data[100];
+    size_t record_size = (sizeof(arrow_ipc_header_t) + sizeof(data) + MESSAGE_ALIGNMENT - 1) & ~(size_t)(MESSAGE_ALIGNMENT - 1);
+    pid_t pid = fork();
+    TEST_ASSERT(pid >= 0, "fork failed");
+    if (pid == 0) {
+        ring_buffer_t *child = ring_buffer_open_shared(path, 0);
+        ring_buffer_span_t span;
+        if (!child) {
+            _exit(1);
+        }
+        for (int i = 0; i < 3; i++) {
+            generate_test_data(data, sizeof(data), i);
+            ring_buffer_write(child, data, sizeof(data));
+        }
+        if (ring_buffer_reserve(child, sizeof(data), &span) != RING_BUFFER_SUCCESS) {
+            _exit(1);
+        }
+        ring_buffer_span_copy(&span, 0, data, sizeof(data) / 2);
+        
+        pthread_t writers[2];
+        blocked_writer_data_t writer_data[2];
+        for (int i = 0; i < 2; i++) {
+            writer_data[i].rb = child;
+            writer_data[i].seq = 3 + i;
+            pthread_create(&writers[i], NULL, blocked_writer_thread, &writer_data[i]);
+        }
+        for (;;) {
+            pause();
+        }
+    }
+    
+    /* Kill it once both late records verify, or once it has given up or
+     * run out of time; the child is reaped on every path */
+    int status = 0;
+    pid_t reaped = 0;
+    rb = ring_buffer_open_shared(path, 0);
+    bool stuck = rb && wait_for_late_records(rb, pid, record_size, sizeof(data), &status, &reaped);
+    if (reaped != pid) {
+        kill(pid, SIGKILL);
+        reaped = waitpid(pid, &status, 0);
+    }
+    if (rb) {
+        ring_buffer_destroy(rb);
+    }
+    TEST_ASSERT(reaped == pid, "waitpid failed");
+    TEST_ASSERT(stuck, "Late writers never finished their records");
+    TEST_ASSERT(WIFSIGNALED(status), "Child producer exited early");
+    
+    rb = ring_buffer_open_shared(path, 0);
+    TEST_ASSERT(rb != NULL, "Failed to reopen shared ring buffer");
+    TEST_ASSERT(atomic_load(&rb->control->commit_pos) == 3 * record_size, "Commits should stop at the reservation");
+    TEST_ASSERT(atomic_load(&rb->control->write_pos) == 6 * record_size, "Later writers should have reserved");
+    
+    ring_buffer_message_t last;
+    TEST_ASSERT(ring_buffer_recover(rb, &last) == 5, "Records behind the reservation should be recovered");
+    TEST_ASSERT(atomic_load(&rb->control->commit_pos) == 6 * record_size, "Recovered records should be published");
+    TEST_ASSERT(atomic_load(&rb->control->write_pos) == 6 * record_size, "Nothing recovered should be reused");
+    
+    /* The reservation is skipped and the late records follow in order */
+    ring_buffer_message_t msg;
+    int later = 0;
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read recovered message");
+        if (i < 3) {
+            TEST_ASSERT(verify_test_data(msg.data, msg.data_size, i), "Recovered message data mismatch");
+        } else {
+            int seq = verify_test_data(msg.data, msg.data_size, 3) ? 3 : 4;
+            TEST_ASSERT(verify_test_data(msg.data, msg.data_size, seq), "Late message data mismatch");
+            later |= 1 << (seq - 3);
+        }
+    }
+    TEST_ASSERT(later == 3, "Both late messages should be recovered");
+    TEST_ASSERT(verify_test_data(last.data, last.data_size, 3) || verify_test_data(last.data, last.data_size, 4),
+                "Wrong newest message");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_ERROR_EMPTY, "Buffer should be empty");
+    
+    generate_test_data(data, sizeof(data), 5);
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Write after recovery failed");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS && verify_test_data(msg.data, msg.data_size, 5),
+                "New message lost");
+    
+    ring_buffer_destroy(rb);
+    unlink(path);
+    return true;
+}
+
+/* Test mirroring committed records into a replica */
+static bool test_replication(void) {
+    ring_buffer_t *source = ring_buffer_create(8192);
+    ring_buffer_t *replica = ring_buffer_create(8192);
+    ring_buffer_t *small = ring_buffer_create(4096);
+    TEST_ASSERT(source && replica && small, "Failed to create ring buffers");
+    
+    size_t cursor = 0;
+    TEST_ASSERT(ring_buffer_replicate(source, small, &cursor) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Should reject size mismatch");
+    TEST_ASSERT(ring_buffer_replicate(source, source, &cursor) == RING_BUFFER_ERROR_INVALID_PARAM,
+                "Should reject replicating onto itself");
+    
+    /* Stream a few laps through the source, replicating in batches */
+    char data[300];
+    ring_buffer_message_t msg;
+    int next_read = 0;
+    for (int i = 0; i < 100; i++) {
+        generate_test_data(data, sizeof(data), i);
+        TEST_ASSERT(ring_buffer_write(source, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Failed to write message");
+        
+        if (i % 7 == 6) {
+            TEST_ASSERT(ring_buffer_replicate(source, replica, &cursor) == RING_BUFFER_SUCCESS, "Replication failed");
+            TEST_ASSERT(ring_buffer_available_read(replica) == ring_buffer_available_read(source),
+                        "Replica backlog differs from source");
+            
+            /* The replica holds exactly what the source has not consumed */
+            TEST_ASSERT(ring_buffer_peek(replica, &msg) == RING_BUFFER_SUCCESS, "Replica empty");
+            TEST_ASSERT(verify_test_data(msg.data, msg.data_size, next_read), "Replica head mismatch");
+            
+            while (ring_buffer_available_read(source) > 4096) {
+                TEST_ASSERT(ring_buffer_read(source, &msg) == RING_BUFFER_SUCCESS, "Failed to drain source");
+                next_read++;
+            }
+        }
+    }
+    
+    TEST_ASSERT(ring_buffer_replicate(source, replica, &cursor) == RING_BUFFER_SUCCESS, "Replication failed");
+    for (int i = next_read; i < 100; i++) {
+        TEST_ASSERT(ring_buffer_read(replica, &msg) == RING_BUFFER_SUCCESS, "Replica missing message");
+        TEST_ASSERT(verify_test_data(msg.data, msg.data_size, i), "Replica data mismatch");
+    }
+    TEST_ASSERT(ring_buffer_read(replica, &msg) == RING_BUFFER_ERROR_EMPTY, "Replica has extra messages");
+    
+    ring_buffer_destroy(small);
+    ring_buffer_destroy(replica);
+    ring_buffer_destroy(source);
+    return true;
+}
+
+/* Delayed producer/consumer for the wait tests */
+typedef struct {
+    ring_buffer_t *rb;
+    int delay_ms;
+    int count;
+} delayed_thread_data_t;
+
+static void *delayed_writer_thread(void *arg) {
+    delayed_thread_data_t *data = (delayed_thread_data_t *)arg;
+    usleep((useconds_t)data->delay_ms * 1000);
+    for (int i = 0; i < data->count; i++) {
+        ring_buffer_write(data->rb, "wake", 4);
+    }
+    return NULL;
+}
+
+static void *delayed_reader_thread(void *arg) {
+    delayed_thread_data_t *data = (delayed_thread_data_t *)arg;
+    ring_buffer_message_t msg;
+    usleep((useconds_t)data->delay_ms * 1000);
+    for (int i = 0; i < data->count; i++) {
+        ring_buffer_read(data->rb, &msg);
+    }
+    return NULL;
+}
+
+static uint64_t elapsed_ms_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000 +
+           (uint64_t)((now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+/* Test blocking waits for readable data and writable space */
+static bool test_wait_notify(void) {
+    ring_buffer_t *rb = ring_buffer_create(8192);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    /* Polling and timing out on an empty buffer */
+    TEST_ASSERT(ring_buffer_wait_readable(rb, 0, 0) == RING_BUFFER_ERROR_TIMEOUT, "Empty buffer should not be readable");
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT(ring_buffer_wait_readable(rb, 0, 20 * 1000000LL) == RING_BUFFER_ERROR_TIMEOUT, "Wait should time out");
+    TEST_ASSERT(elapsed_ms_since(&start) >= 19, "Wait returned before its timeout");
+    
+    /* A parked reader is woken by a commit */
+    delayed_thread_data_t writer = { rb, 20, 1 };
+    pthread_t thread;
+    TEST_ASSERT(pthread_create(&thread, NULL, delayed_writer_thread, &writer) == 0, "Failed to create writer thread");
+    TEST_ASSERT(ring_buffer_wait_readable(rb, 0, -1) == RING_BUFFER_SUCCESS, "Reader was not woken");
+    pthread_join(thread, NULL);
+    
+    ring_buffer_message_t msg;
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Woken reader found no message");
+    TEST_ASSERT(ring_buffer_wait_readable(rb, 0, 0) == RING_BUFFER_ERROR_TIMEOUT, "Drained buffer should not be readable");
+    
+    /* A writer held back by backpressure is woken by reads */
+    char data[512];
+    generate_test_data(data, sizeof(data), 0);
+    int written = 0;
+    while (ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS) {
+        written++;
+    }
+    TEST_ASSERT(ring_buffer_wait_writable(rb, 0, 0) == RING_BUFFER_ERROR_TIMEOUT, "Full buffer should not be writable");
+    
+    delayed_thread_data_t reader = { rb, 20, written };
+    TEST_ASSERT(pthread_create(&thread, NULL, delayed_reader_thread, &reader) == 0, "Failed to create reader thread");
+    TEST_ASSERT(ring_buffer_wait_writable(rb, 1024, 5000 * 1000000LL) == RING_BUFFER_SUCCESS, "Writer was not woken");
+    pthread_join(thread, NULL);
+    TEST_ASSERT(ring_buffer_write(rb, data, sizeof(data)) == RING_BUFFER_SUCCESS, "Woken writer could not write");
+    
+    /* Invalid parameters */
+    TEST_ASSERT(ring_buffer_wait_readable(NULL, 0, 0) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject NULL buffer");
+    TEST_ASSERT(ring_buffer_wait_writable(rb, rb->size + 1, 0) == RING_BUFFER_ERROR_INVALID_PARAM, "Should reject impossible size");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Commit thread for the ordered commit test */
+typedef struct {
+    ring_buffer_t *rb;
+    ring_buffer_span_t *span;
+    volatile bool done;
+} commit_thread_data_t;
+
+static void *commit_thread(void *arg) {
+    commit_thread_data_t *data = (commit_thread_data_t *)arg;
+    ring_buffer_commit(data->rb, data->span);
+    data->done = true;
+    return NULL;
+}
+
+/* Test that a later reservation can't be published before an earlier one */
+static bool test_ordered_commit(void) {
+    ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    ring_buffer_span_t first, second;
+    TEST_ASSERT(ring_buffer_reserve(rb, 16, &first) == RING_BUFFER_SUCCESS, "Failed to reserve first span");
+    TEST_ASSERT(ring_buffer_reserve(rb, 16, &second) == RING_BUFFER_SUCCESS, "Failed to reserve second span");
+    ring_buffer_span_copy(&first, 0, "first-message-01", 16);
+    ring_buffer_span_copy(&second, 0, "second-message-2", 16);
+    
+    /* Finish the second writer first */
+    commit_thread_data_t data = { rb, &second, false };
+    pthread_t thread;
+    TEST_ASSERT(pthread_create(&thread, NULL, commit_thread, &data) == 0, "Failed to create commit thread");
+    
+    usleep(20000);
+    TEST_ASSERT(!data.done, "Second commit should wait for the first");
+    TEST_ASSERT(ring_buffer_available_read(rb) == 0, "Uncommitted region exposed to readers");
+    
+    TEST_ASSERT(ring_buffer_commit(rb, &first) == RING_BUFFER_SUCCESS, "Failed to commit first span");
+    pthread_join(thread, NULL);
+    TEST_ASSERT(data.done, "Second commit did not complete");
+    
+    ring_buffer_message_t msg;
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read first message");
+    TEST_ASSERT(memcmp(msg.data, "first-message-01", 16) == 0, "Messages out of order");
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_SUCCESS, "Failed to read second message");
+    TEST_ASSERT(memcmp(msg.data, "second-message-2", 16) == 0, "Messages out of order");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Producer for the multi-producer ordering test: payload is (thread id, sequence) */
+static void *sequenced_writer_thread(void *arg) {
+    thread_test_data_t *data = (thread_test_data_t *)arg;
+    uint32_t payload[32];
+    
+    for (int i = 0; i < data->message_count; i++) {
+        for (size_t j = 0; j < sizeof(payload) / sizeof(payload[0]); j++) {
+            payload[j] = (uint32_t)data->thread_id * 0x01000193u + (uint32_t)i + (uint32_t)j;
+        }
+        payload[0] = (uint32_t)data->thread_id;
+        payload[1] = (uint32_t)i;
+        
+        ring_buffer_error_t result = ring_buffer_write(data->rb, payload, sizeof(payload));
+        if (result == RING_BUFFER_SUCCESS) {
+            data->messages_written++;
+        } else {
+            sched_yield();
+            i--;  /* Retry this message */
+        }
+    }
+    
+    return NULL;
+}
+
+/* Test that concurrent producers never expose torn messages to a consumer */
+static bool test_multi_producer_ordering(void) {
+    ring_buffer_t *rb = ring_buffer_create(64 * 1024);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    const int num_threads = TEST_THREAD_COUNT;
+    const int messages_per_thread = 5000;
+    pthread_t threads[TEST_THREAD_COUNT];
+    thread_test_data_t writer_data[TEST_THREAD_COUNT];
+    int next_seq[TEST_THREAD_COUNT] = {0};
+    
+    for (int i = 0; i < num_threads; i++) {
+        memset(&writer_data[i], 0, sizeof(writer_data[i]));
+        writer_data[i].rb = rb;
+        writer_data[i].thread_id = i;
+        writer_data[i].message_count = messages_per_thread;
+        TEST_ASSERT(pthread_create(&threads[i], NULL, sequenced_writer_thread, &writer_data[i]) == 0,
+                    "Failed to create writer thread");
+    }
+    
+    int total_read = 0;
+    int corrupted = 0;
+    int out_of_order = 0;
+    while (total_read < num_threads * messages_per_thread) {
+        ring_buffer_message_t msg;
+        ring_buffer_error_t result = ring_buffer_read(rb, &msg);
+        if (result == RING_BUFFER_ERROR_EMPTY) {
+            sched_yield();
+            continue;
+        }
+        if (result != RING_BUFFER_SUCCESS) {
+            corrupted++;
+            break;
+        }
+        
+        const uint32_t *payload = (const uint32_t *)msg.data;
+        uint32_t thread_id = payload[0];
+        if (thread_id >= (uint32_t)num_threads || payload[1] != (uint32_t)next_seq[thread_id]) {
+            out_of_order++;
+            break;
+        }
+        next_seq[thread_id]++;
+        total_read++;
+    }
+    
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    TEST_ASSERT(corrupted == 0, "Consumer observed an uncommitted or torn message");
+    TEST_ASSERT(out_of_order == 0, "Per-producer message order not preserved");
+    TEST_ASSERT(total_read == num_threads * messages_per_thread, "Lost messages");
+    
+    ring_buffer_stats_t stats;
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT(stats.read_errors == 0, "Unexpected read errors");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Registered reader for the fan-out test, checking per-producer order */
+typedef struct {
+    ring_buffer_t *rb;
+    ring_buffer_reader_t reader;
+    int expected;
+    int received;
+    int errors;
+} fanout_reader_data_t;
+
+static void *fanout_reader_thread(void *arg) {
+    fanout_reader_data_t *data = (fanout_reader_data_t *)arg;
+    int next_seq[TEST_THREAD_COUNT] = {0};
+    ring_buffer_message_t msgs[16];
+    
+    while (data->received < data->expected && data->errors == 0) {
+        int count = ring_buffer_reader_peek(data->rb, &data->reader, msgs, 16);
+        if (count < 0) {
+            data->errors++;
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            const uint32_t *payload = (const uint32_t *)msgs[i].data;
+            if (payload[0] >= TEST_THREAD_COUNT || payload[1] != (uint32_t)next_seq[payload[0]]) {
+                data->errors++;
+                break;
+            }
+            next_seq[payload[0]]++;
+            data->received++;
+        }
+        if (count == 0) {
+            sched_yield();
+        } else {
+            ring_buffer_reader_release(data->rb, &data->reader);
+        }
+    }
+    
+    return NULL;
+}
+
+/* Test that concurrent readers each get every message while writers wrap the buffer */
+static bool test_concurrent_fanout(void) {
+    ring_buffer_t *rb = ring_buffer_create(64 * 1024);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    const int messages_per_thread = 5000;
+    const int total = TEST_THREAD_COUNT * messages_per_thread;
+    pthread_t writers[TEST_THREAD_COUNT];
+    pthread_t readers[2];
+    thread_test_data_t writer_data[TEST_THREAD_COUNT];
+    fanout_reader_data_t reader_data[2];
+    ring_buffer_message_t msg;
+    
+    /* The shared read position joins in before the readers release anything */
+    TEST_ASSERT(ring_buffer_read(rb, &msg) == RING_BUFFER_ERROR_EMPTY, "Buffer should start empty");
+    for (int i = 0; i < 2; i++) {
+        memset(&reader_data[i], 0, sizeof(reader_data[i]));
+        reader_data[i].rb = rb;
+        reader_data[i].expected = total;
+        TEST_ASSERT(ring_buffer_reader_open(rb, 0, &reader_data[i].reader) == RING_BUFFER_SUCCESS, "Failed to open reader");
+        TEST_ASSERT(pthread_create(&readers[i], NULL, fanout_reader_thread, &reader_data[i]) == 0,
+                    "Failed to create reader thread");
+    }
+    for (int i = 0; i < TEST_THREAD_COUNT; i++) {
+        memset(&writer_data[i], 0, sizeof(writer_data[i]));
+        writer_data[i].rb = rb;
+        writer_data[i].thread_id = i;
+        writer_data[i].message_count = messages_per_thread;
+        TEST_ASSERT(pthread_create(&writers[i], NULL, sequenced_writer_thread, &writer_data[i]) == 0,
+                    "Failed to create writer thread");
+    }
+    
+    /* The shared read position consumes alongside the readers */
+    int consumed = 0;
+    while (consumed < total) {
+        ring_buffer_error_t result = ring_buffer_read(rb, &msg);
+        if (result == RING_BUFFER_SUCCESS) {
+            consumed++;
+        } else if (result == RING_BUFFER_ERROR_EMPTY) {
+            sched_yield();
+        } else {
+            break;
+        }
+    }
+    
+    for (int i = 0; i < TEST_THREAD_COUNT; i++) {
+        pthread_join(writers[i], NULL);
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(readers[i], NULL);
+        TEST_ASSERT(reader_data[i].errors == 0, "Reader saw a torn, reordered or overwritten message");
+        TEST_ASSERT(reader_data[i].received == total, "Reader lost messages");
+        TEST_ASSERT(ring_buffer_reader_close(rb, &reader_data[i].reader) == RING_BUFFER_SUCCESS, "Failed to close reader");
+    }
+    TEST_ASSERT(consumed == total, "Consumer lost messages");
+    
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test large messages */
+static bool test_large_messages(void) {
+    ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    /* Test message at maximum size */
+    char *large_data = malloc(TEST_LARGE_MESSAGE_SIZE);
+    TEST_ASSERT(large_data != NULL, "Failed to allocate large message");
+    
+    generate_test_data(large_data, TEST_LARGE_MESSAGE_SIZE, 0xAB);
+    
+    ring_buffer_error_t result = ring_buffer_write(rb, large_data, TEST_LARGE_MESSAGE_SIZE);
+    TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to write large message");
+    
+    ring_buffer_message_t msg;
+    result = ring_buffer_read(rb, &msg);
+    TEST_ASSERT(result == RING_BUFFER_SUCCESS, "Failed to read large message");
+    TEST_ASSERT(msg.header.length == TEST_LARGE_MESSAGE_SIZE, "Large message size mismatch");
+    TEST_ASSERT(verify_test_data(msg.data, TEST_LARGE_MESSAGE_SIZE, 0xAB), "Large message data corruption");
+    
+    free(large_data);
+    ring_buffer_destroy(rb);
+    return true;
+}
+
+/* Test error conditions */
+static bool test_error_conditions(void) {
+    ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+    
+    /* Test message too large */
+    char *huge_data = malloc(RING_BUFFER_MAX_MESSAGE_SIZE + 1);
+    TEST_ASSERT(huge_data != NULL, "Failed to allocate huge message");
+    
+    ring_buffer_error_t result = ring_buffer_write(rb, huge_data, RING_BUFFER_MAX_MESSAGE_SIZE + 1);
+    TEST_ASSERT(result == RING_BUFFER_ERROR_TOO_LARGE, "Should reject oversized message");
+    
+    free(huge_data);
+    
+    /* A handle that fails validation is rejected without being used */
+    ring_buffer_t bogus = {0};
+    ring_buffer_message_t msg;
+    ring_buffer_cursor_t cursor = {0};
+    TEST_ASSERT(ring_buffer_write(&bogus, "x", 1) == RING_BUFFER_ERROR_CORRUPTED, "Should reject a bad handle");
+    TEST_ASSERT(ring_buffer_read(&bogus, &msg) == RING_BUFFER_ERROR_CORRUPTED, "Should reject a bad handle");
+    TEST_ASSERT(ring_buffer_read_batch(&bogus, &msg, 1) == RING_BUFFER_ERROR_CORRUPTED, "Should reject a bad handle");
+    TEST_ASSERT(ring_buffer_peek_batch(&bogus, &cursor, &msg, 1) == RING_BUFFER_ERROR_CORRUPTED,
+                "Should reject a bad handle");
     
     /* Test error strings */
     const char *error_str = ring_buffer_error_string(RING_BUFFER_SUCCESS);
@@ -542,12 +2444,40 @@ static void run_all_tests(void) {
     RUN_TEST(test_basic_read_write);
     RUN_TEST(test_multiple_messages);
     RUN_TEST(test_buffer_wraparound);
+    RUN_TEST(test_reserve_commit);
+    RUN_TEST(test_mirrored_buffer);
+    RUN_TEST(test_wrapped_copies);
+    RUN_TEST(test_memory_options);
+    RUN_TEST(test_elastic_buffer);
+    RUN_TEST(test_single_producer_consumer);
+    RUN_TEST(test_batch_operations);
+    RUN_TEST(test_deferred_release);
+    RUN_TEST(test_seek_time);
+    RUN_TEST(test_broadcast_readers);
+    RUN_TEST(test_readers_only);
+    RUN_TEST(test_slab_records);
+    RUN_TEST(test_compression);
+    RUN_TEST(test_clock_sources);
+    RUN_TEST(test_shared_buffer);
+    RUN_TEST(test_crash_recovery);
+    RUN_TEST(test_recover_past_commit);
+    RUN_TEST(test_replication);
+    RUN_TEST(test_control_layout);
     RUN_TEST(test_buffer_overflow);
     RUN_TEST(test_backpressure);
+    RUN_TEST(test_backpressure_hysteresis);
+    RUN_TEST(test_watermark_config);
     RUN_TEST(test_statistics);
+    RUN_TEST(test_sharded_statistics);
     RUN_TEST(test_checksum_validation);
+    RUN_TEST(test_trusted_handle);
+    RUN_TEST(test_checksum_engine);
     RUN_TEST(test_utility_functions);
     RUN_TEST(test_concurrent_access);
+    RUN_TEST(test_ordered_commit);
+    RUN_TEST(test_multi_producer_ordering);
+    RUN_TEST(test_concurrent_fanout);
+    RUN_TEST(test_wait_notify);
     RUN_TEST(test_large_messages);
     RUN_TEST(test_error_conditions);
     
@@ -0,0 +1,225 @@
+/**
+ * @file test_ring_buffer_cpp.cpp
+ * @brief Unit tests for the C++ front end in ring_buffer.hpp
+ *
+ * Tests cover the compile-time policies, the handles they create and
+ * attach, and single-producer, single-consumer operation across threads.
+ */
+
+#include "ring_buffer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using chronicle::Checksum;
+using chronicle::MpscPolicy;
+using chronicle::Policy;
+using chronicle::RingBuffer;
+using chronicle::SpscPolicy;
+
+/* Test statistics */
+static int g_tests_run = 0;
+static int g_tests_failed = 0;
+
+/* Test utilities */
+#define TEST_ASSERT(condition, message) do { \
+    g_tests_run++; \
+    if (!(condition)) { \
+        std::printf("FAIL: %s - %s\n", __func__, message); \
+        g_tests_failed++; \
+        return false; \
+    } \
+} while (0)
+
+#define RUN_TEST(test_func) do { \
+    std::printf("Running %s...\n", #test_func); \
+    if (test_func()) { \
+        std::printf("PASS: %s\n", #test_func); \
+    } else { \
+        std::printf("FAIL: %s\n", #test_func); \
+    } \
+} while (0)
+
+/* A fixed-size record as C++ ingest tools write them */
+struct Sample {
+    uint64_t sequence;
+    uint32_t source;
+    float value;
+};
+
+using Spsc = RingBuffer<SpscPolicy<64 * 1024>>;
+using Mpsc = RingBuffer<MpscPolicy<64 * 1024>>;
+using Mpmc = RingBuffer<Policy<64 * 1024>>;
+using Uncounted = RingBuffer<SpscPolicy<64 * 1024, Checksum::crc32c, false>>;
+
+/* Policies resolve to flags the compiler can see */
+static_assert(Spsc::capacity == 64 * 1024);
+static_assert(Spsc::mode_flags == (RING_BUFFER_FLAG_SINGLE_PRODUCER | RING_BUFFER_FLAG_SINGLE_CONSUMER));
+static_assert(Mpsc::mode_flags == RING_BUFFER_FLAG_SINGLE_CONSUMER);
+static_assert(Mpmc::mode_flags == 0);
+static_assert(RingBuffer<SpscPolicy<4096, Checksum::trusted, false>>::handle_flags ==
+              (RING_BUFFER_FLAG_TRUSTED | RING_BUFFER_FLAG_NO_STATS));
+static_assert(Uncounted::handle_flags == RING_BUFFER_FLAG_NO_STATS);
+static_assert(!std::is_copy_constructible_v<Spsc> && std::is_nothrow_move_constructible_v<Spsc>);
+
+/* Test that created buffers carry the policy and round-trip records */
+static bool test_policy_buffer(void) {
+    Spsc rb = Spsc::create();
+    TEST_ASSERT(rb, "Failed to create SPSC buffer");
+    TEST_ASSERT(rb.get()->size == Spsc::capacity, "Wrong capacity");
+    TEST_ASSERT((rb.get()->flags & Spsc::mode_flags) == Spsc::mode_flags, "Policy flags not set");
+
+    /* Several laps, so reservations and claims wrap */
+    ring_buffer_message_t msg;
+    for (uint64_t i = 0; i < 20000; i++) {
+        Sample sample = { i, 7, 0.5f * (float)i };
+        TEST_ASSERT(rb.write(sample) == RING_BUFFER_SUCCESS, "Failed to write record");
+        TEST_ASSERT(rb.read(msg) == RING_BUFFER_SUCCESS, "Failed to read record");
+        TEST_ASSERT(msg.data_size == sizeof(Sample), "Wrong record size");
+
+        Sample read;
+        std::memcpy(&read, msg.data, sizeof(read));
+        TEST_ASSERT(read.sequence == i && read.source == 7, "Record mismatch");
+    }
+    TEST_ASSERT(rb.read(msg) == RING_BUFFER_ERROR_EMPTY, "Buffer should be empty");
+
+    /* Moving hands the buffer over */
+    Spsc moved = std::move(rb);
+    TEST_ASSERT(!rb && moved, "Move did not transfer the handle");
+    TEST_ASSERT(moved.write("x", 1) == RING_BUFFER_SUCCESS, "Failed to write through moved handle");
+    return true;
+}
+
+/* Test reservations and zero-copy draining */
+static bool test_span_and_drain(void) {
+    Mpsc rb = Mpsc::create(RING_BUFFER_FLAG_MIRRORED);
+    TEST_ASSERT(rb, "Failed to create MPSC buffer");
+
+    for (int i = 0; i < 100; i++) {
+        Mpsc::Span span;
+        TEST_ASSERT(rb.reserve(sizeof(int), span) == RING_BUFFER_SUCCESS, "Failed to reserve");
+        TEST_ASSERT(span.size() == sizeof(int), "Wrong reservation size");
+        TEST_ASSERT(span.copy(0, &i, sizeof(i)) == RING_BUFFER_SUCCESS, "Failed to fill span");
+        TEST_ASSERT(rb.commit(span) == RING_BUFFER_SUCCESS, "Failed to commit");
+    }
+    Mpsc::Span aborted;
+    TEST_ASSERT(rb.reserve(64, aborted) == RING_BUFFER_SUCCESS, "Failed to reserve");
+    TEST_ASSERT(rb.abort(aborted) == RING_BUFFER_SUCCESS, "Failed to abort");
+
+    int expected = 0;
+    bool in_order = true;
+    int drained = rb.drain<16>([&](const ring_buffer_message_t &msg) {
+        int value;
+        std::memcpy(&value, msg.data, sizeof(value));
+        in_order = in_order && value == expected++;
+    });
+    TEST_ASSERT(drained == 100, "Wrong drained count");
+    TEST_ASSERT(in_order, "Drained out of order");
+    TEST_ASSERT(rb.available_read() == 0, "Drain left messages behind");
+    return true;
+}
+
+/* Test that attaching checks the buffer against the policy */
+static bool test_attach_policy(void) {
+    std::string path = "/tmp/chronicle-rb-cpp-" + std::to_string(getpid());
+    Spsc producer = Spsc::create_shared(path.c_str());
+    TEST_ASSERT(producer, "Failed to create shared buffer");
+
+    Spsc consumer = Spsc::open_shared(path.c_str());
+    TEST_ASSERT(consumer, "Matching policy failed to attach");
+    TEST_ASSERT(consumer.get()->flags & RING_BUFFER_FLAG_SINGLE_PRODUCER, "Mode not read from the file");
+
+    /* A handle that allows several producers would break the promise */
+    TEST_ASSERT(!Mpmc::open_shared(path.c_str()), "Multi-producer policy attached");
+    TEST_ASSERT(!RingBuffer<SpscPolicy<128 * 1024>>::open_shared(path.c_str()), "Wrong capacity attached");
+
+    Sample sample = { 42, 1, 1.0f };
+    TEST_ASSERT(producer.write(sample) == RING_BUFFER_SUCCESS, "Failed to write record");
+    ring_buffer_message_t msg;
+    TEST_ASSERT(consumer.read(msg) == RING_BUFFER_SUCCESS, "Failed to read record");
+    TEST_ASSERT(msg.data_size == sizeof(Sample), "Wrong record size");
+    unlink(path.c_str());
+    return true;
+}
+
+/* Test that a policy without statistics keeps its handle out of the counters */
+static bool test_stats_policy(void) {
+    std::string path = "/tmp/chronicle-rb-cpp-stats-" + std::to_string(getpid());
+    Spsc counted = Spsc::create_shared(path.c_str());
+    TEST_ASSERT(counted, "Failed to create shared buffer");
+    Uncounted uncounted = Uncounted::open_shared(path.c_str());
+    TEST_ASSERT(uncounted, "Failed to attach without statistics");
+    TEST_ASSERT(uncounted.get()->flags & RING_BUFFER_FLAG_NO_STATS, "Policy flag not set on the handle");
+
+    ring_buffer_message_t msg;
+    for (uint64_t i = 0; i < 10; i++) {
+        Sample sample = { i, 2, 0.0f };
+        TEST_ASSERT(uncounted.write(sample) == RING_BUFFER_SUCCESS, "Failed to write record");
+        TEST_ASSERT(uncounted.read(msg) == RING_BUFFER_SUCCESS, "Failed to read record");
+    }
+#if RING_BUFFER_STATS
+    TEST_ASSERT(counted.stats().messages_written == 0 && counted.stats().messages_read == 0,
+                "Uncounted handle updated the statistics");
+    TEST_ASSERT(counted.write("x", 1) == RING_BUFFER_SUCCESS, "Failed to write record");
+    TEST_ASSERT(counted.stats().messages_written == 1, "Counted handle not counted");
+#endif
+    unlink(path.c_str());
+    return true;
+}
+
+/* Test one producer and one consumer thread without compare-and-swap */
+static bool test_spsc_threads(void) {
+    Spsc rb = Spsc::create();
+    TEST_ASSERT(rb, "Failed to create SPSC buffer");
+
+    const uint64_t count = 200000;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < count; i++) {
+            Sample sample = { i, 0, 0.0f };
+            while (rb.write(sample) != RING_BUFFER_SUCCESS) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t next = 0;
+    bool in_order = true;
+    ring_buffer_message_t msgs[32];
+    while (next < count) {
+        int n = rb.read_batch(msgs);
+        if (n < 0) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            Sample sample;
+            std::memcpy(&sample, msgs[i].data, sizeof(sample));
+            in_order = in_order && sample.sequence == next++;
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT(next == count, "Lost records");
+    TEST_ASSERT(in_order, "Records out of order");
+#if RING_BUFFER_STATS
+    TEST_ASSERT(rb.stats().messages_read == count, "Wrong read count");
+#endif
+    return true;
+}
+
+int main(void) {
+    std::printf("=== Ring Buffer C++ Front End Tests ===\n\n");
+    RUN_TEST(test_policy_buffer);
+    RUN_TEST(test_span_and_drain);
+    RUN_TEST(test_attach_policy);
+    RUN_TEST(test_stats_policy);
+    RUN_TEST(test_spsc_threads);
+
+    std::printf("\nTests run: %d, failed: %d\n", g_tests_run, g_tests_failed);
+    if (g_tests_failed == 0) {
+        std::printf("All tests PASSED! ✓\n");
+    }
+    return g_tests_failed == 0 ? 0 : 1;
+}
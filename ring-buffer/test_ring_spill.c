@@ -0,0 +1,414 @@
+/**
+ * @file test_ring_spill.c
+ * @brief Unit tests for the continuous spill to segment files
+ *
+ * Tests cover round trips through each I/O path, segment rollover,
+ * spilling under a live producer, padding left as holes, and reading a
+ * segment that was never sealed.
+ */
+
+#include "ring_spill.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/stat.h>
+
+/* Test configuration */
+#define TEST_BUFFER_SIZE (64 * 1024)
+#define TEST_MAX_SEGMENTS 64
+
+/* Test statistics */
+typedef struct {
+    int tests_run;
+    int tests_passed;
+    int tests_failed;
+} test_stats_t;
+
+static test_stats_t g_test_stats = {0, 0, 0};
+
+/* Test utilities */
+#define TEST_ASSERT(condition, message) do { \
+    g_test_stats.tests_run++; \
+    if (!(condition)) { \
+        printf("FAIL: %s - %s\n", __func__, message); \
+        g_test_stats.tests_failed++; \
+        return false; \
+    } \
+    g_test_stats.tests_passed++; \
+} while(0)
+
+#define RUN_TEST(test_func) do { \
+    printf("Running %s...\n", #test_func); \
+    if (test_func()) { \
+        printf("PASS: %s\n", #test_func); \
+    } else { \
+        printf("FAIL: %s\n", #test_func); \
+    } \
+} while(0)
+
+/* Segment file names in creation order */
+typedef struct {
+    char dir[64];
+    char paths[TEST_MAX_SEGMENTS][384];
+    int count;
+} segment_list_t;
+
+static void make_spill_dir(segment_list_t *list) {
+    memset(list, 0, sizeof(*list));
+    snprintf(list->dir, sizeof(list->dir), "/tmp/chronicle-rb-spill-XXXXXX");
+    if (!mkdtemp(list->dir)) {
+        list->dir[0] = '\0';
+    }
+}
+
+static int select_segment(const struct dirent *entry) {
+    size_t length = strlen(entry->d_name);
+    return strncmp(entry->d_name, RING_SPILL_SEGMENT_PREFIX, strlen(RING_SPILL_SEGMENT_PREFIX)) == 0 &&
+           length > strlen(RING_SPILL_SEGMENT_SUFFIX) &&
+           strcmp(entry->d_name + length - strlen(RING_SPILL_SEGMENT_SUFFIX), RING_SPILL_SEGMENT_SUFFIX) == 0;
+}
+
+static void list_segments(segment_list_t *list) {
+    struct dirent **entries;
+    int n = scandir(list->dir, &entries, select_segment, alphasort);
+    list->count = 0;
+    for (int i = 0; i < n; i++) {
+        if (list->count < TEST_MAX_SEGMENTS) {
+            char path[sizeof(list->paths[0])];
+            snprintf(path, sizeof(path), "%s/%s", list->dir, entries[i]->d_name);
+            memcpy(list->paths[list->count++], path, sizeof(path));
+        }
+        free(entries[i]);
+    }
+    if (n >= 0) {
+        free(entries);
+    }
+}
+
+static void remove_spill_dir(segment_list_t *list) {
+    list_segments(list);
+    for (int i = 0; i < list->count; i++) {
+        unlink(list->paths[i]);
+    }
+    rmdir(list->dir);
+}
+
+/* Message seq carries its number and a pattern, in a size that varies */
+static size_t make_message(uint8_t *data, uint64_t seq) {
+    size_t size = sizeof(seq) + (size_t)(seq * 37 % 700);
+    memcpy(data, &seq, sizeof(seq));
+    for (size_t i = sizeof(seq); i < size; i++) {
+        data[i] = (uint8_t)(seq + i);
+    }
+    return size;
+}
+
+static bool check_message(const ring_buffer_message_t *msg, uint64_t seq) {
+    uint8_t expected[1024];
+    size_t size = make_message(expected, seq);
+    return msg->data_size == size && memcmp(msg->data, expected, size) == 0;
+}
+
+/* Read every segment in order; returns the messages that matched seq 0, 1, ... */
+static uint64_t verify_segments(segment_list_t *list, bool *sealed) {
+    uint64_t next = 0;
+    *sealed = true;
+    list_segments(list);
+    for (int i = 0; i < list->count; i++) {
+        ring_spill_segment_t *segment = ring_spill_segment_open(list->paths[i]);
+        if (!segment) {
+            return next;
+        }
+        *sealed = *sealed && (ring_spill_segment_header(segment)->flags & RING_SPILL_SEGMENT_SEALED);
+
+        ring_buffer_message_t msg;
+        ring_buffer_error_t result;
+        while ((result = ring_spill_segment_next(segment, &msg)) == RING_BUFFER_SUCCESS) {
+            if (!check_message(&msg, next)) {
+                ring_spill_segment_close(segment);
+                return next;
+            }
+            next++;
+        }
+        ring_spill_segment_close(segment);
+        if (result != RING_BUFFER_ERROR_EMPTY) {
+            return next;
+        }
+    }
+    return next;
+}
+
+/* Write count messages, polling the spill whenever the buffer fills up */
+static bool produce(ring_buffer_t *rb, ring_spill_t *spill, uint64_t first, uint64_t count) {
+    uint8_t data[1024];
+    for (uint64_t seq = first; seq < first + count; seq++) {
+        size_t size = make_message(data, seq);
+        ring_buffer_error_t result;
+        while ((result = ring_buffer_write(rb, data, size)) == RING_BUFFER_ERROR_FULL ||
+               result == RING_BUFFER_ERROR_BACKPRESSURE) {
+            if (ring_spill_poll(spill, -1) < 0) {
+                return false;
+            }
+        }
+        if (result != RING_BUFFER_SUCCESS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Spill several laps of the buffer with the given flags and read them back */
+static bool spill_round_trip(uint32_t flags, bool mirrored) {
+    segment_list_t list;
+    make_spill_dir(&list);
+    TEST_ASSERT(list.dir[0] != '\0', "Failed to create spill directory");
+
+    ring_buffer_config_t rb_config = { .size = TEST_BUFFER_SIZE, .flags = mirrored ? RING_BUFFER_FLAG_MIRRORED : 0 };
+    ring_buffer_t *rb = ring_buffer_create_ex(&rb_config);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+
+    ring_spill_config_t config = { .directory = list.dir, .batch_size = 8192, .flags = flags };
+    ring_spill_t *spill = ring_spill_create(rb, &config);
+    TEST_ASSERT(spill != NULL, "Failed to create spill");
+
+    const uint64_t count = 2000;
+    TEST_ASSERT(produce(rb, spill, 0, count), "Failed to write messages");
+    TEST_ASSERT(ring_spill_seal(spill) == RING_BUFFER_SUCCESS, "Failed to seal");
+    TEST_ASSERT(ring_buffer_available_read(rb) == 0, "Seal left messages in the buffer");
+
+#if RING_BUFFER_STATS
+    ring_buffer_stats_t stats;
+    ring_buffer_get_stats(rb, &stats);
+    TEST_ASSERT(stats.messages_read == count, "Released messages not counted");
+#endif
+
+    bool sealed;
+    TEST_ASSERT(verify_segments(&list, &sealed) == count, "Segments don't hold every message in order");
+    TEST_ASSERT(sealed, "Segment not sealed");
+
+    ring_spill_destroy(spill);
+    ring_buffer_destroy(rb);
+    remove_spill_dir(&list);
+    return true;
+}
+
+/* Test io_uring (or dispatch_io) with direct I/O */
+static bool test_spill_direct(void) {
+    return spill_round_trip(0, false) && spill_round_trip(0, true);
+}
+
+/* Test the pwrite() fallback through the page cache */
+static bool test_spill_sync_buffered(void) {
+    return spill_round_trip(RING_SPILL_FLAG_SYNC_IO | RING_SPILL_FLAG_BUFFERED, false);
+}
+
+/* Producer thread for the concurrent test */
+typedef struct {
+    ring_buffer_t *rb;
+    uint64_t count;
+    atomic_bool done;
+} producer_args_t;
+
+static void *producer_thread(void *arg) {
+    producer_args_t *args = arg;
+    uint8_t data[1024];
+    for (uint64_t seq = 0; seq < args->count; seq++) {
+        size_t size = make_message(data, seq);
+        while (ring_buffer_write(args->rb, data, size) != RING_BUFFER_SUCCESS) {
+            sched_yield();
+        }
+    }
+    atomic_store(&args->done, true);
+    return NULL;
+}
+
+/* Test spilling while a producer keeps writing */
+static bool test_spill_concurrent(void) {
+    segment_list_t list;
+    make_spill_dir(&list);
+    TEST_ASSERT(list.dir[0] != '\0', "Failed to create spill directory");
+
+    ring_buffer_t *rb = ring_buffer_create(4 * TEST_BUFFER_SIZE);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+
+    ring_spill_config_t config = { .directory = list.dir, .segment_size = 1024 * 1024 };
+    ring_spill_t *spill = ring_spill_create(rb, &config);
+    TEST_ASSERT(spill != NULL, "Failed to create spill");
+
+    producer_args_t args = { .rb = rb, .count = 20000 };
+    atomic_init(&args.done, false);
+    pthread_t thread;
+    TEST_ASSERT(pthread_create(&thread, NULL, producer_thread, &args) == 0, "Failed to start producer");
+
+    bool ok = true;
+    while (ok && !atomic_load(&args.done)) {
+        ok = ring_spill_poll(spill, 1000000) >= 0;
+    }
+    pthread_join(thread, NULL);
+    TEST_ASSERT(ok, "Poll failed");
+    TEST_ASSERT(ring_spill_seal(spill) == RING_BUFFER_SUCCESS, "Failed to seal");
+
+    bool sealed;
+    TEST_ASSERT(verify_segments(&list, &sealed) == args.count, "Messages lost while spilling");
+    TEST_ASSERT(sealed, "Segment not sealed");
+
+    ring_spill_destroy(spill);
+    ring_buffer_destroy(rb);
+    remove_spill_dir(&list);
+    return true;
+}
+
+/* Test that segments roll over and the messages continue across them */
+static bool test_spill_rollover(void) {
+    segment_list_t list;
+    make_spill_dir(&list);
+    TEST_ASSERT(list.dir[0] != '\0', "Failed to create spill directory");
+
+    ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+
+    ring_spill_config_t config = { .directory = list.dir, .segment_size = 32 * 1024, .batch_size = 8192 };
+    ring_spill_t *spill = ring_spill_create(rb, &config);
+    TEST_ASSERT(spill != NULL, "Failed to create spill");
+
+    const uint64_t count = 3000;
+    TEST_ASSERT(produce(rb, spill, 0, count), "Failed to write messages");
+    TEST_ASSERT(ring_spill_seal(spill) == RING_BUFFER_SUCCESS, "Failed to seal");
+
+    bool sealed;
+    TEST_ASSERT(verify_segments(&list, &sealed) == count, "Messages lost across segments");
+    TEST_ASSERT(list.count > 4, "Segments did not roll over");
+    TEST_ASSERT(sealed, "Rolled segment not sealed");
+
+    /* Writing after a seal starts another segment */
+    int before = list.count;
+    TEST_ASSERT(produce(rb, spill, count, 10), "Failed to write after seal");
+    TEST_ASSERT(ring_spill_seal(spill) == RING_BUFFER_SUCCESS, "Failed to seal again");
+    TEST_ASSERT(verify_segments(&list, &sealed) == count + 10, "Messages lost after seal");
+    TEST_ASSERT(list.count == before + 1, "Seal did not start a new segment");
+
+    ring_spill_destroy(spill);
+    ring_buffer_destroy(rb);
+    remove_spill_dir(&list);
+    return true;
+}
+
+/* Test that aborted reservations are skipped on disk and on reading */
+static bool test_spill_padding_hole(void) {
+    segment_list_t list;
+    make_spill_dir(&list);
+    TEST_ASSERT(list.dir[0] != '\0', "Failed to create spill directory");
+
+    ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+
+    ring_spill_config_t config = { .directory = list.dir };
+    ring_spill_t *spill = ring_spill_create(rb, &config);
+    TEST_ASSERT(spill != NULL, "Failed to create spill");
+
+    /* A message, 20KB of padding, and another message */
+    uint8_t data[1024];
+    size_t size = make_message(data, 1);
+    ring_buffer_span_t span;
+    TEST_ASSERT(ring_buffer_write(rb, data, size) == RING_BUFFER_SUCCESS, "Failed to write first message");
+    TEST_ASSERT(ring_buffer_reserve(rb, 20 * 1024, &span) == RING_BUFFER_SUCCESS, "Failed to reserve");
+    TEST_ASSERT(ring_buffer_abort(rb, &span) == RING_BUFFER_SUCCESS, "Failed to abort");
+    TEST_ASSERT(ring_buffer_write(rb, data, size) == RING_BUFFER_SUCCESS, "Failed to write last message");
+    TEST_ASSERT(ring_spill_seal(spill) == RING_BUFFER_SUCCESS, "Failed to seal");
+    TEST_ASSERT(ring_buffer_available_read(rb) == 0, "Padding left in the buffer");
+
+    list_segments(&list);
+    TEST_ASSERT(list.count == 1, "Expected one segment");
+    struct stat st;
+    TEST_ASSERT(stat(list.paths[0], &st) == 0, "Failed to stat segment");
+    TEST_ASSERT(st.st_size > 20 * 1024, "Segment doesn't span the padding");
+    TEST_ASSERT((off_t)st.st_blocks * 512 < st.st_size, "Padding pages were written");
+
+    ring_spill_segment_t *segment = ring_spill_segment_open(list.paths[0]);
+    TEST_ASSERT(segment != NULL, "Failed to open segment");
+    ring_buffer_message_t msg;
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(ring_spill_segment_next(segment, &msg) == RING_BUFFER_SUCCESS, "Failed to read message");
+        TEST_ASSERT(check_message(&msg, 1), "Message mismatch");
+    }
+    TEST_ASSERT(ring_spill_segment_next(segment, &msg) == RING_BUFFER_ERROR_EMPTY, "Padding returned as a message");
+    ring_spill_segment_close(segment);
+
+    ring_spill_destroy(spill);
+    ring_buffer_destroy(rb);
+    remove_spill_dir(&list);
+    return true;
+}
+
+/* Test that messages stay in the buffer until their page is durable,
+ * and that an unsealed segment reads back up to its header */
+static bool test_spill_unsealed(void) {
+    segment_list_t list;
+    make_spill_dir(&list);
+    TEST_ASSERT(list.dir[0] != '\0', "Failed to create spill directory");
+
+    ring_buffer_t *rb = ring_buffer_create(TEST_BUFFER_SIZE);
+    TEST_ASSERT(rb != NULL, "Failed to create ring buffer");
+
+    ring_spill_config_t config = { .directory = list.dir };
+    ring_spill_t *spill = ring_spill_create(rb, &config);
+    TEST_ASSERT(spill != NULL, "Failed to create spill");
+
+    /* About 19KB, inside one batch */
+    TEST_ASSERT(produce(rb, spill, 0, 50), "Failed to write messages");
+    size_t committed = ring_buffer_available_read(rb);
+    TEST_ASSERT(ring_spill_poll(spill, 0) == 0, "Released before anything was durable");
+    TEST_ASSERT(ring_spill_poll(spill, -1) >= 0, "Failed to collect batch");
+    TEST_ASSERT(ring_buffer_available_read(rb) > 0, "Released the partial page");
+    TEST_ASSERT(ring_buffer_available_read(rb) < committed, "Complete pages not released");
+
+    bool sealed;
+    TEST_ASSERT(verify_segments(&list, &sealed) == 50, "Unsealed segment incomplete");
+    TEST_ASSERT(!sealed && list.count == 1, "Segment sealed too early");
+
+    /* Destroying seals what's left */
+    ring_spill_destroy(spill);
+    TEST_ASSERT(ring_buffer_available_read(rb) == 0, "Destroy left messages in the buffer");
+    TEST_ASSERT(verify_segments(&list, &sealed) == 50 && sealed, "Destroy did not seal");
+
+    TEST_ASSERT(ring_spill_segment_open("/nonexistent/spill-0.seg") == NULL, "Opened a missing segment");
+    ring_spill_config_t missing = { 0 };
+    TEST_ASSERT(ring_spill_create(rb, &missing) == NULL, "Created a spill without a directory");
+
+    ring_buffer_destroy(rb);
+    remove_spill_dir(&list);
+    return true;
+}
+
+static void run_all_tests(void) {
+    printf("=== Ring Buffer Spill Tests ===\n\n");
+
+    RUN_TEST(test_spill_direct);
+    RUN_TEST(test_spill_sync_buffered);
+    RUN_TEST(test_spill_rollover);
+    RUN_TEST(test_spill_concurrent);
+    RUN_TEST(test_spill_padding_hole);
+    RUN_TEST(test_spill_unsealed);
+
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", g_test_stats.tests_run);
+    printf("Tests passed: %d\n", g_test_stats.tests_passed);
+    printf("Tests failed: %d\n", g_test_stats.tests_failed);
+    printf("Success rate: %.1f%%\n",
+           (double)g_test_stats.tests_passed / (double)g_test_stats.tests_run * 100.0);
+
+    if (g_test_stats.tests_failed == 0) {
+        printf("\nAll tests PASSED! ✓\n");
+    } else {
+        printf("\nSome tests FAILED! ✗\n");
+    }
+}
+
+int main(void) {
+    run_all_tests();
+    return (g_test_stats.tests_failed == 0) ? 0 : 1;
+}